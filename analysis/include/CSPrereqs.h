@@ -6,16 +6,21 @@
 #include "TH1I.h"
 #include "target.h"
 #include "dataSet.h"
+#include "subRunCatalog.h"
+#include "fastHisto.h"
+#include "config.h"
 
 /******************************************************************************/
 /* Necessary information to calculate a cross section (CS prerequisites) */
+/* Histogram contents are held by value, so copies are independent and moves */
+/* are cheap; ROOT histograms are only made when writing output. */
 
 class CSPrereqs
 {
     public:
         CSPrereqs() {};
-        CSPrereqs(Target t);
-        CSPrereqs(std::string targetDataLocation);
+        CSPrereqs(Target t, const Config& config);
+        CSPrereqs(std::string targetDataLocation, const Config& config);
 
         int readTOFHisto(TFile* histoFile, std::string directory, std::string targetName);
         int readMonitorCounts(TFile* histoFile, std::string directory, std::string targetName);
@@ -23,10 +28,27 @@ class CSPrereqs
         int readEventData(TFile* macroFile, std::string directory, std::string targetName);
         int readUncorrectedTOFHisto(TFile* macroFile, std::string directory, std::string targetName);
 
+        // rebuild TOF histograms (with the run config's TOF binning and gates)
+        // from a subrun's event columns, then correct for deadtime
+        int readTOFFromEvents(std::string subRunLocation, std::string detectorName, std::string targetName, const Config& config);
+
+        // conversion to and from the plain-number form stored in subrun catalogs
+        void readSummary(const SubRunSummary& summary);
+        SubRunSummary getSummary(int runNumber, int subRun, long sourceTime) const;
+
         void readTargetData(std::string expName, std::string targetName);
         void getAverageRate(TFile* histoFile, std::string averageRateDataName, int targetNumber);
 
-        friend CSPrereqs operator+(CSPrereqs& augend, CSPrereqs& addend);
+        // in-place accumulation; CSPrereqs without monitor counts or good
+        // macros add nothing
+        CSPrereqs& operator+=(const CSPrereqs& addend);
+
+        // undo an earlier addition (e.g., of a subrun that's since been
+        // blacklisted)
+        CSPrereqs& operator-=(const CSPrereqs& subtrahend);
+
+        // free the histogram contents, keeping the counters
+        void clearHistos();
 
         Target target;     // physical data for this target
         double monitorCounts = 0;// target-specific counts on monitor for a subrun
@@ -34,12 +56,17 @@ class CSPrereqs
         double totalMacroNumber = 0;
         double totalEventNumber = 0;
 
-        TH1D* energyHisto = 0; // target-specific energy histo, corrected for deadtime
-        TH1D* TOFHisto = 0; // target-specific energy histo, corrected for deadtime
-        TH1D* uncorrectedTOFHisto = 0; // target-specific energy histo, uncorrected for deadtime
+        WeightedHisto1D energy; // target-specific energy histo, corrected for deadtime
+        WeightedHisto1D TOF; // target-specific TOF histo, corrected for deadtime
+        WeightedHisto1D uncorrectedTOF; // target-specific TOF histo, uncorrected for deadtime
 
 };
 
+// Sum a list of CSPrereqs (of the same target) in a fixed pairwise tree, so
+// that the result is independent of how the list was produced (e.g., by how
+// many threads). The inputs are consumed; the list must not be empty.
+CSPrereqs sumPairwise(std::vector<CSPrereqs>& prereqs);
+
 void extractGraphData(
         TGraphAsymmErrors* graph,
         std::vector<double>* xValues,
@@ -55,8 +82,19 @@ double calculateRMS(std::vector<double> graph1Data, std::vector<double> graph2Da
 
 DataSet scale(DataSet setToScale, DataSet expReference, DataSet litReference);
 
-int readTargetData(std::vector<CSPrereqs>& allCSPrereqs, std::string expName);
+int readTargetData(std::vector<CSPrereqs>& allCSPrereqs, std::string expName, const Config& config);
+
+// returns 1 if the subrun is on the experiment's blacklist (or the blacklist
+// can't be read)
+int checkBlacklist(std::string expName, int runNumber, int subRun);
+
+// <dataLocation>/<runNumber>/<subRun, as 4 digits>/
+std::string getSubRunLocation(std::string dataLocation, int runNumber, int subRun);
+
+// latest modification time of the subrun files readSubRun reads, or -1 if
+// any is missing
+long getSubRunSourceTime(std::string dataLocation, int runNumber, int subRun);
 
-int readSubRun(CSPrereqs& subRunData, std::string expName, int runNumber, int subRun, std::string detectorName, std::string dataLocation);
+int readSubRun(CSPrereqs& subRunData, std::string expName, int runNumber, int subRun, std::string detectorName, std::string dataLocation, const Config& config, bool useEventColumns=false);
 
 #endif
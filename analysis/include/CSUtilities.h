@@ -68,6 +68,34 @@ void scaledownCS(std::string CSToBeCorrectedFileName, std::string CSToBeCorrecte
 
 void produceRunningRMS(DataSet firstDS, DataSet secondDS, std::string name);
 
+// In-memory forms of the utilities above, on data sets as read from their
+// graphs. Where the utilities read one graph at another's energies, these
+// interpolate with DataSet::evaluate. Nothing here touches ROOT files or
+// directories, so independent calls can run concurrently.
+DataSet mergeDataSets(const DataSet& firstDS, double juncture, const DataSet& secondDS);
+
+DataSet subtractDataSets(const DataSet& rawCSData, const DataSet& subtrahend,
+                         double factor,  // multiplies the subtrahend
+                         double divisor  // divides the final difference
+                        );
+
+// firstCSData and secondCSData are set to the points compared (as used for
+// the running RMS)
+DataSet relativeDataSets(const DataSet& firstCSDataRaw, const DataSet& secondCSDataRaw,
+                         DataSet& firstCSData, DataSet& secondCSData);
+
+DataSet relativeDiffDataSets(const DataSet& firstCSDataRaw, const DataSet& secondCSDataRaw,
+                             DataSet& firstCSData, DataSet& secondCSData);
+
+DataSet correctDataSet(const DataSet& CSCorrection, const DataSet& CSToBeCorrectedData);
+
+DataSet scaledownDataSet(const DataSet& CSToBeCorrectedData, int scaledown);
+
+DataSet calculateRunningRMS(const DataSet& firstDS, const DataSet& secondDS);
+
+// print the total RMS and write <name>rms to the current directory
+void writeRunningRMS(const DataSet& rms, std::string name);
+
 int produceTotalCSPlots(std::string dataLocation, std::vector<CrossSection>& crossSections);
 
 #endif /* CS_UTILITIES_H */
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 
+#include "config.h"
+
 struct GammaEvent
 {
     GammaEvent() {}
@@ -23,6 +25,6 @@ struct GammaCorrection
 };
 
 int calculateGammaCorrection(std::string inputFileName, std::ofstream& log, std::string treeName,
-        std::string outputFileName);
+        std::string outputFileName, const Config& config);
 
 #endif /* GAMMA_CORRECTION_H */
@@ -4,12 +4,14 @@
 #include <string>
 #include <utility>
 #include "dataStructures.h"
+#include "config.h"
 
 int assignEventsToMacropulses(
         std::string inputFileName,
         std::string outputFileName,
         std::ofstream& log,
-        std::vector<MacropulseEvent>& macropulseList);
+        std::vector<MacropulseEvent>& macropulseList,
+        const Config& config);
 
 #endif /* ASSIGN_EVENTS_TO_MACROPULSES_H */
 
@@ -0,0 +1,96 @@
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+#include <vector>
+#include <string>
+
+#include "CSPrereqs.h"
+#include "crossSection.h"
+
+// Spread of one target's cross section over bootstrap replicas, per energy
+// bin (indexed like the energy histogram's bins; entries 0 and nBins+1 are
+// unused). Bins where fewer than two replicas gave a cross section have
+// validReplicas<2 and zero spread.
+struct BootstrapErrors
+{
+    std::string targetName;
+
+    std::vector<double> mean;
+    std::vector<double> standardDeviation;
+
+    // central 68.3% interval of the replicas' cross sections
+    std::vector<double> lower;
+    std::vector<double> upper;
+
+    std::vector<int> validReplicas;
+};
+
+// Per-subrun inputs to the cross section calculation (monitor counts and
+// energy-binned detector counts of each target), held in memory so that
+// bootstrap replicas - each a resampling of the subruns, with replacement -
+// are summed from plain arrays without rereading any subrun files.
+//
+// Each target's counts are stored as one contiguous array of rows, one row
+// per subrun.
+class SubRunBootstrap
+{
+    public:
+        SubRunBootstrap() {}
+
+        // Add one subrun's CSPrereqs (with energy histograms filled). Targets
+        // are matched by name; a target's data is skipped if CSPrereqs
+        // addition would skip it. Returns 1 if the energy binning differs
+        // from that of earlier subruns.
+        int addSubRun(const std::vector<CSPrereqs>& subRunData);
+
+        int getNumberOfSubRuns() const;
+        const WeightedHisto1D& getEnergyBinning() const;
+
+        // sums over all subruns, in the order targets were first seen
+        std::vector<CSPrereqs> getTotals() const;
+
+        // Resample the subruns numberOfReplicas times and compute each
+        // target's cross section (relative to the blank, as in
+        // CrossSection::calculateCS) for each replica. Replica i draws from
+        // a generator seeded with (seed, i), so the results don't depend on
+        // the number of threads. Returns 1 if there's no blank.
+        int resample(int numberOfReplicas, unsigned long seed, unsigned int numberOfThreads,
+                std::vector<BootstrapErrors>& errors) const;
+
+    private:
+        int findTarget(std::string targetName) const;
+        int getBlankIndex() const;
+
+        // each target's Target description (with no histogram contents)
+        std::vector<CSPrereqs> targets;
+
+        // binning of the energy histograms
+        WeightedHisto1D energyBinning;
+        int rowLength = 0; // nBins+2
+
+        int numberOfSubRuns = 0;
+
+        // [target][subRun]
+        std::vector<std::vector<double>> monitorCounts;
+
+        // [target][subRun*rowLength + bin]
+        std::vector<std::vector<double>> energyCounts;
+
+        // counters that don't enter the bootstrap, summed over all subruns
+        std::vector<double> goodMacroNumbers;
+        std::vector<double> totalMacroNumbers;
+        std::vector<double> totalEventNumbers;
+};
+
+// Nominal cross section of each target (from the sums over all subruns, with
+// analytic errors), written next to its bootstrap errors to the current
+// directory:
+//   <target>StatErrors        analytic statistical errors
+//   <target>Bootstrap         bootstrap standard deviation
+//   <target>BootstrapBand     central 68.3% interval of the replicas
+//   <target>BootstrapToStat   ratio of bootstrap to analytic errors
+void writeBootstrapErrors(std::vector<CrossSection>& crossSections,
+        const std::vector<BootstrapErrors>& errors,
+        const WeightedHisto1D& energyBinning);
+
+#endif /* BOOTSTRAP_H */
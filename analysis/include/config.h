@@ -16,6 +16,8 @@ struct AnalysisConfig
         std::string PASSED_VETO_FILE_NAME;
         std::string HISTOGRAM_FILE_NAME;
         std::string ENERGY_PLOTS_FILE_NAME;
+        std::string GATED_EVENTS_FILE_NAME; // optional; empty if per-event columns are not kept
+        std::string TEMPLATE_TIMING_FILE_NAME; // optional; empty to skip template timing
 
         std::string DPP_TREE_NAME;
         std::string WAVEFORM_TREE_NAME;
@@ -128,6 +130,30 @@ struct PlotConfig
         int NUMBER_ENERGY_BINS;    // for plots with energy units as abscissa
 };
 
+// What a digitizer channel records, from its name in the channel map
+enum class ChannelRole
+{
+    UNUSED,         // "-"
+    MACRO_TIME,     // "macroTime"
+    TARGET_CHANGER, // "targetChanger"
+    MONITOR,        // the monitor tree name
+    VETO,           // "veto"
+    DETECTOR        // any other name
+};
+
+// Channel roles, resolved once per run into tables indexed by channel number,
+// so that per-event code doesn't compare channel names
+struct ChannelConfig
+{
+    public:
+        ChannelConfig() {}
+        ChannelConfig(const DigitizerConfig& digitizer, const CSConfig& cs, const AnalysisConfig& analysis);
+
+        std::vector<ChannelRole> ROLES;
+        std::vector<int> DETECTOR_NUMBERS; // position in DETECTOR_NAMES, or -1 if not a cross section detector
+        std::vector<bool> NEEDS_FINE_TIME; // detector and veto channels get a fine time (CFD or zero-crossing)
+};
+
 struct Config
 {
     public:
@@ -143,8 +169,7 @@ struct Config
         PlotConfig plot;
         DigitizerConfig digitizer;
         TimeConfig time;
+        ChannelConfig channels;
 };
 
-extern Config config;
-
 #endif /* EXPERIMENTAL_CONFIG_H */
@@ -0,0 +1,49 @@
+#ifndef CONFIG_REGISTRY_H
+#define CONFIG_REGISTRY_H
+
+#include "config.h"
+#include "experiment.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// An experiment's config files, each read once into a table indexed by run
+// range. Config snapshots are immutable and shared: runs whose parameters
+// come from the same line of every file get the same Config. Snapshots may be
+// requested from several threads at once.
+class ConfigRegistry
+{
+    public:
+        ConfigRegistry(std::string expName);
+
+        std::shared_ptr<const Config> getConfig(int runNumber);
+
+    private:
+        std::string expName;
+
+        // not indexed by run
+        AnalysisConfig analysis;
+        DeadtimeConfig deadtime;
+
+        RunRangeTable facilityTable;
+        RunRangeTable softwareCFDTable;
+        RunRangeTable targetGatesTable;
+        RunRangeTable targetOrderTable;
+        RunRangeTable csTable;
+        RunRangeTable plotTable;
+        RunRangeTable digitizerTable;
+        RunRangeTable channelMapTable;
+        RunRangeTable timeTable;
+
+        // snapshots by the line each table gives a run
+        std::map<std::vector<int>, std::shared_ptr<const Config>> snapshots;
+        std::mutex snapshotsMutex;
+};
+
+// Registry for the given experiment, created once per process
+ConfigRegistry& getConfigRegistry(std::string expName);
+
+#endif /* CONFIG_REGISTRY_H */
@@ -5,6 +5,6 @@
 #include <string>
 #include "CSPrereqs.h"
 
-int correctForBackground(CSPrereqs& p);
+int correctForBackground(CSPrereqs& p, const Config& config);
 
 #endif /* CORRECT_FOR_BACKGROUND_H */
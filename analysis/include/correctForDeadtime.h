@@ -2,6 +2,7 @@
 #define CORRECT_FOR_DEADTIME_H
 
 #include "GammaCorrection.h"
+#include "config.h"
 
 #include "TH1.h"
 
@@ -9,8 +10,15 @@
 #include <string>
 #include <vector>
 
-int generateDeadtimeCorrection(std::string inputFileName, std::ofstream& log, std::string outputFileName);
+int generateDeadtimeCorrection(std::string inputFileName, std::ofstream& log, std::string outputFileName, const Config& config);
 
-int applyDeadtimeCorrection(std::string inputFileName, std::string deadtimeHistoFileName, std::string macroFileName, std::string gammaCorrectionFileName, std::ofstream& log, std::string outputFileName);
+int readAverageGammaTime(std::string gammaCorrectionFileName, double& averageGammaTime, const Config& config);
+
+// Correct TOF (into correctedTOF, usually a clone of TOF) for deadtime, using a
+// deadtime histogram from generateDeadtimeCorrection. The TOF binning may differ
+// from the deadtime histogram's, e.g. when re-histogramming from event columns.
+void correctTOFForDeadtime(TH1D* TOF, TH1D* deadtimeHisto, double averageGammaTime, double numberOfMicros, TH1D* correctedTOF);
+
+int applyDeadtimeCorrection(std::string inputFileName, std::string deadtimeHistoFileName, std::string macroFileName, std::string gammaCorrectionFileName, std::ofstream& log, std::string outputFileName, const Config& config);
 
 #endif /* CORRECT_FOR_DEADTIME_H */
@@ -17,21 +17,27 @@ class CrossSection
         void addDataPoint(DataPoint dataPoint);
         void addDataSet(DataSet dataSet);
         DataPoint getDataPoint(int i) const;
-        DataSet getDataSet();
+        const DataSet& getDataSet() const;
         void createGraph(std::string name, std::string title);
         void createStatErrorsGraph(std::string name, std::string title);
         void createSysErrorsGraph(std::string name, std::string title);
 
+        // tree of the counts behind each point (and the areal density), from
+        // which correlated statistical errors can be propagated (see toyMC.h)
+        void createCountsTree(std::string name);
+
         int getNumberOfPoints() const;
-        std::vector<double> getEnergyValues() const;
-        std::vector<double> getEnergyErrors() const;
-        std::vector<double> getEnergyErrorsL() const;
-        std::vector<double> getEnergyErrorsR() const;
 
-        std::vector<double> getCrossSectionValues() const;
-        std::vector<double> getCrossSectionErrors() const;
-        std::vector<double> getStatErrors() const;
-        std::vector<double> getSysErrors() const;
+        // columns of the underlying data set (no copies)
+        const std::vector<double>& getEnergyValues() const;
+        const std::vector<double>& getEnergyErrors() const;
+        const std::vector<double>& getEnergyErrorsL() const;
+        const std::vector<double>& getEnergyErrorsR() const;
+
+        const std::vector<double>& getCrossSectionValues() const;
+        const std::vector<double>& getCrossSectionErrors() const;
+        const std::vector<double>& getStatErrors() const;
+        const std::vector<double>& getSysErrors() const;
 
         double getArealDensity() const;
         void setArealDensity(double arealDensity);
@@ -43,7 +49,7 @@ class CrossSection
 
         double calculateRMSError();
 
-        void calculateCS(const CSPrereqs& targetData, const CSPrereqs& blankData);
+        void calculateCS(const CSPrereqs& targetData, const CSPrereqs& blankData, const Config& config);
 
         std::string name;
 
@@ -52,5 +58,8 @@ class CrossSection
         double arealDensity;
 };
 
+// areal density (atoms/cm^2) of a cylindrical target
+double calculateArealDensity(const Target& target);
+
 double getPartialError(DataPoint aPoint, DataPoint bPoint, double aArealDensity);
 #endif
@@ -0,0 +1,70 @@
+#ifndef CS_RECIPE_H
+#define CS_RECIPE_H
+
+#include <vector>
+#include <string>
+
+// A graph in a ROOT file
+struct GraphLocation
+{
+    std::string fileName;
+    std::string graphName;
+
+    bool operator<(const GraphLocation& other) const;
+    bool operator==(const GraphLocation& other) const;
+};
+
+// cross section utilities a recipe can use
+enum class CSOperation
+{
+    SUBTRACT,   // subtractCS
+    SHIFT,      // shiftCS
+    MULTIPLY,   // multiplyCS
+    RELATIVE,   // relativeCS
+    RELATIVE_DIFF, // relativeDiffCS
+    MERGE,      // mergeCS
+    CORRECT,    // applyCSCorrectionFactor
+    SCALEDOWN   // scaledownCS
+};
+
+// One line of a recipe: a utility, with the graphs it reads and writes and
+// its numerical arguments, as given on its command line
+struct RecipeStep
+{
+    CSOperation operation;
+    std::string command; // as written, for messages
+    int lineNumber;
+
+    std::vector<GraphLocation> inputs;
+    std::vector<GraphLocation> outputs; // main output first
+
+    double parameter; // factor, shift, juncture or scaledown (if any)
+    double divisor;   // subtractCS only
+};
+
+// Read a recipe: lines as in the plot scripts, each calling one of the cross
+// section utilities with the same arguments as its binary, e.g.
+//
+//   ../bin/relativeDiffCS "$expFile" "Sn124" "$expFile" "Sn112" "$outFile" "Sn124Sn112"
+//
+// Only the utility's name counts (not the path to its binary). Variables are
+// assigned as in the shell (name="value") and expanded with $name or
+// ${name}, in double quotes or bare words; single quotes are taken
+// literally. A line ending in an unquoted backslash continues on the next
+// line. Blank lines and lines starting with # are skipped, so the
+// plot scripts themselves are recipes, as long as they use no other shell
+// features (loops, command substitution, calls to other scripts).
+// A fileName of "-" reads standard input. Returns 1 on any error.
+int readCSRecipe(std::string fileName, std::vector<RecipeStep>& steps);
+
+// Evaluate a recipe in memory, with the same results as running its lines
+// in order:
+//  - every graph read from a file is read once, before anything else;
+//  - a graph written by an earlier line is taken from memory instead;
+//  - lines whose inputs are ready are evaluated together, on up to
+//    numberOfThreads threads;
+//  - all outputs are written at the end, opening each output file once.
+// Returns 1 (writing nothing) if any input graph is missing.
+int evaluateCSRecipe(const std::vector<RecipeStep>& steps, unsigned int numberOfThreads);
+
+#endif /* CS_RECIPE_H */
@@ -4,6 +4,7 @@
 #include "TFile.h"
 #include "TGraphAsymmErrors.h"
 #include <sstream>
+#include <vector>
 #include "../include/dataPoint.h"
 
 class DataSet
@@ -23,8 +24,15 @@ class DataSet
         void setReference(std::string reference);
 
         void addPoint(DataPoint dataPoint);
+        void reserve(int numberOfPoints);
+
+        // point i, assembled from the columns below
         DataPoint getPoint(int i) const;
 
+        // y at xValue, interpolated linearly between the neighboring points
+        // (as TGraph::Eval does); points must be in increasing x
+        double evaluate(double xValue) const;
+
         friend const DataSet operator+(const DataSet& set1, const DataSet& set2);
         friend const DataSet operator-(const DataSet& set1, const DataSet& set2);
         friend const DataSet operator*(const DataSet& set1, const DataSet& set2);
@@ -40,15 +48,23 @@ class DataSet
         const DataSet divideBy(const DataSet& set2, const std::string& name);
         DataSet merge(DataSet set2);
 
-        std::vector<double> getXValues() const;
-        std::vector<double> getXErrors() const;
-        std::vector<double> getXErrorsL() const;
-        std::vector<double> getXErrorsR() const;
+        // Columns of per-point values, one entry per point. These refer to
+        // the data set's own storage (no copies), and are invalidated by
+        // adding points.
+        const std::vector<double>& getXValues() const;
+        const std::vector<double>& getXErrors() const; // same as getXErrorsL
+        const std::vector<double>& getXErrorsL() const;
+        const std::vector<double>& getXErrorsR() const;
+
+        const std::vector<double>& getYValues() const;
+        const std::vector<double>& getYErrors() const;
+        const std::vector<double>& getStatErrors() const;
+        const std::vector<double>& getSysErrors() const;
 
-        std::vector<double> getYValues() const;
-        std::vector<double> getYErrors() const;
-        std::vector<double> getStatErrors() const;
-        std::vector<double> getSysErrors() const;
+        const std::vector<double>& getBlankMonitorCounts() const;
+        const std::vector<double>& getTargetMonitorCounts() const;
+        const std::vector<double>& getBlankDetCounts() const;
+        const std::vector<double>& getTargetDetCounts() const;
 
         TGraphAsymmErrors* createPlot(std::string name);
         TGraphAsymmErrors* createStatErrorsPlot(std::string name);
@@ -56,12 +72,45 @@ class DataSet
 
         TGraphAsymmErrors* createPlot(std::string name, TFile* file);
     private:
+        // size every column to numberOfPoints zero-filled points
+        void resize(int numberOfPoints);
 
         TGraphAsymmErrors* dataPlot;
 
         std::string reference;
 
-        std::vector<DataPoint> data;
+        // point data, stored by column
+        std::vector<double> xValues;
+        std::vector<double> xErrorsL;
+        std::vector<double> xErrorsR;
+
+        std::vector<double> yValues;
+        std::vector<double> yErrors;
+        std::vector<double> statErrors;
+        std::vector<double> sysErrors;
+
+        std::vector<double> blankMonitorCounts;
+        std::vector<double> targetMonitorCounts;
+        std::vector<double> blankDetCounts;
+        std::vector<double> targetDetCounts;
 };
 
+// read a whole file into contents; returns 1 if it can't be read
+int readFileContents(const std::string& fileName, std::string& contents);
+
+// Parse the contents of a literature data file: three header lines (the
+// second is the reference), then (energy, cross section, error) triples,
+// up to the first incomplete triple.
+void parseLitData(const std::string& contents, std::string& reference,
+        std::vector<double>& energies, std::vector<double>& crossSections,
+        std::vector<double>& errors);
+
+// Average literature points (in increasing energy) into energy bins, given
+// by their edges. Each non-empty bin gives one point at the bin's center,
+// with the mean cross section and mean error of the points in it.
+void binLitData(const std::vector<double>& energies, const std::vector<double>& crossSections,
+        const std::vector<double>& errors, const std::vector<double>& energyBins,
+        std::vector<double>& binEnergies, std::vector<double>& binCrossSections,
+        std::vector<double>& binErrors);
+
 #endif
@@ -0,0 +1,63 @@
+#ifndef ENERGY_REBINNER_H
+#define ENERGY_REBINNER_H
+
+#include <vector>
+#include <string>
+
+#include "TH1D.h"
+
+#include "config.h"
+
+// Sparse linear operator that rebins a uniformly-binned TOF histogram into
+// energy bins.
+//
+// Counts are assumed to be spread uniformly in time across each TOF bin. Each
+// TOF bin contributes to every energy bin its time interval overlaps, in
+// proportion to the overlap; most TOF bins map entirely into a single energy
+// bin, and only bins straddling an energy bin edge are split. Portions of a TOF
+// bin above the highest (below the lowest) energy edge go to the overflow
+// (underflow) bin; portions shorter than the flight time of light are dropped.
+
+class EnergyRebinner
+{
+    public:
+        EnergyRebinner() {}
+        EnergyRebinner(double flightDistance, int numberOfTOFBins,
+                double TOFLowerBound, double TOFUpperBound,
+                const std::vector<double>& energyBinEdges);
+
+        const std::vector<double>& getEnergyBinEdges() const;
+        int getNumberOfEnergyBins() const;
+
+        // TOFCounts and the returned energy counts are indexed like ROOT bins
+        // (0 = underflow, 1 to n, n+1 = overflow)
+        std::vector<double> rebin(const std::vector<double>& TOFCounts) const;
+
+        // rebin a TOF histogram; bin errors are set to sqrt(content)
+        TH1D* rebin(TH1D* TOFHisto, std::string name) const;
+
+    private:
+        struct Element
+        {
+            int energyBin;
+            double fraction;
+        };
+
+        int numberOfTOFBins = 0;
+        std::vector<double> energyBinEdges;
+
+        // compressed sparse rows: row j (TOF bin j) is
+        // elements[rowStart[j]] to elements[rowStart[j+1]-1]
+        std::vector<long> rowStart;
+        std::vector<Element> elements;
+};
+
+// Rebinner for TOF histograms with the given binning, using config's flight
+// distance and energy binning. Rebinners are built once and cached per (flight
+// distance, TOF binning, energy binning).
+const EnergyRebinner& getEnergyRebinner(int numberOfTOFBins,
+        double TOFLowerBound, double TOFUpperBound, const Config& config);
+
+const EnergyRebinner& getEnergyRebinner(TH1D* TOFHisto, const Config& config);
+
+#endif /* ENERGY_REBINNER_H */
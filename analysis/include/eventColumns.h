@@ -0,0 +1,57 @@
+#ifndef EVENT_COLUMNS_H
+#define EVENT_COLUMNS_H
+
+#include <vector>
+#include <string>
+
+#include "TDirectory.h"
+
+#include "fastHisto.h"
+#include "config.h"
+
+// Compact per-event record of a detector's events, one vector per quantity.
+// fillCSHistos records every detector event in a good macropulse (after the
+// gamma time correction, but before the charge, micropulse and veto gates),
+// so that TOF histograms with any binning and any of those gates can be
+// rebuilt later without reprocessing the subrun.
+//
+// Columns are persisted as a TTree of plain leaves (one branch per column)
+// under the detector's directory.
+
+class EventColumns
+{
+    public:
+        EventColumns() {}
+
+        inline void push_back(double time, int micro, int macro, int charge,
+                int target, bool veto)
+        {
+            microTime.push_back(time);
+            microNo.push_back(micro);
+            macroNo.push_back(macro);
+            lgQ.push_back(charge);
+            targetPos.push_back(target);
+            vetoed.push_back(veto);
+        }
+
+        long size() const;
+        void clear();
+
+        // write to the current directory
+        int write(std::string name) const;
+        int read(TDirectory* directory, std::string name);
+
+        std::vector<float> microTime; // time since start of micropulse, in ns
+        std::vector<short> microNo;
+        std::vector<int> macroNo;
+        std::vector<int> lgQ;
+        std::vector<unsigned char> targetPos;
+        std::vector<unsigned char> vetoed;
+};
+
+// Histogram events into one TOF histogram per target position of the run
+// config, using its TOF binning and charge, micropulse and veto gates. Events
+// are scanned in parallel.
+std::vector<FastHisto1D> fillTOFHistos(const EventColumns& events, const Config& config);
+
+#endif /* EVENT_COLUMNS_H */
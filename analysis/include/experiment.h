@@ -7,6 +7,41 @@
 #include <string>
 #include <utility>
 
+// A run-indexed experiment config file (e.g., channelMap.txt): each data line
+// starts with a run range ("low-high", or a single run) followed by that
+// range's parameters; lines not starting with a run number are comments.
+// Runs are looked up by binary search over the intervals the ranges split
+// the runs into. Where ranges overlap, the earliest line wins.
+class RunRangeTable
+{
+    public:
+        RunRangeTable() {}
+        RunRangeTable(std::string fileLocation, std::string description);
+
+        // parameters of the line covering runNumber (empty if none does)
+        const std::vector<std::string>& find(int runNumber) const;
+
+        // index of that line among the file's data lines, or -1
+        int findLine(int runNumber) const;
+
+        std::string getFileLocation() const;
+
+    private:
+        std::string fileLocation;
+        std::vector<std::vector<std::string>> lines;
+
+        // runs from intervalStarts[k] up to intervalStarts[k+1] are covered by
+        // line intervalLines[k] (-1 if none)
+        std::vector<int> intervalStarts;
+        std::vector<int> intervalLines;
+};
+
+// parameters of a channelMap.txt line, as (channel, name) pairs
+std::vector<std::pair<int, std::string>> makeChannelMap(const std::vector<std::string>& tokens);
+
+// parameters of a TargetConfig.txt line ("low-high" gates)
+std::vector<std::pair<int,int>> makeTargetGates(const std::vector<std::string>& tokens);
+
 std::vector<std::pair<int, std::string>> getChannelMap(std::string expName, int runNumber);
 std::vector<std::string> getTargetOrder(std::string expName, int runNumber);
 std::vector<std::pair<std::string,std::string>> getRelativePlotNames(std::string expName,std::string fileName);
@@ -0,0 +1,218 @@
+#ifndef FAST_HISTO_H
+#define FAST_HISTO_H
+
+#include <vector>
+#include <string>
+#include <functional>
+
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TH2I.h"
+
+// Lightweight histograms with fixed, uniform binning and integer counters.
+// These are meant for the event-filling hot loops: each worker thread fills
+// its own private copy over a range of events, the copies are reduced with
+// add(), and only the final, reduced histogram is converted to a ROOT
+// histogram at write time.
+//
+// Bin numbering follows ROOT's convention: bin 0 is the underflow bin, bins
+// 1 to nBins cover [low, high), and bin nBins+1 is the overflow bin. Because
+// bin contents are integers, the reduced counts are identical to those of a
+// serial fill regardless of how events were split between threads.
+
+struct FastAxis
+{
+    FastAxis() {}
+    FastAxis(int n, double l, double h) : nBins(n), low(l), high(h), width(h-l) {}
+
+    // same arithmetic as TAxis::FindBin, so that edge cases round identically
+
+    inline int findBin(double x) const
+    {
+        if(x<low)
+        {
+            return 0;
+        }
+
+        if(!(x<high))
+        {
+            return nBins+1;
+        }
+
+        return 1+(int)(nBins*(x-low)/width);
+    }
+
+    int nBins = 0;
+    double low = 0;
+    double high = 0;
+    double width = 0;
+};
+
+class FastHisto1D
+{
+    public:
+        FastHisto1D() {}
+        FastHisto1D(std::string name, std::string title, int nBins, double low, double high);
+
+        inline void fill(double x)
+        {
+            counts[axis.findBin(x)]++;
+            entries++;
+        }
+
+        void add(const FastHisto1D& h);
+        void reset();
+
+        long getBinContent(int bin) const;
+        long getEntries() const;
+        int getNBins() const;
+        const FastAxis& getAxis() const;
+
+        TH1D* toTH1D() const;
+
+    private:
+        std::string name;
+        std::string title;
+
+        FastAxis axis;
+
+        long entries = 0;
+        std::vector<long> counts;
+};
+
+// Histogram with double-valued bin contents (e.g., deadtime-corrected counts),
+// held by value in one contiguous buffer: copies are deep, moves are cheap, and
+// nothing is registered with ROOT. Meant for summing and transforming data
+// across many subruns; convert to a ROOT histogram only for output. Bins are
+// either uniform or given by explicit edges, and are numbered like ROOT's.
+class WeightedHisto1D
+{
+    public:
+        WeightedHisto1D() {}
+        WeightedHisto1D(int nBins, double low, double high);
+        WeightedHisto1D(const std::vector<double>& binEdges);
+
+        // binning, contents (including under- and overflow) and entries of a
+        // ROOT histogram
+        explicit WeightedHisto1D(const TH1* histo);
+        explicit WeightedHisto1D(const FastHisto1D& histo);
+
+        double getBinContent(int bin) const { return contents[bin]; }
+        void setBinContent(int bin, double content) { contents[bin] = content; }
+
+        // contents, indexed like ROOT bins (0 = underflow, nBins+1 = overflow)
+        const std::vector<double>& getContents() const { return contents; }
+        std::vector<double>& getContents() { return contents; }
+
+        double getEntries() const { return entries; }
+        void setEntries(double e) { entries = e; }
+
+        int getNBins() const;
+        double getLowEdge() const;
+        double getHighEdge() const;
+        double getBinCenter(int bin) const;
+
+        bool empty() const { return contents.empty(); }
+        bool sameBinning(const WeightedHisto1D& h) const;
+
+        // add weight*h bin by bin; an empty histogram takes h's binning.
+        // Returns 1 (and leaves this unchanged) if the binnings differ.
+        int add(const WeightedHisto1D& h, double weight=1);
+
+        // new ROOT histogram in the current directory
+        TH1D* toTH1D(std::string name, std::string title) const;
+
+    private:
+        FastAxis axis;
+        std::vector<double> edges; // empty for uniform binning
+        std::vector<double> contents;
+        double entries = 0;
+};
+
+// 2D histograms (charge correlations, TOF vs. charge "triangles", and the like)
+// are large but mostly empty. FastHisto2D stores its 32-bit counters in square
+// blocks of BLOCK_SIZE x BLOCK_SIZE bins that are only allocated once a bin in
+// that block is filled, so memory use scales with the occupied region of the
+// histogram rather than its full size.
+class FastHisto2D
+{
+    public:
+        FastHisto2D() {}
+        FastHisto2D(std::string name, std::string title,
+                int nBinsX, double lowX, double highX,
+                int nBinsY, double lowY, double highY);
+
+        inline void fill(double x, double y)
+        {
+            int binX = xAxis.findBin(x);
+            int binY = yAxis.findBin(y);
+
+            std::vector<int>& block = blocks[(binX>>BLOCK_BITS)+blocksX*(binY>>BLOCK_BITS)];
+            if(block.empty())
+            {
+                block.assign(BLOCK_SIZE*BLOCK_SIZE, 0);
+            }
+
+            block[(binX&BLOCK_MASK)+BLOCK_SIZE*(binY&BLOCK_MASK)]++;
+            entries++;
+        }
+
+        void add(const FastHisto2D& h);
+        void reset();
+
+        long getBinContent(int binX, int binY) const;
+        long getEntries() const;
+
+        // number of bins currently allocated (for memory diagnostics)
+        long getAllocatedBins() const;
+
+        // integer-valued ROOT histogram; use for writing to file
+        TH2I* toTH2I() const;
+
+        // double-valued ROOT histogram, for callers that need one
+        TH2D* toTH2D() const;
+
+        // write to the current directory as a TH2I; the ROOT copy is deleted
+        // once written
+        void write() const;
+
+    private:
+        template<class H> H* toROOTHisto() const;
+
+        static const int BLOCK_BITS = 5;
+        static const int BLOCK_SIZE = 1<<BLOCK_BITS;
+        static const int BLOCK_MASK = BLOCK_SIZE-1;
+
+        std::string name;
+        std::string title;
+
+        FastAxis xAxis;
+        FastAxis yAxis;
+
+        int blocksX = 0;
+        int blocksY = 0;
+
+        long entries = 0;
+        std::vector<std::vector<int>> blocks;
+};
+
+// number of worker threads to use for histogram filling (at least 1); 1 when
+// called from work running on fillInParallel's or runInParallel's threads
+unsigned int getNumberOfThreads();
+
+// Split the index range [0, numberOfEntries) into contiguous chunks, one per
+// thread, and call fillRange(threadIndex, begin, end) for each chunk on its own
+// thread. Returns after all threads have finished.
+//
+// Pools don't nest: called from work already running on a pool thread, this
+// and runInParallel run serially on the calling thread.
+void fillInParallel(long numberOfEntries, unsigned int numberOfThreads,
+        const std::function<void(unsigned int, long, long)>& fillRange);
+
+// Run task(i) for each i in [0, numberOfTasks) on a pool of threads. Tasks are
+// handed out one at a time, so this suits tasks of uneven duration (e.g.,
+// reading files); tasks must be independent of one another.
+void runInParallel(long numberOfTasks, unsigned int numberOfThreads,
+        const std::function<void(long)>& task);
+
+#endif /* FAST_HISTO_H */
@@ -0,0 +1,40 @@
+#ifndef FIGURE_RENDERER_H
+#define FIGURE_RENDERER_H
+
+#include <vector>
+#include <string>
+
+// A figure: a ROOT macro (e.g., one of those in prettyPrint) that draws one or
+// more canvases, and the ROOT files it reads
+struct Figure
+{
+    std::string macroFileName;
+    std::vector<std::string> inputFileNames;
+};
+
+// Read a macro and find its inputs: every string literal naming a .root file
+// (relative names are taken relative to the macro's directory, where it's
+// run). Returns 1 if the macro can't be read.
+int findFigureInputs(std::string macroFileName, Figure& figure);
+
+// Set up and select the common figure style (graphStyle, as created by the
+// macros)
+void setGraphStyle();
+
+// Render figures headlessly, saving each canvas a macro draws to
+// <outputDirectory>/<macro name>[_<canvas name>].<format>, for each format.
+//
+// The parent process sets up ROOT and the style once, asks the kernel to
+// read the figures' input files ahead (so each file is read from disk once
+// and then shared between workers from the page cache), then forks a worker
+// process per figure, with up to numberOfWorkers running at once; ROOT isn't
+// thread-safe, but forked workers are independent.
+//
+// A figure is skipped if its macro, the sizes and modification times of its
+// inputs, and the formats are the same as when it was last rendered, and its
+// outputs still exist (as recorded in <outputDirectory>/renderStamps.txt).
+// Returns 1 if any figure failed to render.
+int renderFigures(const std::vector<Figure>& figures, std::string outputDirectory,
+        const std::vector<std::string>& formats, unsigned int numberOfWorkers);
+
+#endif /* FIGURE_RENDERER_H */
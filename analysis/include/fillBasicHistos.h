@@ -3,7 +3,8 @@
 
 #include "TH1D.h"
 #include "plots.h"
+#include "config.h"
 
-int fillBasicHistos(std::string inputFileName, std::ofstream& log, std::string outputFileName);
+int fillBasicHistos(std::string inputFileName, std::ofstream& log, std::string outputFileName, const Config& config);
 
 #endif /* FILL_BASIC_HISTOS_H */
@@ -6,10 +6,10 @@
 
 #include "../include/GammaCorrection.h"
 
-int fillCSHistos(std::string vetoedInputFileName, std::string nonVetoInputFileName, bool useVetoPaddle, std::string macropulseFileName, std::string gammaCorrectionFileName, std::ofstream& log, std::string outputFileName);
+int fillCSHistos(std::string vetoedInputFileName, std::string nonVetoInputFileName, bool useVetoPaddle, std::string macropulseFileName, std::string gammaCorrectionFileName, std::ofstream& log, std::string outputFileName, std::string eventColumnsFileName, const Config& config);
 
 int fillMonitorHistos(std::string inputFileName, std::string macropulseFileName, std::ofstream& log, std::string outputFileName);
 
-TH1D* convertTOFtoEnergy(TH1D* tof, std::string name);
+TH1D* convertTOFtoEnergy(TH1D* tof, std::string name, const Config& config);
 
 #endif /* FILL_ADVANCED_HISTOS_H */
@@ -5,6 +5,6 @@
 #include "plots.h"
 
 int fillDiagnosticHistos(std::string inputFileName, std::string treeName, std::string outputFileName);
-TH1D* convertTOFtoEnergy(TH1D* tof, std::string name);
+TH1D* convertTOFtoEnergy(TH1D* tof, std::string name, const Config& config);
 
 #endif /* FILL_BASIC_HISTOS_H */
@@ -6,7 +6,8 @@
 #include <string>
 
 #include "dataStructures.h"
+#include "config.h"
 
-int identifyGoodMacros(std::string macropulseFileName, std::vector<MacropulseEvent>& macropulseList, std::ofstream& logFile);
+int identifyGoodMacros(std::string macropulseFileName, std::vector<MacropulseEvent>& macropulseList, std::ofstream& logFile, const Config& config);
 
 #endif /* IDENTIFY_GOOD_MACROS_H */
@@ -3,11 +3,13 @@
 
 #include <string>
 #include "../include/dataStructures.h"
+#include "../include/config.h"
 
 int identifyMacropulses(
         std::string inputFileName,
         std::string outputFileName,
         std::ofstream& logFile,
-        std::vector<MacropulseEvent>& macropulseList);
+        std::vector<MacropulseEvent>& macropulseList,
+        const Config& config);
 
 #endif /* IDENTIFY_MACROPULSES_H */
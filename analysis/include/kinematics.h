@@ -0,0 +1,82 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include <vector>
+#include <cmath>
+
+#include "config.h"
+
+// Neutron kinematics as a function of time of flight.
+//
+// KinematicsTable tabulates relativistic kinetic energy on a fine TOF grid
+// (NODES_PER_TOF_BIN nodes per TOF histogram bin) spanning the TOF plot range,
+// so that per-event and per-bin conversions need only a multiply, a floor,
+// and a linear interpolation. TOF histogram bin edges and bin centers fall
+// exactly on grid nodes. Times outside the tabulated range, and times before
+// the first grid node above the flight time of light, fall back to the exact
+// formula.
+//
+// Interpolation error is below one part in 10^6 for energies under 2 GeV; it
+// grows only within a few ns of the gamma flash, where the energy diverges.
+//
+// As with the exact formula, times shorter than the flight time of light
+// yield NaN.
+
+// exact conversion: TOF in ns, flight distance in cm, result in MeV
+double exactTOFToRKE(double TOF, double flightDistance);
+
+// exact inverse conversion: RKE in MeV, flight distance in cm, result in ns
+double exactRKEToTOF(double RKE, double flightDistance);
+
+class KinematicsTable
+{
+    public:
+        KinematicsTable() {}
+        KinematicsTable(double flightDistance, double TOFLowerBound,
+                double TOFUpperBound, int TOFBinsPerNs);
+
+        inline double tofToRKE(double TOF) const
+        {
+            double position = (TOF-lowerBound)*nodesPerNs;
+
+            if(!(position>=firstNode) || position>=lastNode)
+            {
+                return exactTOFToRKE(TOF, flightDistance);
+            }
+
+            long node = (long)position;
+            double fraction = position-node;
+
+            if(fraction==0)
+            {
+                return rKE[node];
+            }
+
+            return rKE[node]+fraction*(rKE[node+1]-rKE[node]);
+        }
+
+        // batch conversion of n times of flight
+        void tofToRKE(const double* TOF, double* RKE, long n) const;
+
+        double rKEToTOF(double RKE) const;
+
+        static const int NODES_PER_TOF_BIN = 10;
+
+    private:
+        double flightDistance = 0;
+        double lowerBound = 0;
+        double upperBound = 0;
+        int binsPerNs = 0;
+
+        double nodesPerNs = 0;
+        long firstNode = 0; // first node of the finite run ending at lastNode
+        long lastNode = 0;
+
+        std::vector<double> rKE;
+};
+
+// Table for config's flight distance and TOF binning. Tables are built once and
+// cached per (flight distance, TOF binning); safe to call from several threads.
+const KinematicsTable& getKinematicsTable(const Config& config);
+
+#endif /* KINEMATICS_H */
@@ -0,0 +1,59 @@
+#ifndef LITERATURE_CACHE_H
+#define LITERATURE_CACHE_H
+
+#include <vector>
+#include <string>
+
+#include "dataSet.h"
+
+// Binary cache of binned literature data sets, so that literature files
+// aren't re-parsed and re-binned when neither they nor the energy binning
+// have changed. Entries are keyed by a hash of the file's contents (and its
+// length) and a hash of the bin edges; a file that's renamed but unchanged
+// still hits.
+//
+// The cache holds the entries used since it was loaded; save() writes those
+// (so entries of files no longer read are dropped).
+class LiteratureCache
+{
+    public:
+        LiteratureCache() {}
+
+        // load <fileName>, if it exists and is a literature cache
+        LiteratureCache(std::string fileName);
+
+        // binned data set of a literature file with the given contents;
+        // returns 1 on a cache miss
+        int find(const std::string& contents, const std::vector<double>& energyBins, DataSet& dataSet);
+
+        void add(const std::string& contents, const std::vector<double>& energyBins, const DataSet& dataSet);
+
+        int save() const;
+
+    private:
+        struct Entry
+        {
+            unsigned long contentHash;
+            long contentLength;
+            unsigned long binningHash;
+            int numberOfBinEdges;
+
+            std::string reference;
+            std::vector<double> energies;
+            std::vector<double> crossSections;
+            std::vector<double> errors;
+        };
+
+        std::string fileName;
+
+        std::vector<Entry> storedEntries; // as loaded
+        std::vector<Entry> usedEntries;   // found or added since loading
+        bool changed = false;
+};
+
+// Binned literature data set for a file, from the cache if possible (parsing
+// and binning the file on a miss). Returns 1 if the file can't be read.
+int readLitDataSet(std::string litFileName, const std::vector<double>& energyBins,
+        LiteratureCache& cache, DataSet& dataSet);
+
+#endif /* LITERATURE_CACHE_H */
@@ -0,0 +1,75 @@
+#ifndef MACRO_COUNTER_H
+#define MACRO_COUNTER_H
+
+#include <vector>
+#include <string>
+#include <utility>
+
+#include "TDirectory.h"
+#include "TH1D.h"
+
+// Sparse per-macropulse counter: a list of (macroNo, counts) pairs, sorted by
+// macroNo, holding only macropulses that were actually seen. This replaces
+// the 500000-bin histograms previously used to count events (or monitor
+// events) per macropulse.
+//
+// Counters are persisted as a small TTree (branches "macroNo" and "counts")
+// under the counter's name, so they can be stored alongside the histograms in
+// each subrun's ROOT files and queried without scanning empty bins.
+
+class MacroCounter
+{
+    public:
+        MacroCounter() {}
+        MacroCounter(std::string name);
+
+        // Events usually arrive in increasing macroNo order, so filling is an
+        // append in the common case
+        inline void fill(int macroNo, long n=1)
+        {
+            if(entries.empty() || macroNo>entries.back().first)
+            {
+                entries.push_back(std::make_pair(macroNo, n));
+                return;
+            }
+
+            if(macroNo==entries.back().first)
+            {
+                entries.back().second += n;
+                return;
+            }
+
+            insert(macroNo, n);
+        }
+
+        void add(const MacroCounter& c);
+
+        std::string getName() const;
+        long getCounts(int macroNo) const;
+
+        // number of macropulses with at least minimumCounts counts
+        long getNumberOfMacros(long minimumCounts=1) const;
+
+        // sum of counts over macropulses with at least minimumCounts counts
+        long getTotalCounts(long minimumCounts=1) const;
+
+        const std::vector<std::pair<int,long>>& getEntries() const;
+
+        // write to the current directory
+        int write() const;
+
+        // read from directory; also accepts a per-macropulse TH1 written
+        // by older versions of the analysis
+        int read(TDirectory* directory, std::string name);
+
+        // for plotting only
+        TH1D* toTH1D(int nBins, double low, double high) const;
+
+    private:
+        void insert(int macroNo, long n);
+
+        std::string name;
+        std::vector<std::pair<int,long>> entries;
+};
+
+#endif /* MACRO_COUNTER_H */
@@ -8,11 +8,13 @@
 #include "TFile.h"
 
 #include "crossSection.h"
+#include "fastHisto.h"
+#include "config.h"
 
 class Plots
 {
     public:
-        Plots(std::string name);
+        Plots(std::string name, const Config& config);
         Plots(std::string name, TFile*& inputFile, std::string directory);
 
         TH1D* getTOFHisto();
@@ -29,10 +31,11 @@ class Plots
         TH1D* deadtimeHisto;
 };
 
-TH1D* timeBinsToRKEBins(TH1D *inputHisto, std::string name);
-TH1D* convertTOFtoEnergy(TH1D* tof, std::string name);
+TH1D* timeBinsToRKEBins(TH1D *inputHisto, std::string name, const Config& config);
+TH1D* convertTOFtoEnergy(TH1D* tof, std::string name, const Config& config);
+WeightedHisto1D convertTOFtoEnergy(const WeightedHisto1D& tof, const Config& config);
 
-double calculateEnergyErrorL(double energy, double tofSigma);
-double calculateEnergyErrorR(double energy, double tofSigma);
+double calculateEnergyErrorL(double energy, double tofSigma, const Config& config);
+double calculateEnergyErrorR(double energy, double tofSigma, const Config& config);
 
 #endif
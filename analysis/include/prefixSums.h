@@ -0,0 +1,79 @@
+#ifndef PREFIX_SUMS_H
+#define PREFIX_SUMS_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <utility>
+
+#include "subRunCatalog.h"
+#include "config.h"
+
+// Binary file of cumulative (prefix) sums of subrun summaries, in increasing
+// (run, subrun) key order: the records stored for a key hold, for each target,
+// the sum of that target's summaries over all keys up to and including it. The
+// sum over any contiguous range of keys is then the difference of two records.
+//
+// Each key also stores a source time, so that callers can tell whether the
+// sums from that key on are stale. Targets missing from a key's summaries are
+// carried forward from the previous key.
+class PrefixSums
+{
+    public:
+        PrefixSums() {}
+        PrefixSums(std::string fileName);
+
+        // keys with sums, in increasing order
+        std::vector<std::pair<int, int>> getKeys() const;
+
+        // source time stored with a key, or -1 if there's no such key
+        long getSourceTime(int runNumber, int subRun) const;
+
+        // sums through a new key (greater than all keys so far) are the sums
+        // through the last key plus the given summaries
+        int append(int runNumber, int subRun, long sourceTime, const std::vector<SubRunSummary>& summaries);
+
+        // drop the sums of all keys >= (runNumber, subRun)
+        int truncate(int runNumber, int subRun);
+
+        // per-target sums through the last key <= (runNumber, subRun) (or
+        // < (runNumber, subRun), if not inclusive); empty before the first key
+        int readPrefix(int runNumber, int subRun, bool inclusive, std::vector<SubRunSummary>& sums) const;
+
+    private:
+        typedef std::pair<int, int> Key;
+
+        std::string fileName;
+        long fileLength = 0;
+
+        // key -> (file offset of the key's first record, source time)
+        std::map<Key, std::pair<long, long>> keys;
+
+        // key -> target -> file offset of record
+        std::map<Key, std::map<std::string, long>> index;
+};
+
+// Add (weight 1) or subtract (weight -1) a summary's counters and TOF contents
+// to a running sum, skipping summaries without monitor counts or good macros
+// (as CSPrereqs addition does). An empty sum takes the summary's binning.
+int addToSum(SubRunSummary& sum, const SubRunSummary& summary, double weight);
+
+// Bring the prefix sums of one run (<dataLocation>/<runNumber>/prefixSums_<detectorName>.bin)
+// up to date with its subruns, re-summing from the first subrun that is new,
+// missing, reprocessed, or newly blacklisted, using the run's config.
+int updateRunPrefixSums(std::string expName, int runNumber, std::string detectorName, std::string dataLocation, const Config& config);
+
+// Bring the prefix sums of the given runs, and the prefix sums of whole-run
+// totals across them (<dataLocation>/runPrefixSums_<detectorName>.bin), up to
+// date, taking each run's config from the experiment's config registry.
+int updatePrefixSums(std::string expName, std::vector<int> runNumbers, std::string detectorName, std::string dataLocation);
+
+// Per-target sums over all subruns from (firstRun, firstSubRun) through
+// (lastRun, lastSubRun), from at most four prefix-sum records per target. The
+// prefix sums must be up to date (for ranges spanning runs, the whole-run sums
+// too).
+int sumSubRunRange(std::string dataLocation, std::string detectorName,
+        int firstRun, int firstSubRun, int lastRun, int lastSubRun,
+        std::vector<SubRunSummary>& sums);
+
+#endif /* PREFIX_SUMS_H */
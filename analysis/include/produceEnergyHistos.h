@@ -3,7 +3,7 @@
 
 #include <string>
 
-int produceEnergyHistos(CSPrereqs& csp);
+int produceEnergyHistos(CSPrereqs& csp, const Config& config);
 
 #endif /* PRODUCE_ENERGY_HISTOS_H */
 
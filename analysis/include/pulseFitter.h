@@ -0,0 +1,95 @@
+#ifndef PULSE_FITTER_H
+#define PULSE_FITTER_H
+
+#include <vector>
+
+// Timing of one fitted peak
+struct PulseTiming
+{
+    double peakValue = 0;    // extreme of the fitted form within the search window
+    double triggerTime = 0;  // where the leading edge crosses halfway between background and peakValue
+    double triggerValue = 0; // fitted form at triggerTime
+    double derivative = 0;   // slope of the fitted form at triggerTime
+};
+
+// Levenberg-Marquardt fitter for the fixed-shape peak forms of
+// waveformFitting.cpp (onePeakForm and twoPeakForm): each peak is
+//
+//   A*exp(-(t-t1)/n)/(1+exp(-(t-t1-riseOffset)/d))
+//
+// with n, d (the shape) and the background slope m held fixed, so only the
+// amplitudes, start times and background offset C are fit. Derivatives are
+// analytic, and a fit makes no allocations; use one fitter per thread.
+//
+// Waveforms are fit as TH1::Fit fit a histogram holding sample i in bin i
+// (i.e., at time (i-0.5)*samplePeriod): a chi-square with errors
+// sqrt(sample), skipping sample 0 and empty samples. Parameters are kept
+// within their limits by clamping each step.
+class PulseFitter
+{
+    public:
+        PulseFitter(double samplePeriod, double riseOffset);
+
+        // par, parMin and parMax are in onePeakForm's layout
+        // (A, t1, n, d, C, m); par holds the initial values and gets the
+        // fitted ones. Returns the chi-square.
+        double fitOnePeak(const std::vector<int>& waveform, double* par, const float* parMin, const float* parMax);
+
+        // as above, in twoPeakForm's layout (A, B, t1, t2, n, d, C, m)
+        double fitTwoPeaks(const std::vector<int>& waveform, double* par, const float* parMin, const float* parMax);
+
+        // Timing of a peak (0 or 1) of the last fit, searching from the peak's
+        // start time to window after it. The peak's extreme is found in closed
+        // form, and the half-height crossing by Newton's method (bracketed, as
+        // the leading edge is monotonic). Returns 1 if there's no crossing.
+        int getTiming(int peak, double window, PulseTiming& timing) const;
+
+        // last fitted form, and its time derivative
+        double evaluate(double t) const;
+        double derivative(double t) const;
+
+    private:
+        static const int MAX_PEAKS = 2;
+        static const int MAX_FREE_PARAMETERS = 2*MAX_PEAKS+1;
+        static const int MAX_ITERATIONS = 200;
+
+        // fitted form: free parameters are the amplitudes, then the start
+        // times, then the background offset
+        int numberOfPeaks;
+        double decayTime;
+        double riseTime;
+        double slope;
+
+        // one-peak fits have no slope term (as in onePeakForm)
+        bool useSlope;
+
+        double parameters[MAX_FREE_PARAMETERS];
+        double parameterMin[MAX_FREE_PARAMETERS];
+        double parameterMax[MAX_FREE_PARAMETERS];
+
+        double samplePeriod;
+        double riseOffset;
+
+        // workspace for the normal equations
+        double alpha[MAX_FREE_PARAMETERS][MAX_FREE_PARAMETERS];
+        double beta[MAX_FREE_PARAMETERS];
+        double step[MAX_FREE_PARAMETERS];
+
+        int getNumberOfFreeParameters() const;
+
+        // peak shape at time u after the peak start, and its derivative
+        void shape(double u, double& value, double& valueSlope) const;
+
+        // fitted form at t for the given free parameters; fills gradient (with
+        // respect to the free parameters) if it's not null
+        double evaluate(double t, const double* p, double* gradient) const;
+
+        double calculateChiSquare(const std::vector<int>& waveform, const double* p) const;
+
+        double fit(const std::vector<int>& waveform);
+
+        // solve (alpha + lambda*diag(alpha))*step = beta; returns 1 if singular
+        int solveStep(double lambda);
+};
+
+#endif /* PULSE_FITTER_H */
@@ -5,8 +5,9 @@
 #include <fstream>
 
 #include "../include/dataStructures.h"
+#include "../include/config.h"
 
-int readRawData(std::string inFileName, std::string outFileName, std::ofstream& log);
+int readRawData(std::string inFileName, std::string outFileName, std::ofstream& log, const Config& config);
 bool readEvent(std::ifstream& evtfile, RawEvent& rawEvent);
 bool readEventHeader(std::ifstream& evtfile, RawEvent& rawEvent);
 bool readDPPEventBody(std::ifstream& evtfile, RawEvent& rawEvent);
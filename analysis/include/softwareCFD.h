@@ -6,7 +6,8 @@
 double calculateCFDTime(const std::vector<int>& waveform,
         const double& baseline,
         const double& fraction,
-        const int& delay);
+        const int& delay,
+        const double& armThreshold);
 
 double calculateMacropulseFineTime(std::vector<int>* waveform, double threshold);
 
@@ -0,0 +1,109 @@
+#ifndef SUBRUN_CATALOG_H
+#define SUBRUN_CATALOG_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <iosfwd>
+
+// Everything the aggregation tools (sumAll, eachSubrun, sumChunk) need from one
+// target in one subrun, as plain numbers
+struct SubRunSummary
+{
+    int runNumber = 0;
+    int subRun = 0;
+    std::string targetName;
+
+    // latest modification time of the subrun files this summary was read
+    // from; a summary is stale once those files are newer
+    long sourceTime = 0;
+
+    double monitorCounts = 0;
+    double goodMacroNumber = 0;
+    double totalMacroNumber = 0;
+    double totalEventNumber = 0;
+
+    int TOFBins = 0;
+    double TOFLowerBound = 0;
+    double TOFUpperBound = 0;
+
+    // bin contents, indexed like ROOT bins (0 = underflow, TOFBins+1 = overflow)
+    std::vector<double> TOF; // corrected for deadtime
+    std::vector<double> uncorrectedTOF;
+};
+
+// binary form of one summary, as stored in catalogs and other summary files;
+// reading sets the stream's failbit on a damaged record
+void writeSubRunSummary(std::ostream& file, const SubRunSummary& summary);
+void readSubRunSummary(std::istream& file, SubRunSummary& summary);
+
+// everything but the TOF contents, leaving the stream at the start of them
+void readSubRunSummaryHeader(std::istream& file, SubRunSummary& summary);
+
+// Binary, append-only file of subrun summaries for one detector of one
+// experiment. Opening a catalog scans only the fixed-size record headers to
+// build an in-memory index of (run, subrun, target) -> file offset; TOF
+// contents are read on demand. If a key is added more than once (e.g., after
+// a subrun is reprocessed), the most recent record wins. Catalogs may be used
+// from several threads at once.
+class SubRunCatalog
+{
+    public:
+        SubRunCatalog() {}
+        SubRunCatalog(std::string fileName);
+
+        bool contains(int runNumber, int subRun, std::string targetName) const;
+
+        // returns 1 if the catalog has no summary for this key
+        int read(int runNumber, int subRun, std::string targetName, SubRunSummary& summary) const;
+
+        // append to the catalog file
+        int add(const SubRunSummary& summary);
+
+        // subruns of a run with at least one summary, in increasing order
+        std::vector<int> getSubRuns(int runNumber) const;
+
+        // targets with a summary for this subrun
+        std::vector<std::string> getTargetNames(int runNumber, int subRun) const;
+
+        long size() const;
+
+    private:
+        typedef std::tuple<int, int, std::string> Key;
+
+        std::string fileName;
+        std::map<Key, long> index; // key -> offset of record in file
+};
+
+// Catalog for the given data location and detector, opened once per process
+// and stored as <dataLocation>/subRunCatalog_<detectorName>.bin
+SubRunCatalog& getSubRunCatalog(std::string dataLocation, std::string detectorName);
+
+// Subrun numbers with a directory under <dataLocation>/<runNumber>/, in
+// increasing order
+std::vector<int> findSubRuns(std::string dataLocation, int runNumber);
+
+// latest modification time of the given files, or -1 if any is missing
+long getLatestModificationTime(const std::vector<std::string>& fileNames);
+
+// Per-target totals over a set of subruns, kept by sumAll between invocations
+// so that later invocations only need to add new subruns (and subtract
+// removed ones) rather than re-sum everything
+struct SubRunTotals
+{
+    // (run, subrun) -> source time of the subrun's summaries when added
+    std::map<std::pair<int, int>, long> subRuns;
+
+    // one summary per target (run and subrun numbers unused)
+    std::vector<SubRunSummary> targets;
+};
+
+// returns 1 if the file doesn't exist or can't be read
+int readSubRunTotals(std::string fileName, SubRunTotals& totals);
+
+// replaces the file atomically
+int writeSubRunTotals(std::string fileName, const SubRunTotals& totals);
+
+#endif /* SUBRUN_CATALOG_H */
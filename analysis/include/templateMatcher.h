@@ -0,0 +1,93 @@
+#ifndef TEMPLATE_MATCHER_H
+#define TEMPLATE_MATCHER_H
+
+#include <vector>
+#include <complex>
+
+// Radix-2 fast Fourier transform of a fixed, power-of-two size. The bit
+// reversal and twiddle factors are computed once, so one plan can be shared
+// by any number of threads.
+class FFTPlan
+{
+    public:
+        FFTPlan(unsigned int size);
+
+        unsigned int getSize() const;
+
+        // in-place transform of data (of the plan's size); the inverse
+        // transform includes the 1/size normalization
+        void transform(std::vector<std::complex<double>>& data, bool inverse) const;
+
+    private:
+        unsigned int size;
+        std::vector<unsigned int> bitReversal;
+        std::vector<std::complex<double>> twiddles; // exp(-2*pi*i*k/size), k < size/2
+};
+
+// Average shape of a channel's pulses. Pulses are aligned at a reference time
+// (e.g., their CFD time) with linear interpolation between samples, baseline-
+// subtracted, and normalized to unit peak height before being averaged.
+class PulseTemplate
+{
+    public:
+        // the template spans length samples, with the reference time
+        // preSamples samples after its start
+        PulseTemplate(int preSamples, int length);
+
+        // Add a pulse whose reference time is referenceTime (in samples).
+        // The baseline is the average of the samples before the template's
+        // start. Returns 1 if the pulse doesn't fit in the waveform (or is
+        // flat).
+        int addPulse(const std::vector<int>& waveform, double referenceTime);
+
+        int getNumberOfPulses() const;
+        int getPreSamples() const;
+        int getLength() const;
+
+        // average of the pulses added
+        std::vector<double> getShape() const;
+
+    private:
+        int preSamples;
+        int length;
+        int numberOfPulses;
+
+        std::vector<double> sum;
+};
+
+// Times pulses by cross-correlating each waveform with a template, taking the
+// best-matching lag, and refining it to a fraction of a sample by fitting a
+// parabola through the correlation at that lag and its two neighbours.
+//
+// Correlations are computed with FFTs against the template's spectrum (done
+// once). Two real waveforms are packed into each complex transform (one as the
+// real part and one as the imaginary part), so a pair costs one forward and
+// one inverse FFT. Batches are split between threads, each with its own
+// workspace.
+class TemplateMatcher
+{
+    public:
+        // waveforms up to maxWaveformLength samples can be timed
+        TemplateMatcher(const PulseTemplate& pulseTemplate, unsigned int maxWaveformLength);
+
+        // Time (in samples, on the same reference as the template's) of the
+        // pulse on each waveform, or -1 if a waveform's best match is at the
+        // edge of the lags searched (or it's too short or too long).
+        void calculateTimes(const std::vector<std::vector<int>>& waveforms,
+                std::vector<double>& times, unsigned int numberOfThreads) const;
+
+    private:
+        int preSamples;
+        int templateLength;
+        unsigned int maxWaveformLength;
+
+        FFTPlan plan;
+
+        // complex conjugate of the (zero-mean) template's spectrum
+        std::vector<std::complex<double>> templateSpectrum;
+
+        // time of the pulse on a waveform, from its correlation with the template
+        double findPeak(const std::vector<double>& correlation, unsigned int waveformLength) const;
+};
+
+#endif /* TEMPLATE_MATCHER_H */
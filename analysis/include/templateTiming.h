@@ -0,0 +1,29 @@
+#ifndef TEMPLATE_TIMING_H
+#define TEMPLATE_TIMING_H
+
+#include <fstream>
+#include <string>
+
+#include "config.h"
+
+// Time each detector channel's events by template matching (see
+// templateMatcher.h), as an alternative to the software CFD times assigned
+// when the raw data are read.
+//
+// For each detector channel, the gamma peak is found in the TOF spectrum, and
+// the channel's template is averaged from the gamma pulses, aligned at their
+// CFD times. Every event is then timed against the template, and the gamma
+// peak's width (a Gaussian sigma) is reported for both CFD and template
+// times, as each method's timing resolution.
+//
+// Writes, for each channel, the template, both gamma peaks, the
+// template-minus-CFD time difference for gammas, and a tree with each event's
+// template-based completeTime (entry for entry with the input tree, and equal
+// to the input completeTime where the template didn't match).
+//
+// Only run by driver when "Template timing filename" is set in
+// AnalysisConfig.txt. Returns 2 if the output file already exists, and 1
+// (without writing an output file) if the input is missing a detector tree.
+int calculateTemplateTiming(std::string inputFileName, std::ofstream& logFile, std::string outputFileName, const Config& config);
+
+#endif /* TEMPLATE_TIMING_H */
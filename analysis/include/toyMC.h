@@ -0,0 +1,80 @@
+#ifndef TOY_MC_H
+#define TOY_MC_H
+
+#include <vector>
+#include <string>
+
+#include "TFile.h"
+
+#include "dataSet.h"
+
+// Counts behind one cross section point, as written by
+// CrossSection::createCountsTree
+struct PointCounts
+{
+    double energy;
+    double targetDetCounts;
+    double blankDetCounts;
+    double targetMonitorCounts;
+    double blankMonitorCounts;
+    double arealDensity; // atoms/cm^2
+};
+
+// read a counts tree; returns 1 if the file has no such tree
+int readPointCounts(TFile* file, std::string treeName, std::vector<PointCounts>& counts);
+
+// quantities of two cross sections, a and b
+enum class ToyMCQuantity
+{
+    RATIO,              // a/b
+    RELATIVE_DIFFERENCE // (a-b)/(a+b)
+};
+
+// percentiles of a quantity over toy replicas, per energy
+struct ToyMCBands
+{
+    std::vector<double> energy;
+    std::vector<double> value; // from the nominal cross sections
+
+    std::vector<double> median;
+    std::vector<double> lower68; // 15.9th percentile
+    std::vector<double> upper68; // 84.1st percentile
+    std::vector<double> lower95; // 2.3rd percentile
+    std::vector<double> upper95; // 97.7th percentile
+};
+
+// Propagate statistical errors of two cross sections to a quantity of both by
+// toy Monte Carlo. Each replica draws every count behind a point (Gaussian,
+// with variance equal to the count) and shifts the point's cross section by
+// the change in -ln((targetCounts/blankCounts)/(targetMonitor/blankMonitor))
+// over the areal density. Counts that two points have in common (the blank
+// and blank monitor counts of cross sections from the same runs) are drawn
+// once per replica, so their correlation is kept.
+//
+// Only energies present in both counts tables and both data sets are used.
+// The cross sections may have been shifted since their counts were recorded
+// (e.g., by the blank correction), but not scaled. The replicas of point i are
+// drawn from a generator seeded with (seed, i), so results don't depend on the
+// number of threads.
+int propagateToyMC(const DataSet& a, const std::vector<PointCounts>& aCounts,
+        const DataSet& b, const std::vector<PointCounts>& bCounts,
+        ToyMCQuantity quantity, long numberOfReplicas, unsigned long seed,
+        unsigned int numberOfThreads, ToyMCBands& bands);
+
+// write <name>ToyMC (68% band) and <name>ToyMC95 (95% band) graphs, centered
+// on the nominal values, to the current directory
+void writeToyMCBands(const ToyMCBands& bands, std::string name);
+
+// Toy MC propagation for relativeCS and relativeDiffCS: reads the counts
+// trees (<graph name>Counts) next to both graphs and, if both exist, writes
+// the bands to the current directory. Returns 1 if the counts are missing.
+int addToyMCBands(TFile* aFile, std::string aGraphName, const DataSet& a,
+        TFile* bFile, std::string bGraphName, const DataSet& b,
+        ToyMCQuantity quantity, std::string name);
+
+// as above, with the counts already read
+int addToyMCBands(const DataSet& a, const std::vector<PointCounts>& aCounts,
+        const DataSet& b, const std::vector<PointCounts>& bCounts,
+        ToyMCQuantity quantity, std::string name);
+
+#endif /* TOY_MC_H */
@@ -1,6 +1,8 @@
 #ifndef VETO_EVENTS_H
 #define VETO_EVENTS_H
 
-int vetoEvents(std::string sortedFileName, std::string vetoedFileName, std::ofstream& log, std::string vetoTreeName);
+#include "config.h"
+
+int vetoEvents(std::string sortedFileName, std::string vetoedFileName, std::ofstream& log, std::string vetoTreeName, const Config& config);
 
 #endif /* VETO_EVENTS_H */
@@ -0,0 +1,63 @@
+#ifndef WAVEFORM_DSP_H
+#define WAVEFORM_DSP_H
+
+// Settings for analyzeWaveform. Pulses are negative-going (below the
+// baseline), as from the detectors' PMTs.
+struct WaveformDSPSettings
+{
+    // Baseline: the average of the first baselineSamples-long window (among
+    // the first baselineLimit samples) whose samples are all within
+    // baselineThreshold of the average. If there's no such window, or
+    // baselineSamples is 0, the baseline is defaultBaseline.
+    int baselineSamples = 0;
+    int baselineLimit = 0;
+    double baselineThreshold = 0;
+    double defaultBaseline = 0;
+
+    // Trigger: the first sample, starting at triggerStart (at least 1), that
+    // is at least triggerThreshold below the baseline when the sample before
+    // it isn't. A triggerStart past the waveform's end turns this off.
+    int triggerStart = 1;
+    double triggerThreshold = 0;
+
+    // CFD: the zero crossing of (sample-baseline) - CFDFraction*(delayed
+    // sample-baseline), after the sum first rises above CFDArmThreshold (see
+    // calculateCFDTime). A CFDDelay of 0 turns this off.
+    double CFDFraction = 0;
+    int CFDDelay = 0;
+    double CFDArmThreshold = 0;
+
+    // Charge gates, starting gatePreSamples before the trigger; 0-length gates
+    // (or no trigger) leave the integrals and peak at 0.
+    int gatePreSamples = 0;
+    int shortGateSamples = 0;
+    int longGateSamples = 0;
+};
+
+struct WaveformFeatures
+{
+    double baseline = 0;
+    int triggerSample = -1; // -1 if no trigger
+    double CFDTime = -1;    // in samples; -1 if no zero crossing
+
+    // integrals of (baseline-sample) over the gates
+    double shortIntegral = 0;
+    double longIntegral = 0;
+
+    // largest (baseline-sample) in the long gate, and where it is
+    double peakAmplitude = 0;
+    int peakSample = -1;
+};
+
+// Find a waveform's baseline, trigger, CFD time, gate integrals and peak in one
+// pass. The baseline window slides over the start of the waveform with a
+// running sum; the trigger and CFD searches share one loop that stops as soon
+// as both are found; and the gates are summed by branch-free loops the
+// compiler can vectorize. Nothing is allocated, so this can be called per
+// event from any number of threads.
+//
+// The settings aren't checked (e.g., that the CFD fraction is within (0,1)).
+void analyzeWaveform(const int* samples, int numberOfSamples,
+        const WaveformDSPSettings& settings, WaveformFeatures& features);
+
+#endif /* WAVEFORM_DSP_H */
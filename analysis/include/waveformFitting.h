@@ -34,7 +34,9 @@ const float ERROR_LIMIT_2 = 100.0;
 /*****************************************************************************/
 // Variables for calculating the baseline:
 
-double BASELINE = 15725;
+// nominal baseline, used when a waveform's own baseline can't be found (each
+// waveform's baseline is kept with the waveform, not here)
+const double BASELINE = 15725;
 const int BASELINE_SAMPLES = 10; // number of samples averaged to calculate baseline
 const int BASELINE_THRESHOLD = 20; // used to reject samples from being used to calculate the baseline average 
 const int BASELINE_LIMIT = 50; // used to abort waveform fitting if baseline can't be established within this # of samples
@@ -50,6 +52,9 @@ int numberOnePeakExpBackFits = 0; // Successfully fit as one peak riding on
 int numberTwoPeakFits = 0;        // Successfully fit as two peaks
 int numberTotalTriggers = 0;
 
+// delay of the peak forms' Fermi-function rise, in ns
+extern const double FERMI_OFFSET;
+
 double onePeakForm(double *x, double *par);
 double CFDForm(double *x, double *par);
 double onePeakExpBackForm(double *x, double *par);
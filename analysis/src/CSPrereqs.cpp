@@ -2,6 +2,11 @@
 #include <fstream>
 #include <string>
 #include <utility>
+#include <map>
+#include <set>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
 #include "TFile.h"
 #include "TH1D.h"
 #include "TDirectory.h"
@@ -11,11 +16,13 @@
 #include "../include/CSPrereqs.h"
 #include "../include/config.h"
 #include "../include/experiment.h"
+#include "../include/macroCounter.h"
+#include "../include/eventColumns.h"
+#include "../include/correctForDeadtime.h"
+#include "../include/subRunCatalog.h"
 
 using namespace std;
 
-extern Config config;
-
 int CSPrereqs::readTOFHisto(TFile* histoFile, string directory, string targetName)
 {
     // for histos
@@ -32,8 +39,7 @@ int CSPrereqs::readTOFHisto(TFile* histoFile, string directory, string targetNam
         return 1;
     }
 
-    TOFHisto = (TH1D*)TOFHistoTemp->Clone();
-    TOFHisto->SetDirectory(0);
+    TOF = WeightedHisto1D(TOFHistoTemp);
 
     return 0;
 }
@@ -49,35 +55,17 @@ int CSPrereqs::readMonitorCounts(TFile* histoFile, string directory, string targ
         return 1;
     }
 
-    string histoName = targetName + "GoodMacros";
-    TH1D* histo = (TH1D*)dir->Get(histoName.c_str());
-    if(!histo)
+    string counterName = targetName + "GoodMacros";
+    MacroCounter counter;
+    if(counter.read(dir, counterName))
     {
-        cerr << "Error: Failed to open histogram " << histoName << " in file " << histoFile->GetName()
+        cerr << "Error: Failed to open macro counter " << counterName << " in file " << histoFile->GetName()
             << " (in readMonitorCounts)." << endl;
         return 1;
     }
 
-    int numberOfBins = histo->GetNbinsX();
-
-    double totalMonitorCounts = 0;
-    int totalGoodMonitorMacros = 0;
-
-    for(int i=1; i<=numberOfBins; i++)
-    {
-        double binContent = histo->GetBinContent(i);
-
-        if(binContent<=0.5)
-        {
-            continue;
-        }
-
-        totalMonitorCounts += binContent;
-        totalGoodMonitorMacros++;
-    }
-
-    monitorCounts = totalMonitorCounts;
-    goodMacroNumber = totalGoodMonitorMacros;
+    monitorCounts = counter.getTotalCounts();
+    goodMacroNumber = counter.getNumberOfMacros();
 
     return 0;
 }
@@ -101,23 +89,15 @@ int CSPrereqs::readMacroData(TFile* histoFile, string directory, string totalMac
     }*/
 
     string name = totalMacrosHistoName + "MacroNumber";
-    TH1D* totalMacrosHisto = (TH1D*)dir->Get(name.c_str());
-    if(!totalMacrosHisto)
+    MacroCounter totalMacrosCounter;
+    if(totalMacrosCounter.read(dir, name))
     {
-        cerr << "Error: Failed to open histogram \"" << totalMacrosHistoName
+        cerr << "Error: Failed to open macro counter \"" << name
             << "\" in file " << histoFile->GetName() << " (in getMacroRatio)." << endl;
         return 1;
     }
 
-    int numberOfBins = totalMacrosHisto->GetNbinsX();
-
-    for(int j=1; j<=numberOfBins; j++)
-    {
-        if(totalMacrosHisto->GetBinContent(j)>0)
-        {
-            totalMacroNumber++;
-        }
-    }
+    totalMacroNumber += totalMacrosCounter.getNumberOfMacros();
 
     return 0;
 }
@@ -167,58 +147,306 @@ int CSPrereqs::readUncorrectedTOFHisto(TFile* histoFile, string directoryName, s
         return 1;
     }
 
-    string clonedHistoName = eventDataHistoName + "uncorrected";
-    uncorrectedTOFHisto = (TH1D*)eventDataHistoTemp->Clone(clonedHistoName.c_str());
-    uncorrectedTOFHisto->SetDirectory(0);
+    uncorrectedTOF = WeightedHisto1D(eventDataHistoTemp);
 
    return 0;
 }
 
-CSPrereqs operator+(CSPrereqs& augend, CSPrereqs& addend)
+void CSPrereqs::readSummary(const SubRunSummary& summary)
+{
+    TOF = WeightedHisto1D(summary.TOFBins, summary.TOFLowerBound, summary.TOFUpperBound);
+    TOF.getContents() = summary.TOF;
+
+    uncorrectedTOF = WeightedHisto1D(summary.TOFBins, summary.TOFLowerBound, summary.TOFUpperBound);
+    uncorrectedTOF.getContents() = summary.uncorrectedTOF;
+    uncorrectedTOF.setEntries(summary.totalEventNumber);
+
+    monitorCounts = summary.monitorCounts;
+    goodMacroNumber = summary.goodMacroNumber;
+    totalMacroNumber = summary.totalMacroNumber;
+    totalEventNumber = summary.totalEventNumber;
+}
+
+SubRunSummary CSPrereqs::getSummary(int runNumber, int subRun, long sourceTime) const
+{
+    SubRunSummary summary;
+
+    summary.runNumber = runNumber;
+    summary.subRun = subRun;
+    summary.targetName = target.getName();
+    summary.sourceTime = sourceTime;
+
+    summary.monitorCounts = monitorCounts;
+    summary.goodMacroNumber = goodMacroNumber;
+    summary.totalMacroNumber = totalMacroNumber;
+    summary.totalEventNumber = totalEventNumber;
+
+    summary.TOFBins = TOF.getNBins();
+    summary.TOFLowerBound = TOF.getLowEdge();
+    summary.TOFUpperBound = TOF.getHighEdge();
+
+    summary.TOF = TOF.getContents();
+    summary.uncorrectedTOF = uncorrectedTOF.getContents();
+
+    return summary;
+}
+
+// Re-histogramming a subrun reads and scans all of its events at once, for
+// every target; keep the most recent subrun's TOF histograms, since callers
+// read each target of a subrun in turn (one cache per thread, as subruns may
+// be read in parallel)
+static thread_local string cachedEventColumnsName;
+static thread_local vector<FastHisto1D> cachedEventTOFHistos;
+
+int CSPrereqs::readTOFFromEvents(string subRunLocation, string detectorName, string targetName, const Config& config)
 {
-    if(augend.target.getName() != addend.target.getName())
+    // find target position
+    int targetPos = -1;
+    for(int i=0; (size_t)i<config.target.TARGET_ORDER.size(); i++)
+    {
+        if(config.target.TARGET_ORDER[i]==targetName)
+        {
+            targetPos = i;
+            break;
+        }
+    }
+
+    if(targetPos<0)
+    {
+        cerr << "Error: target " << targetName << " not found in target order (in readTOFFromEvents)." << endl;
+        return 1;
+    }
+
+    if(config.analysis.GATED_EVENTS_FILE_NAME == "")
+    {
+        cerr << "Error: tried to re-histogram events, but no \"Gated events filename\" is set in AnalysisConfig.txt." << endl;
+        return 1;
+    }
+
+    string eventColumnsFileName = subRunLocation + config.analysis.GATED_EVENTS_FILE_NAME;
+
+    stringstream binning;
+    binning << config.plot.TOF_BINS << "_" << config.plot.TOF_LOWER_BOUND << "_" << config.plot.TOF_UPPER_BOUND;
+    string eventColumnsName = eventColumnsFileName + "/" + detectorName + "/" + binning.str();
+
+    if(eventColumnsName != cachedEventColumnsName)
+    {
+        cachedEventColumnsName = "";
+
+        TFile* eventColumnsFile = new TFile(eventColumnsFileName.c_str(),"READ");
+        if(!eventColumnsFile->IsOpen())
+        {
+            cerr << "Error: failed to open " << eventColumnsFileName << " to re-histogram events." << endl;
+            delete eventColumnsFile;
+            return 1;
+        }
+
+        TDirectory* dir = eventColumnsFile->GetDirectory(detectorName.c_str());
+        if(!dir)
+        {
+            cerr << "Error: failed to find " << detectorName << " directory in " << eventColumnsFileName << "." << endl;
+            eventColumnsFile->Close();
+            delete eventColumnsFile;
+            return 1;
+        }
+
+        EventColumns events;
+        if(events.read(dir, "events"))
+        {
+            eventColumnsFile->Close();
+            delete eventColumnsFile;
+            return 1;
+        }
+
+        eventColumnsFile->Close();
+        delete eventColumnsFile;
+
+        cachedEventTOFHistos = fillTOFHistos(events, config);
+        cachedEventColumnsName = eventColumnsName;
+    }
+
+    // deadtime correction inputs, as in applyDeadtimeCorrection
+    string deadtimeFileName = subRunLocation + "deadtime.root";
+    string macroFileName = subRunLocation + config.analysis.HISTOGRAM_FILE_NAME;
+    string gammaCorrectionFileName = subRunLocation + "gammaCorrection.root";
+
+    double averageGammaTime;
+    if(readAverageGammaTime(gammaCorrectionFileName, averageGammaTime, config))
+    {
+        return 1;
+    }
+
+    TFile* macroFile = new TFile(macroFileName.c_str(),"READ");
+    TDirectory* macroDirectory = macroFile->GetDirectory(detectorName.c_str());
+    if(!macroDirectory)
+    {
+        cerr << "Error: failed to find " << detectorName << " directory in " << macroFileName << "." << endl;
+        macroFile->Close();
+        delete macroFile;
+        return 1;
+    }
+
+    string macroCounterName = targetName + "MacroNumber";
+    MacroCounter macroCounter;
+    if(macroCounter.read(macroDirectory, macroCounterName))
+    {
+        macroFile->Close();
+        delete macroFile;
+        return 1;
+    }
+
+    macroFile->Close();
+    delete macroFile;
+
+    double numberOfMicros = macroCounter.getNumberOfMacros()
+        *(config.facility.LAST_GOOD_MICRO-config.facility.FIRST_GOOD_MICRO);
+
+    if(numberOfMicros <=0)
+    {
+        cerr << "Error: cannot apply deadtime for <= 0 periods." << endl;
+        return 1;
+    }
+
+    TFile* deadtimeFile = new TFile(deadtimeFileName.c_str(),"READ");
+    TDirectory* deadtimeDirectory = deadtimeFile->GetDirectory(detectorName.c_str());
+    if(!deadtimeDirectory)
+    {
+        cerr << "Error: failed to find " << detectorName << " directory in " << deadtimeFileName << "." << endl;
+        deadtimeFile->Close();
+        delete deadtimeFile;
+        return 1;
+    }
+
+    string deadtimeHistoName = targetName + "Deadtime";
+    TH1D* deadtimeHisto = (TH1D*)deadtimeDirectory->Get(deadtimeHistoName.c_str());
+    if(!deadtimeHisto)
+    {
+        cerr << "Error: failed to find " << deadtimeHistoName << " in " << deadtimeFileName << "." << endl;
+        deadtimeFile->Close();
+        delete deadtimeFile;
+        return 1;
+    }
+
+    const FastHisto1D& eventTOF = cachedEventTOFHistos[targetPos];
+
+    // the deadtime correction works on ROOT histograms; use temporary ones
+    TH1D* uncorrectedTOFHisto = eventTOF.toTH1D();
+    uncorrectedTOFHisto->SetDirectory(0);
+
+    TH1D* TOFHisto = (TH1D*)uncorrectedTOFHisto->Clone();
+    TOFHisto->SetDirectory(0);
+
+    correctTOFForDeadtime(uncorrectedTOFHisto, deadtimeHisto, averageGammaTime, numberOfMicros, TOFHisto);
+
+    deadtimeFile->Close();
+    delete deadtimeFile;
+
+    uncorrectedTOF = WeightedHisto1D(eventTOF);
+    TOF = WeightedHisto1D(TOFHisto);
+
+    delete uncorrectedTOFHisto;
+    delete TOFHisto;
+
+    totalEventNumber = eventTOF.getEntries();
+
+    return 0;
+}
+
+CSPrereqs& CSPrereqs::operator+=(const CSPrereqs& addend)
+{
+    if(target.getName() != addend.target.getName())
     {
         cerr << "Error: tried to added CSPrereqs of different targets." << endl;
         exit(1);
     }
 
-    if(!addend.TOFHisto || !addend.monitorCounts || !addend.goodMacroNumber || !addend.uncorrectedTOFHisto)
+    if(addend.TOF.empty() || !addend.monitorCounts || !addend.goodMacroNumber || addend.uncorrectedTOF.empty())
     {
-        return augend;
+        return *this;
     }
 
-    augend.TOFHisto->Add(addend.TOFHisto);
-    augend.uncorrectedTOFHisto->Add(addend.uncorrectedTOFHisto);
+    if(TOF.add(addend.TOF) || uncorrectedTOF.add(addend.uncorrectedTOF))
+    {
+        cerr << "Error: tried to add CSPrereqs with different TOF binnings (target "
+            << target.getName() << ")." << endl;
+        exit(1);
+    }
 
-    augend.monitorCounts += addend.monitorCounts;
-    augend.goodMacroNumber += addend.goodMacroNumber;
-    augend.totalMacroNumber += addend.totalMacroNumber;
-    augend.totalEventNumber += addend.totalEventNumber;
+    monitorCounts += addend.monitorCounts;
+    goodMacroNumber += addend.goodMacroNumber;
+    totalMacroNumber += addend.totalMacroNumber;
+    totalEventNumber += addend.totalEventNumber;
 
-    return augend;
+    return *this;
 }
 
-CSPrereqs::CSPrereqs(Target t)
+CSPrereqs& CSPrereqs::operator-=(const CSPrereqs& subtrahend)
 {
-    target = t;
-    TOFHisto = new TH1D("","",config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
-    TOFHisto->SetDirectory(0);
+    if(target.getName() != subtrahend.target.getName())
+    {
+        cerr << "Error: tried to subtract CSPrereqs of different targets." << endl;
+        exit(1);
+    }
 
-    uncorrectedTOFHisto = new TH1D("","",config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
-    uncorrectedTOFHisto->SetDirectory(0);
+    // skip exactly the CSPrereqs that += would have skipped
+    if(subtrahend.TOF.empty() || !subtrahend.monitorCounts || !subtrahend.goodMacroNumber || subtrahend.uncorrectedTOF.empty())
+    {
+        return *this;
+    }
+
+    if(TOF.add(subtrahend.TOF, -1) || uncorrectedTOF.add(subtrahend.uncorrectedTOF, -1))
+    {
+        cerr << "Error: tried to subtract CSPrereqs with different TOF binnings (target "
+            << target.getName() << ")." << endl;
+        exit(1);
+    }
+
+    monitorCounts -= subtrahend.monitorCounts;
+    goodMacroNumber -= subtrahend.goodMacroNumber;
+    totalMacroNumber -= subtrahend.totalMacroNumber;
+    totalEventNumber -= subtrahend.totalEventNumber;
+
+    return *this;
+}
+
+void CSPrereqs::clearHistos()
+{
+    energy = WeightedHisto1D();
+    TOF = WeightedHisto1D();
+    uncorrectedTOF = WeightedHisto1D();
+}
+
+CSPrereqs sumPairwise(vector<CSPrereqs>& prereqs)
+{
+    // combine neighbours, then neighbouring pairs, and so on: the order of
+    // additions depends only on the number of inputs
+    for(size_t stride=1; stride<prereqs.size(); stride*=2)
+    {
+        for(size_t i=0; i+stride<prereqs.size(); i+=2*stride)
+        {
+            prereqs[i] += prereqs[i+stride];
+            prereqs[i+stride].clearHistos();
+        }
+    }
+
+    return move(prereqs[0]);
+}
+
+CSPrereqs::CSPrereqs(Target t, const Config& config)
+{
+    target = t;
+    TOF = WeightedHisto1D(config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
+    uncorrectedTOF = WeightedHisto1D(config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
 
     monitorCounts = 0;
     goodMacroNumber = 0;
     totalMacroNumber = 0;
 }
 
-CSPrereqs::CSPrereqs(string targetDataLocation) : target(targetDataLocation)
+CSPrereqs::CSPrereqs(string targetDataLocation, const Config& config) : target(targetDataLocation)
 {
-    TOFHisto = new TH1D("","",config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_RANGE);
-    TOFHisto->SetDirectory(0);
-
-    uncorrectedTOFHisto = new TH1D("","",config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
-    uncorrectedTOFHisto->SetDirectory(0);
+    TOF = WeightedHisto1D(config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
+    uncorrectedTOF = WeightedHisto1D(config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
 
     monitorCounts = 0;
     goodMacroNumber = 0;
@@ -303,7 +531,7 @@ DataSet scale(DataSet setToScale, DataSet expReference, DataSet litReference)
     return scaledSet;
 }
 
-int readTargetData(vector<CSPrereqs>& allCSPrereqs, string expName)
+int readTargetData(vector<CSPrereqs>& allCSPrereqs, string expName, const Config& config)
 {
     // check to see if data with this target has already been read in
     // (from previous runs). If not, create a new CSPrereq to hold the new
@@ -312,7 +540,7 @@ int readTargetData(vector<CSPrereqs>& allCSPrereqs, string expName)
     {
         bool CSPAlreadyExists = false;
 
-        for(CSPrereqs csp : allCSPrereqs)
+        for(const CSPrereqs& csp : allCSPrereqs)
         {
             if(csp.target.getName() == targetName)
             {
@@ -328,88 +556,135 @@ int readTargetData(vector<CSPrereqs>& allCSPrereqs, string expName)
         }
 
         string targetDataLocation = "../" + expName + "/targetData/" + targetName + ".txt";
-        allCSPrereqs.push_back(CSPrereqs(targetDataLocation));
+        allCSPrereqs.push_back(CSPrereqs(targetDataLocation, config));
     }
 
     return 0;
 }
 
-int readSubRun(CSPrereqs& subRunData, string expName, int runNumber, int subRun, string detectorName, string dataLocation)
+int checkBlacklist(string expName, int runNumber, int subRun)
 {
-    stringstream subRunFormatted;
-    subRunFormatted << setfill('0') << setw(4) << subRun;
+    // blacklists are read once per experiment
+    static map<string, set<string>> blacklists;
+    static mutex blacklistsMutex;
 
-    // Skip subruns on the blacklist
-    string blacklistDataLocation = "../" + expName + "/blacklist.txt";
-    ifstream blacklist(blacklistDataLocation);
+    lock_guard<mutex> lock(blacklistsMutex);
 
-    if(!blacklist.good())
+    auto it = blacklists.find(expName);
+    if(it==blacklists.end())
     {
-        cerr << "Error: couldn't find blacklist in " << blacklistDataLocation << endl;
-        return 1;
-    }
-
-    bool skip = false;
-    string str;
+        string blacklistDataLocation = "../" + expName + "/blacklist.txt";
+        ifstream blacklist(blacklistDataLocation);
 
-    while(getline(blacklist,str))
-    {
-        string runSubrun = to_string(runNumber) + "-" + subRunFormatted.str();
-        if(runSubrun == str)
+        if(!blacklist.good())
         {
-            cout << "Found sub-run " << runSubrun << " on blacklist; skipping..." << endl;
+            cerr << "Error: couldn't find blacklist in " << blacklistDataLocation << endl;
+            return 1;
+        }
 
-            skip = true;
-            break;
+        set<string> entries;
+        string str;
+
+        while(getline(blacklist,str))
+        {
+            entries.insert(str);
         }
+
+        it = blacklists.insert(make_pair(expName, entries)).first;
     }
 
-    if(skip)
+    stringstream runSubrun;
+    runSubrun << runNumber << "-" << setfill('0') << setw(4) << subRun;
+
+    if(it->second.count(runSubrun.str()))
     {
+        cout << "Found sub-run " << runSubrun.str() << " on blacklist; skipping..." << endl;
         return 1;
     }
 
-    // open file containing deadtime-corrected TOF histograms
-    stringstream TOFFileName;
-    TOFFileName << dataLocation << "/" << runNumber << "/"
-        << subRunFormatted.str() << "/correctedHistos.root";
-    ifstream g(TOFFileName.str());
-    if(!g.good())
+    return 0;
+}
+
+string getSubRunLocation(string dataLocation, int runNumber, int subRun)
+{
+    stringstream subRunFormatted;
+    subRunFormatted << setfill('0') << setw(4) << subRun;
+
+    return dataLocation + "/" + to_string(runNumber) + "/" + subRunFormatted.str() + "/";
+}
+
+long getSubRunSourceTime(string dataLocation, int runNumber, int subRun)
+{
+    string subRunLocation = getSubRunLocation(dataLocation, runNumber, subRun);
+
+    return getLatestModificationTime({
+            subRunLocation + "correctedHistos.root",
+            subRunLocation + "gatedHistos.root"});
+}
+
+int readSubRun(CSPrereqs& subRunData, string expName, int runNumber, int subRun, string detectorName, string dataLocation, const Config& config, bool useEventColumns)
+{
+    // Skip subruns on the blacklist
+    if(checkBlacklist(expName, runNumber, subRun))
     {
-        // failed to open this sub-run - skip to the next one
-        cerr << "Couldn't open " << TOFFileName.str() << "; continuing.\r";
-        fflush(stdout);
         return 1;
     }
 
-    g.close();
+    string subRunLocation = getSubRunLocation(dataLocation, runNumber, subRun);
 
-    TFile* TOFFile = new TFile(TOFFileName.str().c_str(),"READ");
+    // file containing deadtime-corrected TOF histograms
+    string TOFFileName = subRunLocation + "correctedHistos.root";
 
-    // open file containing macropulse number data
-    stringstream macroFileName;
-    macroFileName << dataLocation << "/" << runNumber << "/"
-        << subRunFormatted.str() << "/gatedHistos.root";
-    ifstream h(macroFileName.str());
-    if(!h.good())
+    // file containing macropulse number data
+    string macroFileName = subRunLocation + "gatedHistos.root";
+
+    long sourceTime = getSubRunSourceTime(dataLocation, runNumber, subRun);
+    if(sourceTime<0)
     {
         // failed to open this sub-run - skip to the next one
-        cerr << "Couldn't open " << macroFileName.str() << "; continuing.\r";
+        cerr << "Couldn't open " << TOFFileName << " or " << macroFileName << "; continuing.\r";
         fflush(stdout);
         return 1;
     }
 
-    h.close();
+    string targetName = subRunData.target.getName();
+
+    // use the catalog's summary of this subrun, unless the subrun has been
+    // reprocessed since the summary was made
+    SubRunCatalog& catalog = getSubRunCatalog(dataLocation, detectorName);
 
-    TFile* macroFile = new TFile(macroFileName.str().c_str(),"READ");
+    if(!useEventColumns)
+    {
+        SubRunSummary summary;
+        if(!catalog.read(runNumber, subRun, targetName, summary)
+                && summary.sourceTime==sourceTime)
+        {
+            subRunData.readSummary(summary);
+            return 0;
+        }
+    }
+
+    TFile* TOFFile = new TFile(TOFFileName.c_str(),"READ");
+    TFile* macroFile = new TFile(macroFileName.c_str(),"READ");
 
     // pull data needed for CS calculation from subrun 
-    string targetName = subRunData.target.getName();
+    bool failedToRead;
 
-    if(subRunData.readTOFHisto(TOFFile, detectorName, targetName)
+    if(useEventColumns)
+    {
+        failedToRead = subRunData.readMonitorCounts(macroFile, "monitor", targetName)
+            || subRunData.readTOFFromEvents(subRunLocation, detectorName, targetName, config);
+    }
+
+    else
+    {
+        failedToRead = subRunData.readTOFHisto(TOFFile, detectorName, targetName)
             || subRunData.readMonitorCounts(macroFile, "monitor", targetName)
             || subRunData.readEventData(macroFile, detectorName, targetName)
-            || subRunData.readUncorrectedTOFHisto(macroFile, detectorName, targetName))
+            || subRunData.readUncorrectedTOFHisto(macroFile, detectorName, targetName);
+    }
+
+    if(failedToRead)
     {
         // error: failed to read one of the essential cross section quantities
         // for this target.
@@ -418,6 +693,9 @@ int readSubRun(CSPrereqs& subRunData, string expName, int runNumber, int subRun,
         TOFFile->Close();
         macroFile->Close();
 
+        delete TOFFile;
+        delete macroFile;
+
         return 1;
     }
 
@@ -425,5 +703,13 @@ int readSubRun(CSPrereqs& subRunData, string expName, int runNumber, int subRun,
     TOFFile->Close();
     macroFile->Close();
 
+    delete TOFFile;
+    delete macroFile;
+
+    if(!useEventColumns)
+    {
+        catalog.add(subRunData.getSummary(runNumber, subRun, sourceTime));
+    }
+
     return 0;
 }
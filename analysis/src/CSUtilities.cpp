@@ -6,20 +6,30 @@
 #include "../include/experiment.h"
 #include "../include/physicalConstants.h"
 #include "../include/plots.h"
+#include "../include/energyRebinner.h"
+#include "../include/toyMC.h"
+#include "../include/literatureCache.h"
 
 #include <iostream>
 #include <fstream>
 
 using namespace std;
 
-CrossSection mergeCrossSections(CrossSection firstCS, double juncture,
-        CrossSection secondCS)
+// y-error of point i of a data set read from a graph, or -1 if there's no
+// such point (as TGraph::GetErrorY returns)
+static double getYErrorOfPoint(const DataSet& dataSet, int i)
 {
-    CrossSection outputCS;
-    DataSet outputDS;
+    if(i<0 || i>=dataSet.getNumberOfPoints())
+    {
+        return -1;
+    }
+
+    return dataSet.getYErrors()[i];
+}
 
-    DataSet firstDS = firstCS.getDataSet();
-    DataSet secondDS = secondCS.getDataSet();
+DataSet mergeDataSets(const DataSet& firstDS, double juncture, const DataSet& secondDS)
+{
+    DataSet outputDS;
 
     for(int i=0; i<firstDS.getNumberOfPoints(); i++)
     {
@@ -41,7 +51,14 @@ CrossSection mergeCrossSections(CrossSection firstCS, double juncture,
         outputDS.addPoint(secondDS.getPoint(i));
     }
 
-    outputCS.addDataSet(outputDS);
+    return outputDS;
+}
+
+CrossSection mergeCrossSections(CrossSection firstCS, double juncture,
+        CrossSection secondCS)
+{
+    CrossSection outputCS;
+    outputCS.addDataSet(mergeDataSets(firstCS.getDataSet(), juncture, secondCS.getDataSet()));
 
     return outputCS;
 }
@@ -66,21 +83,22 @@ int readLitData(string litDirectory, string litOutputName, const Config& config)
     }
 
     // read energy bins from config
-    TH1D* TOFHisto = new TH1D("","",config.plot.TOF_BINS, config.plot.TOF_LOWER_BOUND, config.plot.TOF_UPPER_BOUND);
-    TH1D* energyHisto = timeBinsToRKEBins(TOFHisto, "");
-
-    vector<double> energyBins;
-    
-    int numberOfBins = energyHisto->GetNbinsX();
-
-    for(int i=1; i<=numberOfBins; i++)
+    vector<double> energyBins = getEnergyRebinner(
+            config.plot.TOF_BINS,
+            config.plot.TOF_LOWER_BOUND,
+            config.plot.TOF_UPPER_BOUND,
+            config).getEnergyBinEdges();
+
+    // binned literature data is cached next to the output file, keyed by
+    // each file's contents and the energy binning
+    string cacheFileName = "literatureCache.bin";
+    size_t lastSlash = litOutputName.rfind('/');
+    if(lastSlash!=string::npos)
     {
-        energyBins.push_back(energyHisto->GetBinLowEdge(i));
+        cacheFileName = litOutputName.substr(0, lastSlash+1) + cacheFileName;
     }
 
-    energyBins.push_back(
-            energyHisto->GetBinLowEdge(numberOfBins)
-           +energyHisto->GetBinWidth(numberOfBins));
+    LiteratureCache cache(cacheFileName);
 
     // recreate output file
     TFile* outFile = new TFile(litOutputName.c_str(),"RECREATE");
@@ -90,13 +108,23 @@ int readLitData(string litDirectory, string litOutputName, const Config& config)
     for(string s : fileNames)
     {
         cout << "Creating plot for " << s << endl;
-        allData.push_back(DataSet(s, energyBins));
+
+        DataSet dataSet;
+        if(readLitDataSet(s, energyBins, cache, dataSet))
+        {
+            outFile->Close();
+            return 1;
+        }
+
+        allData.push_back(dataSet);
         outFile->cd();
         allData.back().getPlot()->Write();
     }
 
     outFile->Close();
 
+    cache.save();
+
     return 0;
 }
 
@@ -197,6 +225,27 @@ int correctForBlank(CrossSection& rawCS, CSPrereqs& targetData, string expName)
     return 0;
 }
 
+DataSet subtractDataSets(const DataSet& rawCSData, const DataSet& subtrahend,
+        double factor, double divisor)
+{
+    DataSet subtrahendData;
+    subtrahendData.reserve(rawCSData.getNumberOfPoints());
+
+    // for each y-value of the raw CS, read the y-value of the subtrahend
+    // and the y-error
+    for(int i=0; i<rawCSData.getNumberOfPoints(); i++)
+    {
+        subtrahendData.addPoint(
+                DataPoint(rawCSData.getPoint(i).getXValue(),
+                    rawCSData.getPoint(i).getXErrorL(),
+                    rawCSData.getPoint(i).getXErrorR(),
+                    subtrahend.evaluate(rawCSData.getPoint(i).getXValue()),
+                    getYErrorOfPoint(subtrahend, i), 0, 0)); // statistical and systematic error are 0 
+    }
+
+    return (rawCSData-subtrahendData*factor)/divisor;
+}
+
 CrossSection subtractCS(string rawCSFileName, string rawCSGraphName,
         string subtrahendFileName, string subtrahendGraphName,
         double factor, double divisor, string name)
@@ -219,24 +268,12 @@ CrossSection subtractCS(string rawCSFileName, string rawCSGraphName,
         exit(1);
     }
 
-    DataSet subtrahendData = DataSet();
     DataSet rawCSData = DataSet(rawCSGraph, rawCSGraphName);
-
-    // for each y-value of the raw CS graph, read the y-value of the subtrahend
-    // and the y-error
-    for(int i=0; i<rawCSData.getNumberOfPoints(); i++)
-    {
-        subtrahendData.addPoint(
-                DataPoint(rawCSData.getPoint(i).getXValue(),
-                    rawCSData.getPoint(i).getXErrorL(),
-                    rawCSData.getPoint(i).getXErrorR(),
-                    subtrahendGraph->Eval(rawCSData.getPoint(i).getXValue()),
-                    subtrahendGraph->GetErrorY(i), 0, 0)); // statistical and systematic error are 0 
-    }
+    DataSet subtrahendData = DataSet(subtrahendGraph, subtrahendGraphName);
 
     // perform the subtraction
     CrossSection differenceCS = CrossSection();
-    differenceCS.addDataSet((rawCSData-subtrahendData*factor)/divisor);
+    differenceCS.addDataSet(subtractDataSets(rawCSData, subtrahendData, factor, divisor));
 
     // create graph of difference
     rawCSFile->cd();
@@ -258,23 +295,10 @@ CrossSection subtractCS(CrossSection rawCS, string subtrahendFileName,
         exit(1);
     }
 
-    DataSet subtrahendData = DataSet();
-    DataSet rawCSData = rawCS.getDataSet();
-
-    // for each y-value of the raw CS graph, read the y-value of the subtrahend
-    // and the y-error
-    for(int i=0; i<rawCSData.getNumberOfPoints(); i++)
-    {
-        subtrahendData.addPoint(
-                DataPoint(rawCSData.getPoint(i).getXValue(),
-                    rawCSData.getPoint(i).getXError(),
-                    subtrahendGraph->Eval(rawCSData.getPoint(i).getXValue()),
-                    subtrahendGraph->GetErrorY(i), 0, 0)); 
-    }
-
     // perform the subtraction
     CrossSection differenceCS = CrossSection();
-    differenceCS.addDataSet((rawCSData-subtrahendData*factor)/divisor);
+    differenceCS.addDataSet(subtractDataSets(rawCS.getDataSet(),
+                DataSet(subtrahendGraph, subtrahendGraphName), factor, divisor));
 
     differenceCS.name = rawCS.name;
 
@@ -366,7 +390,7 @@ double getPartialError(DataPoint aPoint, DataPoint bPoint, double aArealDensity)
     return leftExpression*rightExpression;
 }
 
-void produceRunningRMS(DataSet firstDS, DataSet secondDS, string name)
+DataSet calculateRunningRMS(const DataSet& firstDS, const DataSet& secondDS)
 {
     DataSet rms;
 
@@ -397,6 +421,17 @@ void produceRunningRMS(DataSet firstDS, DataSet secondDS, string name)
         }
     }
 
+    return rms;
+}
+
+void writeRunningRMS(const DataSet& rms, string name)
+{
+    if(rms.getNumberOfPoints()==0)
+    {
+        cerr << "Error: no points in common to calculate " << name << " RMS with." << endl;
+        return;
+    }
+
     cout << "Total RMS at " << rms.getPoint(rms.getNumberOfPoints()-1).getXValue()
         << " MeV = " << rms.getPoint(rms.getNumberOfPoints()-1).getYValue() << endl;
 
@@ -407,37 +442,27 @@ void produceRunningRMS(DataSet firstDS, DataSet secondDS, string name)
     rmsPlot.createGraph(n.c_str(), n.c_str());
 }
 
-CrossSection relativeCS(string firstCSFileName, string firstCSGraphName,
-        string secondCSFileName, string secondCSGraphName,
-        string outputFileName, string name)
+void produceRunningRMS(DataSet firstDS, DataSet secondDS, string name)
 {
-    // get firstCS graph
-    TFile* firstCSFile = new TFile(firstCSFileName.c_str(),"READ");
-    TGraphAsymmErrors* firstCSGraph = (TGraphAsymmErrors*)firstCSFile->Get(firstCSGraphName.c_str());
-    if(!firstCSGraph)
-    {
-        cerr << "Error: failed to find " << firstCSGraphName << " in " << firstCSFileName << endl;
-        exit(1);
-    }
+    writeRunningRMS(calculateRunningRMS(firstDS, secondDS), name);
+}
 
-    // get second graph
-    TFile* secondCSFile = new TFile(secondCSFileName.c_str(),"READ");
-    TGraphAsymmErrors* secondCSGraph = (TGraphAsymmErrors*)secondCSFile->Get(secondCSGraphName.c_str());
-    if(!secondCSGraph)
+DataSet relativeDataSets(const DataSet& firstCSDataRaw, const DataSet& secondCSDataRaw,
+        DataSet& firstCSData, DataSet& secondCSData)
+{
+    firstCSData = DataSet();
+    secondCSData = DataSet();
+
+    if(firstCSDataRaw.getNumberOfPoints()==0 || secondCSDataRaw.getNumberOfPoints()==0)
     {
-        cerr << "Error: failed to find " << secondCSGraphName << " in " << secondCSFileName << endl;
-        exit(1);
+        cerr << "Error: tried to divide data sets, but one is empty." << endl;
+        return DataSet();
     }
 
-    DataSet firstCSData = DataSet();
-    DataSet secondCSData = DataSet();
-
     // find maximum value of second CS dataset
-    DataSet firstCSDataRaw = DataSet(firstCSGraph, firstCSGraphName);
-    DataSet secondCSDataRaw = DataSet(secondCSGraph, secondCSGraphName);
-    double maxEnergyValue = secondCSDataRaw.getPoint(secondCSDataRaw.getNumberOfPoints()-1).getXValue();
+    double maxEnergyValue = secondCSDataRaw.getXValues().back();
 
-    // for each y-value of the first CS graph, read the y-value of the second
+    // for each y-value of the first CS, read the y-value of the second
     // and the y-error
     for(int i=0; i<firstCSDataRaw.getNumberOfPoints(); i++)
     {
@@ -451,74 +476,36 @@ CrossSection relativeCS(string firstCSFileName, string firstCSGraphName,
         secondCSData.addPoint(
                 DataPoint(firstCSDataRaw.getPoint(i).getXValue(),
                     firstCSDataRaw.getPoint(i).getXError(),
-                    secondCSGraph->Eval(firstCSDataRaw.getPoint(i).getXValue()),
-                    secondCSGraph->GetErrorY(i))); 
+                    secondCSDataRaw.evaluate(firstCSDataRaw.getPoint(i).getXValue()),
+                    getYErrorOfPoint(secondCSDataRaw, i))); 
     }
 
-    // perform the division
-    CrossSection relCS = CrossSection();
-    relCS.addDataSet(firstCSData/secondCSData);
-
-    // create graph of relative difference
-    TFile* outputFile = new TFile(outputFileName.c_str(), "UPDATE");
-    relCS.createGraph(name, name);
-
-    // create running RMS plot
-    CrossSection firstCS = CrossSection();
-    firstCS.addDataSet(firstCSData);
-
-    CrossSection secondCS = CrossSection();
-    secondCS.addDataSet(secondCSData);
-
-    produceRunningRMS(firstCS.getDataSet(), secondCS.getDataSet(), name);
-
-    outputFile->Close();
-
-    firstCSFile->Close();
-    secondCSFile->Close();
-
-    return relCS;
+    return firstCSData/secondCSData;
 }
 
-CrossSection relativeDiffCS(string firstCSFileName, string firstCSGraphName,
-        string secondCSFileName, string secondCSGraphName,
-        string outputFileName, string name)
+DataSet relativeDiffDataSets(const DataSet& firstCSDataRaw, const DataSet& secondCSDataRaw,
+        DataSet& firstCSData, DataSet& secondCSData)
 {
-    // get firstCS graph
-    TFile* firstCSFile = new TFile(firstCSFileName.c_str(),"READ");
-    TGraphAsymmErrors* firstCSGraph = (TGraphAsymmErrors*)firstCSFile->Get(firstCSGraphName.c_str());
-    if(!firstCSGraph)
-    {
-        cerr << "Error: failed to find " << firstCSGraphName << " in " << firstCSFileName << endl;
-        exit(1);
-    }
+    firstCSData = DataSet();
+    secondCSData = DataSet();
 
-    // get secondCS graph
-    TFile* secondCSFile = new TFile(secondCSFileName.c_str(),"READ");
-    TGraphAsymmErrors* secondCSGraph = (TGraphAsymmErrors*)secondCSFile->Get(secondCSGraphName.c_str());
-    if(!secondCSGraph)
+    if(firstCSDataRaw.getNumberOfPoints()==0 || secondCSDataRaw.getNumberOfPoints()==0)
     {
-        cerr << "Error: failed to find " << secondCSGraphName << " in " << secondCSFileName << endl;
-        exit(1);
+        cerr << "Error: tried to take the relative difference of data sets, but one is empty." << endl;
+        return DataSet();
     }
 
-    DataSet firstCSData = DataSet();
-    DataSet secondCSData = DataSet();
-
-    DataSet firstCSDataRaw = DataSet(firstCSGraph, firstCSGraphName);
-    DataSet secondCSDataRaw = DataSet(secondCSGraph, secondCSGraphName);
-
     // find maximum value of datasets
     double maxEnergyValue = min(
-            firstCSDataRaw.getPoint(firstCSDataRaw.getNumberOfPoints()-1).getXValue(),
-            secondCSDataRaw.getPoint(secondCSDataRaw.getNumberOfPoints()-1).getXValue());
+            firstCSDataRaw.getXValues().back(),
+            secondCSDataRaw.getXValues().back());
 
     // find minimum value of datasets
     double minEnergyValue = max(
-            firstCSDataRaw.getPoint(0).getXValue(),
-            secondCSDataRaw.getPoint(0).getXValue());
+            firstCSDataRaw.getXValues().front(),
+            secondCSDataRaw.getXValues().front());
 
-    // for each y-value of the second CS graph, read the y-value of the first
+    // for each y-value of the second CS, read the y-value of the first
     // and the y-error
     for(int i=0; i<secondCSDataRaw.getNumberOfPoints(); i++)
     {
@@ -534,14 +521,15 @@ CrossSection relativeDiffCS(string firstCSFileName, string firstCSGraphName,
 
         secondCSData.addPoint(secondCSDataRaw.getPoint(i));
 
-        if(secondCSDataRaw.getPoint(i).getXValue() == firstCSDataRaw.getPoint(i).getXValue())
+        if(i<firstCSDataRaw.getNumberOfPoints()
+                && secondCSDataRaw.getPoint(i).getXValue() == firstCSDataRaw.getPoint(i).getXValue())
         {
             // matching energies of both datasets for this point
             firstCSData.addPoint(
                     DataPoint(secondCSDataRaw.getPoint(i).getXValue(),
                         secondCSDataRaw.getPoint(i).getXError(), 0,
-                        firstCSGraph->Eval(secondCSDataRaw.getPoint(i).getXValue()),
-                        firstCSGraph->GetErrorY(i), 0, 0)); 
+                        firstCSDataRaw.evaluate(secondCSDataRaw.getPoint(i).getXValue()),
+                        getYErrorOfPoint(firstCSDataRaw, i), 0, 0)); 
         }
 
         else
@@ -561,7 +549,7 @@ CrossSection relativeDiffCS(string firstCSFileName, string firstCSGraphName,
                     firstCSData.addPoint(
                             DataPoint(secondCSDataRaw.getPoint(i).getXValue(),
                                 secondCSDataRaw.getPoint(i).getXError(), 0,
-                                firstCSGraph->Eval(secondCSDataRaw.getPoint(i).getXValue()),
+                                firstCSDataRaw.evaluate(secondCSDataRaw.getPoint(i).getXValue()),
                                 pow(pow(firstCSDataRaw.getPoint(j).getYError(),2)
                                    +pow(firstCSDataRaw.getPoint(j-1).getYError(),2),0.5), 0, 0)); 
                 }
@@ -570,33 +558,111 @@ CrossSection relativeDiffCS(string firstCSFileName, string firstCSGraphName,
     }
 
     // perform the sum
-    CrossSection sumCS = CrossSection();
-    sumCS.addDataSet(firstCSData+secondCSData);
+    DataSet sumCSData = firstCSData+secondCSData;
+
+    // calculate both terms of the difference, and take it
+    return firstCSData/sumCSData - secondCSData/sumCSData;
+}
+
+CrossSection relativeCS(string firstCSFileName, string firstCSGraphName,
+        string secondCSFileName, string secondCSGraphName,
+        string outputFileName, string name)
+{
+    // get firstCS graph
+    TFile* firstCSFile = new TFile(firstCSFileName.c_str(),"READ");
+    TGraphAsymmErrors* firstCSGraph = (TGraphAsymmErrors*)firstCSFile->Get(firstCSGraphName.c_str());
+    if(!firstCSGraph)
+    {
+        cerr << "Error: failed to find " << firstCSGraphName << " in " << firstCSFileName << endl;
+        exit(1);
+    }
+
+    // get second graph
+    TFile* secondCSFile = new TFile(secondCSFileName.c_str(),"READ");
+    TGraphAsymmErrors* secondCSGraph = (TGraphAsymmErrors*)secondCSFile->Get(secondCSGraphName.c_str());
+    if(!secondCSGraph)
+    {
+        cerr << "Error: failed to find " << secondCSGraphName << " in " << secondCSFileName << endl;
+        exit(1);
+    }
+
+    DataSet firstCSDataRaw = DataSet(firstCSGraph, firstCSGraphName);
+    DataSet secondCSDataRaw = DataSet(secondCSGraph, secondCSGraphName);
+
+    // perform the division
+    DataSet firstCSData;
+    DataSet secondCSData;
+
+    CrossSection relCS = CrossSection();
+    relCS.addDataSet(relativeDataSets(firstCSDataRaw, secondCSDataRaw, firstCSData, secondCSData));
+
+    // create graph of relative difference
+    TFile* outputFile = new TFile(outputFileName.c_str(), "UPDATE");
+    relCS.createGraph(name, name);
 
-    // calculate first term of the difference
-    CrossSection firstTermCS = CrossSection();
-    firstTermCS.addDataSet(firstCSData/sumCS.getDataSet());
+    // the analytic errors above treat both cross sections as uncorrelated;
+    // where their counts are available, also propagate errors with shared
+    // blank counts correlated
+    addToyMCBands(firstCSFile, firstCSGraphName, firstCSDataRaw,
+            secondCSFile, secondCSGraphName, secondCSDataRaw,
+            ToyMCQuantity::RATIO, name);
 
-    // calculate second term of the difference
-    CrossSection secondTermCS = CrossSection();
-    secondTermCS.addDataSet(secondCSData/sumCS.getDataSet());
+    // create running RMS plot
+    produceRunningRMS(firstCSData, secondCSData, name);
+
+    outputFile->Close();
+
+    firstCSFile->Close();
+    secondCSFile->Close();
+
+    return relCS;
+}
+
+CrossSection relativeDiffCS(string firstCSFileName, string firstCSGraphName,
+        string secondCSFileName, string secondCSGraphName,
+        string outputFileName, string name)
+{
+    // get firstCS graph
+    TFile* firstCSFile = new TFile(firstCSFileName.c_str(),"READ");
+    TGraphAsymmErrors* firstCSGraph = (TGraphAsymmErrors*)firstCSFile->Get(firstCSGraphName.c_str());
+    if(!firstCSGraph)
+    {
+        cerr << "Error: failed to find " << firstCSGraphName << " in " << firstCSFileName << endl;
+        exit(1);
+    }
+
+    // get secondCS graph
+    TFile* secondCSFile = new TFile(secondCSFileName.c_str(),"READ");
+    TGraphAsymmErrors* secondCSGraph = (TGraphAsymmErrors*)secondCSFile->Get(secondCSGraphName.c_str());
+    if(!secondCSGraph)
+    {
+        cerr << "Error: failed to find " << secondCSGraphName << " in " << secondCSFileName << endl;
+        exit(1);
+    }
+
+    DataSet firstCSDataRaw = DataSet(firstCSGraph, firstCSGraphName);
+    DataSet secondCSDataRaw = DataSet(secondCSGraph, secondCSGraphName);
 
     // perform the difference
+    DataSet firstCSData;
+    DataSet secondCSData;
+
     CrossSection relDiffCS = CrossSection();
-    relDiffCS.addDataSet(firstTermCS.getDataSet()-secondTermCS.getDataSet());
+    relDiffCS.addDataSet(relativeDiffDataSets(firstCSDataRaw, secondCSDataRaw, firstCSData, secondCSData));
 
     // create graph of relative difference
     TFile* outputFile = new TFile(outputFileName.c_str(), "UPDATE");
     relDiffCS.createGraph(name, name);
 
-    // create running RMS plot
-    CrossSection firstCS = CrossSection();
-    firstCS.addDataSet(firstCSData);
-
-    CrossSection secondCS = CrossSection();
-    secondCS.addDataSet(secondCSData);
+    // the analytic errors above treat both cross sections as uncorrelated;
+    // where their counts are available, also propagate errors with shared
+    // blank counts correlated
+    addToyMCBands(firstCSFile, firstCSGraphName, firstCSDataRaw,
+            secondCSFile, secondCSGraphName, secondCSDataRaw,
+            ToyMCQuantity::RELATIVE_DIFFERENCE, name);
 
-    produceRunningRMS(firstCS.getDataSet(), secondCS.getDataSet(), name);
+    // create running RMS plot
+    produceRunningRMS(firstCSData, secondCSData, name);
 
     outputFile->Close();
 
@@ -606,6 +672,24 @@ CrossSection relativeDiffCS(string firstCSFileName, string firstCSGraphName,
     return relDiffCS;
 }
 
+DataSet correctDataSet(const DataSet& CSCorrection, const DataSet& CSToBeCorrectedData)
+{
+    DataSet CSCorrectionData;
+    CSCorrectionData.reserve(CSToBeCorrectedData.getNumberOfPoints());
+
+    // for each y-value of the CSToBeCorrected data, read the y-value of the CSCorrection data
+    for(int i=0; i<CSToBeCorrectedData.getNumberOfPoints(); i++)
+    {
+        CSCorrectionData.addPoint(
+                DataPoint(CSToBeCorrectedData.getPoint(i).getXValue(),
+                    CSToBeCorrectedData.getPoint(i).getXError(),
+                    CSCorrection.evaluate(CSToBeCorrectedData.getPoint(i).getXValue()),
+                    getYErrorOfPoint(CSCorrection, i)));
+    }
+
+    return correctCSUsingControl(CSToBeCorrectedData,CSCorrectionData);
+}
+
 void applyCSCorrectionFactor(string CSCorrectionFileName, string CSCorrectionGraphName, string CSToBeCorrectedFileName, string CSToBeCorrectedGraphName, string outputFileName, string outputGraphName)
 {
     // get CS correction graph
@@ -629,21 +713,11 @@ void applyCSCorrectionFactor(string CSCorrectionFileName, string CSCorrectionGra
     TFile* outputFile = new TFile(outputFileName.c_str(),"UPDATE");
 
     DataSet CSToBeCorrectedData = DataSet(CSToBeCorrectedGraph, CSToBeCorrectedGraphName);
-    DataSet CSCorrectionData = DataSet();
-
-    // for each y-value of the CSToBeCorrected graph, read the y-value of the CSCorrection graph
-    for(int i=0; i<CSToBeCorrectedData.getNumberOfPoints(); i++)
-    {
-        CSCorrectionData.addPoint(
-                DataPoint(CSToBeCorrectedData.getPoint(i).getXValue(),
-                    CSToBeCorrectedData.getPoint(i).getXError(),
-                    CSCorrectionGraph->Eval(CSToBeCorrectedData.getPoint(i).getXValue()),
-                    CSCorrectionGraph->GetErrorY(i)));
-    }
+    DataSet CSCorrectionData = DataSet(CSCorrectionGraph, CSCorrectionGraphName);
 
     // perform the correction
     CrossSection correctedCS = CrossSection();
-    correctedCS.addDataSet(correctCSUsingControl(CSToBeCorrectedData,CSCorrectionData));
+    correctedCS.addDataSet(correctDataSet(CSCorrectionData, CSToBeCorrectedData));
 
     // create graph of correctedCS
     outputFile->cd();
@@ -652,30 +726,15 @@ void applyCSCorrectionFactor(string CSCorrectionFileName, string CSCorrectionGra
     outputFile->Close();
 }
 
-void scaledownCS(string CSToBeCorrectedFileName, string CSToBeCorrectedGraphName, int scaledown, string outputFileName, string outputGraphName)
+DataSet scaledownDataSet(const DataSet& CSToBeCorrectedData, int scaledown)
 {
-    // get CSToBeCorrected graph
-    TFile* CSToBeCorrectedFile = new TFile(CSToBeCorrectedFileName.c_str(),"READ");
-    TGraphAsymmErrors* CSToBeCorrectedGraph = (TGraphAsymmErrors*)CSToBeCorrectedFile->Get(CSToBeCorrectedGraphName.c_str());
-    if(!CSToBeCorrectedGraph)
-    {
-        cerr << "Error: failed to find " << CSToBeCorrectedGraphName << " in " << CSToBeCorrectedFileName << endl;
-        exit(1);
-    }
-
-    TFile* outputFile = new TFile(outputFileName.c_str(),"UPDATE");
-
-    DataSet CSToBeCorrectedData = DataSet(CSToBeCorrectedGraph, CSToBeCorrectedGraphName);
     DataSet CorrectedCSData = DataSet();
 
-    CSToBeCorrectedFile->Close();
-
     double rebinnedXValue = 0;
     double rebinnedYValue = 0;
     double rebinnedYError = 0;
     int numberOfPoints = 0;
 
-    // create downscaled CSToBeCorrected graph
     for(int i=0; i<CSToBeCorrectedData.getNumberOfPoints(); i++)
     {
         rebinnedXValue += CSToBeCorrectedData.getPoint(i).getXValue();
@@ -698,9 +757,29 @@ void scaledownCS(string CSToBeCorrectedFileName, string CSToBeCorrectedGraphName
         }
     }
 
-    // perform the correction
+    return CorrectedCSData;
+}
+
+void scaledownCS(string CSToBeCorrectedFileName, string CSToBeCorrectedGraphName, int scaledown, string outputFileName, string outputGraphName)
+{
+    // get CSToBeCorrected graph
+    TFile* CSToBeCorrectedFile = new TFile(CSToBeCorrectedFileName.c_str(),"READ");
+    TGraphAsymmErrors* CSToBeCorrectedGraph = (TGraphAsymmErrors*)CSToBeCorrectedFile->Get(CSToBeCorrectedGraphName.c_str());
+    if(!CSToBeCorrectedGraph)
+    {
+        cerr << "Error: failed to find " << CSToBeCorrectedGraphName << " in " << CSToBeCorrectedFileName << endl;
+        exit(1);
+    }
+
+    TFile* outputFile = new TFile(outputFileName.c_str(),"UPDATE");
+
+    DataSet CSToBeCorrectedData = DataSet(CSToBeCorrectedGraph, CSToBeCorrectedGraphName);
+
+    CSToBeCorrectedFile->Close();
+
+    // create downscaled CSToBeCorrected graph
     CrossSection correctedCS = CrossSection();
-    correctedCS.addDataSet(CorrectedCSData);
+    correctedCS.addDataSet(scaledownDataSet(CSToBeCorrectedData, scaledown));
 
     // create graph of correctedCS
     outputFile->cd();
@@ -19,8 +19,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     applyCSCorrectionFactor(argv[1], argv[2], argv[3], argv[4], argv[5], argv[6]); 
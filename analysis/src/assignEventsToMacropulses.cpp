@@ -24,9 +24,7 @@
 
 using namespace std;
 
-extern Config config;
-
-int assignEventsToMacropulses(string inputFileName, string outputFileName, ofstream& logFile, vector<MacropulseEvent>& macropulseList)
+int assignEventsToMacropulses(string inputFileName, string outputFileName, ofstream& logFile, vector<MacropulseEvent>& macropulseList, const Config& config)
 {
     /**************************************************************************/
     // open input detector tree
@@ -111,15 +109,21 @@ int assignEventsToMacropulses(string inputFileName, string outputFileName, ofstr
 
     for(auto& channel : config.digitizer.CHANNEL_MAP)
     {
+        ChannelRole role = config.channels.ROLES[channel.first];
+
         if(
-                channel.second == "-" ||
-                channel.second == "macroTime" ||
-                channel.second == "targetChanger"
+                role == ChannelRole::UNUSED ||
+                role == ChannelRole::MACRO_TIME ||
+                role == ChannelRole::TARGET_CHANGER
           )
         {
             continue;
         }
 
+        // macropulses count monitor events and events in the first detector
+        bool isMonitor = (role == ChannelRole::MONITOR);
+        bool isFirstDetector = (config.channels.DETECTOR_NUMBERS[channel.first] == 0);
+
         cout << endl << "Start assigning \"" << channel.second
             << "\" events to macropulses..." << endl;
 
@@ -263,12 +267,12 @@ int assignEventsToMacropulses(string inputFileName, string outputFileName, ofstr
                 detectorEvent.macroNo = macropulseList[currentMacropulse].macroNo;
                 detectorEvent.targetPos = macropulseList[currentMacropulse].targetPos;
 
-                if(channel.second == config.analysis.MONITOR_TREE_NAME)
+                if(isMonitor)
                 {
                     macropulseList[currentMacropulse].numberOfMonitorsInMacro++;
                 }
 
-                else if(channel.second == config.cs.DETECTOR_NAMES[0])
+                else if(isFirstDetector)
                 {
                     macropulseList[currentMacropulse].numberOfEventsInMacro++;
                 }
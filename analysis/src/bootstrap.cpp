@@ -0,0 +1,446 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+#include "TGraph.h"
+#include "TGraphAsymmErrors.h"
+#include "TDirectory.h"
+
+#include "../include/bootstrap.h"
+#include "../include/crossSection.h"
+#include "../include/CSPrereqs.h"
+#include "../include/fastHisto.h"
+
+using namespace std;
+
+int SubRunBootstrap::findTarget(string targetName) const
+{
+    for(int i=0; (size_t)i<targets.size(); i++)
+    {
+        if(targets[i].target.getName()==targetName)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int SubRunBootstrap::getBlankIndex() const
+{
+    int blankIndex = findTarget("blank");
+    if(blankIndex<0)
+    {
+        blankIndex = findTarget("blankW");
+    }
+
+    return blankIndex;
+}
+
+int SubRunBootstrap::addSubRun(const vector<CSPrereqs>& subRunData)
+{
+    // check binning before changing anything, so a bad subrun leaves the
+    // stored data as it was
+    for(const CSPrereqs& csp : subRunData)
+    {
+        if(csp.energy.empty() || !csp.monitorCounts || !csp.goodMacroNumber)
+        {
+            continue;
+        }
+
+        if(!energyBinning.empty() && !energyBinning.sameBinning(csp.energy))
+        {
+            cerr << "Error: energy binning of " << csp.target.getName()
+                << " differs from that of earlier subruns; can't bootstrap." << endl;
+            return 1;
+        }
+    }
+
+    numberOfSubRuns++;
+
+    for(const CSPrereqs& csp : subRunData)
+    {
+        if(csp.energy.empty() || !csp.monitorCounts || !csp.goodMacroNumber)
+        {
+            continue;
+        }
+
+        if(energyBinning.empty())
+        {
+            energyBinning = csp.energy;
+            fill(energyBinning.getContents().begin(), energyBinning.getContents().end(), 0);
+            energyBinning.setEntries(0);
+
+            rowLength = energyBinning.getContents().size();
+        }
+
+        int t = findTarget(csp.target.getName());
+        if(t<0)
+        {
+            CSPrereqs newTarget;
+            newTarget.target = csp.target;
+            targets.push_back(newTarget);
+
+            monitorCounts.push_back(vector<double>());
+            energyCounts.push_back(vector<double>());
+            goodMacroNumbers.push_back(0);
+            totalMacroNumbers.push_back(0);
+            totalEventNumbers.push_back(0);
+
+            t = targets.size()-1;
+        }
+
+        // subruns without data for this target (including earlier subruns,
+        // for a target seen for the first time) hold zeros
+        monitorCounts[t].resize(numberOfSubRuns, 0);
+        energyCounts[t].resize((size_t)numberOfSubRuns*rowLength, 0);
+
+        monitorCounts[t].back() += csp.monitorCounts;
+
+        const vector<double>& contents = csp.energy.getContents();
+        double* row = &energyCounts[t][(size_t)(numberOfSubRuns-1)*rowLength];
+        for(int bin=0; bin<rowLength; bin++)
+        {
+            row[bin] += contents[bin];
+        }
+
+        goodMacroNumbers[t] += csp.goodMacroNumber;
+        totalMacroNumbers[t] += csp.totalMacroNumber;
+        totalEventNumbers[t] += csp.totalEventNumber;
+    }
+
+    for(size_t t=0; t<targets.size(); t++)
+    {
+        monitorCounts[t].resize(numberOfSubRuns, 0);
+        energyCounts[t].resize((size_t)numberOfSubRuns*rowLength, 0);
+    }
+
+    return 0;
+}
+
+int SubRunBootstrap::getNumberOfSubRuns() const
+{
+    return numberOfSubRuns;
+}
+
+const WeightedHisto1D& SubRunBootstrap::getEnergyBinning() const
+{
+    return energyBinning;
+}
+
+vector<CSPrereqs> SubRunBootstrap::getTotals() const
+{
+    vector<CSPrereqs> totals = targets;
+
+    for(size_t t=0; t<targets.size(); t++)
+    {
+        CSPrereqs& total = totals[t];
+
+        total.goodMacroNumber = goodMacroNumbers[t];
+        total.totalMacroNumber = totalMacroNumbers[t];
+        total.totalEventNumber = totalEventNumbers[t];
+
+        total.energy = energyBinning;
+        vector<double>& contents = total.energy.getContents();
+
+        for(int s=0; s<numberOfSubRuns; s++)
+        {
+            total.monitorCounts += monitorCounts[t][s];
+
+            const double* row = &energyCounts[t][(size_t)s*rowLength];
+            for(int bin=0; bin<rowLength; bin++)
+            {
+                contents[bin] += row[bin];
+            }
+        }
+    }
+
+    return totals;
+}
+
+int SubRunBootstrap::resample(int numberOfReplicas, unsigned long seed, unsigned int numberOfThreads,
+        vector<BootstrapErrors>& errors) const
+{
+    int blankIndex = getBlankIndex();
+    if(blankIndex<0)
+    {
+        cerr << "Error: no blank data to bootstrap cross sections with." << endl;
+        return 1;
+    }
+
+    if(numberOfSubRuns==0 || numberOfReplicas<=0)
+    {
+        cerr << "Error: need at least one subrun and one replica to bootstrap." << endl;
+        return 1;
+    }
+
+    int numberOfTargets = targets.size();
+    int numberOfBins = rowLength-2;
+
+    vector<double> arealDensities;
+    for(const CSPrereqs& csp : targets)
+    {
+        arealDensities.push_back(calculateArealDensity(csp.target));
+    }
+
+    // [target][replica*rowLength + bin]; NaN where a replica gives no cross
+    // section
+    vector<vector<double>> replicaCS(numberOfTargets,
+            vector<double>((size_t)numberOfReplicas*rowLength, NAN));
+
+    fillInParallel(numberOfReplicas, numberOfThreads,
+            [&](unsigned int, long begin, long end)
+            {
+                // per-thread buffers, reused for every replica
+                vector<int> multiplicities(numberOfSubRuns);
+                vector<double> monitorSums(numberOfTargets);
+                vector<double> countSums((size_t)numberOfTargets*rowLength);
+
+                for(long r=begin; r<end; r++)
+                {
+                    seed_seq seeds{(unsigned long)seed, (unsigned long)r};
+                    mt19937_64 generator(seeds);
+                    uniform_int_distribution<int> pick(0, numberOfSubRuns-1);
+
+                    // a replica is the sum of numberOfSubRuns subruns drawn
+                    // with replacement, i.e., each subrun times the number
+                    // of times it was drawn
+                    fill(multiplicities.begin(), multiplicities.end(), 0);
+                    for(int i=0; i<numberOfSubRuns; i++)
+                    {
+                        multiplicities[pick(generator)]++;
+                    }
+
+                    fill(monitorSums.begin(), monitorSums.end(), 0);
+                    fill(countSums.begin(), countSums.end(), 0);
+
+                    for(int t=0; t<numberOfTargets; t++)
+                    {
+                        double* sum = &countSums[(size_t)t*rowLength];
+
+                        for(int s=0; s<numberOfSubRuns; s++)
+                        {
+                            if(!multiplicities[s])
+                            {
+                                continue;
+                            }
+
+                            double weight = multiplicities[s];
+                            monitorSums[t] += weight*monitorCounts[t][s];
+
+                            const double* row = &energyCounts[t][(size_t)s*rowLength];
+                            for(int bin=1; bin<=numberOfBins; bin++)
+                            {
+                                sum[bin] += weight*row[bin];
+                            }
+                        }
+                    }
+
+                    const double* bCounts = &countSums[(size_t)blankIndex*rowLength];
+                    double bMon = monitorSums[blankIndex];
+
+                    for(int t=0; t<numberOfTargets; t++)
+                    {
+                        const double* tCounts = &countSums[(size_t)t*rowLength];
+                        double monitorRatio = monitorSums[t]/bMon;
+
+                        double* cs = &replicaCS[t][(size_t)r*rowLength];
+
+                        // same cross section as CrossSection::calculateCS
+                        for(int bin=1; bin<=numberOfBins; bin++)
+                        {
+                            double detectorRatio = tCounts[bin]/bCounts[bin];
+
+                            if(!isfinite(detectorRatio) || !isfinite(monitorRatio)
+                                    || detectorRatio<=0 || monitorRatio<=0)
+                            {
+                                continue;
+                            }
+
+                            cs[bin] = -log(detectorRatio/monitorRatio)/arealDensities[t]*pow(10,24); // in barns
+                        }
+                    }
+                }
+            });
+
+    errors.clear();
+    errors.resize(numberOfTargets);
+
+    runInParallel(numberOfTargets, numberOfThreads, [&](long t)
+            {
+                BootstrapErrors& e = errors[t];
+                e.targetName = targets[t].target.getName();
+
+                e.mean.assign(rowLength, 0);
+                e.standardDeviation.assign(rowLength, 0);
+                e.lower.assign(rowLength, 0);
+                e.upper.assign(rowLength, 0);
+                e.validReplicas.assign(rowLength, 0);
+
+                vector<double> values;
+                values.reserve(numberOfReplicas);
+
+                for(int bin=1; bin<=numberOfBins; bin++)
+                {
+                    values.clear();
+                    for(int r=0; r<numberOfReplicas; r++)
+                    {
+                        double cs = replicaCS[t][(size_t)r*rowLength+bin];
+                        if(!isnan(cs))
+                        {
+                            values.push_back(cs);
+                        }
+                    }
+
+                    int n = values.size();
+                    e.validReplicas[bin] = n;
+
+                    if(n<2)
+                    {
+                        continue;
+                    }
+
+                    double mean = 0;
+                    for(double v : values)
+                    {
+                        mean += v;
+                    }
+                    mean /= n;
+
+                    double variance = 0;
+                    for(double v : values)
+                    {
+                        variance += pow(v-mean,2);
+                    }
+                    variance /= (n-1);
+
+                    e.mean[bin] = mean;
+                    e.standardDeviation[bin] = sqrt(variance);
+
+                    // quantiles by linear interpolation between order
+                    // statistics
+                    sort(values.begin(), values.end());
+
+                    auto quantile = [&](double q)
+                    {
+                        double position = q*(n-1);
+                        int below = (int)position;
+                        if(below>=n-1)
+                        {
+                            return values[n-1];
+                        }
+
+                        return values[below] + (position-below)*(values[below+1]-values[below]);
+                    };
+
+                    e.lower[bin] = quantile(0.15866);
+                    e.upper[bin] = quantile(0.84134);
+                }
+            });
+
+    return 0;
+}
+
+void writeBootstrapErrors(vector<CrossSection>& crossSections,
+        const vector<BootstrapErrors>& errors,
+        const WeightedHisto1D& energyBinning)
+{
+    // cross section points are at energy bin centers; points of bins where
+    // calculateCS gave no cross section are missing
+    map<double, int> binsByEnergy;
+    for(int bin=1; bin<=energyBinning.getNBins(); bin++)
+    {
+        binsByEnergy[energyBinning.getBinCenter(bin)] = bin;
+    }
+
+    for(CrossSection& cs : crossSections)
+    {
+        const BootstrapErrors* e = nullptr;
+        for(const BootstrapErrors& candidate : errors)
+        {
+            if(candidate.targetName==cs.name)
+            {
+                e = &candidate;
+                break;
+            }
+        }
+
+        if(!e)
+        {
+            cerr << "Error: no bootstrap errors for " << cs.name << " target." << endl;
+            continue;
+        }
+
+        vector<double> energy;
+        vector<double> energyErrorL;
+        vector<double> energyErrorR;
+        vector<double> value;
+        vector<double> bootstrapError;
+        vector<double> bandErrorL;
+        vector<double> bandErrorR;
+        vector<double> errorRatio;
+
+        double ratioSum = 0;
+
+        for(int i=0; i<cs.getNumberOfPoints(); i++)
+        {
+            DataPoint point = cs.getDataPoint(i);
+
+            auto bin = binsByEnergy.find(point.getXValue());
+            if(bin==binsByEnergy.end() || e->validReplicas[bin->second]<2)
+            {
+                continue;
+            }
+
+            double y = point.getYValue();
+
+            energy.push_back(point.getXValue());
+            energyErrorL.push_back(point.getXErrorL());
+            energyErrorR.push_back(point.getXErrorR());
+            value.push_back(y);
+            bootstrapError.push_back(e->standardDeviation[bin->second]);
+            bandErrorL.push_back(max(0., y-e->lower[bin->second]));
+            bandErrorR.push_back(max(0., e->upper[bin->second]-y));
+
+            errorRatio.push_back(point.getStatError()>0 ?
+                    e->standardDeviation[bin->second]/point.getStatError() : 0);
+            ratioSum += errorRatio.back();
+        }
+
+        cs.createStatErrorsGraph(cs.name + "StatErrors", cs.name + "StatErrors");
+
+        if(energy.empty())
+        {
+            cerr << "Error: no bins with bootstrap errors for " << cs.name << " target." << endl;
+            continue;
+        }
+
+        string name = cs.name + "Bootstrap";
+        TGraphAsymmErrors* t = new TGraphAsymmErrors(energy.size(),
+                &energy[0], &value[0],
+                &energyErrorL[0], &energyErrorR[0],
+                &bootstrapError[0], &bootstrapError[0]);
+        t->SetNameTitle(name.c_str(), name.c_str());
+        gDirectory->WriteTObject(t);
+
+        name = cs.name + "BootstrapBand";
+        t = new TGraphAsymmErrors(energy.size(),
+                &energy[0], &value[0],
+                &energyErrorL[0], &energyErrorR[0],
+                &bandErrorL[0], &bandErrorR[0]);
+        t->SetNameTitle(name.c_str(), name.c_str());
+        gDirectory->WriteTObject(t);
+
+        name = cs.name + "BootstrapToStat";
+        TGraph* r = new TGraph(energy.size(), &energy[0], &errorRatio[0]);
+        r->SetNameTitle(name.c_str(), name.c_str());
+        gDirectory->WriteTObject(r);
+
+        cout << cs.name << ": mean ratio of bootstrap to analytic statistical error = "
+            << ratioSum/energy.size() << " over " << energy.size() << " points" << endl;
+    }
+}
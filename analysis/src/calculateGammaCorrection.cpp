@@ -10,12 +10,11 @@
 #include "../include/GammaCorrection.h"
 #include "../include/dataStructures.h"
 #include "../include/physicalConstants.h"
+#include "../include/fastHisto.h"
 
 using namespace std;
 
-extern Config config;
-
-int calculateGammaCorrection(string inputFileName, ofstream& logFile, string treeName, string outputFileName)
+int calculateGammaCorrection(string inputFileName, ofstream& logFile, string treeName, string outputFileName, const Config& config)
 {
     // test if output file already exists
     ifstream f(outputFileName);
@@ -82,22 +81,55 @@ int calculateGammaCorrection(string inputFileName, ofstream& logFile, string tre
     double timeDiff;
     double microTime;
 
+    // read the event data once; both passes below use these copies
+    vector<double> timeDiffs(totalEntries);
+    vector<int> macroNos(totalEntries);
+    vector<int> lgQs(totalEntries);
+
     for(long i=0; i<totalEntries; i++)
     {
         tree->GetEntry(i);
 
-        timeDiff = completeTime-macroTime;
-        microTime = fmod(timeDiff,config.facility.MICRO_LENGTH);
-
-        uncorrectedTOF->Fill(microTime);
+        timeDiffs[i] = completeTime-macroTime;
+        macroNos[i] = macroNo;
+        lgQs[i] = lgQ;
 
         if(i%10000==0)
         {
-            cout << "Processed " << i << " events into uncorrectedTOF...\r";
+            cout << "Read " << i << " events for gamma correction...\r";
             fflush(stdout);
         }
     }
 
+    // fill uncorrectedTOF in parallel
+    unsigned int numberOfThreads = getNumberOfThreads();
+    vector<FastHisto1D> threadTOFs(numberOfThreads,
+            FastHisto1D("uncorrectedTOF", "uncorrectedTOF",
+                config.plot.TOF_BINS,
+                config.plot.TOF_LOWER_BOUND,
+                config.plot.TOF_UPPER_BOUND));
+
+    fillInParallel(totalEntries, numberOfThreads,
+            [&](unsigned int thread, long begin, long end)
+            {
+                for(long j=begin; j<end; j++)
+                {
+                    threadTOFs[thread].fill(fmod(timeDiffs[j],config.facility.MICRO_LENGTH));
+                }
+            });
+
+    for(unsigned int t=1; t<numberOfThreads; t++)
+    {
+        threadTOFs[0].add(threadTOFs[t]);
+    }
+
+    for(int i=0; i<=config.plot.TOF_BINS+1; i++)
+    {
+        uncorrectedTOF->SetBinContent(i, threadTOFs[0].getBinContent(i));
+    }
+
+    uncorrectedTOF->SetEntries(threadTOFs[0].getEntries());
+
     vector<double> sumsOfNeighborhood(config.plot.TOF_BINS,0);
 
     int binNeighborhood = config.plot.TOF_BINS_PER_NS;
@@ -175,9 +207,10 @@ int calculateGammaCorrection(string inputFileName, ofstream& logFile, string tre
 
     for(long i=0; i<totalEntries; i++)
     {
-        tree->GetEntry(i);
+        timeDiff = timeDiffs[i];
+        macroNo = macroNos[i];
+        lgQ = lgQs[i];
 
-        timeDiff = completeTime-macroTime;
         microTime = fmod(timeDiff,config.facility.MICRO_LENGTH);
         microNo = floor(timeDiff/config.facility.MICRO_LENGTH);
 
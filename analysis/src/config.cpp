@@ -1,5 +1,6 @@
 #include "../include/config.h"
 #include "../include/experiment.h"
+#include "../include/configRegistry.h"
 
 #include <string>
 #include <vector>
@@ -123,17 +124,57 @@ PlotConfig::PlotConfig(std::vector<std::string> v)
     NUMBER_ENERGY_BINS = stoi(v[5]);
 }
 
+ChannelConfig::ChannelConfig(const DigitizerConfig& digitizer, const CSConfig& cs, const AnalysisConfig& analysis)
+{
+    for(auto& channel : digitizer.CHANNEL_MAP)
+    {
+        ChannelRole role = ChannelRole::DETECTOR;
+
+        if(channel.second=="-")
+        {
+            role = ChannelRole::UNUSED;
+        }
+
+        else if(channel.second=="macroTime")
+        {
+            role = ChannelRole::MACRO_TIME;
+        }
+
+        else if(channel.second=="targetChanger")
+        {
+            role = ChannelRole::TARGET_CHANGER;
+        }
+
+        else if(channel.second==analysis.MONITOR_TREE_NAME)
+        {
+            role = ChannelRole::MONITOR;
+        }
+
+        else if(channel.second=="veto")
+        {
+            role = ChannelRole::VETO;
+        }
+
+        int detectorNumber = -1;
+        for(int i=0; (size_t)i<cs.DETECTOR_NAMES.size(); i++)
+        {
+            if(channel.second==cs.DETECTOR_NAMES[i])
+            {
+                detectorNumber = i;
+                break;
+            }
+        }
+
+        ROLES.push_back(role);
+        DETECTOR_NUMBERS.push_back(detectorNumber);
+        NEEDS_FINE_TIME.push_back(role==ChannelRole::DETECTOR || role==ChannelRole::VETO);
+    }
+}
+
 Config::Config(std::string expName, int runNumber)
 {
-    facility = readFacilityConfig(expName, runNumber);
-    softwareCFD = readSoftwareCFDConfig(expName, runNumber);
-    target = readTargetConfig(expName, runNumber);
-    cs = readCSConfig(expName, runNumber);
-    plot = readPlotConfig(expName, runNumber);
-    digitizer = readDigitizerConfig(expName, runNumber);
-    time = readTimeConfig(expName, runNumber);
-    deadtime = readDeadtimeConfig(expName);
-    analysis = readAnalysisConfig(expName);
+    // each experiment's config files are only read once per process
+    *this = *getConfigRegistry(expName).getConfig(runNumber);
 
     std::cout << "Finished reading experiment config data." << std::endl;
 }
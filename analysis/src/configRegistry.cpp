@@ -0,0 +1,100 @@
+#include "../include/configRegistry.h"
+#include "../include/config.h"
+#include "../include/experiment.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <iostream>
+#include <utility> // for pair
+
+using namespace std;
+
+ConfigRegistry::ConfigRegistry(string expName) : expName(expName)
+{
+    string experimentLocation = "../" + expName + "/";
+
+    analysis = readAnalysisConfig(expName);
+    deadtime = readDeadtimeConfig(expName);
+
+    facilityTable = RunRangeTable(experimentLocation + "FacilityConfig.txt", "facility configuration");
+    softwareCFDTable = RunRangeTable(experimentLocation + "softwareCFDConfig.txt", "software CFD configuration");
+    targetGatesTable = RunRangeTable(experimentLocation + "TargetConfig.txt", "target configuration");
+    targetOrderTable = RunRangeTable(experimentLocation + "TargetOrder.txt", "target order data");
+    csTable = RunRangeTable(experimentLocation + "CSConfig.txt", "CS configuration");
+    plotTable = RunRangeTable(experimentLocation + "PlotConfig.txt", "plot configuration");
+    digitizerTable = RunRangeTable(experimentLocation + "DigitizerConfig.txt", "digitizer configuration");
+    channelMapTable = RunRangeTable(experimentLocation + "channelMap.txt", "channel mapping");
+    timeTable = RunRangeTable(experimentLocation + "TimeConfig.txt", "time configuration");
+}
+
+shared_ptr<const Config> ConfigRegistry::getConfig(int runNumber)
+{
+    vector<int> lines = {
+        facilityTable.findLine(runNumber),
+        softwareCFDTable.findLine(runNumber),
+        targetGatesTable.findLine(runNumber),
+        targetOrderTable.findLine(runNumber),
+        csTable.findLine(runNumber),
+        plotTable.findLine(runNumber),
+        digitizerTable.findLine(runNumber),
+        channelMapTable.findLine(runNumber),
+        timeTable.findLine(runNumber)
+    };
+
+    lock_guard<mutex> lock(snapshotsMutex);
+
+    auto it = snapshots.find(lines);
+    if(it!=snapshots.end())
+    {
+        return it->second;
+    }
+
+    // same order (and so the same first error, if any) as reading each file
+    // with the read*Config functions
+    Config runConfig;
+
+    runConfig.facility = FacilityConfig(facilityTable.find(runNumber));
+    runConfig.softwareCFD = SoftwareCFDConfig(softwareCFDTable.find(runNumber));
+    runConfig.target = TargetConfig(targetOrderTable.find(runNumber),
+            makeTargetGates(targetGatesTable.find(runNumber)));
+    runConfig.cs = CSConfig(csTable.find(runNumber));
+    runConfig.plot = PlotConfig(plotTable.find(runNumber));
+
+    vector<pair<int, string>> channelMap = makeChannelMap(channelMapTable.find(runNumber));
+    if(channelMap.size()==0)
+    {
+        cerr << "Error: failed to recover a channel mapping from " << channelMapTable.getFileLocation() << "." << endl;
+        exit(1);
+    }
+
+    runConfig.digitizer = DigitizerConfig(channelMap, digitizerTable.find(runNumber));
+    runConfig.time = TimeConfig(timeTable.find(runNumber));
+    runConfig.deadtime = deadtime;
+    runConfig.analysis = analysis;
+    runConfig.channels = ChannelConfig(runConfig.digitizer, runConfig.cs, runConfig.analysis);
+
+    shared_ptr<const Config> snapshot = make_shared<const Config>(runConfig);
+    snapshots.insert(make_pair(lines, snapshot));
+
+    return snapshot;
+}
+
+ConfigRegistry& getConfigRegistry(string expName)
+{
+    static map<string, unique_ptr<ConfigRegistry>> registries;
+    static mutex registriesMutex;
+
+    lock_guard<mutex> lock(registriesMutex);
+
+    auto it = registries.find(expName);
+    if(it==registries.end())
+    {
+        it = registries.insert(make_pair(expName,
+                    unique_ptr<ConfigRegistry>(new ConfigRegistry(expName)))).first;
+    }
+
+    return *it->second;
+}
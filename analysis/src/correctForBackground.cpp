@@ -14,16 +14,10 @@
 
 using namespace std;
 
-extern Config config;
-
-int correctForBackground(CSPrereqs& csp)
+int correctForBackground(CSPrereqs& csp, const Config& config)
 {
-    // create corrected histo
-    string correctedTOFName = csp.TOFHisto->GetName();
-    correctedTOFName = correctedTOFName + "BGCorrected";
-    TH1D* correctedTOF = (TH1D*)csp.TOFHisto->Clone(correctedTOFName.c_str());
-
-    int numberOfBins = csp.TOFHisto->GetNbinsX();
+    // corrected in place
+    int numberOfBins = csp.TOF.getNBins();
 
     const double GAMMA_TIME = pow(10,7)*config.facility.FLIGHT_DISTANCE/C;
     const double GAMMA_WINDOW_WIDTH = 0.8;
@@ -96,7 +90,7 @@ int correctForBackground(CSPrereqs& csp)
 
     for(int i=1; i<=(GAMMA_TIME-10)*config.plot.TOF_BINS_PER_NS; i++)
     {
-        backgroundCounts += csp.TOFHisto->GetBinContent(i);
+        backgroundCounts += csp.TOF.getBinContent(i);
         backgroundBins++;
     }
 
@@ -104,11 +98,9 @@ int correctForBackground(CSPrereqs& csp)
 
     for(int i=1; i<=numberOfBins; i++)
     {
-        correctedTOF->SetBinContent(
-                i, correctedTOF->GetBinContent(i)-backgroundCounts);
+        csp.TOF.setBinContent(
+                i, csp.TOF.getBinContent(i)-backgroundCounts);
     }
 
-    csp.TOFHisto = correctedTOF;
-
     return 0;
 }
@@ -9,17 +9,16 @@
 #include "../include/physicalConstants.h"
 #include "../include/correctForDeadtime.h"
 #include "../include/config.h"
+#include "../include/macroCounter.h"
 
 using namespace std;
 
-extern Config config;
-
 // logistic curve for deadtime response
 // (calculated by fitting "time difference between events" histogram using a
 // logistic curve)
 
 // input x in ns
-double logisticDeadtimeFunction(double x)
+double logisticDeadtimeFunction(double x, const Config& config)
 {
     if(x<config.deadtime.LOGISTIC_MU-15)
     {
@@ -29,7 +28,7 @@ double logisticDeadtimeFunction(double x)
     return (1-1/(1+exp(-config.deadtime.LOGISTIC_K*(x-config.deadtime.LOGISTIC_MU))));
 }
 
-int generateDeadtimeCorrection(TH1D*& TOFtoCorrect, TH1D*& deadtimeHisto, const int& numberOfPeriods)
+int generateDeadtimeCorrection(TH1D*& TOFtoCorrect, TH1D*& deadtimeHisto, const int& numberOfPeriods, const Config& config)
 {
     int DEADTIME_BINS = (config.deadtime.LOGISTIC_MU+15)*config.plot.TOF_BINS_PER_NS;
 
@@ -52,12 +51,12 @@ int generateDeadtimeCorrection(TH1D*& TOFtoCorrect, TH1D*& deadtimeHisto, const
         {
             if((i-j)<0)
             {
-                deadtimePerBin[i] += measuredRatePerBin[(i-j)+numberOfBins]*logisticDeadtimeFunction(((double)j)/config.plot.TOF_BINS_PER_NS);
+                deadtimePerBin[i] += measuredRatePerBin[(i-j)+numberOfBins]*logisticDeadtimeFunction(((double)j)/config.plot.TOF_BINS_PER_NS, config);
             }
 
             else
             {
-                deadtimePerBin[i] += measuredRatePerBin[i-j]*logisticDeadtimeFunction(((double)j)/config.plot.TOF_BINS_PER_NS);
+                deadtimePerBin[i] += measuredRatePerBin[i-j]*logisticDeadtimeFunction(((double)j)/config.plot.TOF_BINS_PER_NS, config);
             }
         }
 
@@ -67,7 +66,88 @@ int generateDeadtimeCorrection(TH1D*& TOFtoCorrect, TH1D*& deadtimeHisto, const
     return 0;
 }
 
-int applyDeadtimeCorrection(string inputFileName, string deadtimeFileName, string macroFileName, string gammaCorrectionFileName, ofstream& logFile, string outputFileName)
+int readAverageGammaTime(string gammaCorrectionFileName, double& averageGammaTime, const Config& config)
+{
+    // open gamma correction file
+    TFile* gammaCorrectionFile = new TFile(gammaCorrectionFileName.c_str(),"READ");
+    if(!gammaCorrectionFile->IsOpen())
+    {
+        cerr << "Error: failed to open " << gammaCorrectionFileName << "  to read gamma correction." << endl;
+        return 1;
+    }
+
+    TDirectory* gammaDirectory = (TDirectory*)gammaCorrectionFile->Get(config.analysis.GAMMA_CORRECTION_TREE_NAME.c_str());
+    if(!gammaDirectory)
+    {
+        cerr << "Error: failed to open " << config.analysis.GAMMA_CORRECTION_TREE_NAME << " directory in " << gammaCorrectionFileName << " for reading gamma corrections." << endl;
+        gammaCorrectionFile->Close();
+        return 1;
+    }
+
+    gammaDirectory->cd();
+
+    TH1D* gammaCorrectionHisto = (TH1D*)gammaDirectory->Get("gammaCorrection");
+    if(!gammaCorrectionHisto)
+    {
+        cerr << "Error: failed to open gammaCorrections histo in " << gammaCorrectionFileName << " for reading gamma corrections." << endl;
+        gammaCorrectionFile->Close();
+        return 1;
+    }
+
+    int gammaCorrectionBins = gammaCorrectionHisto->GetNbinsX();
+    if(gammaCorrectionBins<=0)
+    {
+        cerr << "Cannot divide by 0 to calculate overall average gamma time (in readAverageGammaTime)." << endl;
+        gammaCorrectionFile->Close();
+        return 1;
+    }
+
+    averageGammaTime = 0;
+
+    for(int i=1; i<=gammaCorrectionBins; i++)
+    {
+        averageGammaTime += gammaCorrectionHisto->GetBinContent(i);
+    }
+
+    averageGammaTime /= gammaCorrectionBins;
+
+    gammaCorrectionFile->Close();
+
+    return 0;
+}
+
+void correctTOFForDeadtime(TH1D* TOF, TH1D* deadtimeHisto, double averageGammaTime, double numberOfMicros, TH1D* correctedTOF)
+{
+    // the deadtime histogram is in uncorrected (raw) time; shift by the
+    // average gamma time to line it up with the gamma-corrected TOF
+    int deadtimeBins = deadtimeHisto->GetNbinsX();
+    double deadtimeBinsPerNs = deadtimeBins/
+        (deadtimeHisto->GetXaxis()->GetXmax()-deadtimeHisto->GetXaxis()->GetXmin());
+
+    int deadtimeBinOffset = floor(deadtimeBinsPerNs*averageGammaTime);
+
+    int numberOfBins = TOF->GetNbinsX();
+
+    for(int i=1; i<=numberOfBins; i++)
+    {
+        double originalBin = TOF->GetBinContent(i);
+
+        // TOF and deadtime histograms normally share a binning, in which case
+        // this is bin i+deadtimeBinOffset
+        int deadtimeBin = deadtimeHisto->FindBin(TOF->GetBinCenter(i))+deadtimeBinOffset;
+
+        if(deadtimeBin > deadtimeBins)
+        {
+            deadtimeBin -= deadtimeBins;
+        }
+
+        double deadtime = deadtimeHisto->GetBinContent(deadtimeBin);
+
+        correctedTOF->SetBinContent(i, -log(1-(originalBin/numberOfMicros)/(1-deadtime))*numberOfMicros);
+    }
+}
+
+int applyDeadtimeCorrection(string inputFileName, string deadtimeFileName, string macroFileName, string gammaCorrectionFileName, ofstream& logFile, string outputFileName, const Config& config)
 {
     // test if output file already exists
     ifstream f(outputFileName);
@@ -105,48 +185,12 @@ int applyDeadtimeCorrection(string inputFileName, string deadtimeFileName, strin
         return 1;
     }
 
-    // open gamma correction file
-    TFile* gammaCorrectionFile = new TFile(gammaCorrectionFileName.c_str(),"READ");
-    if(!gammaCorrectionFile->IsOpen())
-    {
-        cerr << "Error: failed to open " << gammaCorrectionFileName << "  to read gamma correction." << endl;
-        return 1;
-    }
-
-    TDirectory* gammaDirectory = (TDirectory*)gammaCorrectionFile->Get(config.analysis.GAMMA_CORRECTION_TREE_NAME.c_str());
-    if(!gammaDirectory)
-    {
-        cerr << "Error: failed to open " << config.analysis.GAMMA_CORRECTION_TREE_NAME << " directory in " << gammaCorrectionFileName << " for reading gamma corrections." << endl;
-        return 1;
-    }
-
-    gammaDirectory->cd();
-
-    TH1D* gammaCorrectionHisto = (TH1D*)gammaDirectory->Get("gammaCorrection");
-    if(!gammaCorrectionHisto)
-    {
-        cerr << "Error: failed to open gammaCorrections histo in " << gammaCorrectionFileName << " for reading gamma corrections." << endl;
-        return 1;
-    }
-
-    double overallAverageGammaTime = 0;
-
-    int gammaCorrectionBins = gammaCorrectionHisto->GetNbinsX();
-    if(gammaCorrectionBins<=0)
+    double overallAverageGammaTime;
+    if(readAverageGammaTime(gammaCorrectionFileName, overallAverageGammaTime, config))
     {
-        cerr << "Cannot divide by 0 to calculate overall average gamma time (in applyDeadtimeCorrection)." << endl;
         return 1;
     }
 
-    for(int i=1; i<=gammaCorrectionBins; i++)
-    {
-        overallAverageGammaTime += gammaCorrectionHisto->GetBinContent(i);
-    }
-
-    overallAverageGammaTime /= gammaCorrectionBins;
-
-    int deadtimeBinOffset = floor(config.plot.TOF_BINS_PER_NS*(overallAverageGammaTime));
-
     // create outputFile
     TFile* outputFile = new TFile(outputFileName.c_str(),"CREATE");
 
@@ -207,11 +251,11 @@ int applyDeadtimeCorrection(string inputFileName, string deadtimeFileName, strin
                 return 1;
             }
 
-            string macroHistoName = targetName + "MacroNumber";
-            TH1I* macroHisto = (TH1I*)macroDirectory->Get(macroHistoName.c_str());
-            if(!macroHisto)
+            string macroCounterName = targetName + "MacroNumber";
+            MacroCounter macroCounter;
+            if(macroCounter.read(macroDirectory, macroCounterName))
             {
-                cerr << "Error: failed to find " << macroHistoName << " in "
+                cerr << "Error: failed to find " << macroCounterName << " in "
                     << channelName << " of " << macroFileName << "." << endl;
 
                 outputFile->Close();
@@ -223,16 +267,7 @@ int applyDeadtimeCorrection(string inputFileName, string deadtimeFileName, strin
             string correctedTOFName = TOFHistoName;
             TH1D* correctedTOF = (TH1D*)TOF->Clone(correctedTOFName.c_str());
 
-            int numberOfMacroBins = macroHisto->GetNbinsX();
-            int numberOfMacros = 0;
-
-            for(int j=1; j<=numberOfMacroBins; j++)
-            {
-                if(macroHisto->GetBinContent(j)>=1)
-                {
-                    numberOfMacros++;
-                }
-            }
+            int numberOfMacros = macroCounter.getNumberOfMacros();
 
             double numberOfMicros = numberOfMacros
                 *(config.facility.LAST_GOOD_MICRO-config.facility.FIRST_GOOD_MICRO);
@@ -247,26 +282,7 @@ int applyDeadtimeCorrection(string inputFileName, string deadtimeFileName, strin
                 return 1;
             }
 
-            int numberOfBins = TOF->GetNbinsX();
-
-            for(int i=1; i<=numberOfBins; i++)
-            {
-                double originalBin = TOF->GetBinContent(i);
-
-                double deadtime;
-
-                if(i+deadtimeBinOffset > numberOfBins)
-                {
-                    deadtime = deadtimeHisto->GetBinContent(i+deadtimeBinOffset-numberOfBins);
-                }
-
-                else
-                {
-                    deadtime = deadtimeHisto->GetBinContent(i+deadtimeBinOffset);
-                }
-
-                correctedTOF->SetBinContent(i, -log(1-(originalBin/numberOfMicros)/(1-deadtime))*numberOfMicros);
-            }
+            correctTOFForDeadtime(TOF, deadtimeHisto, overallAverageGammaTime, numberOfMicros, correctedTOF);
 
             correctedTOF->Write();
         }
@@ -279,7 +295,7 @@ int applyDeadtimeCorrection(string inputFileName, string deadtimeFileName, strin
     return 0;
 }
 
-int generateDeadtimeCorrection(string inputFileName, ofstream& logFile, string outputFileName)
+int generateDeadtimeCorrection(string inputFileName, ofstream& logFile, string outputFileName, const Config& config)
 {
     // test if output file already exists
     ifstream f(outputFileName);
@@ -322,25 +338,23 @@ int generateDeadtimeCorrection(string inputFileName, ofstream& logFile, string o
             string TOFHistoName = targetName + "TOF";
             TH1D* TOF = (TH1D*)detectorDirectory->Get(TOFHistoName.c_str());
 
-            string macroHistoName = targetName + "MacroNumber";
-            TH1I* macroHisto = (TH1I*)detectorDirectory->Get(macroHistoName.c_str());
-            int numberOfBins = macroHisto->GetNbinsX();
-            int numberOfMacros = 0;
-
-            for(int j=1; j<=numberOfBins; j++)
+            string macroCounterName = targetName + "MacroNumber";
+            MacroCounter macroCounter;
+            if(macroCounter.read(detectorDirectory, macroCounterName))
             {
-                if(macroHisto->GetBinContent(j)>=1)
-                {
-                    numberOfMacros++;
-                }
+                outputFile->Close();
+                inputFile->Close();
+                return 1;
             }
 
+            int numberOfMacros = macroCounter.getNumberOfMacros();
+
             double numberOfMicros = numberOfMacros
                 *(config.facility.LAST_GOOD_MICRO-config.facility.FIRST_GOOD_MICRO);
 
             string deadtimeHistoName = targetName + "Deadtime";
             TH1D* deadtimeHisto = (TH1D*)TOF->Clone(deadtimeHistoName.c_str());
-            generateDeadtimeCorrection(TOF, deadtimeHisto, numberOfMicros);
+            generateDeadtimeCorrection(TOF, deadtimeHisto, numberOfMicros, config);
 
             deadtimeHisto->Write();
         }
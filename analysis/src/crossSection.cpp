@@ -18,14 +18,13 @@
 #include "TH1.h"
 #include "TF1.h"
 #include "TFile.h"
+#include "TTree.h"
 #include "TAxis.h"
 #include "TGraphAsymmErrors.h"
 #include "TGraphAsymmErrors.h"
 
 using namespace std;
 
-extern Config config;
-
 CrossSection::CrossSection() {}
 
 CrossSection::CrossSection(string n) : name(n) {}
@@ -40,7 +39,7 @@ void CrossSection::addDataPoint(DataPoint dataPoint)
     dataSet.addPoint(dataPoint);
 }
 
-DataSet CrossSection::getDataSet()
+const DataSet& CrossSection::getDataSet() const
 {
     return dataSet;
 }
@@ -64,85 +63,44 @@ DataPoint CrossSection::getDataPoint(int i) const
     return dataSet.getPoint(i);
 }
 
-vector<double> CrossSection::getEnergyValues() const
+const vector<double>& CrossSection::getEnergyValues() const
 {
-    vector<double> energyValues;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        energyValues.push_back(dataSet.getPoint(i).getXValue());
-    }
-    return energyValues;
+    return dataSet.getXValues();
 }
 
-vector<double> CrossSection::getEnergyErrors() const
+const vector<double>& CrossSection::getEnergyErrors() const
 {
-    vector<double> energyErrors;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        energyErrors.push_back(dataSet.getPoint(i).getXError());
-    }
-    return energyErrors;
+    return dataSet.getXErrors();
 }
 
-vector<double> CrossSection::getEnergyErrorsL() const
+const vector<double>& CrossSection::getEnergyErrorsL() const
 {
-    vector<double> energyErrorsL;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        energyErrorsL.push_back(dataSet.getPoint(i).getXErrorL());
-    }
-
-    return energyErrorsL;
+    return dataSet.getXErrorsL();
 }
 
-vector<double> CrossSection::getEnergyErrorsR() const
+const vector<double>& CrossSection::getEnergyErrorsR() const
 {
-    vector<double> energyErrorsR;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        energyErrorsR.push_back(dataSet.getPoint(i).getXErrorR());
-    }
-    return energyErrorsR;
+    return dataSet.getXErrorsR();
 }
 
-vector<double> CrossSection::getCrossSectionValues() const
+const vector<double>& CrossSection::getCrossSectionValues() const
 {
-    vector<double> crossSectionValues;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        crossSectionValues.push_back(dataSet.getPoint(i).getYValue());
-    }
-    return crossSectionValues;
+    return dataSet.getYValues();
 }
 
-vector<double> CrossSection::getCrossSectionErrors() const
+const vector<double>& CrossSection::getCrossSectionErrors() const
 {
-    vector<double> crossSectionErrors;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        crossSectionErrors.push_back(dataSet.getPoint(i).getYError());
-    }
-    return crossSectionErrors;
+    return dataSet.getYErrors();
 }
 
-vector<double> CrossSection::getStatErrors() const
+const vector<double>& CrossSection::getStatErrors() const
 {
-    vector<double> statErrors;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        statErrors.push_back(dataSet.getPoint(i).getStatError());
-    }
-    return statErrors;
+    return dataSet.getStatErrors();
 }
 
-vector<double> CrossSection::getSysErrors() const
+const vector<double>& CrossSection::getSysErrors() const
 {
-    vector<double> sysErrors;
-    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
-    {
-        sysErrors.push_back(dataSet.getPoint(i).getSysError());
-    }
-    return sysErrors;
+    return dataSet.getSysErrors();
 }
 
 double CrossSection::getArealDensity() const
@@ -210,12 +168,12 @@ CrossSection operator*(const CrossSection& cs, double factor)
 void CrossSection::createGraph(string name, string title)
 {
     TGraphAsymmErrors* t = new TGraphAsymmErrors(getNumberOfPoints(),
-                                      &getEnergyValues()[0],
-                                      &getCrossSectionValues()[0],
-                                      &getEnergyErrorsL()[0],
-                                      &getEnergyErrorsR()[0],
-                                      &getCrossSectionErrors()[0],
-                                      &getCrossSectionErrors()[0]);
+                                      getEnergyValues().data(),
+                                      getCrossSectionValues().data(),
+                                      getEnergyErrorsL().data(),
+                                      getEnergyErrorsR().data(),
+                                      getCrossSectionErrors().data(),
+                                      getCrossSectionErrors().data());
     t->SetNameTitle(name.c_str(),title.c_str());
     gDirectory->WriteTObject(t);
 }
@@ -223,28 +181,60 @@ void CrossSection::createGraph(string name, string title)
 void CrossSection::createStatErrorsGraph(string name, string title)
 {
     TGraphAsymmErrors* t = new TGraphAsymmErrors(getNumberOfPoints(),
-                                      &getEnergyValues()[0],
-                                      &getCrossSectionValues()[0],
-                                      &getEnergyErrorsL()[0],
-                                      &getEnergyErrorsR()[0],
-                                      &getStatErrors()[0],
-                                      &getStatErrors()[0]);
+                                      getEnergyValues().data(),
+                                      getCrossSectionValues().data(),
+                                      getEnergyErrorsL().data(),
+                                      getEnergyErrorsR().data(),
+                                      getStatErrors().data(),
+                                      getStatErrors().data());
     t->SetNameTitle(name.c_str(),title.c_str());
     gDirectory->WriteTObject(t);
 }
 void CrossSection::createSysErrorsGraph(string name, string title)
 {
     TGraphAsymmErrors* t = new TGraphAsymmErrors(getNumberOfPoints(),
-                                      &getEnergyValues()[0],
-                                      &getCrossSectionValues()[0],
-                                      &getEnergyErrorsL()[0],
-                                      &getEnergyErrorsR()[0],
-                                      &getSysErrors()[0],
-                                      &getSysErrors()[0]);
+                                      getEnergyValues().data(),
+                                      getCrossSectionValues().data(),
+                                      getEnergyErrorsL().data(),
+                                      getEnergyErrorsR().data(),
+                                      getSysErrors().data(),
+                                      getSysErrors().data());
     t->SetNameTitle(name.c_str(),title.c_str());
     gDirectory->WriteTObject(t);
 }
 
+void CrossSection::createCountsTree(string name)
+{
+    double energy;
+    double targetDetCounts;
+    double blankDetCounts;
+    double targetMonitorCounts;
+    double blankMonitorCounts;
+    double arealDensityValue = arealDensity;
+
+    TTree* tree = new TTree(name.c_str(), name.c_str());
+    tree->Branch("energy", &energy, "energy/D");
+    tree->Branch("targetDetCounts", &targetDetCounts, "targetDetCounts/D");
+    tree->Branch("blankDetCounts", &blankDetCounts, "blankDetCounts/D");
+    tree->Branch("targetMonitorCounts", &targetMonitorCounts, "targetMonitorCounts/D");
+    tree->Branch("blankMonitorCounts", &blankMonitorCounts, "blankMonitorCounts/D");
+    tree->Branch("arealDensity", &arealDensityValue, "arealDensity/D");
+
+    for(int i=0; i<getNumberOfPoints(); i++)
+    {
+        energy = dataSet.getXValues()[i];
+        targetDetCounts = dataSet.getTargetDetCounts()[i];
+        blankDetCounts = dataSet.getBlankDetCounts()[i];
+        targetMonitorCounts = dataSet.getTargetMonitorCounts()[i];
+        blankMonitorCounts = dataSet.getBlankMonitorCounts()[i];
+
+        tree->Fill();
+    }
+
+    gDirectory->WriteTObject(tree);
+    delete tree;
+}
+
 double CrossSection::calculateRMSError()
 {
     double RMSError = 0;
@@ -268,7 +258,7 @@ double CrossSection::calculateRMSError()
     return RMSError;
 }
 
-double calculateTOFSigma(TH1D* TOFHisto)
+double calculateTOFSigma(TH1D* TOFHisto, const Config& config)
 {
     // define gamma times
     const double GAMMA_TIME = pow(10,7)*config.facility.FLIGHT_DISTANCE/C;
@@ -291,10 +281,19 @@ double calculateTOFSigma(TH1D* TOFHisto)
     return tofSigma;
 }
 
-void CrossSection::calculateCS(const CSPrereqs& targetData, const CSPrereqs& blankData)
+double calculateArealDensity(const Target& target)
+{
+    // calculate number of atoms in this target
+    double numberOfAtoms =
+        (target.getMass()/target.getMolarMass())*AVOGADROS_NUMBER;
+
+    return numberOfAtoms/(pow(target.getDiameter()/2,2)*M_PI); // area of cylinder end
+}
+
+void CrossSection::calculateCS(const CSPrereqs& targetData, const CSPrereqs& blankData, const Config& config)
 {
     // define variables to hold cross section information
-    int numberOfBins = targetData.energyHisto->GetNbinsX();
+    int numberOfBins = targetData.energy.getNBins();
 
     // calculate the ratio of target/blank monitor counts (normalize
     // flux/macropulse)
@@ -304,8 +303,8 @@ void CrossSection::calculateCS(const CSPrereqs& targetData, const CSPrereqs& bla
     double monitorRatio = tMon/bMon;
 
     // read data from detector histograms for target and blank
-    TH1D* bEnergyHisto = blankData.energyHisto;
-    TH1D* tEnergyHisto = targetData.energyHisto;
+    const WeightedHisto1D& bEnergyHisto = blankData.energy;
+    const WeightedHisto1D& tEnergyHisto = targetData.energy;
 
     // calculate the ratio of target/blank good macropulse ratio (normalize
     // macropulse number)
@@ -314,13 +313,9 @@ void CrossSection::calculateCS(const CSPrereqs& targetData, const CSPrereqs& bla
 
     double avgFluxRatio = monitorRatio*goodMacroRatio;
 
-    // calculate number of atoms in this target
-    double numberOfAtoms =
-        (targetData.target.getMass()/targetData.target.getMolarMass())*AVOGADROS_NUMBER;
-
     // calculate areal density (atoms/cm^2) in target
-    double arealDensity =
-        numberOfAtoms/(pow(targetData.target.getDiameter()/2,2)*M_PI); // area of cylinder end
+    double arealDensity = calculateArealDensity(targetData.target);
+    setArealDensity(arealDensity);
 
     double massError =
         targetData.target.getMassUncertainty()/targetData.target.getMass();
@@ -334,18 +329,18 @@ void CrossSection::calculateCS(const CSPrereqs& targetData, const CSPrereqs& bla
     double arealDensityErrorPercent =
         pow(pow(massError,2) + pow(molarMassError,2) + pow(diameterError,2),0.5); // as percent
 
-    double tofSigma = 1; //calculateTOFSigma(targetData.TOFHisto);
+    double tofSigma = 1; //calculateTOFSigma(targetData.TOF, config);
 
     // loop through each bin in the energy histo, calculating a cross section
     // for each bin
     for(int i=1; i<=numberOfBins; i++) // skip the overflow and underflow bins
     {
-        double energyValue = tEnergyHisto->GetBinCenter(i);
-        double energyErrorL = calculateEnergyErrorL(tEnergyHisto->GetBinCenter(i), tofSigma);
-        double energyErrorR = calculateEnergyErrorR(tEnergyHisto->GetBinCenter(i), tofSigma);
+        double energyValue = tEnergyHisto.getBinCenter(i);
+        double energyErrorL = calculateEnergyErrorL(tEnergyHisto.getBinCenter(i), tofSigma, config);
+        double energyErrorR = calculateEnergyErrorR(tEnergyHisto.getBinCenter(i), tofSigma, config);
 
-        double tCounts = tEnergyHisto->GetBinContent(i);
-        double bCounts = bEnergyHisto->GetBinContent(i);
+        double tCounts = tEnergyHisto.getBinContent(i);
+        double bCounts = bEnergyHisto.getBinContent(i);
 
         // calculate the ratio of target/blank counts in the detector
         double detectorRatio = tCounts/bCounts;
@@ -0,0 +1,798 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TGraphAsymmErrors.h"
+
+#include "../include/csRecipe.h"
+#include "../include/CSUtilities.h"
+#include "../include/crossSection.h"
+#include "../include/dataSet.h"
+#include "../include/dataPoint.h"
+#include "../include/toyMC.h"
+#include "../include/fastHisto.h"
+
+using namespace std;
+
+bool GraphLocation::operator<(const GraphLocation& other) const
+{
+    if(fileName!=other.fileName)
+    {
+        return fileName<other.fileName;
+    }
+
+    return graphName<other.graphName;
+}
+
+bool GraphLocation::operator==(const GraphLocation& other) const
+{
+    return fileName==other.fileName && graphName==other.graphName;
+}
+
+struct OperationSyntax
+{
+    string name;
+    CSOperation operation;
+    int numberOfArguments;
+};
+
+// the utilities' command lines (see each one's main)
+static const vector<OperationSyntax> OPERATIONS = {
+    {"subtractCS", CSOperation::SUBTRACT, 7},
+    {"shiftCS", CSOperation::SHIFT, 5},
+    {"multiplyCS", CSOperation::MULTIPLY, 4},
+    {"relativeCS", CSOperation::RELATIVE, 6},
+    {"relativeDiffCS", CSOperation::RELATIVE_DIFF, 6},
+    {"mergeCS", CSOperation::MERGE, 7},
+    {"applyCSCorrectionFactor", CSOperation::CORRECT, 6},
+    {"scaledownCS", CSOperation::SCALEDOWN, 5}
+};
+
+static bool isNameCharacter(char c)
+{
+    return isalnum((unsigned char)c) || c=='_';
+}
+
+// Expand the variable named at line[i] (just after a '$') onto word, moving i
+// past its name. A '$' not followed by a name is kept as is.
+static int expandVariable(const string& line, size_t& i,
+        const map<string, string>& variables, string& word)
+{
+    string name;
+
+    if(i<line.size() && line[i]=='{')
+    {
+        size_t end = line.find('}', i);
+        if(end==string::npos)
+        {
+            cerr << "Error: unterminated ${ in recipe line \"" << line << "\"" << endl;
+            return 1;
+        }
+
+        name = line.substr(i+1, end-i-1);
+        i = end+1;
+    }
+
+    else
+    {
+        while(i<line.size() && isNameCharacter(line[i]))
+        {
+            name += line[i];
+            i++;
+        }
+    }
+
+    if(name.empty())
+    {
+        word += '$';
+        return 0;
+    }
+
+    auto variable = variables.find(name);
+    if(variable==variables.end())
+    {
+        cerr << "Error: undefined variable " << name << " in recipe line \"" << line << "\"" << endl;
+        return 1;
+    }
+
+    word += variable->second;
+    return 0;
+}
+
+// Split line[begin, end) into words, as the shell would
+static int splitWords(const string& line, size_t begin,
+        const map<string, string>& variables, vector<string>& words)
+{
+    string word;
+    bool inWord = false;
+
+    size_t i = begin;
+    while(i<line.size())
+    {
+        char c = line[i];
+
+        if(isspace((unsigned char)c))
+        {
+            if(inWord)
+            {
+                words.push_back(word);
+                word.clear();
+                inWord = false;
+            }
+
+            i++;
+            continue;
+        }
+
+        // comment to the end of the line
+        if(c=='#' && !inWord)
+        {
+            break;
+        }
+
+        inWord = true;
+
+        if(c=='\'')
+        {
+            size_t end = line.find('\'', i+1);
+            if(end==string::npos)
+            {
+                cerr << "Error: unterminated quote in recipe line \"" << line << "\"" << endl;
+                return 1;
+            }
+
+            word += line.substr(i+1, end-i-1);
+            i = end+1;
+        }
+
+        else if(c=='"')
+        {
+            i++;
+            while(i<line.size() && line[i]!='"')
+            {
+                if(line[i]=='$')
+                {
+                    i++;
+                    if(expandVariable(line, i, variables, word))
+                    {
+                        return 1;
+                    }
+                }
+
+                else if(line[i]=='\\' && i+1<line.size()
+                        && (line[i+1]=='"' || line[i+1]=='\\' || line[i+1]=='$'))
+                {
+                    word += line[i+1];
+                    i += 2;
+                }
+
+                else
+                {
+                    word += line[i];
+                    i++;
+                }
+            }
+
+            if(i>=line.size())
+            {
+                cerr << "Error: unterminated quote in recipe line \"" << line << "\"" << endl;
+                return 1;
+            }
+
+            i++;
+        }
+
+        else if(c=='$')
+        {
+            i++;
+            if(expandVariable(line, i, variables, word))
+            {
+                return 1;
+            }
+        }
+
+        else if(c=='\\' && i+1<line.size())
+        {
+            word += line[i+1];
+            i += 2;
+        }
+
+        else
+        {
+            word += c;
+            i++;
+        }
+    }
+
+    if(inWord)
+    {
+        words.push_back(word);
+    }
+
+    return 0;
+}
+
+static int parseNumber(const string& word, double& value)
+{
+    char* end;
+    value = strtod(word.c_str(), &end);
+
+    return (word.empty() || *end!='\0');
+}
+
+// Fill in a step's inputs, outputs and numerical arguments from the
+// arguments of its utility
+static int parseStep(const vector<string>& arguments, RecipeStep& step)
+{
+    vector<string> numbers;
+
+    switch(step.operation)
+    {
+        case CSOperation::SUBTRACT:
+            // [raw file] [raw graph] [subtrahend file] [subtrahend graph]
+            // [factor] [divisor] [output graph, in raw file]
+            step.inputs = {{arguments[0], arguments[1]}, {arguments[2], arguments[3]}};
+            step.outputs = {{arguments[0], arguments[6]}};
+            numbers = {arguments[4], arguments[5]};
+            break;
+
+        case CSOperation::SHIFT:
+            // [raw file] [raw graph] [shift] [output file] [output graph]
+            step.inputs = {{arguments[0], arguments[1]}};
+            step.outputs = {{arguments[3], arguments[4]}};
+            numbers = {arguments[2]};
+            break;
+
+        case CSOperation::MULTIPLY:
+            // [raw file] [raw graph] [factor] [output graph, in raw file]
+            step.inputs = {{arguments[0], arguments[1]}};
+            step.outputs = {{arguments[0], arguments[3]}};
+            numbers = {arguments[2]};
+            break;
+
+        case CSOperation::RELATIVE:
+        case CSOperation::RELATIVE_DIFF:
+            // [first file] [first graph] [second file] [second graph]
+            // [output file] [output graph] (and <output graph>rms)
+            step.inputs = {{arguments[0], arguments[1]}, {arguments[2], arguments[3]}};
+            step.outputs = {{arguments[4], arguments[5]}, {arguments[4], arguments[5] + "rms"}};
+            break;
+
+        case CSOperation::MERGE:
+            // [first file] [first graph] [second file] [second graph]
+            // [juncture] [output file] [output graph]
+            step.inputs = {{arguments[0], arguments[1]}, {arguments[2], arguments[3]}};
+            step.outputs = {{arguments[5], arguments[6]}};
+            numbers = {arguments[4]};
+            break;
+
+        case CSOperation::CORRECT:
+            // [correction file] [correction graph] [raw file] [raw graph]
+            // [output file] [output graph]
+            step.inputs = {{arguments[0], arguments[1]}, {arguments[2], arguments[3]}};
+            step.outputs = {{arguments[4], arguments[5]}};
+            break;
+
+        case CSOperation::SCALEDOWN:
+            // [raw file] [raw graph] [scaledown] [output file] [output graph]
+            step.inputs = {{arguments[0], arguments[1]}};
+            step.outputs = {{arguments[3], arguments[4]}};
+            numbers = {arguments[2]};
+            break;
+    }
+
+    step.parameter = 0;
+    step.divisor = 1;
+
+    for(unsigned int i=0; i<numbers.size(); i++)
+    {
+        double value;
+        if(parseNumber(numbers[i], value))
+        {
+            cerr << "Error: expected a number, not \"" << numbers[i] << "\"" << endl;
+            return 1;
+        }
+
+        (i==0 ? step.parameter : step.divisor) = value;
+    }
+
+    if(step.operation==CSOperation::SCALEDOWN
+            && (step.parameter<1 || step.parameter!=floor(step.parameter)))
+    {
+        cerr << "Error: scaledown must be a positive integer, not " << numbers[0] << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// true if the line ends in a backslash outside quotes (the shell's line
+// continuation)
+static bool endsWithContinuation(const string& line)
+{
+    size_t length = line.size();
+    if(length && line[length-1]=='\r')
+    {
+        length--;
+    }
+
+    bool inWord = false;
+    char quote = 0;
+
+    for(size_t i=0; i<length; i++)
+    {
+        char c = line[i];
+
+        if(quote)
+        {
+            if(c==quote)
+            {
+                quote = 0;
+            }
+
+            else if(quote=='"' && c=='\\')
+            {
+                i++;
+            }
+
+            continue;
+        }
+
+        if(isspace((unsigned char)c))
+        {
+            inWord = false;
+            continue;
+        }
+
+        // comment to the end of the line
+        if(c=='#' && !inWord)
+        {
+            return false;
+        }
+
+        inWord = true;
+
+        if(c=='\'' || c=='"')
+        {
+            quote = c;
+        }
+
+        else if(c=='\\')
+        {
+            if(i+1==length)
+            {
+                return true;
+            }
+
+            i++;
+        }
+    }
+
+    return false;
+}
+
+int readCSRecipe(string fileName, vector<RecipeStep>& steps)
+{
+    ifstream file;
+    if(fileName!="-")
+    {
+        file.open(fileName);
+        if(!file.is_open())
+        {
+            cerr << "Error: couldn't open recipe " << fileName << endl;
+            return 1;
+        }
+    }
+
+    istream& recipe = (fileName=="-") ? cin : file;
+
+    map<string, string> variables;
+    steps.clear();
+
+    string line;
+    int lineNumber = 0;
+
+    while(getline(recipe, line))
+    {
+        lineNumber++;
+
+        // join continued lines (dropping the backslash and newline)
+        string nextLine;
+        while(endsWithContinuation(line) && getline(recipe, nextLine))
+        {
+            lineNumber++;
+
+            line.erase(line.find_last_of('\\'));
+            line += nextLine;
+        }
+
+        size_t begin = line.find_first_not_of(" \t\r");
+        if(begin==string::npos || line[begin]=='#')
+        {
+            continue;
+        }
+
+        // variable assignment
+        size_t end = begin;
+        while(end<line.size() && isNameCharacter(line[end]))
+        {
+            end++;
+        }
+
+        if(end>begin && end<line.size() && line[end]=='=' && !isdigit((unsigned char)line[begin]))
+        {
+            vector<string> value;
+            if(splitWords(line, end+1, variables, value) || value.size()>1)
+            {
+                cerr << "Error: couldn't read assignment on line " << lineNumber
+                    << " of " << fileName << endl;
+                return 1;
+            }
+
+            variables[line.substr(begin, end-begin)] = value.empty() ? "" : value[0];
+            continue;
+        }
+
+        vector<string> words;
+        if(splitWords(line, begin, variables, words))
+        {
+            cerr << "Error: couldn't read line " << lineNumber << " of " << fileName << endl;
+            return 1;
+        }
+
+        if(words.empty())
+        {
+            continue;
+        }
+
+        // the utility's name, without the path to its binary
+        string name = words[0].substr(words[0].rfind('/')+1);
+
+        auto syntax = find_if(OPERATIONS.begin(), OPERATIONS.end(),
+                [&](const OperationSyntax& o) { return o.name==name; });
+
+        if(syntax==OPERATIONS.end())
+        {
+            cerr << "Error: line " << lineNumber << " of " << fileName
+                << " doesn't call a cross section utility: " << line << endl;
+            return 1;
+        }
+
+        vector<string> arguments(words.begin()+1, words.end());
+        if((int)arguments.size()!=syntax->numberOfArguments)
+        {
+            cerr << "Error: " << name << " takes " << syntax->numberOfArguments
+                << " arguments, but line " << lineNumber << " of " << fileName
+                << " gives " << arguments.size() << endl;
+            return 1;
+        }
+
+        RecipeStep step;
+        step.operation = syntax->operation;
+        step.command = name;
+        step.lineNumber = lineNumber;
+
+        if(parseStep(arguments, step))
+        {
+            cerr << "Error: couldn't read line " << lineNumber << " of " << fileName << endl;
+            return 1;
+        }
+
+        steps.push_back(step);
+    }
+
+    return 0;
+}
+
+// The data set a later line reads back from the graph CrossSection::
+// createGraph writes (as DataSet(TGraphAsymmErrors*, ...) would give)
+static DataSet asReadBack(const DataSet& dataSet)
+{
+    DataSet readBack;
+    readBack.reserve(dataSet.getNumberOfPoints());
+
+    const vector<double>& xErrorsL = dataSet.getXErrorsL();
+    const vector<double>& xErrorsR = dataSet.getXErrorsR();
+
+    for(int i=0; i<dataSet.getNumberOfPoints(); i++)
+    {
+        readBack.addPoint(DataPoint(dataSet.getXValues()[i],
+                    sqrt(0.5*(pow(xErrorsL[i],2)+pow(xErrorsR[i],2))),
+                    dataSet.getYValues()[i],
+                    dataSet.getYErrors()[i]));
+    }
+
+    return readBack;
+}
+
+static void evaluateStep(const RecipeStep& step, const vector<const DataSet*>& inputs,
+        vector<DataSet>& outputs)
+{
+    DataSet firstCSData;
+    DataSet secondCSData;
+
+    switch(step.operation)
+    {
+        case CSOperation::SUBTRACT:
+            outputs.push_back(subtractDataSets(*inputs[0], *inputs[1], step.parameter, step.divisor));
+            break;
+
+        case CSOperation::SHIFT:
+            outputs.push_back(*inputs[0]+step.parameter);
+            break;
+
+        case CSOperation::MULTIPLY:
+            outputs.push_back(*inputs[0]*step.parameter);
+            break;
+
+        case CSOperation::RELATIVE:
+            outputs.push_back(relativeDataSets(*inputs[0], *inputs[1], firstCSData, secondCSData));
+            outputs.push_back(calculateRunningRMS(firstCSData, secondCSData));
+            break;
+
+        case CSOperation::RELATIVE_DIFF:
+            outputs.push_back(relativeDiffDataSets(*inputs[0], *inputs[1], firstCSData, secondCSData));
+            outputs.push_back(calculateRunningRMS(firstCSData, secondCSData));
+            break;
+
+        case CSOperation::MERGE:
+            outputs.push_back(mergeDataSets(*inputs[0], step.parameter, *inputs[1]));
+            break;
+
+        case CSOperation::CORRECT:
+            outputs.push_back(correctDataSet(*inputs[0], *inputs[1]));
+            break;
+
+        case CSOperation::SCALEDOWN:
+            outputs.push_back(scaledownDataSet(*inputs[0], (int)step.parameter));
+            break;
+    }
+}
+
+// where a step's input comes from: output (step, output) of an earlier step,
+// or, with step -1, a graph read from a file
+struct InputSource
+{
+    int step;
+    int index;
+};
+
+int evaluateCSRecipe(const vector<RecipeStep>& steps, unsigned int numberOfThreads)
+{
+    int numberOfSteps = steps.size();
+
+    // link each input to the last earlier line writing it, if any; each
+    // step's level is one past that of the latest step it waits for
+    map<GraphLocation, InputSource> latestOutputs;
+
+    vector<GraphLocation> fileInputs;
+    map<GraphLocation, int> fileInputIndices;
+    vector<bool> needsCounts;
+
+    vector<vector<InputSource>> sources(numberOfSteps);
+    vector<int> levels(numberOfSteps, 0);
+    int numberOfLevels = 0;
+
+    for(int s=0; s<numberOfSteps; s++)
+    {
+        const RecipeStep& step = steps[s];
+
+        bool relative = (step.operation==CSOperation::RELATIVE
+                || step.operation==CSOperation::RELATIVE_DIFF);
+
+        for(const GraphLocation& input : step.inputs)
+        {
+            auto output = latestOutputs.find(input);
+            if(output!=latestOutputs.end())
+            {
+                sources[s].push_back(output->second);
+                levels[s] = max(levels[s], levels[output->second.step]+1);
+                continue;
+            }
+
+            auto fileInput = fileInputIndices.find(input);
+            if(fileInput==fileInputIndices.end())
+            {
+                fileInput = fileInputIndices.insert(make_pair(input, (int)fileInputs.size())).first;
+                fileInputs.push_back(input);
+                needsCounts.push_back(false);
+            }
+
+            sources[s].push_back(InputSource{-1, fileInput->second});
+
+            // relative cross sections also propagate errors from counts
+            if(relative)
+            {
+                needsCounts[fileInput->second] = true;
+            }
+        }
+
+        for(unsigned int k=0; k<step.outputs.size(); k++)
+        {
+            latestOutputs[step.outputs[k]] = InputSource{s, (int)k};
+        }
+
+        numberOfLevels = max(numberOfLevels, levels[s]+1);
+    }
+
+    // read every input graph (and counts tree) from files, opening each file once
+    map<string, vector<int>> fileInputsByFile;
+    for(unsigned int i=0; i<fileInputs.size(); i++)
+    {
+        fileInputsByFile[fileInputs[i].fileName].push_back(i);
+    }
+
+    vector<DataSet> fileData(fileInputs.size());
+    vector<vector<PointCounts>> fileCounts(fileInputs.size());
+    vector<bool> hasCounts(fileInputs.size(), false);
+
+    for(auto& file : fileInputsByFile)
+    {
+        TFile* inputFile = new TFile(file.first.c_str(),"READ");
+        if(!inputFile->IsOpen())
+        {
+            cerr << "Error: couldn't open " << file.first << "." << endl;
+            return 1;
+        }
+
+        for(int i : file.second)
+        {
+            const string& graphName = fileInputs[i].graphName;
+
+            TGraphAsymmErrors* graph = (TGraphAsymmErrors*)inputFile->Get(graphName.c_str());
+            if(!graph)
+            {
+                cerr << "Error: failed to find " << graphName << " in " << file.first << endl;
+                inputFile->Close();
+                return 1;
+            }
+
+            fileData[i] = DataSet(graph, graphName);
+
+            if(needsCounts[i])
+            {
+                hasCounts[i] = !readPointCounts(inputFile, graphName + "Counts", fileCounts[i]);
+            }
+        }
+
+        inputFile->Close();
+    }
+
+    cout << "Read " << fileInputs.size() << " graphs from " << fileInputsByFile.size()
+        << " files." << endl;
+
+    // evaluate level by level; the steps of a level depend only on earlier
+    // levels
+    vector<vector<DataSet>> results(numberOfSteps);
+    vector<vector<DataSet>> readBacks(numberOfSteps);
+
+    for(int level=0; level<numberOfLevels; level++)
+    {
+        vector<int> levelSteps;
+        for(int s=0; s<numberOfSteps; s++)
+        {
+            if(levels[s]==level)
+            {
+                levelSteps.push_back(s);
+            }
+        }
+
+        runInParallel(levelSteps.size(), numberOfThreads, [&](long i)
+                {
+                    int s = levelSteps[i];
+
+                    vector<const DataSet*> inputs;
+                    for(const InputSource& source : sources[s])
+                    {
+                        inputs.push_back(source.step<0 ? &fileData[source.index]
+                                : &readBacks[source.step][source.index]);
+                    }
+
+                    evaluateStep(steps[s], inputs, results[s]);
+
+                    for(const DataSet& result : results[s])
+                    {
+                        readBacks[s].push_back(asReadBack(result));
+                    }
+                });
+    }
+
+    // write outputs, grouped by file (in the order files are first written);
+    // a graph written by several lines is written once, from the last
+    vector<string> outputFileNames;
+    map<string, vector<InputSource>> outputsByFile;
+
+    for(int s=0; s<numberOfSteps; s++)
+    {
+        for(unsigned int k=0; k<steps[s].outputs.size(); k++)
+        {
+            const GraphLocation& output = steps[s].outputs[k];
+
+            const InputSource& latest = latestOutputs[output];
+            if(latest.step!=s || latest.index!=(int)k)
+            {
+                continue;
+            }
+
+            if(outputsByFile.find(output.fileName)==outputsByFile.end())
+            {
+                outputFileNames.push_back(output.fileName);
+            }
+
+            outputsByFile[output.fileName].push_back(latest);
+        }
+    }
+
+    int numberOfGraphs = 0;
+
+    for(const string& fileName : outputFileNames)
+    {
+        TFile* outputFile = new TFile(fileName.c_str(),"UPDATE");
+        if(!outputFile->IsOpen())
+        {
+            cerr << "Error: couldn't open " << fileName << " for writing." << endl;
+            return 1;
+        }
+
+        outputFile->cd();
+
+        for(const InputSource& output : outputsByFile[fileName])
+        {
+            const RecipeStep& step = steps[output.step];
+            const DataSet& result = results[output.step][output.index];
+            string graphName = step.outputs[output.index].graphName;
+
+            bool relative = (step.operation==CSOperation::RELATIVE
+                    || step.operation==CSOperation::RELATIVE_DIFF);
+
+            numberOfGraphs++;
+
+            if(relative && output.index==1)
+            {
+                writeRunningRMS(result, step.outputs[0].graphName);
+                continue;
+            }
+
+            CrossSection outputCS;
+            outputCS.addDataSet(result);
+            outputCS.createGraph(graphName, graphName);
+
+            if(!relative)
+            {
+                continue;
+            }
+
+            // as relativeCS and relativeDiffCS do, propagate errors of
+            // cross sections with counts by toy Monte Carlo
+            const InputSource& first = sources[output.step][0];
+            const InputSource& second = sources[output.step][1];
+
+            if(first.step>=0 || second.step>=0 || !hasCounts[first.index] || !hasCounts[second.index])
+            {
+                cout << "No counts trees for " << step.inputs[0].graphName << " and "
+                    << step.inputs[1].graphName << "; skipping toy MC error propagation." << endl;
+                continue;
+            }
+
+            addToyMCBands(fileData[first.index], fileCounts[first.index],
+                    fileData[second.index], fileCounts[second.index],
+                    step.operation==CSOperation::RELATIVE ?
+                    ToyMCQuantity::RATIO : ToyMCQuantity::RELATIVE_DIFFERENCE,
+                    graphName);
+        }
+
+        outputFile->Close();
+    }
+
+    cout << "Evaluated " << numberOfSteps << " recipe lines in " << numberOfLevels
+        << " stages; wrote " << numberOfGraphs << " graphs to " << outputFileNames.size()
+        << " files." << endl;
+
+    return 0;
+}
@@ -3,6 +3,8 @@
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
 #include "TMath.h"
 #include "TFile.h"
 
@@ -17,9 +19,11 @@ DataSet::DataSet()
 
 DataSet::DataSet(std::vector<double> var1, std::vector<double> var2, std::vector<double> var3, std::string ref)
 {
+    reserve(var1.size());
+
     for(int i=0; (size_t)i<var1.size(); i++)
     {
-        data.push_back(DataPoint(var1[i],0,var2[i],var3[i]));
+        addPoint(DataPoint(var1[i],0,var2[i],var3[i]));
     }
 
     reference = ref;
@@ -45,7 +49,7 @@ DataSet::DataSet(string dataSetLocation)
 
     while(dataFile >> dum >> dum2 >> dum3)
     {
-        data.push_back(DataPoint(dum, 0, dum2, dum3, 0, 0));
+        addPoint(DataPoint(dum, 0, dum2, dum3, 0, 0));
     }
 
     createPlot(reference);
@@ -54,54 +58,153 @@ DataSet::DataSet(string dataSetLocation)
 
 DataSet::DataSet(string dataSetLocation, const vector<double>& energyBins)
 {
-    std::ifstream dataFile(dataSetLocation.c_str());
-    if(!dataFile.is_open())
+    string contents;
+    if(readFileContents(dataSetLocation, contents))
     {
         std::cout << "Attempted to create DataSet, but failed to find " << dataSetLocation << std::endl;
         exit(1);
     }
 
-    vector<DataPoint> rawDataPoints;
+    vector<double> energies;
+    vector<double> crossSections;
+    vector<double> errors;
+    parseLitData(contents, reference, energies, crossSections, errors);
 
-    string dummy;
-    std::getline(dataFile,dummy);
-    std::getline(dataFile,reference);
-    std::getline(dataFile,dummy);
+    vector<double> binEnergies;
+    vector<double> binCrossSections;
+    vector<double> binErrors;
+    binLitData(energies, crossSections, errors, energyBins,
+            binEnergies, binCrossSections, binErrors);
 
-    double dum,dum2,dum3;
+    reserve(binEnergies.size());
 
-    while(dataFile >> dum >> dum2 >> dum3)
+    for(int i=0; (size_t)i<binEnergies.size(); i++)
+    {
+        addPoint(DataPoint(binEnergies[i], 0, binCrossSections[i], binErrors[i]));
+    }
+
+    createPlot(reference);
+}
+
+int readFileContents(const string& fileName, string& contents)
+{
+    ifstream file(fileName, ios::binary);
+    if(!file.is_open())
+    {
+        return 1;
+    }
+
+    file.seekg(0, ios::end);
+    long length = file.tellg();
+    file.seekg(0, ios::beg);
+
+    if(length<0)
     {
-        rawDataPoints.push_back(DataPoint(dum, 0, dum2, dum3));
+        return 1;
     }
 
-    vector<vector<DataPoint>> binnedDataPoints;
+    contents.assign(length, ' ');
+    file.read(&contents[0], length);
+
+    return file.good() || file.eof() ? 0 : 1;
+}
+
+void parseLitData(const string& contents, string& reference,
+        vector<double>& energies, vector<double>& crossSections, vector<double>& errors)
+{
+    energies.clear();
+    crossSections.clear();
+    errors.clear();
+
+    // three header lines; the second is the reference
+    size_t position = 0;
+    for(int line=0; line<3; line++)
+    {
+        size_t end = contents.find('\n', position);
+        if(end==string::npos)
+        {
+            end = contents.size();
+        }
+
+        if(line==1)
+        {
+            reference = contents.substr(position, end-position);
+        }
+
+        position = min(end+1, contents.size());
+    }
+
+    // strtod needs a terminated string; std::string provides one
+    const char* cursor = contents.c_str()+position;
+
+    while(true)
+    {
+        double values[3];
+        int parsed = 0;
+
+        for(; parsed<3; parsed++)
+        {
+            char* next;
+            values[parsed] = strtod(cursor, &next);
+            if(next==cursor)
+            {
+                break;
+            }
+
+            cursor = next;
+        }
+
+        // like stream extraction, stop at the first incomplete triple
+        if(parsed<3)
+        {
+            break;
+        }
+
+        energies.push_back(values[0]);
+        crossSections.push_back(values[1]);
+        errors.push_back(values[2]);
+    }
+}
+
+void binLitData(const vector<double>& energies, const vector<double>& crossSections,
+        const vector<double>& errors, const vector<double>& energyBins,
+        vector<double>& binEnergies, vector<double>& binCrossSections, vector<double>& binErrors)
+{
+    binEnergies.clear();
+    binCrossSections.clear();
+    binErrors.clear();
 
-    for(int i=0; i<energyBins.size()-1; i++)
+    if(energyBins.size()<2)
     {
-        binnedDataPoints.push_back(vector<DataPoint>());
+        return;
     }
 
+    int numberOfBins = energyBins.size()-1;
+
+    vector<double> crossSectionSums(numberOfBins, 0);
+    vector<double> errorSums(numberOfBins, 0);
+    vector<int> pointsInBin(numberOfBins, 0);
+
     int energyBinCounter = 0;
     double lowEnergy = energyBins[energyBinCounter];
     double highEnergy = energyBins[energyBinCounter+1];
 
-    bool endSort = false;
-
-    // average data in rawDataPoints according to energy bins
-    for(int i=0; i<rawDataPoints.size(); i++)
+    // walk the points (in increasing energy) and the bins together
+    for(size_t i=0; i<energies.size(); i++)
     {
-        DataPoint dp = rawDataPoints[i];
+        double energy = energies[i];
 
-        if(dp.getXValue() < lowEnergy)
+        if(energy < lowEnergy)
         {
             continue;
         }
 
-        while(dp.getXValue() > highEnergy)
+        bool endSort = false;
+
+        while(energy > highEnergy)
         {
             energyBinCounter++;
-            if(energyBinCounter>=energyBins.size()-1)
+            if(energyBinCounter>=numberOfBins)
             {
                 endSort = true;
                 break;
@@ -115,12 +218,13 @@ DataSet::DataSet(string dataSetLocation, const vector<double>& energyBins)
         {
             break;
         }
-        
-        if(dp.getXValue()>=lowEnergy
-                && dp.getXValue()<=highEnergy)
+
+        if(energy>=lowEnergy && energy<=highEnergy)
         {
             // found correct bin for this data point
-            binnedDataPoints[energyBinCounter].push_back(dp);
+            crossSectionSums[energyBinCounter] += crossSections[i];
+            errorSums[energyBinCounter] += errors[i];
+            pointsInBin[energyBinCounter]++;
         }
 
         else
@@ -128,40 +232,19 @@ DataSet::DataSet(string dataSetLocation, const vector<double>& energyBins)
             cerr << "Error: assignment error while reading literature dataset. Exiting..." << endl;
             exit(1);
         }
-
-        if(i%10==0)
-        {
-            cout << "Read " << i << " data points in from literature file...\r";
-            fflush(stdout);
-        }
     }
 
-    for(int i=0; i<binnedDataPoints.size(); i++)
+    for(int i=0; i<numberOfBins; i++)
     {
-        double averageCrossSection = 0;
-        double averageError = 0;
-
-        for(int j=0; j<binnedDataPoints[i].size(); j++)
-        {
-            averageCrossSection += binnedDataPoints[i][j].getYValue();
-            averageError += binnedDataPoints[i][j].getYError();
-        }
-
-        if(binnedDataPoints[i].size()==0)
+        if(pointsInBin[i]==0)
         {
             continue;
         }
 
-        averageCrossSection /= binnedDataPoints[i].size();
-        averageError /= binnedDataPoints[i].size();
-
-        double energy = (energyBins[i] + energyBins[i+1])/2;
-
-        data.push_back(DataPoint(energy, 0, averageCrossSection, averageError));
+        binEnergies.push_back((energyBins[i] + energyBins[i+1])/2);
+        binCrossSections.push_back(crossSectionSums[i]/pointsInBin[i]);
+        binErrors.push_back(errorSums[i]/pointsInBin[i]);
     }
-
-    createPlot(reference);
-    dataFile.close();
 }
 
 DataSet::DataSet(TGraphAsymmErrors* graph, string ref)
@@ -174,18 +257,15 @@ DataSet::DataSet(TGraphAsymmErrors* graph, string ref)
 
     int numberOfPoints = graph->GetN();
 
-    vector<double> x (numberOfPoints, 0);
-    vector<double> y (numberOfPoints, 0);
-    vector<double> xError (numberOfPoints, 0);
-    vector<double> yError (numberOfPoints, 0);
+    reserve(numberOfPoints);
 
     for(int i=0; i<numberOfPoints; i++)
     {
-        graph->GetPoint(i,x[i],y[i]);
-        xError[i] = graph->GetErrorX(i);
-        yError[i] = graph->GetErrorY(i);
+        double x;
+        double y;
+        graph->GetPoint(i,x,y);
 
-        addPoint(DataPoint(x[i],xError[i],y[i],yError[i]));
+        addPoint(DataPoint(x,graph->GetErrorX(i),y,graph->GetErrorY(i)));
     }
 
     reference = ref; 
@@ -193,12 +273,70 @@ DataSet::DataSet(TGraphAsymmErrors* graph, string ref)
 
 void DataSet::addPoint(DataPoint dataPoint)
 {
-    data.push_back(dataPoint);
+    xValues.push_back(dataPoint.getXValue());
+    xErrorsL.push_back(dataPoint.getXErrorL());
+    xErrorsR.push_back(dataPoint.getXErrorR());
+
+    yValues.push_back(dataPoint.getYValue());
+    yErrors.push_back(dataPoint.getYError());
+    statErrors.push_back(dataPoint.getStatError());
+    sysErrors.push_back(dataPoint.getSysError());
+
+    blankMonitorCounts.push_back(dataPoint.getBlankMonitorCounts());
+    targetMonitorCounts.push_back(dataPoint.getTargetMonitorCounts());
+    blankDetCounts.push_back(dataPoint.getBlankDetCounts());
+    targetDetCounts.push_back(dataPoint.getTargetDetCounts());
+}
+
+void DataSet::reserve(int numberOfPoints)
+{
+    for(vector<double>* column :
+            {&xValues, &xErrorsL, &xErrorsR,
+             &yValues, &yErrors, &statErrors, &sysErrors,
+             &blankMonitorCounts, &targetMonitorCounts, &blankDetCounts, &targetDetCounts})
+    {
+        column->reserve(numberOfPoints);
+    }
 }
 
 DataPoint DataSet::getPoint(int i) const
 {
-    return data[i];
+    return DataPoint(xValues[i], xErrorsL[i], xErrorsR[i],
+            yValues[i], yErrors[i], statErrors[i], sysErrors[i],
+            blankMonitorCounts[i], targetMonitorCounts[i],
+            blankDetCounts[i], targetDetCounts[i]);
+}
+
+double DataSet::evaluate(double xValue) const
+{
+    int n = xValues.size();
+    if(n==0)
+    {
+        return 0;
+    }
+
+    if(n==1)
+    {
+        return yValues[0];
+    }
+
+    // first point at or above xValue
+    int up = lower_bound(xValues.begin(), xValues.end(), xValue) - xValues.begin();
+    if(up<n && xValues[up]==xValue)
+    {
+        return yValues[up];
+    }
+
+    // outside the data, extrapolate from the first or last two points
+    up = max(1, min(n-1, up));
+    int low = up-1;
+
+    if(xValues[low]==xValues[up])
+    {
+        return yValues[low];
+    }
+
+    return yValues[up] + (xValue-xValues[up])*(yValues[low]-yValues[up])/(xValues[low]-xValues[up]);
 }
 
 TGraphAsymmErrors* DataSet::getPlot() const
@@ -218,7 +356,79 @@ void DataSet::setReference(string reference)
 
 int DataSet::getNumberOfPoints() const
 {
-    return data.size();
+    return xValues.size();
+}
+
+// Column kernels backing the DataSet arithmetic operators: each works on
+// whole columns of n points, with no per-point objects, in loops the compiler
+// can vectorize. Results are those of the per-point error propagation in
+// DataPoint (sqrt in place of pow(x,0.5)).
+
+// out = sqrt(a^2 + b^2)
+static void addInQuadrature(const double* a, const double* b, double* out, int n)
+{
+    for(int i=0; i<n; i++)
+    {
+        out[i] = sqrt(a[i]*a[i] + b[i]*b[i]);
+    }
+}
+
+// error of c = a*b or c = a/b: |c|*sqrt((aError/a)^2 + (bError/b)^2)
+static void addRelativeInQuadrature(const double* a, const double* aError,
+        const double* b, const double* bError, const double* c, double* cError, int n)
+{
+    for(int i=0; i<n; i++)
+    {
+        double aRelative = aError[i]/a[i];
+        double bRelative = bError[i]/b[i];
+
+        cError[i] = fabs(c[i])*sqrt(aRelative*aRelative + bRelative*bRelative);
+    }
+}
+
+// out = a*factor
+static void scale(const double* a, double factor, double* out, int n)
+{
+    for(int i=0; i<n; i++)
+    {
+        out[i] = a[i]*factor;
+    }
+}
+
+// out = a/divisor
+static void divide(const double* a, double divisor, double* out, int n)
+{
+    for(int i=0; i<n; i++)
+    {
+        out[i] = a[i]/divisor;
+    }
+}
+
+// Number of leading points whose x-values agree in both sets. Operators on two
+// sets only combine those points (and report the first mismatch, if any).
+static int countMatchingPoints(const vector<double>& x1, const vector<double>& x2)
+{
+    int n = x1.size();
+    for(int i=0; i<n; i++)
+    {
+        if(x1[i]!=x2[i])
+        {
+            return i;
+        }
+    }
+
+    return n;
+}
+
+void DataSet::resize(int numberOfPoints)
+{
+    for(vector<double>* column :
+            {&xValues, &xErrorsL, &xErrorsR,
+             &yValues, &yErrors, &statErrors, &sysErrors,
+             &blankMonitorCounts, &targetMonitorCounts, &blankDetCounts, &targetDetCounts})
+    {
+        column->assign(numberOfPoints, 0);
+    }
 }
 
 const DataSet operator+(const DataSet& set1, const DataSet& set2)
@@ -230,23 +440,25 @@ const DataSet operator+(const DataSet& set1, const DataSet& set2)
         return summedDataSet;
     }
 
-    for (int i=0; i<set1.getNumberOfPoints(); i++)
+    int n = countMatchingPoints(set1.xValues, set2.xValues);
+    summedDataSet.resize(n);
+
+    copy(set1.xValues.begin(), set1.xValues.begin()+n, summedDataSet.xValues.begin());
+    copy(set1.xErrorsL.begin(), set1.xErrorsL.begin()+n, summedDataSet.xErrorsL.begin());
+    copy(set1.xErrorsL.begin(), set1.xErrorsL.begin()+n, summedDataSet.xErrorsR.begin());
+
+    for(int i=0; i<n; i++)
     {
-        if (set1.getPoint(i).getXValue()!=set2.getPoint(i).getXValue())
-        {
-            cerr << "Error: there was an energy mismatch between a data point in set 1\
-                and a data point in set 2. Returning summed dataSet." << endl;
-            return summedDataSet;
-        }
+        summedDataSet.yValues[i] = set1.yValues[i] + set2.yValues[i];
+    }
 
-        double xValue = set1.getPoint(i).getXValue();
-        double xError = set1.getPoint(i).getXError();
-        double yValue = set1.getPoint(i).getYValue() +
-                        set2.getPoint(i).getYValue();
-        double yError = pow(pow(set1.getPoint(i).getYError(),2) +
-                            pow(set2.getPoint(i).getYError(),2),0.5);
+    addInQuadrature(set1.yErrors.data(), set2.yErrors.data(), summedDataSet.yErrors.data(), n);
 
-        summedDataSet.addPoint(DataPoint(xValue,xError,yValue,yError));
+    if(n<set1.getNumberOfPoints())
+    {
+        cerr << "Error: there was an energy mismatch between a data point in set 1\
+            and a data point in set 2. Returning summed dataSet." << endl;
+        return summedDataSet;
     }
 
     summedDataSet.setReference(set1.getReference() + set2.getReference() + "sum");
@@ -262,16 +474,33 @@ const DataSet operator-(const DataSet& set1, const DataSet& set2)
         return differenceDataSet;
     }
 
-    for (int i=0; i<set1.getNumberOfPoints(); i++)
+    int n = countMatchingPoints(set1.xValues, set2.xValues);
+    differenceDataSet.resize(n);
+
+    copy(set1.xValues.begin(), set1.xValues.begin()+n, differenceDataSet.xValues.begin());
+    addInQuadrature(set1.xErrorsL.data(), set2.xErrorsL.data(), differenceDataSet.xErrorsL.data(), n);
+    addInQuadrature(set1.xErrorsR.data(), set2.xErrorsR.data(), differenceDataSet.xErrorsR.data(), n);
+
+    for(int i=0; i<n; i++)
     {
-        if (set1.getPoint(i).getXValue()!=set2.getPoint(i).getXValue())
-        {
-            cerr << "Error: there was an energy mismatch between a data point in set 1\
-                and a data point in set 2. Returning difference dataSet." << endl;
-            return differenceDataSet;
-        }
+        differenceDataSet.yValues[i] = set1.yValues[i] - set2.yValues[i];
+    }
+
+    addInQuadrature(set1.yErrors.data(), set2.yErrors.data(), differenceDataSet.yErrors.data(), n);
+    addInQuadrature(set1.statErrors.data(), set2.statErrors.data(), differenceDataSet.statErrors.data(), n);
+    addInQuadrature(set1.sysErrors.data(), set2.sysErrors.data(), differenceDataSet.sysErrors.data(), n);
 
-        differenceDataSet.addPoint(set1.getPoint(i)-set2.getPoint(i));
+    // counts are those of the minuend
+    copy(set1.blankMonitorCounts.begin(), set1.blankMonitorCounts.begin()+n, differenceDataSet.blankMonitorCounts.begin());
+    copy(set1.targetMonitorCounts.begin(), set1.targetMonitorCounts.begin()+n, differenceDataSet.targetMonitorCounts.begin());
+    copy(set1.blankDetCounts.begin(), set1.blankDetCounts.begin()+n, differenceDataSet.blankDetCounts.begin());
+    copy(set1.targetDetCounts.begin(), set1.targetDetCounts.begin()+n, differenceDataSet.targetDetCounts.begin());
+
+    if(n<set1.getNumberOfPoints())
+    {
+        cerr << "Error: there was an energy mismatch between a data point in set 1\
+            and a data point in set 2. Returning difference dataSet." << endl;
+        return differenceDataSet;
     }
 
     differenceDataSet.setReference(set1.getReference() + set2.getReference() + "difference");
@@ -287,24 +516,27 @@ const DataSet operator*(const DataSet& set1, const DataSet& set2)
         return productDataSet;
     }
 
-    for (int i=0; i<set1.getNumberOfPoints(); i++)
+    int n = countMatchingPoints(set1.xValues, set2.xValues);
+    productDataSet.resize(n);
+
+    copy(set1.xValues.begin(), set1.xValues.begin()+n, productDataSet.xValues.begin());
+    copy(set1.xErrorsL.begin(), set1.xErrorsL.begin()+n, productDataSet.xErrorsL.begin());
+    copy(set1.xErrorsL.begin(), set1.xErrorsL.begin()+n, productDataSet.xErrorsR.begin());
+
+    for(int i=0; i<n; i++)
     {
-        if (set1.getPoint(i).getXValue()!=set2.getPoint(i).getXValue())
-        {
-            cerr << "Error: there was an energy mismatch between a data point in set 1\
-                and a data point in set 2. Returning product dataSet." << endl;
-            return productDataSet;
-        }
+        productDataSet.yValues[i] = set1.yValues[i] * set2.yValues[i];
+    }
 
-        double xValue = set1.getPoint(i).getXValue();
-        double xError = set1.getPoint(i).getXError();
-        double yValue = set1.getPoint(i).getYValue() *
-                        set2.getPoint(i).getYValue();
-        double yError = abs(yValue)*
-                        pow(pow(set1.getPoint(i).getYError()/set1.getPoint(i).getYValue(),2) +
-                            pow(set2.getPoint(i).getYError()/set2.getPoint(i).getYValue(),2),0.5);
+    addRelativeInQuadrature(set1.yValues.data(), set1.yErrors.data(),
+            set2.yValues.data(), set2.yErrors.data(),
+            productDataSet.yValues.data(), productDataSet.yErrors.data(), n);
 
-        productDataSet.addPoint(DataPoint(xValue,xError,yValue,yError));
+    if(n<set1.getNumberOfPoints())
+    {
+        cerr << "Error: there was an energy mismatch between a data point in set 1\
+            and a data point in set 2. Returning product dataSet." << endl;
+        return productDataSet;
     }
 
     productDataSet.setReference(set1.getReference() + set2.getReference() + "product");
@@ -315,21 +547,27 @@ const DataSet operator+(const DataSet& rawDataSet, const double addend)
 {
     DataSet sum;
 
-    for(int i=0; i<rawDataSet.getNumberOfPoints(); i++)
+    int n = rawDataSet.getNumberOfPoints();
+    sum.resize(n);
+
+    sum.xValues = rawDataSet.xValues;
+    sum.xErrorsL = rawDataSet.xErrorsL;
+    sum.xErrorsR = rawDataSet.xErrorsL;
+
+    for(int i=0; i<n; i++)
     {
-        sum.addPoint(rawDataSet.getPoint(i)+addend);
+        sum.yValues[i] = rawDataSet.yValues[i] + addend;
     }
 
+    sum.yErrors = rawDataSet.yErrors;
+    sum.statErrors = rawDataSet.statErrors;
+    sum.sysErrors = rawDataSet.sysErrors;
+
     return sum;
 }
 
-vector<double> DataSet::getXValues() const
+const vector<double>& DataSet::getXValues() const
 {
-    vector<double> xValues;
-    for(const DataPoint point : data)
-    {
-        xValues.push_back(point.getXValue());
-    }
     return xValues;
 }
 
@@ -337,10 +575,17 @@ const DataSet operator*(const DataSet& multiplicand, const double multiplier)
 {
     DataSet product;
 
-    for(int i=0; i<multiplicand.getNumberOfPoints(); i++)
-    {
-        product.addPoint(multiplicand.getPoint(i)*multiplier);
-    }
+    int n = multiplicand.getNumberOfPoints();
+    product.resize(n);
+
+    product.xValues = multiplicand.xValues;
+    product.xErrorsL = multiplicand.xErrorsL;
+    product.xErrorsR = multiplicand.xErrorsL;
+
+    scale(multiplicand.yValues.data(), multiplier, product.yValues.data(), n);
+    scale(multiplicand.yErrors.data(), multiplier, product.yErrors.data(), n);
+    scale(multiplicand.statErrors.data(), multiplier, product.statErrors.data(), n);
+    scale(multiplicand.sysErrors.data(), multiplier, product.sysErrors.data(), n);
 
     return product;
 }
@@ -354,25 +599,27 @@ const DataSet operator/(const DataSet& set1, const DataSet& set2)
         return quotientDataSet;
     }
 
-    for (int i=0; i<set1.getNumberOfPoints(); i++)
+    int n = countMatchingPoints(set1.xValues, set2.xValues);
+    quotientDataSet.resize(n);
+
+    copy(set1.xValues.begin(), set1.xValues.begin()+n, quotientDataSet.xValues.begin());
+    copy(set1.xErrorsL.begin(), set1.xErrorsL.begin()+n, quotientDataSet.xErrorsL.begin());
+    copy(set1.xErrorsL.begin(), set1.xErrorsL.begin()+n, quotientDataSet.xErrorsR.begin());
+
+    for(int i=0; i<n; i++)
     {
-        if (set1.getPoint(i).getXValue()!=set2.getPoint(i).getXValue())
-        {
-            cerr << "Error: there was an energy mismatch between a data point in set 1\
-                and a data point in set 2. Returning quotient dataSet." << endl;
-            return quotientDataSet;
-        }
+        quotientDataSet.yValues[i] = set1.yValues[i] / set2.yValues[i];
+    }
 
-        double xValue = set1.getPoint(i).getXValue();
-        double xError = set1.getPoint(i).getXError();
-        double yValue = set1.getPoint(i).getYValue() /
-                        set2.getPoint(i).getYValue();
-        double yError = abs(yValue)
-            *(pow(pow(set1.getPoint(i).getYError()/set1.getPoint(i).getYValue(),2) +
-                  pow(set2.getPoint(i).getYError()/set2.getPoint(i).getYValue(),2)
-                  ,0.5));
+    addRelativeInQuadrature(set1.yValues.data(), set1.yErrors.data(),
+            set2.yValues.data(), set2.yErrors.data(),
+            quotientDataSet.yValues.data(), quotientDataSet.yErrors.data(), n);
 
-        quotientDataSet.addPoint(DataPoint(xValue,xError,yValue,yError));
+    if(n<set1.getNumberOfPoints())
+    {
+        cerr << "Error: there was an energy mismatch between a data point in set 1\
+            and a data point in set 2. Returning quotient dataSet." << endl;
+        return quotientDataSet;
     }
 
     quotientDataSet.setReference(set1.getReference() + set2.getReference() + "quotient");
@@ -388,23 +635,24 @@ const DataSet correctCSUsingControl(const DataSet& dataSetToCorrect, const DataS
         return correctedDataSet;
     }
 
-    for (int i=0; i<dataSetToCorrect.getNumberOfPoints(); i++)
-    {
-        if (dataSetToCorrect.getPoint(i).getXValue()!=correction.getPoint(i).getXValue())
-        {
-            cerr << "Error: there was an energy mismatch between a data point in set 1\
-                and a data point in set 2. Returning quotient dataSet." << endl;
-            return correctedDataSet;
-        }
+    int n = countMatchingPoints(dataSetToCorrect.xValues, correction.xValues);
+    correctedDataSet.resize(n);
+
+    copy(dataSetToCorrect.xValues.begin(), dataSetToCorrect.xValues.begin()+n, correctedDataSet.xValues.begin());
+    copy(dataSetToCorrect.xErrorsL.begin(), dataSetToCorrect.xErrorsL.begin()+n, correctedDataSet.xErrorsL.begin());
+    copy(dataSetToCorrect.xErrorsL.begin(), dataSetToCorrect.xErrorsL.begin()+n, correctedDataSet.xErrorsR.begin());
 
-        double xValue = dataSetToCorrect.getPoint(i).getXValue();
-        double xError = dataSetToCorrect.getPoint(i).getXError();
-        double yValue = dataSetToCorrect.getPoint(i).getYValue()/
-                        correction.getPoint(i).getYValue();
-        double yError = dataSetToCorrect.getPoint(i).getYError()/
-                        correction.getPoint(i).getYValue();
+    for(int i=0; i<n; i++)
+    {
+        correctedDataSet.yValues[i] = dataSetToCorrect.yValues[i]/correction.yValues[i];
+        correctedDataSet.yErrors[i] = dataSetToCorrect.yErrors[i]/correction.yValues[i];
+    }
 
-        correctedDataSet.addPoint(DataPoint(xValue,xError,yValue,yError));
+    if(n<dataSetToCorrect.getNumberOfPoints())
+    {
+        cerr << "Error: there was an energy mismatch between a data point in set 1\
+            and a data point in set 2. Returning quotient dataSet." << endl;
+        return correctedDataSet;
     }
 
     correctedDataSet.setReference(dataSetToCorrect.getReference() + correction.getReference() + "correctedByControl");
@@ -415,93 +663,85 @@ const DataSet operator/(const DataSet& dividend, const double divisor)
 {
     DataSet quotient;
 
-    for(int i=0; i<dividend.getNumberOfPoints(); i++)
-    {
-        quotient.addPoint(dividend.getPoint(i)/divisor);
-    }
+    int n = dividend.getNumberOfPoints();
+    quotient.resize(n);
+
+    quotient.xValues = dividend.xValues;
+    quotient.xErrorsL = dividend.xErrorsL;
+    quotient.xErrorsR = dividend.xErrorsL;
+
+    divide(dividend.yValues.data(), divisor, quotient.yValues.data(), n);
+    divide(dividend.yErrors.data(), divisor, quotient.yErrors.data(), n);
+    divide(dividend.statErrors.data(), divisor, quotient.statErrors.data(), n);
+    divide(dividend.sysErrors.data(), divisor, quotient.sysErrors.data(), n);
 
     return quotient;
 }
 
-vector<double> DataSet::getYValues() const
+const vector<double>& DataSet::getYValues() const
 {
-    vector<double> yValues;
-    for(const DataPoint point : data)
-    {
-        yValues.push_back(point.getYValue());
-    }
     return yValues;
 }
 
-vector<double> DataSet::getXErrors() const
+const vector<double>& DataSet::getXErrors() const
 {
-    vector<double> xErrors;
-    for(const DataPoint point : data)
-    {
-        xErrors.push_back(point.getXError());
-    }
-    return xErrors;
+    return xErrorsL;
 }
 
-vector<double> DataSet::getXErrorsL() const
+const vector<double>& DataSet::getXErrorsL() const
 {
-    vector<double> xErrorsL;
-    for(const DataPoint point : data)
-    {
-        xErrorsL.push_back(point.getXErrorL());
-    }
     return xErrorsL;
 }
 
-vector<double> DataSet::getXErrorsR() const
+const vector<double>& DataSet::getXErrorsR() const
 {
-    vector<double> xErrorsR;
-    for(const DataPoint point : data)
-    {
-        xErrorsR.push_back(point.getXErrorR());
-    }
     return xErrorsR;
 }
 
-vector<double> DataSet::getYErrors() const
+const vector<double>& DataSet::getYErrors() const
 {
-    vector<double> yErrors;
-    for(const DataPoint point : data)
-    {
-        yErrors.push_back(point.getYError());
-    }
     return yErrors;
 }
 
-vector<double> DataSet::getStatErrors() const
+const vector<double>& DataSet::getStatErrors() const
 {
-    vector<double> statErrors;
-    for(const DataPoint point : data)
-    {
-        statErrors.push_back(point.getStatError());
-    }
     return statErrors;
 }
 
-vector<double> DataSet::getSysErrors() const
+const vector<double>& DataSet::getSysErrors() const
 {
-    vector<double> sysErrors;
-    for(const DataPoint point : data)
-    {
-        sysErrors.push_back(point.getSysError());
-    }
     return sysErrors;
 }
 
+const vector<double>& DataSet::getBlankMonitorCounts() const
+{
+    return blankMonitorCounts;
+}
+
+const vector<double>& DataSet::getTargetMonitorCounts() const
+{
+    return targetMonitorCounts;
+}
+
+const vector<double>& DataSet::getBlankDetCounts() const
+{
+    return blankDetCounts;
+}
+
+const vector<double>& DataSet::getTargetDetCounts() const
+{
+    return targetDetCounts;
+}
+
 TGraphAsymmErrors* DataSet::createPlot(string name)
 {
-    dataPlot = new TGraphAsymmErrors(getXValues().size(),
-            &getXValues()[0],
-            &getYValues()[0],
-            &getXErrors()[0],
-            &getXErrors()[0],
-            &getYErrors()[0],
-            &getYErrors()[0]
+    dataPlot = new TGraphAsymmErrors(xValues.size(),
+            xValues.data(),
+            yValues.data(),
+            xErrorsL.data(),
+            xErrorsL.data(),
+            yErrors.data(),
+            yErrors.data()
             );
     dataPlot->SetNameTitle(name.c_str(),name.c_str());
     return dataPlot;
@@ -509,13 +749,13 @@ TGraphAsymmErrors* DataSet::createPlot(string name)
 
 TGraphAsymmErrors* DataSet::createStatErrorsPlot(string name)
 {
-    dataPlot = new TGraphAsymmErrors(getXValues().size(),
-            &getXValues()[0],
-            &getYValues()[0],
-            &getXErrors()[0],
-            &getXErrors()[0],
-            &getStatErrors()[0],
-            &getStatErrors()[0]
+    dataPlot = new TGraphAsymmErrors(xValues.size(),
+            xValues.data(),
+            yValues.data(),
+            xErrorsL.data(),
+            xErrorsL.data(),
+            statErrors.data(),
+            statErrors.data()
             );
     dataPlot->SetNameTitle(name.c_str(),name.c_str());
     return dataPlot;
@@ -523,13 +763,13 @@ TGraphAsymmErrors* DataSet::createStatErrorsPlot(string name)
 
 TGraphAsymmErrors* DataSet::createSysErrorsPlot(string name)
 {
-    dataPlot = new TGraphAsymmErrors(getXValues().size(),
-            &getXValues()[0],
-            &getYValues()[0],
-            &getXErrors()[0],
-            &getXErrors()[0],
-            &getSysErrors()[0],
-            &getSysErrors()[0]
+    dataPlot = new TGraphAsymmErrors(xValues.size(),
+            xValues.data(),
+            yValues.data(),
+            xErrorsL.data(),
+            xErrorsL.data(),
+            sysErrors.data(),
+            sysErrors.data()
             );
     dataPlot->SetNameTitle(name.c_str(),name.c_str());
     return dataPlot;
@@ -22,8 +22,6 @@ const unsigned int TIME_CHECK_Q_HIGH_THRESHOLD = 10000; // in ns
 const unsigned int TIME_CHECK_Q_LOW_THRESHOLD = 5000; // in ns
 const unsigned int NUMBER_OF_EVENTS = 400000;  // number of events to examine for time correlation
 
-Config config;
-
 int main(int argc, char** argv)
 {
     // open input file
@@ -46,7 +44,7 @@ int main(int argc, char** argv)
 
     int runNumber = atoi(argv[4]);
 
-    config = Config(experimentName, runNumber);
+    const Config config(experimentName, runNumber);
 
     // create a ROOT file for holding time correlation plots
     TFile* outFile = new TFile(outFileLocation.c_str(),"RECREATE");
@@ -92,7 +90,8 @@ int main(int argc, char** argv)
                         rawEvent.waveform,
                         rawEvent.baseline,
                         config.softwareCFD.CFD_FRACTION,
-                        config.softwareCFD.CFD_DELAY)
+                        config.softwareCFD.CFD_DELAY,
+                        config.softwareCFD.CFD_ZC_TRIGGER_THRESHOLD)
                     *config.digitizer.SAMPLE_PERIOD;
 
                 ch6FineTimeH->Fill(ch6FineTime);
@@ -124,7 +123,8 @@ int main(int argc, char** argv)
                         rawEvent.waveform,
                         rawEvent.baseline,
                         config.softwareCFD.CFD_FRACTION,
-                        config.softwareCFD.CFD_DELAY)
+                        config.softwareCFD.CFD_DELAY,
+                        config.softwareCFD.CFD_ZC_TRIGGER_THRESHOLD)
                     *config.digitizer.SAMPLE_PERIOD;
 
                 ch7FineTimeH->Fill(ch7FineTime);
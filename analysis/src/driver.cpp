@@ -13,6 +13,7 @@
 #include "../include/config.h"
 #include "../include/GammaCorrection.h"
 #include "../include/identifyGoodMacros.h"
+#include "../include/templateTiming.h"
 
 // ROOT library classes
 #include "TFile.h"
@@ -26,8 +27,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     /*************************************************************************/
@@ -59,7 +58,7 @@ int main(int, char* argv[])
         useVetoPaddle = true;
     }
 
-    config = Config(experimentName, runNumber);
+    const Config config(experimentName, runNumber);
 
     string logFileName = analysisDirectory + "log.txt";
     ofstream log(logFileName);
@@ -72,7 +71,7 @@ int main(int, char* argv[])
     cout << endl << "Start processing event data into raw data tree..." << endl;
 
     string rawTreeFileName = analysisDirectory + config.analysis.RAW_TREE_FILE_NAME;
-    if(readRawData(rawDataFileName, rawTreeFileName, log))
+    if(readRawData(rawDataFileName, rawTreeFileName, log, config))
     {
         return 1;
     }
@@ -87,7 +86,7 @@ int main(int, char* argv[])
 
     vector<MacropulseEvent> macropulseList;
 
-    switch(identifyMacropulses(rawTreeFileName, sortedFileName, log, macropulseList))
+    switch(identifyMacropulses(rawTreeFileName, sortedFileName, log, macropulseList, config))
     {
         case 0:
             // recreate sorted.root file
@@ -96,13 +95,14 @@ int main(int, char* argv[])
                     rawTreeFileName,
                     sortedFileName,
                     log,
-                    macropulseList
+                    macropulseList,
+                    config
                     );
 
             /******************************************************************/
             /* Identify "good" macropulses */
             /******************************************************************/
-            identifyGoodMacros(macropulseFileName, macropulseList, log);
+            identifyGoodMacros(macropulseFileName, macropulseList, log, config);
 
             break;
 
@@ -123,20 +123,20 @@ int main(int, char* argv[])
     if(useVetoPaddle)
     {
         cout << endl << "\"Veto Events\" flag enabled; start processing detector events through veto..." << endl;
-        vetoEvents(sortedFileName, vetoedFileName, log, "veto");
+        vetoEvents(sortedFileName, vetoedFileName, log, "veto", config);
     }
 
     /******************************************************************/
     /* Populate events into basic histograms */
     /******************************************************************/
     string histoFileName = analysisDirectory + config.analysis.HISTOGRAM_FILE_NAME;
-    fillBasicHistos(sortedFileName, log, histoFileName);
+    fillBasicHistos(sortedFileName, log, histoFileName, config);
 
     /*****************************************************/
     /* Use raw TOF histos to create deadtime correction  */
     /*****************************************************/
     string deadtimeFileName = analysisDirectory + "deadtime.root";
-    generateDeadtimeCorrection(histoFileName, log, deadtimeFileName);
+    generateDeadtimeCorrection(histoFileName, log, deadtimeFileName, config);
 
     /*****************************************************/
     /* Calculate macropulse time correction using gammas */
@@ -147,26 +147,46 @@ int main(int, char* argv[])
             sortedFileName,
             log,
             config.analysis.GAMMA_CORRECTION_TREE_NAME,
-            gammaCorrectionFileName);
+            gammaCorrectionFileName,
+            config);
+
+    /*****************************************************/
+    /* Time detector events by template matching, and    */
+    /* compare its timing resolution with the CFD's      */
+    /* (only if named in config)                         */
+    /*****************************************************/
+    if(config.analysis.TEMPLATE_TIMING_FILE_NAME != "")
+    {
+        string templateTimingFileName = analysisDirectory + config.analysis.TEMPLATE_TIMING_FILE_NAME;
+        calculateTemplateTiming(sortedFileName, log, templateTimingFileName, config);
+    }
 
     /******************************************************************/
     /* Populate events into gated histograms, using time correction   */
     /******************************************************************/
     string gatedHistoFileName = analysisDirectory + "gatedHistos.root";
-    fillCSHistos(vetoedFileName, sortedFileName, useVetoPaddle, macropulseFileName, gammaCorrectionFileName, log, gatedHistoFileName);
+
+    // per-event columns for re-histogramming (only if named in config)
+    string eventColumnsFileName = "";
+    if(config.analysis.GATED_EVENTS_FILE_NAME != "")
+    {
+        eventColumnsFileName = analysisDirectory + config.analysis.GATED_EVENTS_FILE_NAME;
+    }
+
+    fillCSHistos(vetoedFileName, sortedFileName, useVetoPaddle, macropulseFileName, gammaCorrectionFileName, log, gatedHistoFileName, eventColumnsFileName, config);
 
     /*****************************************************/
     /* Apply deadtime correction to gated histograms     */
     /*****************************************************/
     string correctedHistoFileName = analysisDirectory + "correctedHistos.root";
-    applyDeadtimeCorrection(gatedHistoFileName, deadtimeFileName, histoFileName, gammaCorrectionFileName, log, correctedHistoFileName);
+    applyDeadtimeCorrection(gatedHistoFileName, deadtimeFileName, histoFileName, gammaCorrectionFileName, log, correctedHistoFileName, config);
 
     /*************************************************************************/
     /* Convert TOF histograms into energy in preparation for cross section
      * calculation */
     /*************************************************************************/
     //string energyFileName = analysisDirectory + config.analysis.ENERGY_PLOTS_FILE_NAME;
-    //produceEnergyHistos(correctedHistoFileName, log, energyFileName);
+    //produceEnergyHistos(correctedHistoFileName, log, energyFileName, config);
 
     return 0;
 }
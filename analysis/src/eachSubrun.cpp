@@ -17,19 +17,20 @@
 #include "../include/dataSet.h"
 #include "../include/dataPoint.h"
 #include "../include/CSPrereqs.h"
+#include "../include/subRunCatalog.h"
+#include "../include/bootstrap.h"
 #include "../include/crossSection.h"
 #include "../include/experiment.h"
+#include "../include/configRegistry.h"
 #include "../include/plots.h"
 #include "../include/CSUtilities.h"
 #include "../include/correctForBackground.h"
 
 using namespace std;
 
-Config config;
-
 const int MAX_SUBRUN_NUMBER = 50;
 
-int main(int, char* argv[])
+int main(int argc, char* argv[])
 {
     string dataLocation = argv[1];
 
@@ -38,6 +39,20 @@ int main(int, char* argv[])
 
     string detectorName = argv[3]; // detector name to be used for calculating cross sections
 
+    // optionally, check the statistical errors of the summed cross sections
+    // against the subrun-to-subrun scatter by resampling subruns
+    int numberOfReplicas = 0;
+    if(argc>4)
+    {
+        numberOfReplicas = atoi(argv[4]);
+    }
+
+    unsigned long bootstrapSeed = 1;
+    if(argc>5)
+    {
+        bootstrapSeed = stoul(argv[5]);
+    }
+
     // Open run list
     string runListName = "../" + expName + "/runsToSort.txt";
     ifstream runList(runListName);
@@ -54,51 +69,64 @@ int main(int, char* argv[])
 
     vector<vector<CSPrereqs>> allCSPrereqs;
 
+    SubRunBootstrap bootstrap;
+
     int counter = 0;
 
+    // the current run's config (the summary plots below use the last run's)
+    shared_ptr<const Config> config = make_shared<const Config>();
+
     string line;
     while (runList >> line)
     {
         runNumber = stoi(line);
 
-        // read in run config file
-        config = Config(expName, runNumber);
+        // this run's config (each config file is only read once)
+        config = getConfigRegistry(expName).getConfig(runNumber);
 
         // Loop through all subruns of this run
-        for(int subRun=0; subRun<=MAX_SUBRUN_NUMBER; subRun++)
+        for(int subRun : findSubRuns(dataLocation, runNumber))
         {
+            if(subRun>MAX_SUBRUN_NUMBER)
+            {
+                break;
+            }
+
             vector<CSPrereqs> subRunCSPrereqs;
 
             cout << "Reading subrun " << runNumber << " " << subRun << endl;
 
             // Loop through all target positions in this subrun
-            for(int j=0; (size_t)j<config.target.TARGET_ORDER.size(); j++)
+            for(int j=0; (size_t)j<config->target.TARGET_ORDER.size(); j++)
             {
                 // pull data needed for CS calculation from subrun 
-                string targetDataLocation = "../" + expName + "/targetData/" + config.target.TARGET_ORDER[j] + ".txt";
-                CSPrereqs subRunData(targetDataLocation);
+                string targetDataLocation = "../" + expName + "/targetData/" + config->target.TARGET_ORDER[j] + ".txt";
+                CSPrereqs subRunData(targetDataLocation, *config);
 
-                if(readSubRun(subRunData, expName, runNumber, subRun, detectorName, dataLocation))
+                if(readSubRun(subRunData, expName, runNumber, subRun, detectorName, dataLocation, *config))
                 {
                     break;
                 }
 
-                subRunCSPrereqs.push_back(subRunData);
+                subRunCSPrereqs.push_back(move(subRunData));
             }
 
             allCSPrereqs.push_back(subRunCSPrereqs);
 
+            // only the counters are kept for the summary plots below
+            for(auto& p : allCSPrereqs.back())
+            {
+                p.clearHistos();
+            }
+
             cout << "counter = " << counter++ << endl;
 
             CSPrereqs blank;
             for(auto& p : subRunCSPrereqs)
             {
-                //correctForBackground(p);
-
-                string energyHistoName = p.target.getName();
-                energyHistoName = energyHistoName + "Energy";
+                //correctForBackground(p, *config);
 
-                p.energyHisto = convertTOFtoEnergy(p.TOFHisto, energyHistoName.c_str());
+                p.energy = convertTOFtoEnergy(p.TOF, *config);
 
                 if(p.target.getName()=="blank" || p.target.getName()=="blankW")
                 {
@@ -112,11 +140,18 @@ int main(int, char* argv[])
                 continue;
             }
 
+            if(numberOfReplicas>0 && bootstrap.addSubRun(subRunCSPrereqs))
+            {
+                cerr << "Error: failed to store subrun " << runNumber << " " << subRun
+                    << " for bootstrapping. Exiting..." << endl;
+                exit(1);
+            }
+
             vector<CrossSection> crossSections;
             for(auto& p : subRunCSPrereqs)
             {
                 CrossSection cs;
-                cs.calculateCS(p,blank);
+                cs.calculateCS(p,blank,*config);
 
                 string blankCSFileName = "../" + dataLocation + "/literature.root"; 
 
@@ -135,6 +170,7 @@ int main(int, char* argv[])
             allCrossSections.push_back(crossSections);
 
             outFile->Close();
+            delete outFile;
         }
     }
 
@@ -187,9 +223,9 @@ int main(int, char* argv[])
 
     vector<TH1D*> monitorToDetectorRatios;
 
-    for(int i=0; i<config.target.TARGET_ORDER.size(); i++)
+    for(int i=0; i<config->target.TARGET_ORDER.size(); i++)
     {
-        string name = config.target.TARGET_ORDER[i] + "_mon/det";
+        string name = config->target.TARGET_ORDER[i] + "_mon/det";
 
         monitorToDetectorRatios.push_back(new TH1D(name.c_str(), name.c_str(), 
             numberOfCSPrereqs, 0, numberOfCSPrereqs));
@@ -199,11 +235,11 @@ int main(int, char* argv[])
     
     for(int i=0; i<allCSPrereqs.size(); i++)
     {
-        vector<CSPrereqs> subRun = allCSPrereqs[i];
+        const vector<CSPrereqs>& subRun = allCSPrereqs[i];
 
         CSPrereqs blank;
             
-        for(auto csp : subRun)
+        for(auto& csp : subRun)
         {
             if(csp.target.getName() == "blank")
             {
@@ -214,11 +250,11 @@ int main(int, char* argv[])
 
         for(int k=0; k<subRun.size(); k++)
         {
-            CSPrereqs csp = subRun[k];
+            const CSPrereqs& csp = subRun[k];
 
-            for(int j=0; j<config.target.TARGET_ORDER.size(); j++)
+            for(int j=0; j<config->target.TARGET_ORDER.size(); j++)
             {
-                if(csp.target.getName() == config.target.TARGET_ORDER[j])
+                if(csp.target.getName() == config->target.TARGET_ORDER[j])
                 {
                     double ratio = csp.monitorCounts/csp.totalEventNumber;
                     monitorToDetectorRatios[j]->SetBinContent(currentBin, ratio);
@@ -227,9 +263,9 @@ int main(int, char* argv[])
             }
             currentBin++;
 
-            for(int j=0; j<config.target.TARGET_ORDER.size(); j++)
+            for(int j=0; j<config->target.TARGET_ORDER.size(); j++)
             {
-                if(csp.target.getName() == config.target.TARGET_ORDER[j])
+                if(csp.target.getName() == config->target.TARGET_ORDER[j])
                 {
                     double ratio = csp.monitorCounts/csp.totalEventNumber;
                     monitorToDetectorRatios[j]->SetBinContent(currentBin, ratio);
@@ -246,9 +282,9 @@ int main(int, char* argv[])
 
     /*vector<TH2D*> monitorToDetectorRatios2D;
 
-    for(int i=0; i<config.target.TARGET_ORDER.size(); i++)
+    for(int i=0; i<config->target.TARGET_ORDER.size(); i++)
     {
-        string name = config.target.TARGET_ORDER[i] + "_mon/det_2D";
+        string name = config->target.TARGET_ORDER[i] + "_mon/det_2D";
 
         monitorToDetectorRatios2D.push_back(new TH2D(name.c_str(), name.c_str(),
             1000, 0, 50,
@@ -257,9 +293,9 @@ int main(int, char* argv[])
 
     for(int i=0; i<allCSPrereqs.size(); i++)
     {
-        for(int j=0; j<config.target.TARGET_ORDER.size(); j++)
+        for(int j=0; j<config->target.TARGET_ORDER.size(); j++)
         {
-            if(allCSPrereqs[i].target.getName() == config.target.TARGET_ORDER[j])
+            if(allCSPrereqs[i].target.getName() == config->target.TARGET_ORDER[j])
             {
                 double countRatio = allCSPrereqs[i].totalEventNumber/allCSPrereqs[1].totalEventNumber;
                 double fluxPerMacro = allCSPrereqs[i].monitorCounts/allCSPrereqs[i].goodMacroNumber;
@@ -278,9 +314,9 @@ int main(int, char* argv[])
 
     vector<TH2D*> detectorToMonitor2Ds;
 
-    for(int i=0; i<config.target.TARGET_ORDER.size(); i++)
+    for(int i=0; i<config->target.TARGET_ORDER.size(); i++)
     {
-        string name = config.target.TARGET_ORDER[i] + "_det/mon_2D";
+        string name = config->target.TARGET_ORDER[i] + "_det/mon_2D";
 
         detectorToMonitor2Ds.push_back(new TH2D(name.c_str(), name.c_str(),
             1000, 0.95, 1.05,
@@ -291,14 +327,14 @@ int main(int, char* argv[])
 
     for(int i=0; i<allCSPrereqs.size(); i++)
     {
-        vector<CSPrereqs> subRun = allCSPrereqs[i];
+        const vector<CSPrereqs>& subRun = allCSPrereqs[i];
         for(int k=0; k<subRun.size(); k++)
         {
-            CSPrereqs csp = subRun[k];
+            const CSPrereqs& csp = subRun[k];
 
             CSPrereqs blank;
 
-            for(auto csp : subRun)
+            for(auto& csp : subRun)
             {
                 if(csp.target.getName() == "blank")
                 {
@@ -307,9 +343,9 @@ int main(int, char* argv[])
                 }
             }
 
-            for(int j=0; j<config.target.TARGET_ORDER.size(); j++)
+            for(int j=0; j<config->target.TARGET_ORDER.size(); j++)
             {
-                if(csp.target.getName() == config.target.TARGET_ORDER[j])
+                if(csp.target.getName() == config->target.TARGET_ORDER[j])
                 {
                     double countRatio = csp.totalEventNumber/blank.totalEventNumber;
                     double macroRatio = (csp.monitorCounts/blank.monitorCounts)/(csp.goodMacroNumber/blank.goodMacroNumber);
@@ -327,4 +363,48 @@ int main(int, char* argv[])
     }
 
     outFile->Close();
+
+    if(numberOfReplicas>0)
+    {
+        cout << "Bootstrapping cross sections from " << bootstrap.getNumberOfSubRuns()
+            << " subruns with " << numberOfReplicas << " replicas..." << endl;
+
+        vector<BootstrapErrors> bootstrapErrors;
+        if(bootstrap.resample(numberOfReplicas, bootstrapSeed, getNumberOfThreads(), bootstrapErrors))
+        {
+            cerr << "Error: failed to bootstrap cross sections. Exiting..." << endl;
+            exit(1);
+        }
+
+        // cross sections of the summed subruns, with analytic errors. The
+        // blank correction shifts every replica's cross section by the same
+        // amount, so neither these nor the replicas include it.
+        vector<CSPrereqs> totals = bootstrap.getTotals();
+
+        CSPrereqs blank;
+        for(auto& p : totals)
+        {
+            if(p.target.getName()=="blank" || p.target.getName()=="blankW")
+            {
+                blank = p;
+                break;
+            }
+        }
+
+        vector<CrossSection> crossSections;
+        for(auto& p : totals)
+        {
+            CrossSection cs;
+            cs.calculateCS(p,blank,*config);
+            crossSections.push_back(cs);
+        }
+
+        string bootstrapFileName = dataLocation + "/bootstrap.root";
+        TFile* bootstrapFile = new TFile(bootstrapFileName.c_str(), "RECREATE");
+
+        writeBootstrapErrors(crossSections, bootstrapErrors, bootstrap.getEnergyBinning());
+
+        bootstrapFile->Close();
+        delete bootstrapFile;
+    }
 }
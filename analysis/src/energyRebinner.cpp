@@ -0,0 +1,209 @@
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <limits>
+#include <algorithm>
+
+#include "../include/energyRebinner.h"
+#include "../include/kinematics.h"
+#include "../include/physicalConstants.h"
+#include "../include/plots.h"
+#include "../include/config.h"
+
+using namespace std;
+
+// overlaps smaller than this fraction of a TOF bin are rounding noise from
+// converting energy edges back into times
+const double MINIMUM_OVERLAP = 1e-9;
+
+EnergyRebinner::EnergyRebinner(double flightDistance, int nTOFBins,
+        double TOFLowerBound, double TOFUpperBound,
+        const vector<double>& edges)
+    : numberOfTOFBins(nTOFBins), energyBinEdges(edges)
+{
+    int numberOfEnergyBins = energyBinEdges.size()-1;
+
+    // time intervals covered by each energy bin, in order of increasing time
+    // (i.e., decreasing energy)
+    struct Interval
+    {
+        double start;
+        double end;
+        int energyBin;
+    };
+
+    vector<double> edgeTimes;
+    for(double edge : energyBinEdges)
+    {
+        edgeTimes.push_back(exactRKEToTOF(edge, flightDistance));
+    }
+
+    vector<Interval> intervals;
+
+    const double GAMMA_TIME = pow(10.,7.)*flightDistance/C;
+    intervals.push_back(Interval{GAMMA_TIME, edgeTimes.back(), numberOfEnergyBins+1});
+
+    for(int k=numberOfEnergyBins; k>=1; k--)
+    {
+        intervals.push_back(Interval{edgeTimes[k], edgeTimes[k-1], k});
+    }
+
+    intervals.push_back(Interval{edgeTimes[0], numeric_limits<double>::infinity(), 0});
+
+    // sweep TOF bins and energy intervals together, both in increasing time
+    double binWidth = (TOFUpperBound-TOFLowerBound)/numberOfTOFBins;
+
+    rowStart.resize(numberOfTOFBins+3, 0);
+
+    size_t firstInterval = 0;
+
+    for(int j=1; j<=numberOfTOFBins; j++)
+    {
+        rowStart[j] = elements.size();
+
+        double a = TOFLowerBound+(j-1)*binWidth;
+        double b = TOFLowerBound+j*binWidth;
+
+        while(firstInterval<intervals.size() && intervals[firstInterval].end<=a)
+        {
+            firstInterval++;
+        }
+
+        for(size_t q=firstInterval; q<intervals.size() && intervals[q].start<b; q++)
+        {
+            double overlap = min(b, intervals[q].end)-max(a, intervals[q].start);
+
+            if(overlap>MINIMUM_OVERLAP*binWidth)
+            {
+                elements.push_back(Element{intervals[q].energyBin, overlap/binWidth});
+            }
+        }
+    }
+
+    // underflow and overflow TOF bins are not rebinned
+    rowStart[numberOfTOFBins+1] = elements.size();
+    rowStart[numberOfTOFBins+2] = elements.size();
+}
+
+const vector<double>& EnergyRebinner::getEnergyBinEdges() const
+{
+    return energyBinEdges;
+}
+
+int EnergyRebinner::getNumberOfEnergyBins() const
+{
+    return energyBinEdges.size()-1;
+}
+
+vector<double> EnergyRebinner::rebin(const vector<double>& TOFCounts) const
+{
+    vector<double> energyCounts(getNumberOfEnergyBins()+2, 0);
+
+    if(TOFCounts.size()!=(size_t)numberOfTOFBins+2)
+    {
+        cerr << "Error: can't rebin TOF counts with " << TOFCounts.size()
+            << " bins using an energy rebinner built for " << numberOfTOFBins
+            << " bins (+ underflow and overflow)." << endl;
+        return energyCounts;
+    }
+
+    for(int j=1; j<=numberOfTOFBins; j++)
+    {
+        double counts = TOFCounts[j];
+        if(counts==0)
+        {
+            continue;
+        }
+
+        for(long e=rowStart[j]; e<rowStart[j+1]; e++)
+        {
+            energyCounts[elements[e].energyBin] += elements[e].fraction*counts;
+        }
+    }
+
+    return energyCounts;
+}
+
+TH1D* EnergyRebinner::rebin(TH1D* TOFHisto, string name) const
+{
+    int numberOfEnergyBins = getNumberOfEnergyBins();
+
+    TH1D* energy = new TH1D(name.c_str(), name.c_str(), numberOfEnergyBins, &energyBinEdges[0]);
+
+    vector<double> TOFCounts(numberOfTOFBins+2);
+    for(int j=0; j<=numberOfTOFBins+1; j++)
+    {
+        TOFCounts[j] = TOFHisto->GetBinContent(j);
+    }
+
+    vector<double> energyCounts = rebin(TOFCounts);
+
+    for(int k=0; k<=numberOfEnergyBins+1; k++)
+    {
+        energy->SetBinContent(k, energyCounts[k]);
+    }
+
+    // calculate energy error
+    for(int k=1; k<=numberOfEnergyBins; k++)
+    {
+        energy->SetBinError(k,pow(energy->GetBinContent(k),0.5));
+    }
+
+    return energy;
+}
+
+const EnergyRebinner& getEnergyRebinner(int numberOfTOFBins,
+        double TOFLowerBound, double TOFUpperBound, const Config& config)
+{
+    typedef tuple<double, int, double, double, double, double, int> RebinnerKey;
+
+    static map<RebinnerKey, EnergyRebinner> rebinners;
+    static mutex rebinnersMutex;
+
+    RebinnerKey key(config.facility.FLIGHT_DISTANCE,
+            numberOfTOFBins, TOFLowerBound, TOFUpperBound,
+            config.plot.ENERGY_LOWER_BOUND, config.plot.ENERGY_UPPER_BOUND,
+            config.plot.NUMBER_ENERGY_BINS);
+
+    lock_guard<mutex> lock(rebinnersMutex);
+
+    auto it = rebinners.find(key);
+    if(it!=rebinners.end())
+    {
+        return it->second;
+    }
+
+    // find energy bin edges for this TOF binning
+    TH1D* TOFTemplate = new TH1D("", "", numberOfTOFBins, TOFLowerBound, TOFUpperBound);
+    TOFTemplate->SetDirectory(0);
+
+    TH1D* energyTemplate = timeBinsToRKEBins(TOFTemplate, "", config);
+    energyTemplate->SetDirectory(0);
+
+    vector<double> energyBinEdges;
+
+    int numberOfEnergyBins = energyTemplate->GetNbinsX();
+    for(int i=1; i<=numberOfEnergyBins; i++)
+    {
+        energyBinEdges.push_back(energyTemplate->GetBinLowEdge(i));
+    }
+
+    energyBinEdges.push_back(
+            energyTemplate->GetBinLowEdge(numberOfEnergyBins)
+            +energyTemplate->GetBinWidth(numberOfEnergyBins));
+
+    delete TOFTemplate;
+    delete energyTemplate;
+
+    return rebinners[key] = EnergyRebinner(config.facility.FLIGHT_DISTANCE,
+            numberOfTOFBins, TOFLowerBound, TOFUpperBound, energyBinEdges);
+}
+
+const EnergyRebinner& getEnergyRebinner(TH1D* TOFHisto, const Config& config)
+{
+    return getEnergyRebinner(TOFHisto->GetNbinsX(),
+            TOFHisto->GetXaxis()->GetXmin(),
+            TOFHisto->GetXaxis()->GetXmax(),
+            config);
+}
@@ -0,0 +1,38 @@
+/* How to use:
+ *
+ * ./evaluateCS [recipe file name, or - for standard input]
+ *
+ * Runs a recipe of cross section utility calls (subtractCS, shiftCS,
+ * multiplyCS, relativeCS, relativeDiffCS, mergeCS, applyCSCorrectionFactor
+ * and scaledownCS, with the same arguments as their binaries) in one
+ * process. See csRecipe.h for the recipe format; e.g.,
+ *
+ *   cd plotScripts; cat relativeDiff_*.sh | ../bin/evaluateCS -
+ */
+
+#include "../include/config.h"
+#include "../include/csRecipe.h"
+#include "../include/fastHisto.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    if(argc<2)
+    {
+        cerr << "Error: expected a recipe file name (or - for standard input)." << endl;
+        return 1;
+    }
+
+    vector<RecipeStep> steps;
+    if(readCSRecipe(argv[1], steps))
+    {
+        return 1;
+    }
+
+    return evaluateCSRecipe(steps, getNumberOfThreads());
+}
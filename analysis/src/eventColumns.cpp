@@ -0,0 +1,183 @@
+#include <iostream>
+
+#include "TTree.h"
+
+#include "../include/eventColumns.h"
+#include "../include/physicalConstants.h"
+#include "../include/config.h"
+
+using namespace std;
+
+long EventColumns::size() const
+{
+    return microTime.size();
+}
+
+void EventColumns::clear()
+{
+    microTime.clear();
+    microNo.clear();
+    macroNo.clear();
+    lgQ.clear();
+    targetPos.clear();
+    vetoed.clear();
+}
+
+int EventColumns::write(string name) const
+{
+    TTree* tree = new TTree(name.c_str(), name.c_str());
+
+    Float_t microTimeBuffer;
+    Short_t microNoBuffer;
+    Int_t macroNoBuffer;
+    Int_t lgQBuffer;
+    UChar_t targetPosBuffer;
+    Bool_t vetoedBuffer;
+
+    tree->Branch("microTime", &microTimeBuffer, "microTime/F");
+    tree->Branch("microNo", &microNoBuffer, "microNo/S");
+    tree->Branch("macroNo", &macroNoBuffer, "macroNo/I");
+    tree->Branch("lgQ", &lgQBuffer, "lgQ/I");
+    tree->Branch("targetPos", &targetPosBuffer, "targetPos/b");
+    tree->Branch("vetoed", &vetoedBuffer, "vetoed/O");
+
+    long numberOfEvents = size();
+    for(long i=0; i<numberOfEvents; i++)
+    {
+        microTimeBuffer = microTime[i];
+        microNoBuffer = microNo[i];
+        macroNoBuffer = macroNo[i];
+        lgQBuffer = lgQ[i];
+        targetPosBuffer = targetPos[i];
+        vetoedBuffer = vetoed[i];
+
+        tree->Fill();
+    }
+
+    tree->Write();
+
+    return 0;
+}
+
+int EventColumns::read(TDirectory* directory, string name)
+{
+    clear();
+
+    TTree* tree = (TTree*)directory->Get(name.c_str());
+    if(!tree)
+    {
+        cerr << "Error: failed to find event columns " << name << " in "
+            << directory->GetName() << "." << endl;
+        return 1;
+    }
+
+    Float_t microTimeBuffer;
+    Short_t microNoBuffer;
+    Int_t macroNoBuffer;
+    Int_t lgQBuffer;
+    UChar_t targetPosBuffer;
+    Bool_t vetoedBuffer;
+
+    tree->SetBranchAddress("microTime", &microTimeBuffer);
+    tree->SetBranchAddress("microNo", &microNoBuffer);
+    tree->SetBranchAddress("macroNo", &macroNoBuffer);
+    tree->SetBranchAddress("lgQ", &lgQBuffer);
+    tree->SetBranchAddress("targetPos", &targetPosBuffer);
+    tree->SetBranchAddress("vetoed", &vetoedBuffer);
+
+    long numberOfEvents = tree->GetEntries();
+
+    microTime.reserve(numberOfEvents);
+    microNo.reserve(numberOfEvents);
+    macroNo.reserve(numberOfEvents);
+    lgQ.reserve(numberOfEvents);
+    targetPos.reserve(numberOfEvents);
+    vetoed.reserve(numberOfEvents);
+
+    for(long i=0; i<numberOfEvents; i++)
+    {
+        tree->GetEntry(i);
+
+        push_back(microTimeBuffer, microNoBuffer, macroNoBuffer, lgQBuffer,
+                targetPosBuffer, vetoedBuffer);
+    }
+
+    return 0;
+}
+
+vector<FastHisto1D> fillTOFHistos(const EventColumns& events, const Config& config)
+{
+    const vector<string>& targetOrder = config.target.TARGET_ORDER;
+
+    vector<FastHisto1D> prototype;
+
+    for(string targetName : targetOrder)
+    {
+        string TOFName = targetName + "TOF";
+        prototype.push_back(FastHisto1D(TOFName,
+                    TOFName,
+                    config.plot.TOF_BINS,
+                    config.plot.TOF_LOWER_BOUND,
+                    config.plot.TOF_UPPER_BOUND));
+    }
+
+    // same gates as fillCSHistos
+    const double GAMMA_TIME = pow(10,7)*config.facility.FLIGHT_DISTANCE/C;
+    const double GAMMA_WINDOW_WIDTH = config.time.GAMMA_WINDOW_SIZE/2;
+
+    const double CHARGE_GATE_LOW = config.analysis.CHARGE_GATE_LOW_THRESHOLD;
+    const double CHARGE_GATE_HIGH = config.analysis.CHARGE_GATE_HIGH_THRESHOLD;
+
+    const int FIRST_GOOD_MICRO = config.facility.FIRST_GOOD_MICRO;
+    const int LAST_GOOD_MICRO = config.facility.LAST_GOOD_MICRO;
+
+    const int NUMBER_OF_TARGETS = targetOrder.size();
+
+    unsigned int numberOfThreads = getNumberOfThreads();
+    vector<vector<FastHisto1D>> threadHistos(numberOfThreads, prototype);
+
+    fillInParallel(events.size(), numberOfThreads,
+            [&](unsigned int thread, long begin, long end)
+            {
+                vector<FastHisto1D>& histos = threadHistos[thread];
+
+                for(long i=begin; i<end; i++)
+                {
+                    if(events.lgQ[i]<CHARGE_GATE_LOW
+                            || events.lgQ[i]>CHARGE_GATE_HIGH)
+                    {
+                        continue;
+                    }
+
+                    if(events.microNo[i]<FIRST_GOOD_MICRO
+                            || events.microNo[i]>=LAST_GOOD_MICRO)
+                    {
+                        continue;
+                    }
+
+                    if(events.vetoed[i]
+                            && events.microTime[i]>GAMMA_TIME+GAMMA_WINDOW_WIDTH*2)
+                    {
+                        continue;
+                    }
+
+                    if(events.targetPos[i]>=NUMBER_OF_TARGETS)
+                    {
+                        continue;
+                    }
+
+                    histos[events.targetPos[i]].fill(events.microTime[i]);
+                }
+            });
+
+    vector<FastHisto1D>& histos = threadHistos[0];
+    for(unsigned int t=1; t<numberOfThreads; t++)
+    {
+        for(int j=0; j<NUMBER_OF_TARGETS; j++)
+        {
+            histos[j].add(threadHistos[t][j]);
+        }
+    }
+
+    return histos;
+}
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <iterator>
+#include <algorithm>
 #include <utility> // for pair
 
 using namespace std;
@@ -36,20 +37,19 @@ vector<pair<string,string>> getRelativePlotNames(string expName, string fileName
     return relativePlotNames;
 }
 
-// read the channel mapping of the current run
-vector<pair<int, string>> getChannelMap(string expName, int runNumber)
+RunRangeTable::RunRangeTable(string fileLocation, string description) : fileLocation(fileLocation)
 {
-    string channelMapLocation = "../" + expName + "/channelMap.txt";
-    ifstream dataFile(channelMapLocation.c_str());
+    ifstream dataFile(fileLocation.c_str());
     if(!dataFile.is_open())
     {
-        std::cout << "Failed to find channel mapping in " << channelMapLocation << std::endl;
+        std::cout << "Failed to find " << description << " in " << fileLocation << std::endl;
         exit(1);
     }
 
     string str;
     int run;
-    vector<pair<int, string>> channelMap;
+    vector<int> lowRuns;
+    vector<int> highRuns;
 
     while(getline(dataFile,str))
     {
@@ -76,79 +76,131 @@ vector<pair<int, string>> getChannelMap(string expName, int runNumber)
 
         delimiter = "\n";
         string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
+
+        lowRuns.push_back(atoi(lowRun.c_str()));
+        highRuns.push_back(atoi(highRun.c_str()));
+
+        tokens.erase(tokens.begin());
+        lines.push_back(tokens);
+    }
+
+    // split the runs at every range's ends; within each interval, the same
+    // lines cover every run
+    vector<int> boundaries;
+    for(int i=0; (size_t)i<lines.size(); i++)
+    {
+        if(lowRuns[i]<=highRuns[i])
+        {
+            boundaries.push_back(lowRuns[i]);
+            boundaries.push_back(highRuns[i]+1);
+        }
+    }
+
+    sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    for(int start : boundaries)
+    {
+        int line = -1;
+        for(int i=0; (size_t)i<lines.size(); i++)
         {
-            for(int i=1; (size_t)i<tokens.size(); i++)
+            if(lowRuns[i] <= start && start <= highRuns[i])
             {
-                channelMap.push_back(make_pair(i-1,tokens[i]));
+                line = i;
+                break;
             }
+        }
 
-            break;
+        // merge with the previous interval if it has the same line
+        if(intervalLines.size() && intervalLines.back()==line)
+        {
+            continue;
         }
+
+        intervalStarts.push_back(start);
+        intervalLines.push_back(line);
     }
+}
 
-    if(channelMap.size()==0)
+int RunRangeTable::findLine(int runNumber) const
+{
+    auto it = upper_bound(intervalStarts.begin(), intervalStarts.end(), runNumber);
+    if(it==intervalStarts.begin())
     {
-        cerr << "Error: failed to recover a channel mapping from " << channelMapLocation << "." << endl;
-        exit(1);
+        return -1;
     }
 
-    return channelMap;
+    return intervalLines[(it-intervalStarts.begin())-1];
 }
 
-// Determine the target order for a given run
-vector<string> getTargetOrder(string expName, int runNumber)
+const vector<string>& RunRangeTable::find(int runNumber) const
 {
-    string targetOrderLocation = "../" + expName + "/TargetOrder.txt";
-    ifstream dataFile(targetOrderLocation.c_str());
-    if(!dataFile.is_open())
+    static const vector<string> noTokens;
+
+    int line = findLine(runNumber);
+    if(line<0)
     {
-        std::cout << "Failed to find target order data in " << targetOrderLocation << std::endl;
-        exit(1);
+        return noTokens;
     }
 
-    string str;
-    int run;
-    vector<string> targetOrder;
+    return lines[line];
+}
 
-    while(getline(dataFile,str))
+string RunRangeTable::getFileLocation() const
+{
+    return fileLocation;
+}
+
+vector<pair<int, string>> makeChannelMap(const vector<string>& tokens)
+{
+    vector<pair<int, string>> channelMap;
+
+    for(int i=0; (size_t)i<tokens.size(); i++)
     {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
+        channelMap.push_back(make_pair(i,tokens[i]));
+    }
 
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
+    return channelMap;
+}
 
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
+vector<pair<int,int>> makeTargetGates(const vector<string>& tokens)
+{
+    vector<pair<int,int>> targetGates;
 
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
+    for(string token : tokens)
+    {
+        string delimiter = "-";
+        string lowGate = token.substr(0,token.find(delimiter));
+        token = token.erase(0,token.find(delimiter) + delimiter.length());
 
         delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                targetOrder.push_back(tokens[i]);
-            }
-            break;
-        }
+        string highGate = token.substr(0,token.find(delimiter));
+
+        targetGates.push_back(pair<int,int>(atoi(lowGate.c_str()),atoi(highGate.c_str())));
+    }
+
+    return targetGates;
+}
+
+// read the channel mapping of the current run
+vector<pair<int, string>> getChannelMap(string expName, int runNumber)
+{
+    RunRangeTable channelMapTable("../" + expName + "/channelMap.txt", "channel mapping");
+    vector<pair<int, string>> channelMap = makeChannelMap(channelMapTable.find(runNumber));
+
+    if(channelMap.size()==0)
+    {
+        cerr << "Error: failed to recover a channel mapping from " << channelMapTable.getFileLocation() << "." << endl;
+        exit(1);
     }
 
-    return targetOrder;
+    return channelMap;
+}
+
+// Determine the target order for a given run
+vector<string> getTargetOrder(string expName, int runNumber)
+{
+    return RunRangeTable("../" + expName + "/TargetOrder.txt", "target order data").find(runNumber);
 }
 
 // extract configuration data from an experiment directory
@@ -232,6 +284,16 @@ AnalysisConfig readAnalysisConfig(string expName)
         {
             analysisConfig.ENERGY_PLOTS_FILE_NAME = tokens.back();
         }
+
+        else if(tokens[0]=="Gated")
+        {
+            analysisConfig.GATED_EVENTS_FILE_NAME = tokens.back();
+        }
+
+        else if(tokens[0]=="Template")
+        {
+            analysisConfig.TEMPLATE_TIMING_FILE_NAME = tokens.back();
+        }
         
         else if(tokens[0]=="DPP")
         {
@@ -329,396 +391,48 @@ DeadtimeConfig readDeadtimeConfig(string expName)
 // Read facility  parameters
 FacilityConfig readFacilityConfig(string expName, int runNumber)
 {
-    string facilityConfigLocation = "../" + expName + "/FacilityConfig.txt";
-    ifstream dataFile(facilityConfigLocation.c_str());
-    if(!dataFile.is_open())
-    {
-        std::cout << "Failed to find facility configuration in " << facilityConfigLocation << std::endl;
-        exit(1);
-    }
-
-    string str;
-    int run;
-    vector<string> facilityConfig;
-
-    while(getline(dataFile,str))
-    {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
-
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
-
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
-
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
-
-        delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                facilityConfig.push_back(tokens[i]);
-            }
-
-            break;
-        }
-    }
-
-    return FacilityConfig(facilityConfig);
+    return FacilityConfig(RunRangeTable("../" + expName + "/FacilityConfig.txt", "facility configuration").find(runNumber));
 }
 
 // Read software CFD parameters
 SoftwareCFDConfig readSoftwareCFDConfig(string expName, int runNumber)
 {
-    string softwareCFDConfigLocation = "../" + expName + "/softwareCFDConfig.txt";
-    ifstream dataFile(softwareCFDConfigLocation.c_str());
-    if(!dataFile.is_open())
-    {
-        std::cout << "Failed to find software CFD configuration in " << softwareCFDConfigLocation << std::endl;
-        exit(1);
-    }
-
-    string str;
-    int run;
-    vector<string> softwareCFDConfig;
-
-    while(getline(dataFile,str))
-    {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
-
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
-
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
-
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
-
-        delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                softwareCFDConfig.push_back(tokens[i]);
-            }
-
-            break;
-        }
-    }
-
-    return SoftwareCFDConfig(softwareCFDConfig);
+    return SoftwareCFDConfig(RunRangeTable("../" + expName + "/softwareCFDConfig.txt", "software CFD configuration").find(runNumber));
 }
 
-
 // Read time offset parameters
 TimeConfig readTimeConfig(string expName, int runNumber)
 {
-    string timeConfigLocation = "../" + expName + "/TimeConfig.txt";
-    ifstream dataFile(timeConfigLocation.c_str());
-    if(!dataFile.is_open())
-    {
-        std::cout << "Failed to find time configuration in " << timeConfigLocation << std::endl;
-        exit(1);
-    }
-
-    string str;
-    int run;
-    vector<string> timeConfig;
-
-    while(getline(dataFile,str))
-    {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
-
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
-
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
-
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
-
-        delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                timeConfig.push_back(tokens[i]);
-            }
-
-            break;
-        }
-    }
-
-    return TimeConfig(timeConfig);
+    return TimeConfig(RunRangeTable("../" + expName + "/TimeConfig.txt", "time configuration").find(runNumber));
 }
 
-// Read time offset parameters
+// Read digitizer parameters
 DigitizerConfig readDigitizerConfig(string expName, int runNumber)
 {
-    string digitizerConfigLocation = "../" + expName + "/DigitizerConfig.txt";
-    ifstream dataFile(digitizerConfigLocation.c_str());
-    if(!dataFile.is_open())
-    {
-        std::cout << "Failed to find digitizer configuration in " << digitizerConfigLocation << std::endl;
-        exit(1);
-    }
-
-    string str;
-    int run;
-    vector<string> digitizerConfig;
-
-    while(getline(dataFile,str))
-    {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
-
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
-
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
-
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
-
-        delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                digitizerConfig.push_back(tokens[i]);
-            }
-
-            break;
-        }
-    }
+    vector<string> digitizerConfig = RunRangeTable("../" + expName + "/DigitizerConfig.txt", "digitizer configuration").find(runNumber);
 
     vector<pair<int, string>> channelMap = getChannelMap(expName, runNumber);
 
     return DigitizerConfig(channelMap, digitizerConfig);
 }
 
-
 // Read CS parameters 
 CSConfig readCSConfig(string expName, int runNumber)
 {
-    string csConfigLocation = "../" + expName + "/CSConfig.txt";
-    ifstream dataFile(csConfigLocation.c_str());
-    if(!dataFile.is_open())
-    {
-        std::cout << "Failed to find CS configuration in " << csConfigLocation << std::endl;
-        exit(1);
-    }
-
-    string str;
-    int run;
-    vector<string> csConfig;
-
-    while(getline(dataFile,str))
-    {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
-
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
-
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
-
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
-
-        delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                csConfig.push_back(tokens[i]);
-            }
-
-            break;
-        }
-    }
-
-    return CSConfig(csConfig);
+    return CSConfig(RunRangeTable("../" + expName + "/CSConfig.txt", "CS configuration").find(runNumber));
 }
 
 // Read plot parameters 
 PlotConfig readPlotConfig(string expName, int runNumber)
 {
-    string plotConfigLocation = "../" + expName + "/PlotConfig.txt";
-
-    ifstream dataFile(plotConfigLocation.c_str());
-    if(!dataFile.is_open())
-    {
-        std::cerr << "Failed to find plot configuration in " << plotConfigLocation << std::endl;
-        exit(1);
-    }
-
-    string str;
-    int run;
-    vector<string> plotConfig;
-
-    while(getline(dataFile,str))
-    {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
-
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
-
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
-
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
-
-        delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                plotConfig.push_back(tokens[i]);
-            }
-
-            break;
-        }
-    }
-
-    return PlotConfig(plotConfig);
+    return PlotConfig(RunRangeTable("../" + expName + "/PlotConfig.txt", "plot configuration").find(runNumber));
 }
 
 // Read target configuration parameters 
 TargetConfig readTargetConfig(string expName, int runNumber)
 {
-    string targetConfigLocation = "../" + expName + "/TargetConfig.txt";
-    ifstream dataFile(targetConfigLocation.c_str());
-    if(!dataFile.is_open())
-    {
-        std::cout << "Failed to find target configuration in " << targetConfigLocation << std::endl;
-        exit(1);
-    }
-
-    string str;
-    int run;
-    vector<pair<int,int>> targetConfig;
-
-    while(getline(dataFile,str))
-    {
-        // ignore comments in data file
-        string delimiter = "-";
-        stringstream tokenStream(str.substr(0,str.find(delimiter)));
-
-        if(!(tokenStream>>run))
-        {
-            // This line starts with a non-integer and is thus a comment; ignore
-            continue;
-        }
-
-        // parse data lines into space-delimited tokens
-        vector<string> tokens;
-        istringstream iss(str);
-        copy(istream_iterator<string>(iss),
-                istream_iterator<string>(),
-                back_inserter(tokens));
-
-        // extract run numbers from first token
-        string lowRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        tokens[0] = tokens[0].erase(0,tokens[0].find(delimiter) + delimiter.length());
-
-        delimiter = "\n";
-        string highRun = tokens[0].substr(0,tokens[0].find(delimiter));
-        
-        if(atoi(lowRun.c_str()) <= runNumber && runNumber <= atoi(highRun.c_str()))
-        {
-            for(int i=1; (size_t)i<tokens.size(); i++)
-            {
-                delimiter = "-";
-                string lowGate = tokens[i].substr(0,tokens[i].find(delimiter));
-                tokens[i] = tokens[i].erase(0,tokens[i].find(delimiter) + delimiter.length());
-
-                delimiter = "\n";
-                string highGate = tokens[i].substr(0,tokens[i].find(delimiter));
-
-                targetConfig.push_back(pair<int,int>(atoi(lowGate.c_str()),atoi(highGate.c_str())));
-            }
-
-            break;
-        }
-    }
+    vector<pair<int,int>> targetConfig = makeTargetGates(
+            RunRangeTable("../" + expName + "/TargetConfig.txt", "target configuration").find(runNumber));
 
     vector<string> targetPositions = getTargetOrder(expName, runNumber);
 
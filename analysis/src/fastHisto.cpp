@@ -0,0 +1,436 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "../include/fastHisto.h"
+
+using namespace std;
+
+FastHisto1D::FastHisto1D(string n, string t, int nBins, double low, double high)
+    : name(n), title(t), axis(nBins, low, high), counts(nBins+2, 0)
+{
+}
+
+void FastHisto1D::add(const FastHisto1D& h)
+{
+    if(h.counts.size()!=counts.size())
+    {
+        cerr << "Error: cannot add FastHisto1D " << h.name << " to " << name
+            << " (different binning)." << endl;
+        return;
+    }
+
+    for(size_t i=0; i<counts.size(); i++)
+    {
+        counts[i] += h.counts[i];
+    }
+
+    entries += h.entries;
+}
+
+void FastHisto1D::reset()
+{
+    fill_n(counts.begin(), counts.size(), 0);
+    entries = 0;
+}
+
+long FastHisto1D::getBinContent(int bin) const
+{
+    return counts[bin];
+}
+
+long FastHisto1D::getEntries() const
+{
+    return entries;
+}
+
+int FastHisto1D::getNBins() const
+{
+    return axis.nBins;
+}
+
+const FastAxis& FastHisto1D::getAxis() const
+{
+    return axis;
+}
+
+TH1D* FastHisto1D::toTH1D() const
+{
+    TH1D* histo = new TH1D(name.c_str(), title.c_str(), axis.nBins, axis.low, axis.high);
+
+    for(int i=0; i<=axis.nBins+1; i++)
+    {
+        if(counts[i])
+        {
+            histo->SetBinContent(i, counts[i]);
+        }
+    }
+
+    histo->SetEntries(entries);
+
+    return histo;
+}
+
+WeightedHisto1D::WeightedHisto1D(int nBins, double low, double high)
+    : axis(nBins, low, high), contents(nBins+2, 0)
+{
+}
+
+WeightedHisto1D::WeightedHisto1D(const vector<double>& binEdges)
+    : axis(binEdges.size()-1, binEdges.front(), binEdges.back()), edges(binEdges),
+      contents(binEdges.size()+1, 0)
+{
+}
+
+WeightedHisto1D::WeightedHisto1D(const TH1* histo)
+{
+    const TAxis* histoAxis = histo->GetXaxis();
+    int nBins = histoAxis->GetNbins();
+
+    axis = FastAxis(nBins, histoAxis->GetXmin(), histoAxis->GetXmax());
+
+    if(histoAxis->GetXbins()->GetSize())
+    {
+        const double* binEdges = histoAxis->GetXbins()->GetArray();
+        edges.assign(binEdges, binEdges+nBins+1);
+    }
+
+    contents.resize(nBins+2);
+    for(int i=0; i<=nBins+1; i++)
+    {
+        contents[i] = histo->GetBinContent(i);
+    }
+
+    entries = histo->GetEntries();
+}
+
+WeightedHisto1D::WeightedHisto1D(const FastHisto1D& histo)
+    : axis(histo.getAxis()), contents(histo.getNBins()+2)
+{
+    for(int i=0; i<=histo.getNBins()+1; i++)
+    {
+        contents[i] = histo.getBinContent(i);
+    }
+
+    entries = histo.getEntries();
+}
+
+int WeightedHisto1D::getNBins() const
+{
+    return axis.nBins;
+}
+
+double WeightedHisto1D::getLowEdge() const
+{
+    return axis.low;
+}
+
+double WeightedHisto1D::getHighEdge() const
+{
+    return axis.high;
+}
+
+double WeightedHisto1D::getBinCenter(int bin) const
+{
+    if(edges.size())
+    {
+        return (edges[bin-1]+edges[bin])/2;
+    }
+
+    // same arithmetic as TAxis::GetBinCenter
+    double binWidth = axis.width/axis.nBins;
+    return axis.low + (bin-1)*binWidth + binWidth/2;
+}
+
+bool WeightedHisto1D::sameBinning(const WeightedHisto1D& h) const
+{
+    return axis.nBins==h.axis.nBins
+        && axis.low==h.axis.low
+        && axis.high==h.axis.high
+        && edges==h.edges;
+}
+
+int WeightedHisto1D::add(const WeightedHisto1D& h, double weight)
+{
+    if(empty())
+    {
+        axis = h.axis;
+        edges = h.edges;
+        contents.assign(h.contents.size(), 0);
+    }
+
+    else if(!sameBinning(h))
+    {
+        cerr << "Error: cannot add WeightedHisto1Ds with different binning." << endl;
+        return 1;
+    }
+
+    for(size_t i=0; i<contents.size(); i++)
+    {
+        contents[i] += weight*h.contents[i];
+    }
+
+    entries += weight*h.entries;
+
+    return 0;
+}
+
+TH1D* WeightedHisto1D::toTH1D(string name, string title) const
+{
+    TH1D* histo;
+
+    if(edges.size())
+    {
+        histo = new TH1D(name.c_str(), title.c_str(), axis.nBins, &edges[0]);
+    }
+
+    else
+    {
+        histo = new TH1D(name.c_str(), title.c_str(), axis.nBins, axis.low, axis.high);
+    }
+
+    for(int i=0; i<=axis.nBins+1; i++)
+    {
+        histo->SetBinContent(i, contents[i]);
+    }
+
+    histo->SetEntries(entries);
+
+    return histo;
+}
+
+FastHisto2D::FastHisto2D(string n, string t,
+        int nBinsX, double lowX, double highX,
+        int nBinsY, double lowY, double highY)
+    : name(n), title(t), xAxis(nBinsX, lowX, highX), yAxis(nBinsY, lowY, highY)
+{
+    // include underflow and overflow bins
+    blocksX = (nBinsX+2+BLOCK_MASK)>>BLOCK_BITS;
+    blocksY = (nBinsY+2+BLOCK_MASK)>>BLOCK_BITS;
+
+    blocks.resize((long)blocksX*blocksY);
+}
+
+void FastHisto2D::add(const FastHisto2D& h)
+{
+    if(h.blocks.size()!=blocks.size())
+    {
+        cerr << "Error: cannot add FastHisto2D " << h.name << " to " << name
+            << " (different binning)." << endl;
+        return;
+    }
+
+    for(size_t i=0; i<blocks.size(); i++)
+    {
+        const vector<int>& other = h.blocks[i];
+        if(other.empty())
+        {
+            continue;
+        }
+
+        if(blocks[i].empty())
+        {
+            blocks[i] = other;
+            continue;
+        }
+
+        for(size_t j=0; j<other.size(); j++)
+        {
+            blocks[i][j] += other[j];
+        }
+    }
+
+    entries += h.entries;
+}
+
+void FastHisto2D::reset()
+{
+    for(auto& block : blocks)
+    {
+        vector<int>().swap(block);
+    }
+
+    entries = 0;
+}
+
+long FastHisto2D::getBinContent(int binX, int binY) const
+{
+    const vector<int>& block = blocks[(binX>>BLOCK_BITS)+blocksX*(binY>>BLOCK_BITS)];
+    if(block.empty())
+    {
+        return 0;
+    }
+
+    return block[(binX&BLOCK_MASK)+BLOCK_SIZE*(binY&BLOCK_MASK)];
+}
+
+long FastHisto2D::getEntries() const
+{
+    return entries;
+}
+
+long FastHisto2D::getAllocatedBins() const
+{
+    long allocatedBins = 0;
+
+    for(auto& block : blocks)
+    {
+        allocatedBins += block.size();
+    }
+
+    return allocatedBins;
+}
+
+template<class H> H* FastHisto2D::toROOTHisto() const
+{
+    H* histo = new H(name.c_str(), title.c_str(),
+            xAxis.nBins, xAxis.low, xAxis.high,
+            yAxis.nBins, yAxis.low, yAxis.high);
+
+    // only visit allocated blocks
+    for(int by=0; by<blocksY; by++)
+    {
+        for(int bx=0; bx<blocksX; bx++)
+        {
+            const vector<int>& block = blocks[bx+blocksX*by];
+            if(block.empty())
+            {
+                continue;
+            }
+
+            for(int j=0; j<BLOCK_SIZE; j++)
+            {
+                int binY = (by<<BLOCK_BITS)+j;
+                if(binY>yAxis.nBins+1)
+                {
+                    break;
+                }
+
+                for(int i=0; i<BLOCK_SIZE; i++)
+                {
+                    int binX = (bx<<BLOCK_BITS)+i;
+                    if(binX>xAxis.nBins+1)
+                    {
+                        break;
+                    }
+
+                    int content = block[i+BLOCK_SIZE*j];
+                    if(content)
+                    {
+                        histo->SetBinContent(binX, binY, content);
+                    }
+                }
+            }
+        }
+    }
+
+    histo->SetEntries(entries);
+
+    return histo;
+}
+
+TH2I* FastHisto2D::toTH2I() const
+{
+    return toROOTHisto<TH2I>();
+}
+
+TH2D* FastHisto2D::toTH2D() const
+{
+    return toROOTHisto<TH2D>();
+}
+
+void FastHisto2D::write() const
+{
+    TH2I* histo = toTH2I();
+    histo->Write();
+    delete histo;
+}
+
+// set on the threads fillInParallel and runInParallel start, so that work
+// they run doesn't start pools of its own (which would multiply the number of
+// threads, and of per-thread histogram copies)
+thread_local bool onPoolThread = false;
+
+unsigned int getNumberOfThreads()
+{
+    if(onPoolThread)
+    {
+        return 1;
+    }
+
+    unsigned int numberOfThreads = thread::hardware_concurrency();
+    if(numberOfThreads==0)
+    {
+        numberOfThreads = 1;
+    }
+
+    return numberOfThreads;
+}
+
+void fillInParallel(long numberOfEntries, unsigned int numberOfThreads,
+        const function<void(unsigned int, long, long)>& fillRange)
+{
+    if(numberOfThreads<=1 || numberOfEntries<(long)numberOfThreads || onPoolThread)
+    {
+        fillRange(0, 0, numberOfEntries);
+        return;
+    }
+
+    vector<thread> workers;
+    long chunkSize = numberOfEntries/numberOfThreads;
+
+    for(unsigned int t=0; t<numberOfThreads; t++)
+    {
+        long begin = t*chunkSize;
+        long end = (t==numberOfThreads-1) ? numberOfEntries : begin+chunkSize;
+
+        workers.push_back(thread([&fillRange, t, begin, end]()
+                    {
+                        onPoolThread = true;
+                        fillRange(t, begin, end);
+                    }));
+    }
+
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void runInParallel(long numberOfTasks, unsigned int numberOfThreads,
+        const function<void(long)>& task)
+{
+    if(numberOfThreads<=1 || numberOfTasks<=1 || onPoolThread)
+    {
+        for(long i=0; i<numberOfTasks; i++)
+        {
+            task(i);
+        }
+
+        return;
+    }
+
+    atomic<long> nextTask(0);
+
+    vector<thread> workers;
+
+    for(unsigned int t=0; t<numberOfThreads && t<numberOfTasks; t++)
+    {
+        workers.push_back(thread([&]()
+                    {
+                        onPoolThread = true;
+
+                        long i;
+                        while((i = nextTask++)<numberOfTasks)
+                        {
+                            task(i);
+                        }
+                    }));
+    }
+
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+}
@@ -0,0 +1,548 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <limits.h>
+
+#include "TROOT.h"
+#include "TStyle.h"
+#include "TCanvas.h"
+#include "TCollection.h"
+#include "TError.h"
+
+#include "../include/figureRenderer.h"
+
+using namespace std;
+
+const string RENDER_STAMPS_FILE_NAME = "renderStamps.txt";
+
+// 64-bit FNV-1a hash, continuing from hash
+static unsigned long hashBytes(const char* bytes, size_t length,
+        unsigned long hash = 14695981039346656037UL)
+{
+    for(size_t i=0; i<length; i++)
+    {
+        hash ^= (unsigned char)bytes[i];
+        hash *= 1099511628211UL;
+    }
+
+    return hash;
+}
+
+static unsigned long hashString(const string& s, unsigned long hash)
+{
+    // include the terminator, so that consecutive strings can't run together
+    return hashBytes(s.c_str(), s.size()+1, hash);
+}
+
+static string getDirectory(const string& fileName)
+{
+    size_t lastSlash = fileName.rfind('/');
+    if(lastSlash==string::npos)
+    {
+        return ".";
+    }
+
+    return fileName.substr(0, lastSlash);
+}
+
+static string getBaseName(const string& fileName)
+{
+    return fileName.substr(fileName.rfind('/')+1);
+}
+
+static int readMacro(const string& macroFileName, string& contents)
+{
+    ifstream file(macroFileName);
+    if(!file.good())
+    {
+        return 1;
+    }
+
+    stringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+
+    return 0;
+}
+
+int findFigureInputs(string macroFileName, Figure& figure)
+{
+    string contents;
+    if(readMacro(macroFileName, contents))
+    {
+        cerr << "Error: couldn't read figure macro " << macroFileName << endl;
+        return 1;
+    }
+
+    figure.macroFileName = macroFileName;
+    figure.inputFileNames.clear();
+
+    set<string> inputs;
+
+    istringstream lines(contents);
+    string line;
+
+    while(getline(lines, line))
+    {
+        // string literals on this line, up to any comment
+        bool inLiteral = false;
+        string literal;
+
+        for(size_t i=0; i<line.size(); i++)
+        {
+            if(!inLiteral && line.compare(i, 2, "//")==0)
+            {
+                break;
+            }
+
+            if(line[i]!='"')
+            {
+                if(inLiteral)
+                {
+                    literal += line[i];
+                }
+
+                continue;
+            }
+
+            if(inLiteral && literal.size()>5
+                    && literal.compare(literal.size()-5, 5, ".root")==0)
+            {
+                string input = literal;
+
+                if(input[0]=='~' && getenv("HOME"))
+                {
+                    input = getenv("HOME") + input.substr(1);
+                }
+
+                else if(input[0]!='/')
+                {
+                    input = getDirectory(macroFileName) + "/" + input;
+                }
+
+                if(inputs.insert(input).second)
+                {
+                    figure.inputFileNames.push_back(input);
+                }
+            }
+
+            inLiteral = !inLiteral;
+            literal.clear();
+        }
+    }
+
+    return 0;
+}
+
+void setGraphStyle()
+{
+    TStyle* style = (TStyle*)gROOT->FindObject("graphStyle");
+
+    if(!style)
+    {
+        style = new TStyle("graphStyle","graphStyle");
+    }
+
+    style->SetOptStat(0);
+    style->SetOptTitle(0);
+    style->SetCanvasColor(10);
+    style->SetCanvasBorderMode(0);
+    style->SetFrameLineWidth(3);
+    style->SetFrameFillColor(10);
+    style->SetPadColor(10);
+    style->SetHistLineWidth(4);
+    style->SetHistLineColor(kRed);
+    style->SetMarkerSize(0.6);
+    style->SetMarkerStyle(8);
+    style->SetLabelColor(kBlack,"xyz");
+    style->SetTitleSize(0.08,"xyz");
+    style->SetTitleFillColor(10);
+    style->SetTitleTextColor(kBlack);
+    style->SetEndErrorSize(0);
+
+    gROOT->SetStyle("graphStyle");
+    gROOT->ForceStyle();
+}
+
+// Stamp of everything a figure's rendering depends on: its macro, its inputs'
+// sizes and modification times, and the formats to save
+static unsigned long getFigureStamp(const Figure& figure, const vector<string>& formats)
+{
+    string contents;
+    if(readMacro(figure.macroFileName, contents))
+    {
+        contents.clear();
+    }
+
+    unsigned long stamp = hashString(contents, hashBytes(nullptr, 0));
+
+    for(const string& input : figure.inputFileNames)
+    {
+        stamp = hashString(input, stamp);
+
+        struct stat status;
+        if(stat(input.c_str(), &status))
+        {
+            stamp = hashString("missing", stamp);
+            continue;
+        }
+
+        long times[3] = {(long)status.st_size,
+            (long)status.st_mtim.tv_sec, (long)status.st_mtim.tv_nsec};
+        stamp = hashBytes((const char*)times, sizeof(times), stamp);
+    }
+
+    for(const string& format : formats)
+    {
+        stamp = hashString(format, stamp);
+    }
+
+    return stamp;
+}
+
+struct RenderStamp
+{
+    unsigned long stamp;
+    vector<string> outputFileNames;
+};
+
+// renderStamps.txt: one line per figure, of tab-separated macro file name,
+// stamp (hexadecimal) and output file names
+static void readRenderStamps(string fileName, map<string, RenderStamp>& stamps)
+{
+    ifstream file(fileName);
+
+    string line;
+    while(getline(file, line))
+    {
+        vector<string> fields;
+        istringstream tokens(line);
+        string field;
+        while(getline(tokens, field, '\t'))
+        {
+            fields.push_back(field);
+        }
+
+        if(fields.size()<3)
+        {
+            continue;
+        }
+
+        RenderStamp stamp;
+        stamp.stamp = strtoul(fields[1].c_str(), nullptr, 16);
+        stamp.outputFileNames.assign(fields.begin()+2, fields.end());
+
+        stamps[fields[0]] = stamp;
+    }
+}
+
+static int writeRenderStamps(string fileName, const map<string, RenderStamp>& stamps)
+{
+    // write to a temporary file first, so that an interrupted write leaves
+    // the previous stamps intact
+    string temporaryFileName = fileName + ".tmp";
+
+    ofstream file(temporaryFileName, ios::trunc);
+    if(!file.good())
+    {
+        cerr << "Error: failed to open " << temporaryFileName << " for writing." << endl;
+        return 1;
+    }
+
+    for(auto& stamp : stamps)
+    {
+        file << stamp.first << "\t" << hex << stamp.second.stamp << dec;
+
+        for(const string& output : stamp.second.outputFileNames)
+        {
+            file << "\t" << output;
+        }
+
+        file << "\n";
+    }
+
+    file.close();
+
+    if(!file.good() || rename(temporaryFileName.c_str(), fileName.c_str()))
+    {
+        cerr << "Error: failed to write render stamps " << fileName << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+static bool isUpToDate(const map<string, RenderStamp>& stamps, const string& macroFileName,
+        unsigned long stamp)
+{
+    auto previous = stamps.find(macroFileName);
+    if(previous==stamps.end() || previous->second.stamp!=stamp)
+    {
+        return false;
+    }
+
+    for(const string& output : previous->second.outputFileNames)
+    {
+        if(access(output.c_str(), F_OK))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Run in a worker: draw a figure and save its canvases, listing each file
+// saved on outputs. Returns 1 on failure.
+static int renderFigure(const Figure& figure, const string& outputDirectory,
+        const vector<string>& formats, FILE* outputs)
+{
+    // run the macro from its own directory, as when it's run by hand
+    if(chdir(getDirectory(figure.macroFileName).c_str()))
+    {
+        cerr << "Error: couldn't change to the directory of " << figure.macroFileName << endl;
+        return 1;
+    }
+
+    string macroName = getBaseName(figure.macroFileName);
+
+    int error = 0;
+    gROOT->Macro(macroName.c_str(), &error);
+    if(error)
+    {
+        cerr << "Error: failed to run figure macro " << figure.macroFileName << endl;
+        return 1;
+    }
+
+    TSeqCollection* canvases = gROOT->GetListOfCanvases();
+    if(canvases->GetSize()==0)
+    {
+        cerr << "Error: figure macro " << figure.macroFileName << " drew no canvases." << endl;
+        return 1;
+    }
+
+    string figureName = macroName.substr(0, macroName.rfind('.'));
+
+    TIter nextCanvas(canvases);
+    while(TCanvas* canvas = (TCanvas*)nextCanvas())
+    {
+        string outputName = outputDirectory + "/" + figureName;
+        if(canvases->GetSize()>1)
+        {
+            outputName += string("_") + canvas->GetName();
+        }
+
+        for(const string& format : formats)
+        {
+            string outputFileName = outputName + "." + format;
+            canvas->SaveAs(outputFileName.c_str());
+
+            fprintf(outputs, "%s\n", outputFileName.c_str());
+        }
+    }
+
+    return 0;
+}
+
+// a worker process rendering one figure
+struct Worker
+{
+    int figure;
+    int outputsPipe; // read end; the worker lists the files it saved
+};
+
+int renderFigures(const vector<Figure>& figures, string outputDirectory,
+        const vector<string>& formats, unsigned int numberOfWorkers)
+{
+    if(mkdir(outputDirectory.c_str(), 0755) && access(outputDirectory.c_str(), W_OK))
+    {
+        cerr << "Error: couldn't create output directory " << outputDirectory << endl;
+        return 1;
+    }
+
+    // workers change directory, so need an absolute output path
+    char absolutePath[PATH_MAX];
+    if(!realpath(outputDirectory.c_str(), absolutePath))
+    {
+        cerr << "Error: couldn't resolve output directory " << outputDirectory << endl;
+        return 1;
+    }
+
+    outputDirectory = absolutePath;
+
+    string stampsFileName = outputDirectory + "/" + RENDER_STAMPS_FILE_NAME;
+    map<string, RenderStamp> stamps;
+    readRenderStamps(stampsFileName, stamps);
+
+    vector<int> staleFigures;
+    vector<unsigned long> figureStamps;
+
+    for(unsigned int i=0; i<figures.size(); i++)
+    {
+        figureStamps.push_back(getFigureStamp(figures[i], formats));
+
+        if(isUpToDate(stamps, figures[i].macroFileName, figureStamps[i]))
+        {
+            cout << "Skipping " << figures[i].macroFileName << " (up to date)" << endl;
+            continue;
+        }
+
+        staleFigures.push_back(i);
+    }
+
+    if(staleFigures.empty())
+    {
+        cout << "All " << figures.size() << " figures are up to date." << endl;
+        return 0;
+    }
+
+    // read shared inputs ahead, once, into the page cache the workers share
+    set<string> inputs;
+    for(int i : staleFigures)
+    {
+        inputs.insert(figures[i].inputFileNames.begin(), figures[i].inputFileNames.end());
+    }
+
+    for(const string& input : inputs)
+    {
+        int file = open(input.c_str(), O_RDONLY);
+        if(file<0)
+        {
+            cerr << "Error: couldn't open figure input " << input << endl;
+            continue;
+        }
+
+        posix_fadvise(file, 0, 0, POSIX_FADV_WILLNEED);
+        close(file);
+    }
+
+    // set up ROOT once, before forking, so that each worker starts with it
+    gROOT->SetBatch(kTRUE);
+    gErrorIgnoreLevel = kWarning;
+    setGraphStyle();
+
+    if(numberOfWorkers<1)
+    {
+        numberOfWorkers = 1;
+    }
+
+    map<pid_t, Worker> running;
+    unsigned int next = 0;
+    int numberOfFailures = 0;
+
+    while(next<staleFigures.size() || !running.empty())
+    {
+        // start workers while there's room
+        while(next<staleFigures.size() && running.size()<numberOfWorkers)
+        {
+            int figure = staleFigures[next++];
+
+            cout << "Rendering " << figures[figure].macroFileName << endl;
+            cout.flush();
+            cerr.flush();
+
+            int outputsPipe[2];
+            if(pipe(outputsPipe))
+            {
+                cerr << "Error: couldn't create a pipe for " << figures[figure].macroFileName << endl;
+                numberOfFailures++;
+                continue;
+            }
+
+            pid_t pid = fork();
+
+            if(pid<0)
+            {
+                cerr << "Error: couldn't start a worker for " << figures[figure].macroFileName << endl;
+                close(outputsPipe[0]);
+                close(outputsPipe[1]);
+                numberOfFailures++;
+                continue;
+            }
+
+            if(pid==0)
+            {
+                close(outputsPipe[0]);
+
+                FILE* outputs = fdopen(outputsPipe[1], "w");
+                int status = renderFigure(figures[figure], outputDirectory, formats, outputs);
+                fclose(outputs);
+
+                cout.flush();
+                cerr.flush();
+                _exit(status);
+            }
+
+            close(outputsPipe[1]);
+            running[pid] = Worker{figure, outputsPipe[0]};
+        }
+
+        // wait for any worker to finish
+        int status;
+        pid_t pid = wait(&status);
+        if(pid<0)
+        {
+            break;
+        }
+
+        auto worker = running.find(pid);
+        if(worker==running.end())
+        {
+            continue;
+        }
+
+        const Figure& figure = figures[worker->second.figure];
+
+        // the files the worker saved
+        string outputList;
+        char buffer[4096];
+        ssize_t length;
+        while((length = read(worker->second.outputsPipe, buffer, sizeof(buffer)))>0)
+        {
+            outputList.append(buffer, length);
+        }
+
+        close(worker->second.outputsPipe);
+
+        if(!WIFEXITED(status) || WEXITSTATUS(status)!=0)
+        {
+            cerr << "Error: failed to render " << figure.macroFileName << endl;
+            stamps.erase(figure.macroFileName);
+            numberOfFailures++;
+        }
+
+        else
+        {
+            RenderStamp stamp;
+            stamp.stamp = figureStamps[worker->second.figure];
+
+            istringstream outputLines(outputList);
+            string output;
+            while(getline(outputLines, output))
+            {
+                stamp.outputFileNames.push_back(output);
+            }
+
+            stamps[figure.macroFileName] = stamp;
+        }
+
+        running.erase(worker);
+    }
+
+    writeRenderStamps(stampsFileName, stamps);
+
+    cout << "Rendered " << staleFigures.size()-numberOfFailures << " figures ("
+        << figures.size()-staleFigures.size() << " up to date, "
+        << numberOfFailures << " failed)." << endl;
+
+    return numberOfFailures>0;
+}
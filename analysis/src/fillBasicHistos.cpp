@@ -16,14 +16,125 @@
 #include "../include/waveform.h"
 #include "../include/config.h"
 #include "../include/GammaCorrection.h"
+#include "../include/fastHisto.h"
+#include "../include/macroCounter.h"
 
 #include "TRandom3.h"
 
 using namespace std;
 
-extern Config config;
+// event quantities needed to fill the basic histograms
+struct BasicEvent
+{
+    int cycleNumber = 0;
+    int macroNo = 0;
+    double macroTime = 0;
+    int targetPos = 0;
+    int eventNo = 0;
+    double fineTime = 0;
+    int sgQ = 0;
+    int lgQ = 0;
+
+    // detector channels only: jittered TOF, if in a good micropulse
+    bool passedMicroGate = false;
+    double microTime = 0;
+};
+
+// one filling thread's private copy of a channel's basic histograms
+struct BasicHistos
+{
+    FastHisto1D cycleNumberH;
+    MacroCounter macroNoH;
+    FastHisto1D macroTimeH;
+
+    std::vector<MacroCounter> macroNumberCounters;
+
+    FastHisto1D eventNoH;
+    FastHisto1D targetPosH;
+    FastHisto1D fineTimeH;
+    FastHisto1D sgQH;
+    FastHisto1D lgQH;
+
+    FastHisto2D sgQlgQH;
+    FastHisto1D QRatio;
+
+    std::vector<FastHisto1D> rawTOFHistos;
+
+    void fill(const BasicEvent& e)
+    {
+        cycleNumberH.fill(e.cycleNumber);
+        macroNoH.fill(e.macroNo);
+        if(e.cycleNumber==1)
+        {
+            macroTimeH.fill(e.macroTime);
+        }
+
+        macroNumberCounters[e.targetPos].fill(e.macroNo);
+
+        targetPosH.fill(e.targetPos);
+        eventNoH.fill(e.eventNo);
+        fineTimeH.fill(e.fineTime);
+        sgQH.fill(e.sgQ);
+        lgQH.fill(e.lgQ);
+
+        sgQlgQH.fill(e.sgQ,e.lgQ);
+        QRatio.fill(e.sgQ/(double)e.lgQ);
+
+        if(e.passedMicroGate)
+        {
+            rawTOFHistos[e.targetPos].fill(e.microTime);
+        }
+    }
+
+    void add(const BasicHistos& h)
+    {
+        cycleNumberH.add(h.cycleNumberH);
+        macroNoH.add(h.macroNoH);
+        macroTimeH.add(h.macroTimeH);
+
+        for(int i=0; i<macroNumberCounters.size(); i++)
+        {
+            macroNumberCounters[i].add(h.macroNumberCounters[i]);
+            rawTOFHistos[i].add(h.rawTOFHistos[i]);
+        }
+
+        eventNoH.add(h.eventNoH);
+        targetPosH.add(h.targetPosH);
+        fineTimeH.add(h.fineTimeH);
+        sgQH.add(h.sgQH);
+        lgQH.add(h.lgQH);
+        sgQlgQH.add(h.sgQlgQH);
+        QRatio.add(h.QRatio);
+    }
+
+    // convert to ROOT histograms and write to the current directory
+    void write() const
+    {
+        cycleNumberH.toTH1D()->Write();
+        macroNoH.write();
+        macroTimeH.toTH1D()->Write();
+
+        for(auto& counter : macroNumberCounters)
+        {
+            counter.write();
+        }
 
-int fillBasicHistos(string inputFileName, ofstream& log, string outputFileName)
+        eventNoH.toTH1D()->Write();
+        targetPosH.toTH1D()->Write();
+        fineTimeH.toTH1D()->Write();
+        sgQH.toTH1D()->Write();
+        lgQH.toTH1D()->Write();
+        sgQlgQH.write();
+        QRatio.toTH1D()->Write();
+
+        for(auto& histo : rawTOFHistos)
+        {
+            histo.toTH1D()->Write();
+        }
+    }
+};
+
+int fillBasicHistos(string inputFileName, ofstream& log, string outputFileName, const Config& config)
 {
     ifstream f(outputFileName);
 
@@ -47,8 +158,8 @@ int fillBasicHistos(string inputFileName, ofstream& log, string outputFileName)
     for(auto& channel : config.digitizer.CHANNEL_MAP)
     {
         if(
-                channel.second == "-" ||
-                channel.second == "targetChanger"
+                config.channels.ROLES[channel.first] == ChannelRole::UNUSED ||
+                config.channels.ROLES[channel.first] == ChannelRole::TARGET_CHANGER
           )
         {
             continue;
@@ -81,40 +192,41 @@ int fillBasicHistos(string inputFileName, ofstream& log, string outputFileName)
         TDirectory* directory = outputFile->mkdir(channel.second.c_str(),channel.second.c_str());
         directory->cd();
 
-        // create histos for visualizing basic event data
-        TH1D* cycleNumberH = new TH1D("cycleNumberH","cycleNumberH",500,0,500);
-        TH1D* macroNoH = new TH1D("macroNoH","macroNo",500000,0,500000);
-        TH1D* macroTimeH = new TH1D("macroTimeH","macroTime",5000,0,5000000000);
+        // create histos for visualizing basic event data; each filling
+        // thread receives its own copy of this prototype
+        BasicHistos prototype;
+
+        prototype.cycleNumberH = FastHisto1D("cycleNumberH","cycleNumberH",500,0,500);
+        prototype.macroNoH = MacroCounter("macroNoH");
+        prototype.macroTimeH = FastHisto1D("macroTimeH","macroTime",5000,0,5000000000);
 
-        vector<TH1D*> macroNumberHistos;
         for(string targetName : config.target.TARGET_ORDER)
         {
             string macroNumberName = targetName + "MacroNumber";
-            macroNumberHistos.push_back(new TH1D(macroNumberName.c_str(), macroNumberName.c_str(),
-                        500000, 0, 500000));
+            prototype.macroNumberCounters.push_back(MacroCounter(macroNumberName));
         }
 
-        TH1D* eventNoH = new TH1D("eventNoH","eventNo",300,0,300);
-        TH1D* targetPosH = new TH1D("targetPosH","targetPos",7,0,7);
-        TH1D* fineTimeH = new TH1D("fineTimeH","fineTimeH",6200,-2,60);
-        TH1D* sgQH = new TH1D("sgQH","sgQ",3500,0,35000);
-        TH1D* lgQH = new TH1D("lgQH","lgQ",7000,0,70000);
+        prototype.eventNoH = FastHisto1D("eventNoH","eventNo",300,0,300);
+        prototype.targetPosH = FastHisto1D("targetPosH","targetPos",7,0,7);
+        prototype.fineTimeH = FastHisto1D("fineTimeH","fineTimeH",6200,-2,60);
+        prototype.sgQH = FastHisto1D("sgQH","sgQ",3500,0,35000);
+        prototype.lgQH = FastHisto1D("lgQH","lgQ",7000,0,70000);
 
-        TH2D *sgQlgQH = new TH2D("sgQlgQH","short gate Q vs. long gate Q",2048,0,65536,2048,0,65536);
-        TH1D *QRatio = new TH1D("QRatio","short gate Q/long gate Q",1000,0,1);
-
-        vector<TH1D*> rawTOFHistos;
+        prototype.sgQlgQH = FastHisto2D("sgQlgQH","short gate Q vs. long gate Q",2048,0,65536,2048,0,65536);
+        prototype.QRatio = FastHisto1D("QRatio","short gate Q/long gate Q",1000,0,1);
 
         for(string targetName : config.target.TARGET_ORDER)
         {
             string TOFName = targetName + "TOF";
-            rawTOFHistos.push_back(new TH1D(TOFName.c_str(),
-                        TOFName.c_str(),
+            prototype.rawTOFHistos.push_back(FastHisto1D(TOFName,
+                        TOFName,
                         config.plot.TOF_BINS,
                         config.plot.TOF_LOWER_BOUND,
                         config.plot.TOF_UPPER_BOUND));
         }
 
+        bool isDetector = (config.channels.DETECTOR_NUMBERS[channel.first] >= 0);
+
         // create a subdirectory for holding DPP-mode waveform data
         directory->mkdir("waveformsDir","raw DPP waveforms");
         TDirectory* waveformsDir = (TDirectory*)gDirectory->Get("waveformsDir");
@@ -127,55 +239,45 @@ int fillBasicHistos(string inputFileName, ofstream& log, string outputFileName)
 
         TRandom3* rng = new TRandom3();
 
-        // fill basic histos
+        // read events from tree (serially, to preserve the random number
+        // sequence used for TOF jitter)
+        vector<BasicEvent> events(totalEntries);
+
         for(int i=0; i<totalEntries; i++)
         {
             tree->GetEntry(i);
 
             event.waveform = *waveformPointer;
 
-            cycleNumberH->Fill(event.cycleNumber);
-            macroNoH->Fill(event.macroNo);
-            if(event.cycleNumber==1)
-            {
-                macroTimeH->Fill(event.macroTime);
-            }
-
-            macroNumberHistos[event.targetPos]->Fill(event.macroNo);
-
-            targetPosH->Fill(event.targetPos);
-            eventNoH->Fill(event.eventNo);
-            fineTimeH->Fill(event.fineTime);
-            sgQH->Fill(event.sgQ);
-            lgQH->Fill(event.lgQ);
-
-            sgQlgQH->Fill(event.sgQ,event.lgQ);
-            QRatio->Fill(event.sgQ/(double)event.lgQ);
-
-            for(auto& detectorName : config.cs.DETECTOR_NAMES)
+            BasicEvent& be = events[i];
+            be.cycleNumber = event.cycleNumber;
+            be.macroNo = event.macroNo;
+            be.macroTime = event.macroTime;
+            be.targetPos = event.targetPos;
+            be.eventNo = event.eventNo;
+            be.fineTime = event.fineTime;
+            be.sgQ = event.sgQ;
+            be.lgQ = event.lgQ;
+
+            if(isDetector)
             {
-                if(channel.second==detectorName)
+                // fill uncorrected TOF histos
+                timeDiff = event.completeTime-event.macroTime+config.digitizer.SAMPLE_PERIOD*(rng->Uniform(0, 1)-0.5);
+                microNo = floor(timeDiff/config.facility.MICRO_LENGTH);
+                microTime = fmod(timeDiff,config.facility.MICRO_LENGTH);
+
+                // micropulse gate:
+                if(microNo >= config.facility.FIRST_GOOD_MICRO
+                        && microNo < config.facility.LAST_GOOD_MICRO)
                 {
-                    // fill uncorrected TOF histos
-                    timeDiff = event.completeTime-event.macroTime+config.digitizer.SAMPLE_PERIOD*(rng->Uniform(0, 1)-0.5);
-                    //cout << "timeDiff = " << timeDiff << ", rng = " << rng->Uniform(0,1) << endl;
-                    microNo = floor(timeDiff/config.facility.MICRO_LENGTH);
-                    microTime = fmod(timeDiff,config.facility.MICRO_LENGTH);
-
-                    // micropulse gate:
-                    if(microNo < config.facility.FIRST_GOOD_MICRO
-                            || microNo >= config.facility.LAST_GOOD_MICRO)
-                    {
-                        continue;
-                    }
-
-                    rawTOFHistos[event.targetPos]->Fill(microTime);
+                    be.passedMicroGate = true;
+                    be.microTime = microTime;
                 }
             }
 
             if(i%10000==0)
             {
-                cout << "Processed " << i << " " << channel.second << " events into basic histos...\r";
+                cout << "Read " << i << " " << channel.second << " events for basic histos...\r";
 
                 waveformsDir->cd();
                 stringstream temp;
@@ -192,29 +294,27 @@ int fillBasicHistos(string inputFileName, ofstream& log, string outputFileName)
             }
         }
 
-        directory->cd();
+        // fill basic histos in parallel, then reduce the per-thread copies
+        unsigned int numberOfThreads = getNumberOfThreads();
+        vector<BasicHistos> threadHistos(numberOfThreads, prototype);
 
-        cycleNumberH->Write();
-        macroNoH->Write();
-        macroTimeH->Write();
+        fillInParallel(events.size(), numberOfThreads,
+                [&](unsigned int thread, long begin, long end)
+                {
+                    for(long j=begin; j<end; j++)
+                    {
+                        threadHistos[thread].fill(events[j]);
+                    }
+                });
 
-        for(auto& histo : macroNumberHistos)
+        BasicHistos& histos = threadHistos[0];
+        for(unsigned int t=1; t<numberOfThreads; t++)
         {
-            histo->Write();
+            histos.add(threadHistos[t]);
         }
 
-        eventNoH->Write();
-        targetPosH->Write();
-        fineTimeH->Write();
-        sgQH->Write();
-        lgQH->Write();
-        sgQlgQH->Write();
-        QRatio->Write();
-
-        for(auto& histo : rawTOFHistos)
-        {
-            histo->Write();
-        }
+        directory->cd();
+        histos.write();
     }
 
     outputFile->Close();
@@ -18,12 +18,123 @@
 #include "../include/waveform.h"
 #include "../include/config.h"
 #include "../include/GammaCorrection.h"
+#include "../include/fastHisto.h"
+#include "../include/macroCounter.h"
+#include "../include/kinematics.h"
+#include "../include/eventColumns.h"
 
 using namespace std;
 
-extern Config config;
+// event quantities needed to fill the gated histograms, recorded during the
+// (serial) gating pass
+struct GatedEvent
+{
+    int targetPos = 0;
+    int macroNo = 0;
+    int microNo = 0;
+    int lgQ = 0;
+    bool vetoed = false;
+
+    double microTime = 0;
+    double eventTimeDiff = 0;
+    double prevMicroTime = 0;
+    double rKE = 0;
+    double prevRKE = 0;
+};
+
+// one filling thread's private copy of a channel's gated histograms
+struct GatedHistos
+{
+    std::vector<MacroCounter> goodMacroCounters;
+
+    std::vector<FastHisto1D> TOFHistos;
+    std::vector<FastHisto2D> triangleHistos;
+    std::vector<FastHisto1D> vetoTOFHistos;
+    std::vector<FastHisto2D> vetoTriangleHistos;
+
+    FastHisto1D timeDiffHisto;
+    FastHisto2D timeDiffVEnergy1;
+    FastHisto2D time1Vtime2;
+    FastHisto2D energy1VEnergy2;
+    FastHisto1D microNoH;
+
+    void fill(const GatedEvent& e)
+    {
+        if(e.vetoed)
+        {
+            vetoTOFHistos[e.targetPos].fill(e.microTime);
+            vetoTriangleHistos[e.targetPos].fill(e.microTime, e.lgQ);
+            return;
+        }
+
+        TOFHistos[e.targetPos].fill(e.microTime);
+        triangleHistos[e.targetPos].fill(e.microTime, e.lgQ);
+
+        // fill detector histograms with event data
+        timeDiffHisto.fill(e.eventTimeDiff);
+        timeDiffVEnergy1.fill(e.eventTimeDiff,e.prevRKE);
+        time1Vtime2.fill(e.prevMicroTime,e.microTime);
+        energy1VEnergy2.fill(e.prevRKE,e.rKE);
+        microNoH.fill(e.microNo);
+
+        goodMacroCounters[e.targetPos].fill(e.macroNo);
+    }
+
+    void add(const GatedHistos& h)
+    {
+        for(int i=0; i<TOFHistos.size(); i++)
+        {
+            goodMacroCounters[i].add(h.goodMacroCounters[i]);
+            TOFHistos[i].add(h.TOFHistos[i]);
+            triangleHistos[i].add(h.triangleHistos[i]);
+            vetoTOFHistos[i].add(h.vetoTOFHistos[i]);
+            vetoTriangleHistos[i].add(h.vetoTriangleHistos[i]);
+        }
+
+        timeDiffHisto.add(h.timeDiffHisto);
+        timeDiffVEnergy1.add(h.timeDiffVEnergy1);
+        time1Vtime2.add(h.time1Vtime2);
+        energy1VEnergy2.add(h.energy1VEnergy2);
+        microNoH.add(h.microNoH);
+    }
+
+    // convert to ROOT histograms and write to the current directory
+    void write() const
+    {
+        for(auto& histo : TOFHistos)
+        {
+            histo.toTH1D()->Write();
+        }
+
+        for(auto& histo : triangleHistos)
+        {
+            histo.write();
+        }
+
+        for(auto& histo : vetoTOFHistos)
+        {
+            histo.toTH1D()->Write();
+        }
 
-int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool useVetoPaddle, string macropulseFileName, string gammaCorrectionFileName, ofstream& logFile, string outputFileName)
+        for(auto& histo : vetoTriangleHistos)
+        {
+            histo.write();
+        }
+
+        timeDiffHisto.toTH1D()->Write();
+        timeDiffVEnergy1.write();
+        time1Vtime2.write();
+        energy1VEnergy2.write();
+        microNoH.toTH1D()->Write();
+
+        for(auto& counter : goodMacroCounters)
+        {
+            counter.write();
+        }
+    }
+};
+
+int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool useVetoPaddle, string macropulseFileName, string gammaCorrectionFileName, ofstream& logFile, string outputFileName, string eventColumnsFileName, const Config& config)
 {
     ifstream f(outputFileName);
 
@@ -36,7 +147,7 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
 
     logFile << endl << "*** Filling CS histos ***" << endl;
 
-    TFile* vetoedInputFile;
+    TFile* vetoedInputFile = 0;
     if(useVetoPaddle)
     {
         // open vetoed input tree
@@ -175,47 +286,64 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
     // create outputFile
     TFile* outputFile = new TFile(outputFileName.c_str(),"UPDATE");
 
+    // optionally, record detector events for later re-histogramming
+    TFile* eventColumnsFile = 0;
+    if(eventColumnsFileName != "")
+    {
+        eventColumnsFile = new TFile(eventColumnsFileName.c_str(),"RECREATE");
+    }
+
     for(auto& channel : config.digitizer.CHANNEL_MAP)
     {
-        if(channel.second == "-" || channel.second == "macroTime"
-                || channel.second == "targetChanger")
+        ChannelRole role = config.channels.ROLES[channel.first];
+
+        if(role == ChannelRole::UNUSED || role == ChannelRole::MACRO_TIME
+                || role == ChannelRole::TARGET_CHANGER)
         {
             continue;
         }
 
-        bool isDetector = false;
+        bool isDetector = (config.channels.DETECTOR_NUMBERS[channel.first] >= 0);
 
         TTree* tree;
 
-        for(auto& detName : config.cs.DETECTOR_NAMES)
+        cout << "Filling gated histograms for tree \"" << channel.second << "\"..." << endl;
+
+        tree = (TTree*)nonVetoInputFile->Get(channel.second.c_str());
+
+        if(!tree)
         {
-            if(channel.second == detName)
+            cerr << "Error: tried to populate advanced histos, but failed to find " << channel.second << " in " << nonVetoInputFileName << endl;
+
+            if(vetoedInputFile)
             {
-                isDetector = true;
-                break;
+                vetoedInputFile->Close();
             }
-        }
 
-        cout << "Filling gated histograms for tree \"" << channel.second << "\"..." << endl;
+            macropulseFile->Close();
+            gammaCorrectionFile->Close();
 
-        if(isDetector && useVetoPaddle)
-        {
-            tree = (TTree*)vetoedInputFile->Get(channel.second.c_str());
+            return 1;
         }
 
-        else
+        // the veto stage stores only the veto bit of each detector event, in
+        // a tree aligned entry-by-entry with the sorted tree
+        if(isDetector && useVetoPaddle)
         {
-            tree = (TTree*)nonVetoInputFile->Get(channel.second.c_str());
-        }
+            TTree* vetoTree = (TTree*)vetoedInputFile->Get(channel.second.c_str());
+            if(!vetoTree || vetoTree->GetEntries()!=tree->GetEntries())
+            {
+                cerr << "Error: failed to find veto bits for " << channel.second << " in " << vetoedInputFileName
+                    << " (or they don't match the events in " << nonVetoInputFileName << ")." << endl;
 
-        if(!tree)
-        {
-            cerr << "Error: tried to populate advanced histos, but failed to find " << channel.second << " in " << vetoedInputFileName << endl;
-            vetoedInputFile->Close();
-            macropulseFile->Close();
-            gammaCorrectionFile->Close();
+                vetoedInputFile->Close();
+                macropulseFile->Close();
+                gammaCorrectionFile->Close();
 
-            return 1;
+                return 1;
+            }
+
+            tree->AddFriend(vetoTree, "veto");
         }
 
         // connect input tree to event data buffer
@@ -233,7 +361,7 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
         tree->SetBranchAddress("lgQ",&event.lgQ);
         tree->SetBranchAddress("waveform",&waveformPointer);
 
-        if(isDetector)
+        if(isDetector && useVetoPaddle)
         {
             tree->SetBranchAddress("vetoed",&event.vetoed);
         }
@@ -241,72 +369,76 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
         TDirectory* directory = outputFile->mkdir(channel.second.c_str(),channel.second.c_str());
         directory->cd();
 
-        vector<TH1D*> goodMacroHistos;
+        // build a prototype set of (empty) histograms; each filling thread
+        // receives its own copy
+        GatedHistos prototype;
+
         for(string targetName : config.target.TARGET_ORDER)
         {
             string macroNumberName = targetName + "GoodMacros";
-            goodMacroHistos.push_back(new TH1D(macroNumberName.c_str(),
-                        macroNumberName.c_str(), 500000, 0, 500000));
+            prototype.goodMacroCounters.push_back(MacroCounter(macroNumberName));
         }
 
         // create other diagnostic histograms used to examine run data
-        TH1D* timeDiffHisto = new TH1D("time since last event","time since last event",
+        prototype.timeDiffHisto = FastHisto1D("time since last event","time since last event",
                 config.plot.TOF_RANGE,0,config.plot.TOF_RANGE);
-        TH2D* timeDiffVEnergy1 = new TH2D("time difference vs. energy of first",
+        prototype.timeDiffVEnergy1 = FastHisto2D("time difference vs. energy of first",
                 "time difference vs. energy of first",config.plot.TOF_RANGE,
                 0,config.plot.TOF_RANGE,10*config.plot.NUMBER_ENERGY_BINS,2,700);
 
-        TH2D* time1Vtime2 = new TH2D("time of first vs. time of second",
+        prototype.time1Vtime2 = FastHisto2D("time of first vs. time of second",
                 "time of first vs. time of second",config.plot.TOF_RANGE,0,
                 config.plot.TOF_RANGE,config.plot.TOF_RANGE,0,
                 config.plot.TOF_RANGE);
 
-        TH2D* energy1VEnergy2 = new TH2D("energy of first vs. energy of second",
+        prototype.energy1VEnergy2 = FastHisto2D("energy of first vs. energy of second",
                 "energy of first vs. energy of second",
                 10*config.plot.NUMBER_ENERGY_BINS, floor(config.plot.ENERGY_LOWER_BOUND), ceil(config.plot.ENERGY_UPPER_BOUND),
                 10*config.plot.NUMBER_ENERGY_BINS, floor(config.plot.ENERGY_LOWER_BOUND), ceil(config.plot.ENERGY_UPPER_BOUND));
 
-        TH1D* microNoH = new TH1D("microNoH","microNo",config.facility.MICROS_PER_MACRO+1
+        prototype.microNoH = FastHisto1D("microNoH","microNo",config.facility.MICROS_PER_MACRO+1
                 ,0,config.facility.MICROS_PER_MACRO+1);
 
-        vector<TH1D*> TOFHistos;
-        vector<TH2D*> triangleHistos;
-        vector<TH1D*> vetoTOFHistos;
-        vector<TH2D*> vetoTriangleHistos;
-
         for(string targetName : config.target.TARGET_ORDER)
         {
             string TOFName = targetName + "TOF";
-            TOFHistos.push_back(new TH1D(TOFName.c_str(),
-                        TOFName.c_str(),
+            prototype.TOFHistos.push_back(FastHisto1D(TOFName,
+                        TOFName,
                         config.plot.TOF_BINS,
                         config.plot.TOF_LOWER_BOUND,
                         config.plot.TOF_UPPER_BOUND));
 
             string triangleName = targetName + "Triangle";
-            triangleHistos.push_back(new TH2D(triangleName.c_str(),
-                        triangleName.c_str(),
+            prototype.triangleHistos.push_back(FastHisto2D(triangleName,
+                        triangleName,
                         config.plot.TOF_RANGE,
                         config.plot.TOF_LOWER_BOUND,
                         config.plot.TOF_UPPER_BOUND,
                         pow(2,9),0,pow(2,15)));
 
             string vetoTOFName = "veto" + TOFName;
-            vetoTOFHistos.push_back(new TH1D(vetoTOFName.c_str(),
-                        vetoTOFName.c_str(),
+            prototype.vetoTOFHistos.push_back(FastHisto1D(vetoTOFName,
+                        vetoTOFName,
                         config.plot.TOF_BINS,
                         config.plot.TOF_LOWER_BOUND,
                         config.plot.TOF_UPPER_BOUND));
 
             string vetoTriangleName = "veto" + triangleName;
-            vetoTriangleHistos.push_back(new TH2D(vetoTriangleName.c_str(),
-                        vetoTriangleName.c_str(),
+            prototype.vetoTriangleHistos.push_back(FastHisto2D(vetoTriangleName,
+                        vetoTriangleName,
                         config.plot.TOF_RANGE,
                         config.plot.TOF_LOWER_BOUND,
                         config.plot.TOF_UPPER_BOUND,
                         pow(2,9),0,pow(2,15)));
         }
 
+        // events that pass all gates, in tree order; histograms are filled
+        // from this list after gating is complete
+        vector<GatedEvent> gatedEvents;
+
+        bool writeEventColumns = eventColumnsFile && isDetector;
+        EventColumns eventColumns;
+
         double prevCompleteTime = 0;
         double prevlgQ = 0;
 
@@ -316,10 +448,11 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
 
         double timeDiff;
         double eventTimeDiff = 0;
-        double velocity;
         double rKE;
         double prevRKE = 0;
 
+        const KinematicsTable& kinematics = getKinematicsTable(config);
+
         double prevAverageTime = 0;
 
         const double MACRO_LENGTH = config.facility.MICROS_PER_MACRO*config.facility.MICRO_LENGTH;
@@ -385,6 +518,25 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
                 targetPositionMacroCounter[event.targetPos]++;
             }
 
+            /*****************************************************************/
+            // Calculate event properties
+
+            // find which micropulse the event is in and the time since the start of
+            // the micropulse (the TOF)
+            timeDiff = event.completeTime-event.macroTime;
+
+            // correct times using average gamma time
+            timeDiff -= gammaCorrectionList[event.macroNo];
+
+            microNo = floor(timeDiff/config.facility.MICRO_LENGTH);
+            microTime = fmod(timeDiff,config.facility.MICRO_LENGTH);
+
+            if(writeEventColumns && timeDiff <= MACRO_LENGTH)
+            {
+                eventColumns.push_back(microTime, microNo, event.macroNo,
+                        event.lgQ, event.targetPos, event.vetoed);
+            }
+
             // charge gates:
             if(isDetector)
             {
@@ -403,16 +555,6 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
                 }*/
             }
 
-            /*****************************************************************/
-            // Calculate event properties
-
-            // find which micropulse the event is in and the time since the start of
-            // the micropulse (the TOF)
-            timeDiff = event.completeTime-event.macroTime;
-
-            // correct times using average gamma time
-            timeDiff -= gammaCorrectionList[event.macroNo];
-
             // timing gate
             if(timeDiff > MACRO_LENGTH)
             {
@@ -421,8 +563,6 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
             }
 
             eventTimeDiff = event.completeTime-prevCompleteTime;
-            microNo = floor(timeDiff/config.facility.MICRO_LENGTH);
-            microTime = fmod(timeDiff,config.facility.MICRO_LENGTH);
 
             // micropulse gate:
             if(microNo < config.facility.FIRST_GOOD_MICRO
@@ -431,38 +571,36 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
                 continue;
             }
 
+            GatedEvent gatedEvent;
+            gatedEvent.targetPos = event.targetPos;
+            gatedEvent.macroNo = event.macroNo;
+            gatedEvent.lgQ = event.lgQ;
+            gatedEvent.microTime = microTime;
+
             // veto gate: apply to neutron events only
             if(event.vetoed && microTime > GAMMA_TIME+GAMMA_WINDOW_WIDTH*2)
             {
-                vetoTOFHistos[event.targetPos]->Fill(microTime);
-                vetoTriangleHistos[event.targetPos]->Fill(microTime, event.lgQ);
+                gatedEvent.vetoed = true;
+                gatedEvents.push_back(gatedEvent);
 
                 continue;
             }
 
-            // convert micropulse time into neutron velocity based on flight path distance
-            velocity = (pow(10.,7.)*config.facility.FLIGHT_DISTANCE)/microTime; // in meters/sec 
-
-            // convert velocity to relativistic kinetic energy
-            rKE = (pow((1.-pow((velocity/C),2.)),-0.5)-1.)*NEUTRON_MASS; // in MeV
-
-            TOFHistos[event.targetPos]->Fill(microTime);
-            triangleHistos[event.targetPos]->Fill(microTime, event.lgQ);
+            // convert micropulse time into relativistic kinetic energy
+            rKE = kinematics.tofToRKE(microTime); // in MeV
 
-            // fill detector histograms with event data
-            timeDiffHisto->Fill(eventTimeDiff);
-            timeDiffVEnergy1->Fill(eventTimeDiff,prevRKE);
-            time1Vtime2->Fill(prevMicroTime,microTime);
-            energy1VEnergy2->Fill(prevRKE,rKE);
-            microNoH->Fill(microNo);
+            gatedEvent.microNo = microNo;
+            gatedEvent.eventTimeDiff = eventTimeDiff;
+            gatedEvent.prevMicroTime = prevMicroTime;
+            gatedEvent.rKE = rKE;
+            gatedEvent.prevRKE = prevRKE;
+            gatedEvents.push_back(gatedEvent);
 
             prevlgQ = event.lgQ;
             prevMicroTime = microTime;
             prevCompleteTime = event.completeTime;
             prevRKE = rKE;
 
-            goodMacroHistos[event.targetPos]->Fill(event.macroNo+1);
-
             if(i%10000==0)
             {
                 cout << "Processed " << i << " " << channel.second << " events into advanced CS histos...\r";
@@ -486,35 +624,32 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
         logFile << "Fraction events outside macropulse: "
             << 100*(double)outsideMacro/totalEntries << "%." << endl;
 
-        for(auto& histo : TOFHistos)
-        {
-            histo->Write();
-        }
-
-        for(auto& histo : triangleHistos)
-        {
-            histo->Write();
-        }
+        // fill histograms in parallel, then reduce the per-thread copies
+        unsigned int numberOfThreads = getNumberOfThreads();
+        vector<GatedHistos> threadHistos(numberOfThreads, prototype);
 
-        for(auto& histo : vetoTOFHistos)
-        {
-            histo->Write();
-        }
-
-        for(auto& histo : vetoTriangleHistos)
+        fillInParallel(gatedEvents.size(), numberOfThreads,
+                [&](unsigned int thread, long begin, long end)
+                {
+                    for(long j=begin; j<end; j++)
+                    {
+                        threadHistos[thread].fill(gatedEvents[j]);
+                    }
+                });
+
+        GatedHistos& histos = threadHistos[0];
+        for(unsigned int t=1; t<numberOfThreads; t++)
         {
-            histo->Write();
+            histos.add(threadHistos[t]);
         }
 
-        timeDiffHisto->Write();
-        timeDiffVEnergy1->Write();
-        time1Vtime2->Write();
-        energy1VEnergy2->Write();
-        microNoH->Write();
+        directory->cd();
+        histos.write();
 
-        for(auto& histo : goodMacroHistos)
+        if(writeEventColumns)
         {
-            histo->Write();
+            eventColumnsFile->mkdir(channel.second.c_str(),channel.second.c_str())->cd();
+            eventColumns.write("events");
         }
     }
 
@@ -529,6 +664,11 @@ int fillCSHistos(string vetoedInputFileName, string nonVetoInputFileName, bool u
 
     outputFile->Close();
 
+    if(eventColumnsFile)
+    {
+        eventColumnsFile->Close();
+    }
+
     logFile << endl << "*** Finished filling CS histos ***" << endl;
 
     return 0;
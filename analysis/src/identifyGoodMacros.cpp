@@ -1,5 +1,6 @@
 #include "../include/identifyGoodMacros.h"
 #include "../include/config.h"
+#include "../include/macroCounter.h"
 
 #include "TFile.h"
 #include "TTree.h"
@@ -9,9 +10,7 @@
 
 using namespace std;
 
-extern Config config;
-
-int identifyGoodMacros(string macropulseFileName, vector<MacropulseEvent>& macropulseList, ofstream& logFile)
+int identifyGoodMacros(string macropulseFileName, vector<MacropulseEvent>& macropulseList, ofstream& logFile, const Config& config)
 {
     if(macropulseList.size()==0)
     {
@@ -77,17 +76,19 @@ int identifyGoodMacros(string macropulseFileName, vector<MacropulseEvent>& macro
     TFile* outputFile = new TFile(macropulseFileName.c_str(),"CREATE");
 
     TH1D* cycleNumber = new TH1D("cycleNumber","cycleNumber", 1000, 0, 1000);
-    TH1D* macroNumber = new TH1D("macroNo","macroNo", 500000, 0, 500000);
-    TH1D* macroTime = new TH1D("macroTime","macroTime", 5000000, 0, 5000000000);
+    MacroCounter macroNumber("macroNo");
+
+    // (full-precision macropulse times are kept in the macropulses tree)
+    TH1D* macroTime = new TH1D("macroTime","macroTime", 5000, 0, 5000000000);
 
-    vector<TH1D*> macroNumberByTargets;
+    vector<MacroCounter> macroNumberByTargets;
     vector<TH1D*> eventsPerMacroByTargets;
     vector<TH1D*> monitorsPerMacroByTargets;
 
     for(auto& targetName : config.target.TARGET_ORDER)
     {
         string macroNumberByTargetsName = targetName + "macroNo";
-        macroNumberByTargets.push_back(new TH1D(macroNumberByTargetsName.c_str(), macroNumberByTargetsName.c_str(), 500000, 0, 500000));
+        macroNumberByTargets.push_back(MacroCounter(macroNumberByTargetsName));
 
         string eventsPerMacroName = targetName + "eventsPerMacro";
         eventsPerMacroByTargets.push_back(new TH1D(eventsPerMacroName.c_str(), eventsPerMacroName.c_str(), 300, 0, 300));
@@ -99,10 +100,10 @@ int identifyGoodMacros(string macropulseFileName, vector<MacropulseEvent>& macro
     for(auto& macropulse : macropulseList)
     {
         cycleNumber->Fill(macropulse.cycleNumber);
-        macroNumber->Fill(macropulse.macroNo);
+        macroNumber.fill(macropulse.macroNo);
         macroTime->Fill(macropulse.macroTime);
 
-        macroNumberByTargets[macropulse.targetPos]->Fill(macropulse.macroNo);
+        macroNumberByTargets[macropulse.targetPos].fill(macropulse.macroNo);
         eventsPerMacroByTargets[macropulse.targetPos]->Fill(macropulse.numberOfEventsInMacro);
         monitorsPerMacroByTargets[macropulse.targetPos]->Fill(macropulse.numberOfMonitorsInMacro);
     }
@@ -135,12 +136,12 @@ int identifyGoodMacros(string macropulseFileName, vector<MacropulseEvent>& macro
     macropulseTree->Write();
 
     cycleNumber->Write();
-    macroNumber->Write();
+    macroNumber.write();
     macroTime->Write();
 
     for(int i=0; i<macroNumberByTargets.size(); i++)
     {
-        macroNumberByTargets[i]->Write();
+        macroNumberByTargets[i].write();
         eventsPerMacroByTargets[i]->Write();
         monitorsPerMacroByTargets[i]->Write();
     }
@@ -32,12 +32,10 @@
 
 #include "../include/config.h"
 
-extern Config config;
-
 using namespace std;
 
 // Use the lgQ from the target changer to determine the target position
-int assignTargetPos(int lgQ)
+int assignTargetPos(int lgQ, const Config& config)
 {
     for(int i=0; (size_t)i<config.target.TARGET_GATES.size(); i++)
     {
@@ -55,7 +53,8 @@ int identifyMacropulses(
         string inputFileName,
         string outputFileName,
         ofstream& logFile,
-        vector<MacropulseEvent>& macropulseList)
+        vector<MacropulseEvent>& macropulseList,
+        const Config& config)
 {
     // check to see if output file already exists; if so, exit
     ifstream f(outputFileName);
@@ -89,9 +88,9 @@ int identifyMacropulses(
     bool useMacroTime = false;
 
     // test to see if macrotime channel is in use
-    for(auto& channel : config.digitizer.CHANNEL_MAP)
+    for(ChannelRole role : config.channels.ROLES)
     {
-        if(channel.second=="macroTime")
+        if(role==ChannelRole::MACRO_TIME)
         {
             useMacroTime = true;
             break;
@@ -137,14 +136,14 @@ int identifyMacropulses(
         {
             inputTree->GetEntry(currentTreeEntry);
 
-            if(config.digitizer.CHANNEL_MAP[chNo].second=="targetChanger")
+            if(config.channels.ROLES[chNo]==ChannelRole::TARGET_CHANGER)
             {
                 targetChangerEvent.cycleNumber = cycleNumber;
                 targetChangerEvent.completeTime = completeTime;
                 targetChangerList.push_back(TargetChangerEvent(targetChangerEvent));
             }
 
-            else if(config.digitizer.CHANNEL_MAP[chNo].second=="macroTime")
+            else if(config.channels.ROLES[chNo]==ChannelRole::MACRO_TIME)
             {
                 macrotimeEvent.cycleNumber = cycleNumber;
                 macrotimeEvent.completeTime = completeTime;
@@ -279,7 +278,7 @@ int identifyMacropulses(
             {
                 // found a match between the target changer and the macrotime lists
                 macropulseEvent.lgQ = targetChangerList[currentTargetChangerEntry].lgQ;
-                macropulseEvent.targetPos = assignTargetPos(macropulseEvent.lgQ);
+                macropulseEvent.targetPos = assignTargetPos(macropulseEvent.lgQ, config);
 
                 if(macropulseEvent.targetPos < 0)
                 {
@@ -362,7 +361,7 @@ int identifyMacropulses(
         {
             inputTree->GetEntry(currentTreeEntry);
 
-            if(config.digitizer.CHANNEL_MAP[chNo].second=="targetChanger")
+            if(config.channels.ROLES[chNo]==ChannelRole::TARGET_CHANGER)
             {
                 targetChangerEvent.cycleNumber = cycleNumber;
                 targetChangerEvent.completeTime = completeTime;
@@ -416,7 +415,7 @@ int identifyMacropulses(
         for(auto& tc : targetChangerList)
         {
             macropulseEvent.lgQ = tc.lgQ;
-            macropulseEvent.targetPos = assignTargetPos(tc.lgQ);
+            macropulseEvent.targetPos = assignTargetPos(tc.lgQ, config);
 
             if(macropulseEvent.targetPos < 0)
             {
@@ -0,0 +1,91 @@
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "../include/kinematics.h"
+#include "../include/physicalConstants.h"
+#include "../include/config.h"
+
+using namespace std;
+
+double exactTOFToRKE(double TOF, double flightDistance)
+{
+    // convert time into neutron velocity based on flight path distance
+    double velocity = pow(10.,7.)*flightDistance/TOF; // in meters/sec
+
+    // convert velocity to relativistic kinetic energy
+    return (pow((1.-pow((velocity/C),2.)),-0.5)-1.)*NEUTRON_MASS; // in MeV
+}
+
+double exactRKEToTOF(double RKE, double flightDistance)
+{
+    // convert relativistic kinetic energy to velocity
+    double velocity = pow(1-pow((1/((RKE/NEUTRON_MASS)+1)),2),0.5)*C;
+
+    return pow(10.,7.)*flightDistance/velocity; // in ns
+}
+
+KinematicsTable::KinematicsTable(double fd, double TOFLowerBound,
+        double TOFUpperBound, int TOFBinsPerNs)
+    : flightDistance(fd), lowerBound(TOFLowerBound), upperBound(TOFUpperBound),
+    binsPerNs(TOFBinsPerNs)
+{
+    nodesPerNs = NODES_PER_TOF_BIN*binsPerNs;
+    lastNode = (long)round((upperBound-lowerBound)*nodesPerNs);
+
+    rKE.resize(lastNode+1);
+
+    for(long i=0; i<=lastNode; i++)
+    {
+        rKE[i] = exactTOFToRKE(lowerBound+i/nodesPerNs, flightDistance);
+    }
+
+    // nodes at or below the flight time of light don't hold a usable energy
+    // (NaN, or a meaningless finite value at 0 ns); times before the first
+    // node of the finite run reaching the upper bound use the exact formula
+    firstNode = lastNode;
+    while(firstNode>0 && std::isfinite(rKE[firstNode-1]))
+    {
+        firstNode--;
+    }
+}
+
+void KinematicsTable::tofToRKE(const double* TOF, double* RKE, long n) const
+{
+    for(long i=0; i<n; i++)
+    {
+        RKE[i] = tofToRKE(TOF[i]);
+    }
+}
+
+double KinematicsTable::rKEToTOF(double RKE) const
+{
+    return exactRKEToTOF(RKE, flightDistance);
+}
+
+const KinematicsTable& getKinematicsTable(const Config& config)
+{
+    typedef tuple<double, double, double, int> TableKey;
+
+    static map<TableKey, KinematicsTable> tables;
+    static mutex tablesMutex;
+
+    TableKey key(config.facility.FLIGHT_DISTANCE,
+            config.plot.TOF_LOWER_BOUND,
+            config.plot.TOF_UPPER_BOUND,
+            config.plot.TOF_BINS_PER_NS);
+
+    lock_guard<mutex> lock(tablesMutex);
+
+    auto it = tables.find(key);
+    if(it!=tables.end())
+    {
+        return it->second;
+    }
+
+    return tables[key] = KinematicsTable(
+            config.facility.FLIGHT_DISTANCE,
+            config.plot.TOF_LOWER_BOUND,
+            config.plot.TOF_UPPER_BOUND,
+            config.plot.TOF_BINS_PER_NS);
+}
@@ -0,0 +1,240 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#include "../include/literatureCache.h"
+#include "../include/dataSet.h"
+
+using namespace std;
+
+const char LITERATURE_CACHE_MAGIC[8] = {'L','I','T','C','A','C','H','1'};
+
+// sanity limits used to detect a damaged entry
+const int MAX_REFERENCE_LENGTH = 100000;
+const int MAX_LITERATURE_POINTS = 100000000;
+
+// 64-bit FNV-1a hash
+static unsigned long hashBytes(const char* bytes, size_t length)
+{
+    unsigned long hash = 14695981039346656037UL;
+    for(size_t i=0; i<length; i++)
+    {
+        hash ^= (unsigned char)bytes[i];
+        hash *= 1099511628211UL;
+    }
+
+    return hash;
+}
+
+static unsigned long hashBinning(const vector<double>& energyBins)
+{
+    return hashBytes((const char*)energyBins.data(), energyBins.size()*sizeof(double));
+}
+
+LiteratureCache::LiteratureCache(string fn) : fileName(fn)
+{
+    ifstream file(fileName, ios::binary);
+    if(!file.good())
+    {
+        return;
+    }
+
+    char magic[8];
+    file.read(magic, sizeof(magic));
+
+    if(!file.good() || memcmp(magic, LITERATURE_CACHE_MAGIC, sizeof(magic)))
+    {
+        cerr << "Error: " << fileName << " is not a literature cache; ignoring it." << endl;
+        changed = true;
+        return;
+    }
+
+    int numberOfEntries;
+    file.read((char*)&numberOfEntries, sizeof(numberOfEntries));
+
+    vector<Entry> entries;
+
+    for(int i=0; i<numberOfEntries && file.good(); i++)
+    {
+        Entry entry;
+        int referenceLength;
+        int numberOfPoints;
+
+        file.read((char*)&entry.contentHash, sizeof(entry.contentHash));
+        file.read((char*)&entry.contentLength, sizeof(entry.contentLength));
+        file.read((char*)&entry.binningHash, sizeof(entry.binningHash));
+        file.read((char*)&entry.numberOfBinEdges, sizeof(entry.numberOfBinEdges));
+
+        file.read((char*)&referenceLength, sizeof(referenceLength));
+        if(!file.good() || referenceLength<0 || referenceLength>MAX_REFERENCE_LENGTH)
+        {
+            file.setstate(ios::failbit);
+            break;
+        }
+
+        entry.reference.assign(referenceLength, ' ');
+        file.read(&entry.reference[0], referenceLength);
+
+        file.read((char*)&numberOfPoints, sizeof(numberOfPoints));
+        if(!file.good() || numberOfPoints<0 || numberOfPoints>MAX_LITERATURE_POINTS)
+        {
+            file.setstate(ios::failbit);
+            break;
+        }
+
+        entry.energies.resize(numberOfPoints);
+        entry.crossSections.resize(numberOfPoints);
+        entry.errors.resize(numberOfPoints);
+
+        file.read((char*)entry.energies.data(), numberOfPoints*sizeof(double));
+        file.read((char*)entry.crossSections.data(), numberOfPoints*sizeof(double));
+        file.read((char*)entry.errors.data(), numberOfPoints*sizeof(double));
+
+        entries.push_back(entry);
+    }
+
+    if(!file.good())
+    {
+        cerr << "Error: failed to read literature cache " << fileName << "; ignoring it." << endl;
+        changed = true;
+        return;
+    }
+
+    storedEntries = entries;
+}
+
+int LiteratureCache::find(const string& contents, const vector<double>& energyBins, DataSet& dataSet)
+{
+    unsigned long contentHash = hashBytes(contents.data(), contents.size());
+    unsigned long binningHash = hashBinning(energyBins);
+
+    for(const vector<Entry>* entries : {&usedEntries, &storedEntries})
+    {
+        for(const Entry& entry : *entries)
+        {
+            if(entry.contentHash!=contentHash
+                    || entry.contentLength!=(long)contents.size()
+                    || entry.binningHash!=binningHash
+                    || entry.numberOfBinEdges!=(int)energyBins.size())
+            {
+                continue;
+            }
+
+            dataSet = DataSet(entry.energies, entry.crossSections, entry.errors, entry.reference);
+
+            if(entries==&storedEntries)
+            {
+                usedEntries.push_back(entry);
+            }
+
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void LiteratureCache::add(const string& contents, const vector<double>& energyBins, const DataSet& dataSet)
+{
+    Entry entry;
+    entry.contentHash = hashBytes(contents.data(), contents.size());
+    entry.contentLength = contents.size();
+    entry.binningHash = hashBinning(energyBins);
+    entry.numberOfBinEdges = energyBins.size();
+
+    entry.reference = dataSet.getReference();
+    entry.energies = dataSet.getXValues();
+    entry.crossSections = dataSet.getYValues();
+    entry.errors = dataSet.getYErrors();
+
+    usedEntries.push_back(entry);
+    changed = true;
+}
+
+int LiteratureCache::save() const
+{
+    // nothing new, and nothing to drop
+    if(!changed && usedEntries.size()==storedEntries.size())
+    {
+        return 0;
+    }
+
+    // write to a temporary file first, so that an interrupted write leaves
+    // the previous cache intact
+    string temporaryFileName = fileName + ".tmp";
+
+    ofstream file(temporaryFileName, ios::binary | ios::trunc);
+    if(!file.good())
+    {
+        cerr << "Error: failed to open " << temporaryFileName << " for writing." << endl;
+        return 1;
+    }
+
+    file.write(LITERATURE_CACHE_MAGIC, sizeof(LITERATURE_CACHE_MAGIC));
+
+    int numberOfEntries = usedEntries.size();
+    file.write((char*)&numberOfEntries, sizeof(numberOfEntries));
+
+    for(const Entry& entry : usedEntries)
+    {
+        int referenceLength = entry.reference.size();
+        int numberOfPoints = entry.energies.size();
+
+        file.write((char*)&entry.contentHash, sizeof(entry.contentHash));
+        file.write((char*)&entry.contentLength, sizeof(entry.contentLength));
+        file.write((char*)&entry.binningHash, sizeof(entry.binningHash));
+        file.write((char*)&entry.numberOfBinEdges, sizeof(entry.numberOfBinEdges));
+
+        file.write((char*)&referenceLength, sizeof(referenceLength));
+        file.write(entry.reference.c_str(), referenceLength);
+
+        file.write((char*)&numberOfPoints, sizeof(numberOfPoints));
+        file.write((char*)entry.energies.data(), numberOfPoints*sizeof(double));
+        file.write((char*)entry.crossSections.data(), numberOfPoints*sizeof(double));
+        file.write((char*)entry.errors.data(), numberOfPoints*sizeof(double));
+    }
+
+    file.close();
+
+    if(!file.good() || rename(temporaryFileName.c_str(), fileName.c_str()))
+    {
+        cerr << "Error: failed to write literature cache " << fileName << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int readLitDataSet(string litFileName, const vector<double>& energyBins,
+        LiteratureCache& cache, DataSet& dataSet)
+{
+    string contents;
+    if(readFileContents(litFileName, contents))
+    {
+        cerr << "Error: failed to read literature data from " << litFileName << endl;
+        return 1;
+    }
+
+    if(cache.find(contents, energyBins, dataSet))
+    {
+        string reference;
+        vector<double> energies;
+        vector<double> crossSections;
+        vector<double> errors;
+        parseLitData(contents, reference, energies, crossSections, errors);
+
+        vector<double> binEnergies;
+        vector<double> binCrossSections;
+        vector<double> binErrors;
+        binLitData(energies, crossSections, errors, energyBins,
+                binEnergies, binCrossSections, binErrors);
+
+        dataSet = DataSet(binEnergies, binCrossSections, binErrors, reference);
+        cache.add(contents, energyBins, dataSet);
+    }
+
+    dataSet.createPlot(dataSet.getReference());
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include <iostream>
+#include <algorithm>
+
+#include "TTree.h"
+#include "TH1.h"
+
+#include "../include/macroCounter.h"
+
+using namespace std;
+
+MacroCounter::MacroCounter(string n) : name(n)
+{
+}
+
+void MacroCounter::insert(int macroNo, long n)
+{
+    auto it = lower_bound(entries.begin(), entries.end(), make_pair(macroNo, 0L),
+            [](const pair<int,long>& a, const pair<int,long>& b)
+            {
+                return a.first < b.first;
+            });
+
+    if(it!=entries.end() && it->first==macroNo)
+    {
+        it->second += n;
+        return;
+    }
+
+    entries.insert(it, make_pair(macroNo, n));
+}
+
+void MacroCounter::add(const MacroCounter& c)
+{
+    // merge two sorted lists
+    vector<pair<int,long>> merged;
+    merged.reserve(entries.size()+c.entries.size());
+
+    auto a = entries.begin();
+    auto b = c.entries.begin();
+
+    while(a!=entries.end() || b!=c.entries.end())
+    {
+        if(b==c.entries.end() || (a!=entries.end() && a->first < b->first))
+        {
+            merged.push_back(*a);
+            a++;
+        }
+
+        else if(a==entries.end() || b->first < a->first)
+        {
+            merged.push_back(*b);
+            b++;
+        }
+
+        else
+        {
+            merged.push_back(make_pair(a->first, a->second+b->second));
+            a++;
+            b++;
+        }
+    }
+
+    entries.swap(merged);
+}
+
+string MacroCounter::getName() const
+{
+    return name;
+}
+
+long MacroCounter::getCounts(int macroNo) const
+{
+    auto it = lower_bound(entries.begin(), entries.end(), make_pair(macroNo, 0L),
+            [](const pair<int,long>& a, const pair<int,long>& b)
+            {
+                return a.first < b.first;
+            });
+
+    if(it!=entries.end() && it->first==macroNo)
+    {
+        return it->second;
+    }
+
+    return 0;
+}
+
+long MacroCounter::getNumberOfMacros(long minimumCounts) const
+{
+    long numberOfMacros = 0;
+
+    for(auto& entry : entries)
+    {
+        if(entry.second>=minimumCounts)
+        {
+            numberOfMacros++;
+        }
+    }
+
+    return numberOfMacros;
+}
+
+long MacroCounter::getTotalCounts(long minimumCounts) const
+{
+    long totalCounts = 0;
+
+    for(auto& entry : entries)
+    {
+        if(entry.second>=minimumCounts)
+        {
+            totalCounts += entry.second;
+        }
+    }
+
+    return totalCounts;
+}
+
+const vector<pair<int,long>>& MacroCounter::getEntries() const
+{
+    return entries;
+}
+
+int MacroCounter::write() const
+{
+    TTree* tree = new TTree(name.c_str(), name.c_str());
+
+    Int_t macroNo;
+    Long64_t counts;
+
+    tree->Branch("macroNo", &macroNo, "macroNo/I");
+    tree->Branch("counts", &counts, "counts/L");
+
+    for(auto& entry : entries)
+    {
+        macroNo = entry.first;
+        counts = entry.second;
+        tree->Fill();
+    }
+
+    tree->Write();
+
+    return 0;
+}
+
+int MacroCounter::read(TDirectory* directory, string n)
+{
+    name = n;
+    entries.clear();
+
+    TObject* object = directory->Get(name.c_str());
+    if(!object)
+    {
+        cerr << "Error: failed to find macro counter " << name << " in "
+            << directory->GetName() << "." << endl;
+        return 1;
+    }
+
+    // older analysis output: one histogram bin per macropulse
+    if(object->InheritsFrom("TH1"))
+    {
+        TH1* histo = (TH1*)object;
+
+        int numberOfBins = histo->GetNbinsX();
+        for(int i=1; i<=numberOfBins; i++)
+        {
+            double binContent = histo->GetBinContent(i);
+            if(binContent>0)
+            {
+                entries.push_back(make_pair((int)histo->GetBinLowEdge(i), (long)(binContent+0.5)));
+            }
+        }
+
+        return 0;
+    }
+
+    TTree* tree = (TTree*)object;
+
+    Int_t macroNo;
+    Long64_t counts;
+
+    tree->SetBranchAddress("macroNo", &macroNo);
+    tree->SetBranchAddress("counts", &counts);
+
+    long numberOfEntries = tree->GetEntries();
+    entries.reserve(numberOfEntries);
+
+    for(long i=0; i<numberOfEntries; i++)
+    {
+        tree->GetEntry(i);
+        fill(macroNo, counts);
+    }
+
+    return 0;
+}
+
+TH1D* MacroCounter::toTH1D(int nBins, double low, double high) const
+{
+    TH1D* histo = new TH1D(name.c_str(), name.c_str(), nBins, low, high);
+
+    for(auto& entry : entries)
+    {
+        histo->Fill(entry.first, entry.second);
+    }
+
+    return histo;
+}
@@ -19,8 +19,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     string firstCSFileName = argv[1];
@@ -18,8 +18,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     multiplyCS(argv[1], argv[2], stod(argv[3]), argv[4]);
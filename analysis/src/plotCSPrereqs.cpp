@@ -21,8 +21,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     string dataLocation = argv[1];
@@ -42,14 +40,14 @@ int main(int, char* argv[])
     vector<vector<double>> runningGoodMacroCounts;
  
     // read in run config file
-    config = Config(expName, runNumber);
+    const Config config(expName, runNumber);
 
-    readTargetData(allCSPrereqs, expName);
+    readTargetData(allCSPrereqs, expName, config);
 
     // Loop through all subruns of this run
     for(int subRun=lowSubrun; subRun<=highSubrun; subRun++)
     {
-        readSubRun(allCSPrereqs, expName, runNumber, subRun, detectorName, dataLocation);
+        readSubRun(allCSPrereqs, expName, runNumber, subRun, detectorName, dataLocation, config);
         vector<double> currentMonitorCounts;
         vector<double> currentGoodMacroCounts;
 
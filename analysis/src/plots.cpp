@@ -8,41 +8,32 @@
 #include "../include/CSUtilities.h"
 #include "../include/crossSection.h"
 #include "../include/experiment.h"
+#include "../include/kinematics.h"
+#include "../include/energyRebinner.h"
 
 #include <iostream>
 
 using namespace std;
 
-TH1D* convertTOFtoEnergy(TH1D* tof, string name)
+TH1D* convertTOFtoEnergy(TH1D* tof, string name, const Config& config)
 {
-    TH1D* energy = timeBinsToRKEBins(tof, name); 
-
     if(!tof)
     {
         cerr << "Error: cannot convert empty TOF histogram to energy units in convertTOFtoEnergy()" << endl;
-        return energy;
+        return 0;
     }
 
-    int tofBins = tof->GetNbinsX();
-
-    for(int j=1; j<=tofBins; j++)
-    {
-        // convert time into neutron velocity based on flight path distance
-        double velocity = pow(10.,7.)*(config.facility.FLIGHT_DISTANCE)
-            /tof->GetBinCenter(j); // in meters/sec 
-
-        // convert velocity to relativistic kinetic energy
-        double rKE = (pow((1.-pow((velocity/C),2.)),-0.5)-1.)*NEUTRON_MASS; // in MeV
+    return getEnergyRebinner(tof, config).rebin(tof, name);
+}
 
-        energy->Fill(rKE,tof->GetBinContent(j));
-    }
+WeightedHisto1D convertTOFtoEnergy(const WeightedHisto1D& tof, const Config& config)
+{
+    const EnergyRebinner& rebinner = getEnergyRebinner(tof.getNBins(),
+            tof.getLowEdge(), tof.getHighEdge(), config);
 
-    // calculate energy error
-    int energyBins = energy->GetNbinsX();
-    for(int j=1; j<=energyBins; j++)
-    {
-        energy->SetBinError(j,pow(energy->GetBinContent(j),0.5));
-    }
+    WeightedHisto1D energy(rebinner.getEnergyBinEdges());
+    energy.getContents() = rebinner.rebin(tof.getContents());
+    energy.setEntries(tof.getEntries());
 
     return energy;
 }
@@ -65,7 +56,7 @@ vector<double> scaleBins(vector<double> inputBins, double scaledown)
     return outputBins;
 }
 
-double tofToRKE(double TOF)
+double tofToRKE(double TOF, const Config& config)
 {
     double velocity = pow(10.,7.)*config.facility.FLIGHT_DISTANCE/TOF; // in meters/sec 
 
@@ -74,9 +65,8 @@ double tofToRKE(double TOF)
         return -1;
     }
 
-    // convert velocity to relativistic kinetic energy
-    double RKE = (pow((1.-pow((velocity/C),2.)),-0.5)-1.)*NEUTRON_MASS; // in MeV
-    if(RKE<0)
+    double RKE = getKinematicsTable(config).tofToRKE(TOF); // in MeV
+    if(!(RKE>=0))
     {
         return -1;
     }
@@ -84,34 +74,31 @@ double tofToRKE(double TOF)
     return RKE;
 }
 
-double RKEToTOF(double RKE)
+double RKEToTOF(double RKE, const Config& config)
 {
-    // convert relativistic kinetic energy to velocity
-    double velocity = pow(1-pow((1/((RKE/NEUTRON_MASS)+1)),2),0.5)*C;
+    double TOF = getKinematicsTable(config).rKEToTOF(RKE); // in ns
 
-    if(velocity<0 || velocity>C)
+    if(!(TOF>0))
     {
         return -1;
     }
 
-    double TOF = pow(10.,7.)*config.facility.FLIGHT_DISTANCE/velocity; // in meters/sec 
-
     return TOF; // in ns
 }
 
-double calculateEnergyErrorL(double energy, double tofSigma)
+double calculateEnergyErrorL(double energy, double tofSigma, const Config& config)
 {
-    double tof = RKEToTOF(energy);
-    return tofToRKE(tof)-tofToRKE(tof+tofSigma);
+    double tof = RKEToTOF(energy, config);
+    return tofToRKE(tof, config)-tofToRKE(tof+tofSigma, config);
 }
 
-double calculateEnergyErrorR(double energy, double tofSigma)
+double calculateEnergyErrorR(double energy, double tofSigma, const Config& config)
 {
-    double tof = RKEToTOF(energy);
-    return tofToRKE(tof-tofSigma)-tofToRKE(tof);
+    double tof = RKEToTOF(energy, config);
+    return tofToRKE(tof-tofSigma, config)-tofToRKE(tof, config);
 }
 
-TH1D* timeBinsToRKEBins(TH1D* inputHisto, string name)
+TH1D* timeBinsToRKEBins(TH1D* inputHisto, string name, const Config& config)
 {
     if(!inputHisto)
     {
@@ -129,14 +116,14 @@ TH1D* timeBinsToRKEBins(TH1D* inputHisto, string name)
         minimumTime = inputHisto->GetBinLowEdge(i);
         minimumTimeBinEdgeNumber = i;
 
-        double rke =  tofToRKE(minimumTime);
+        double rke =  tofToRKE(minimumTime, config);
         if(rke>0 && rke<config.plot.ENERGY_UPPER_BOUND)
         {
             break;
         }
     }
 
-    if(tofToRKE(minimumTime)==-1)
+    if(tofToRKE(minimumTime, config)==-1)
     {
         cerr << "Error: energy of old min time " << minimumTime << " was not finite." << endl;
         exit(1);
@@ -150,13 +137,13 @@ TH1D* timeBinsToRKEBins(TH1D* inputHisto, string name)
         maximumTime = inputHisto->GetBinLowEdge(i) + inputHisto->GetBinWidth(i);
         maximumTimeBinEdgeNumber = i;
 
-        if(tofToRKE(maximumTime)>config.plot.ENERGY_LOWER_BOUND)
+        if(tofToRKE(maximumTime, config)>config.plot.ENERGY_LOWER_BOUND)
         {
             break;
         }
     }
 
-    if(tofToRKE(maximumTime)==-1)
+    if(tofToRKE(maximumTime, config)==-1)
     {
         cerr << "Error: energy of old maximum time " << maximumTime << " was not finite." << endl;
         exit(1);
@@ -170,7 +157,7 @@ TH1D* timeBinsToRKEBins(TH1D* inputHisto, string name)
     // n points are defined for n+1 bin edges (like fence sections and fence posts)
     for(int i=0; i<numberEnergyBins-1; i++)
     {
-        double newBinEdge = tofToRKE(oldAxis->GetBinLowEdge(maximumTimeBinEdgeNumber-i)+oldAxis->GetBinWidth(maximumTimeBinEdgeNumber-i));
+        double newBinEdge = tofToRKE(oldAxis->GetBinLowEdge(maximumTimeBinEdgeNumber-i)+oldAxis->GetBinWidth(maximumTimeBinEdgeNumber-i), config);
 
         if(newBinEdge<=0)
         {
@@ -181,7 +168,7 @@ TH1D* timeBinsToRKEBins(TH1D* inputHisto, string name)
         unscaledEnergyBinEdges.push_back(newBinEdge);
     }
 
-    unscaledEnergyBinEdges.push_back(tofToRKE(oldAxis->GetBinLowEdge(minimumTimeBinEdgeNumber)));
+    unscaledEnergyBinEdges.push_back(tofToRKE(oldAxis->GetBinLowEdge(minimumTimeBinEdgeNumber), config));
 
     // Downscale bins to desired granularity
     double scaledown = ((double)unscaledEnergyBinEdges.size())/config.plot.NUMBER_ENERGY_BINS;
@@ -196,7 +183,7 @@ TH1D* timeBinsToRKEBins(TH1D* inputHisto, string name)
     return outputHisto;
 }
 
-TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name)
+TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name, const Config& config)
 {
     // extract the total number of bins in the input Histo (minus the
     // overflow and underflow bins)
@@ -207,7 +194,7 @@ TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name)
 
     for(int i=0; i<nOldBins; i++)
     {
-        if(RKEToTOF(minimumEnergy)>0 && RKEToTOF(minimumEnergy)<config.plot.TOF_UPPER_BOUND)
+        if(RKEToTOF(minimumEnergy, config)>0 && RKEToTOF(minimumEnergy, config)<config.plot.TOF_UPPER_BOUND)
         {
             break;
         }
@@ -216,7 +203,7 @@ TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name)
         minimumBin = i;
     }
 
-    double tentativeTime = RKEToTOF(minimumEnergy);
+    double tentativeTime = RKEToTOF(minimumEnergy, config);
     if(tentativeTime==-1)
     {
         cerr << "Error: time of old min energy " << minimumEnergy << " was not finite: " << tentativeTime << " (ns)" << endl;
@@ -230,7 +217,7 @@ TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name)
 
     for(int i=nOldBins; i>0; i--)
     {
-        if(RKEToTOF(maximumEnergy)>config.plot.TOF_LOWER_BOUND)
+        if(RKEToTOF(maximumEnergy, config)>config.plot.TOF_LOWER_BOUND)
         {
             break;
         }
@@ -238,7 +225,7 @@ TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name)
         maximumBin = i;
     }
 
-    tentativeTime = RKEToTOF(maximumEnergy);
+    tentativeTime = RKEToTOF(maximumEnergy, config);
     if(tentativeTime==-1)
     {
         cerr << "Error: time of old maximum energy " << maximumEnergy << " was not finite: " << tentativeTime << " (ns)" << endl;
@@ -257,7 +244,7 @@ TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name)
     // n bins are defined n+1 points (like fence sections and fence posts)
     for(int i=0; i<nUnscaledTimeBins+1; i++)
     {
-        double newBin = RKEToTOF(oldAxis->GetBinLowEdge(maximumBin-i));
+        double newBin = RKEToTOF(oldAxis->GetBinLowEdge(maximumBin-i), config);
         if(newBin<=0)
         {
             continue;
@@ -287,7 +274,7 @@ TH1D* RKEBinsToTimeBins(TH1D *inputHisto, string name)
 }
 
 // create new plots
-Plots::Plots(string name)
+Plots::Plots(string name, const Config& config)
 {
     string tofName = name + "TOF";
     string rawTOFName = name + "rawTOF";
@@ -298,7 +285,7 @@ Plots::Plots(string name)
     rawTOFHisto = new TH1D(rawTOFName.c_str(),rawTOFName.c_str(),config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
     deadtimeHisto = new TH1D(deadtimeName.c_str(),deadtimeName.c_str(),config.plot.TOF_BINS,config.plot.TOF_LOWER_BOUND,config.plot.TOF_UPPER_BOUND);
 
-    energyHisto = timeBinsToRKEBins(TOFHisto,energyName);
+    energyHisto = timeBinsToRKEBins(TOFHisto,energyName,config);
 }
 
 TH1D* Plots::getTOFHisto()
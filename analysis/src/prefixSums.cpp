@@ -0,0 +1,566 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include "../include/prefixSums.h"
+#include "../include/CSPrereqs.h"
+#include "../include/config.h"
+#include "../include/configRegistry.h"
+
+using namespace std;
+
+const char PREFIX_SUMS_MAGIC[8] = {'S','R','P','F','X','0','0','1'};
+
+// source time stored for blacklisted subruns, which add nothing to the sums
+const long BLACKLISTED_SOURCE_TIME = -2;
+
+// sanity limit used to detect a damaged key header
+const int MAX_TARGETS_PER_KEY = 1000;
+
+PrefixSums::PrefixSums(string name) : fileName(name)
+{
+    ifstream file(fileName, ios::binary);
+    if(!file.good())
+    {
+        // no sums yet; the file is created on the first append()
+        return;
+    }
+
+    file.seekg(0, ios::end);
+    long length = file.tellg();
+    file.seekg(0, ios::beg);
+
+    char magic[8];
+    file.read(magic, sizeof(magic));
+
+    if(!file.good() || memcmp(magic, PREFIX_SUMS_MAGIC, sizeof(magic)))
+    {
+        // fileLength stays 0, so the file is overwritten on the first append()
+        cerr << "Error: " << fileName << " is not a prefix sums file; re-summing it." << endl;
+        return;
+    }
+
+    long validLength = sizeof(PREFIX_SUMS_MAGIC);
+
+    // each key is a header (run, subrun, source time, number of targets)
+    // followed by one summary record per target; a key is only indexed once
+    // all of its records are complete
+    while(validLength<length)
+    {
+        file.seekg(validLength);
+
+        Key key;
+        long sourceTime;
+        int numberOfTargets;
+
+        file.read((char*)&key.first, sizeof(key.first));
+        file.read((char*)&key.second, sizeof(key.second));
+        file.read((char*)&sourceTime, sizeof(sourceTime));
+        file.read((char*)&numberOfTargets, sizeof(numberOfTargets));
+
+        if(!file.good() || numberOfTargets<0 || numberOfTargets>MAX_TARGETS_PER_KEY)
+        {
+            break;
+        }
+
+        map<string, long> targetOffsets;
+        long keyEnd = file.tellg();
+
+        for(int i=0; i<numberOfTargets; i++)
+        {
+            file.seekg(keyEnd);
+
+            SubRunSummary header;
+            readSubRunSummaryHeader(file, header);
+
+            if(!file.good())
+            {
+                break;
+            }
+
+            long recordEnd = (long)file.tellg()
+                + 2*(header.TOFBins+2)*sizeof(double); // TOF and uncorrected TOF contents
+
+            if(recordEnd>length)
+            {
+                break;
+            }
+
+            targetOffsets[header.targetName] = keyEnd;
+            keyEnd = recordEnd;
+        }
+
+        if((int)targetOffsets.size()!=numberOfTargets)
+        {
+            break;
+        }
+
+        keys[key] = make_pair(validLength, sourceTime);
+        index[key] = targetOffsets;
+        validLength = keyEnd;
+    }
+
+    file.close();
+
+    fileLength = validLength;
+
+    // drop an incomplete key left by an interrupted write
+    if(validLength<length)
+    {
+        cerr << "Warning: discarding damaged tail of prefix sums " << fileName << "." << endl;
+
+        if(::truncate(fileName.c_str(), validLength))
+        {
+            cerr << "Error: failed to truncate " << fileName << "." << endl;
+        }
+    }
+}
+
+vector<pair<int, int>> PrefixSums::getKeys() const
+{
+    vector<Key> keyList;
+
+    for(auto& entry : keys)
+    {
+        keyList.push_back(entry.first);
+    }
+
+    return keyList;
+}
+
+long PrefixSums::getSourceTime(int runNumber, int subRun) const
+{
+    auto it = keys.find(Key(runNumber, subRun));
+    if(it==keys.end())
+    {
+        return -1;
+    }
+
+    return it->second.second;
+}
+
+int PrefixSums::append(int runNumber, int subRun, long sourceTime, const vector<SubRunSummary>& summaries)
+{
+    Key key(runNumber, subRun);
+
+    if(!keys.empty() && !(keys.rbegin()->first < key))
+    {
+        cerr << "Error: prefix sums must be appended in increasing key order (in "
+            << fileName << ")." << endl;
+        return 1;
+    }
+
+    // sums through the last key, plus this key's summaries
+    vector<SubRunSummary> sums;
+    if(readPrefix(runNumber, subRun, false, sums))
+    {
+        return 1;
+    }
+
+    for(auto& summary : summaries)
+    {
+        auto sum = find_if(sums.begin(), sums.end(),
+                [&](const SubRunSummary& s) { return s.targetName==summary.targetName; });
+
+        if(sum==sums.end())
+        {
+            SubRunSummary empty;
+            empty.targetName = summary.targetName;
+            sums.push_back(empty);
+            sum = sums.end()-1;
+        }
+
+        if(addToSum(*sum, summary, 1))
+        {
+            return 1;
+        }
+    }
+
+    fstream file;
+
+    if(fileLength==0)
+    {
+        file.open(fileName, ios::out | ios::binary | ios::trunc);
+        file.write(PREFIX_SUMS_MAGIC, sizeof(PREFIX_SUMS_MAGIC));
+        fileLength = sizeof(PREFIX_SUMS_MAGIC);
+    }
+
+    else
+    {
+        file.open(fileName, ios::in | ios::out | ios::binary);
+        file.seekp(fileLength);
+    }
+
+    if(!file.good())
+    {
+        cerr << "Error: failed to open prefix sums " << fileName << " for writing." << endl;
+        return 1;
+    }
+
+    int numberOfTargets = sums.size();
+
+    file.write((char*)&runNumber, sizeof(runNumber));
+    file.write((char*)&subRun, sizeof(subRun));
+    file.write((char*)&sourceTime, sizeof(sourceTime));
+    file.write((char*)&numberOfTargets, sizeof(numberOfTargets));
+
+    map<string, long> targetOffsets;
+
+    for(auto& sum : sums)
+    {
+        sum.runNumber = runNumber;
+        sum.subRun = subRun;
+        sum.sourceTime = sourceTime;
+
+        // targets that have never had data
+        sum.TOF.resize(sum.TOFBins+2);
+        sum.uncorrectedTOF.resize(sum.TOFBins+2);
+
+        targetOffsets[sum.targetName] = file.tellp();
+        writeSubRunSummary(file, sum);
+    }
+
+    long keyEnd = file.tellp();
+
+    file.close();
+
+    if(!file.good())
+    {
+        cerr << "Error: failed to write prefix sums through " << runNumber << "-" << subRun
+            << " to " << fileName << "." << endl;
+        return 1;
+    }
+
+    keys[key] = make_pair(fileLength, sourceTime);
+    index[key] = targetOffsets;
+    fileLength = keyEnd;
+
+    return 0;
+}
+
+int PrefixSums::truncate(int runNumber, int subRun)
+{
+    auto it = keys.lower_bound(Key(runNumber, subRun));
+    if(it==keys.end())
+    {
+        return 0;
+    }
+
+    long newLength = it->second.first;
+
+    if(::truncate(fileName.c_str(), newLength))
+    {
+        cerr << "Error: failed to truncate " << fileName << "." << endl;
+        return 1;
+    }
+
+    fileLength = newLength;
+
+    keys.erase(it, keys.end());
+    index.erase(index.lower_bound(Key(runNumber, subRun)), index.end());
+
+    return 0;
+}
+
+int PrefixSums::readPrefix(int runNumber, int subRun, bool inclusive, vector<SubRunSummary>& sums) const
+{
+    sums.clear();
+
+    Key key(runNumber, subRun);
+
+    auto it = inclusive ? index.upper_bound(key) : index.lower_bound(key);
+    if(it==index.begin())
+    {
+        return 0;
+    }
+
+    it--;
+
+    ifstream file(fileName, ios::binary);
+
+    for(auto& target : it->second)
+    {
+        file.seekg(target.second);
+
+        SubRunSummary sum;
+        readSubRunSummary(file, sum);
+
+        if(!file.good())
+        {
+            cerr << "Error: failed to read prefix sums through " << it->first.first << "-"
+                << it->first.second << " (" << target.first << ") from " << fileName << "." << endl;
+            return 1;
+        }
+
+        sums.push_back(sum);
+    }
+
+    return 0;
+}
+
+int addToSum(SubRunSummary& sum, const SubRunSummary& summary, double weight)
+{
+    if(!summary.monitorCounts || !summary.goodMacroNumber)
+    {
+        return 0;
+    }
+
+    if(sum.TOFBins==0)
+    {
+        sum.TOFBins = summary.TOFBins;
+        sum.TOFLowerBound = summary.TOFLowerBound;
+        sum.TOFUpperBound = summary.TOFUpperBound;
+
+        sum.TOF.assign(sum.TOFBins+2, 0);
+        sum.uncorrectedTOF.assign(sum.TOFBins+2, 0);
+    }
+
+    else if(sum.TOFBins!=summary.TOFBins
+            || sum.TOFLowerBound!=summary.TOFLowerBound
+            || sum.TOFUpperBound!=summary.TOFUpperBound)
+    {
+        cerr << "Error: can't sum " << summary.targetName
+            << " summaries with different TOF binning." << endl;
+        return 1;
+    }
+
+    for(int i=0; i<=sum.TOFBins+1; i++)
+    {
+        sum.TOF[i] += weight*summary.TOF[i];
+        sum.uncorrectedTOF[i] += weight*summary.uncorrectedTOF[i];
+    }
+
+    sum.monitorCounts += weight*summary.monitorCounts;
+    sum.goodMacroNumber += weight*summary.goodMacroNumber;
+    sum.totalMacroNumber += weight*summary.totalMacroNumber;
+    sum.totalEventNumber += weight*summary.totalEventNumber;
+
+    return 0;
+}
+
+static string getRunPrefixSumsName(string dataLocation, int runNumber, string detectorName)
+{
+    return dataLocation + "/" + to_string(runNumber) + "/prefixSums_" + detectorName + ".bin";
+}
+
+int updateRunPrefixSums(string expName, int runNumber, string detectorName, string dataLocation, const Config& config)
+{
+    PrefixSums sums(getRunPrefixSumsName(dataLocation, runNumber, detectorName));
+
+    vector<int> subRuns = findSubRuns(dataLocation, runNumber);
+    vector<pair<int, int>> keys = sums.getKeys();
+
+    vector<long> sourceTimes;
+    for(int subRun : subRuns)
+    {
+        if(checkBlacklist(expName, runNumber, subRun))
+        {
+            sourceTimes.push_back(BLACKLISTED_SOURCE_TIME);
+        }
+
+        else
+        {
+            sourceTimes.push_back(getSubRunSourceTime(dataLocation, runNumber, subRun));
+        }
+    }
+
+    // the stored sums are good up to the first subrun that is new, missing,
+    // reprocessed or newly (un)blacklisted
+    size_t firstStale = 0;
+    while(firstStale<subRuns.size() && firstStale<keys.size()
+            && keys[firstStale]==make_pair(runNumber, subRuns[firstStale])
+            && sums.getSourceTime(runNumber, subRuns[firstStale])==sourceTimes[firstStale])
+    {
+        firstStale++;
+    }
+
+    if(firstStale<keys.size())
+    {
+        if(sums.truncate(keys[firstStale].first, keys[firstStale].second))
+        {
+            return 1;
+        }
+    }
+
+    for(size_t i=firstStale; i<subRuns.size(); i++)
+    {
+        vector<SubRunSummary> summaries;
+
+        if(sourceTimes[i]!=BLACKLISTED_SOURCE_TIME)
+        {
+            for(string targetName : config.target.TARGET_ORDER)
+            {
+                string targetDataLocation = "../" + expName + "/targetData/" + targetName + ".txt";
+                CSPrereqs targetData(targetDataLocation, config);
+
+                if(readSubRun(targetData, expName, runNumber, subRuns[i], detectorName, dataLocation, config))
+                {
+                    break;
+                }
+
+                summaries.push_back(targetData.getSummary(runNumber, subRuns[i], sourceTimes[i]));
+            }
+        }
+
+        if(sums.append(runNumber, subRuns[i], sourceTimes[i], summaries))
+        {
+            return 1;
+        }
+    }
+
+    if(firstStale<subRuns.size())
+    {
+        cout << "Updated prefix sums of run " << runNumber << " from sub-run "
+            << subRuns[firstStale] << endl;
+    }
+
+    return 0;
+}
+
+int updatePrefixSums(string expName, vector<int> runNumbers, string detectorName, string dataLocation)
+{
+    sort(runNumbers.begin(), runNumbers.end());
+    runNumbers.erase(unique(runNumbers.begin(), runNumbers.end()), runNumbers.end());
+
+    // each run's whole-run sums are keyed (run, 0), with the sum of the run's
+    // subrun source times as a signature: any change to the run's prefix sums
+    // changes it
+    vector<long> signatures;
+
+    ConfigRegistry& configRegistry = getConfigRegistry(expName);
+
+    for(int runNumber : runNumbers)
+    {
+        if(updateRunPrefixSums(expName, runNumber, detectorName, dataLocation, *configRegistry.getConfig(runNumber)))
+        {
+            return 1;
+        }
+
+        PrefixSums sums(getRunPrefixSumsName(dataLocation, runNumber, detectorName));
+
+        long signature = 0;
+        for(auto& key : sums.getKeys())
+        {
+            signature += sums.getSourceTime(key.first, key.second);
+        }
+
+        signatures.push_back(signature);
+    }
+
+    PrefixSums runSums(dataLocation + "/runPrefixSums_" + detectorName + ".bin");
+    vector<pair<int, int>> keys = runSums.getKeys();
+
+    size_t firstStale = 0;
+    while(firstStale<runNumbers.size() && firstStale<keys.size()
+            && keys[firstStale]==make_pair(runNumbers[firstStale], 0)
+            && runSums.getSourceTime(runNumbers[firstStale], 0)==signatures[firstStale])
+    {
+        firstStale++;
+    }
+
+    if(firstStale<keys.size())
+    {
+        if(runSums.truncate(keys[firstStale].first, keys[firstStale].second))
+        {
+            return 1;
+        }
+    }
+
+    for(size_t i=firstStale; i<runNumbers.size(); i++)
+    {
+        PrefixSums sums(getRunPrefixSumsName(dataLocation, runNumbers[i], detectorName));
+
+        vector<SubRunSummary> runTotals;
+        if(sums.readPrefix(runNumbers[i], INT_MAX, true, runTotals)
+                || runSums.append(runNumbers[i], 0, signatures[i], runTotals))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int sumSubRunRange(string dataLocation, string detectorName,
+        int firstRun, int firstSubRun, int lastRun, int lastSubRun,
+        vector<SubRunSummary>& sums)
+{
+    sums.clear();
+
+    // each term is a prefix sum and the weight to add it with
+    vector<pair<vector<SubRunSummary>, double>> terms;
+
+    auto addTerm = [&](const PrefixSums& prefixSums, int runNumber, int subRun, bool inclusive, double weight) -> int
+    {
+        vector<SubRunSummary> prefix;
+        if(prefixSums.readPrefix(runNumber, subRun, inclusive, prefix))
+        {
+            return 1;
+        }
+
+        terms.push_back(make_pair(prefix, weight));
+        return 0;
+    };
+
+    PrefixSums firstRunSums(getRunPrefixSumsName(dataLocation, firstRun, detectorName));
+
+    if(firstRun==lastRun)
+    {
+        if(addTerm(firstRunSums, firstRun, lastSubRun, true, 1)
+                || addTerm(firstRunSums, firstRun, firstSubRun, false, -1))
+        {
+            return 1;
+        }
+    }
+
+    else
+    {
+        PrefixSums lastRunSums(getRunPrefixSumsName(dataLocation, lastRun, detectorName));
+        PrefixSums runSums(dataLocation + "/runPrefixSums_" + detectorName + ".bin");
+
+        // rest of the first run, whole runs in between, and start of the last run
+        if(addTerm(firstRunSums, firstRun, INT_MAX, true, 1)
+                || addTerm(firstRunSums, firstRun, firstSubRun, false, -1)
+                || addTerm(runSums, lastRun, 0, false, 1)
+                || addTerm(runSums, firstRun, 0, true, -1)
+                || addTerm(lastRunSums, lastRun, lastSubRun, true, 1))
+        {
+            return 1;
+        }
+    }
+
+    for(auto& term : terms)
+    {
+        for(auto& summary : term.first)
+        {
+            auto sum = find_if(sums.begin(), sums.end(),
+                    [&](const SubRunSummary& s) { return s.targetName==summary.targetName; });
+
+            if(sum==sums.end())
+            {
+                SubRunSummary empty;
+                empty.targetName = summary.targetName;
+                sums.push_back(empty);
+                sum = sums.end()-1;
+            }
+
+            if(addToSum(*sum, summary, term.second))
+            {
+                return 1;
+            }
+        }
+    }
+
+    // targets that have never had data
+    for(auto& sum : sums)
+    {
+        sum.TOF.resize(sum.TOFBins+2);
+        sum.uncorrectedTOF.resize(sum.TOFBins+2);
+    }
+
+    return 0;
+}
@@ -11,9 +11,7 @@
 
 using namespace std;
 
-extern Config config;
-
-int produceEnergyHistos(CSPrereqs& csp)
+int produceEnergyHistos(CSPrereqs& csp, const Config& config)
 {
     cout << endl << "Mapping " << csp.name << " TOF histogram to energy domain..." << endl;
 
@@ -56,7 +54,7 @@ int produceEnergyHistos(CSPrereqs& csp)
 
             outputDirectory->cd();
 
-            TH1D* correctedEnergy = convertTOFtoEnergy(TOF, targetName + "Energy");
+            TH1D* correctedEnergy = convertTOFtoEnergy(TOF, targetName + "Energy", config);
             TOF->Write();
             correctedEnergy->Write();
         }
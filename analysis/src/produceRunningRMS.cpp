@@ -19,8 +19,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     string expCSFileName = argv[1];
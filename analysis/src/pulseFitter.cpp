@@ -0,0 +1,431 @@
+#include "../include/pulseFitter.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+PulseFitter::PulseFitter(double samplePeriod, double riseOffset)
+    : samplePeriod(samplePeriod), riseOffset(riseOffset)
+{
+    numberOfPeaks = 1;
+    decayTime = 1;
+    riseTime = 1;
+    slope = 0;
+    useSlope = false;
+
+    fill(parameters, parameters+MAX_FREE_PARAMETERS, 0);
+    fill(parameterMin, parameterMin+MAX_FREE_PARAMETERS, 0);
+    fill(parameterMax, parameterMax+MAX_FREE_PARAMETERS, 0);
+}
+
+int PulseFitter::getNumberOfFreeParameters() const
+{
+    return 2*numberOfPeaks+1;
+}
+
+void PulseFitter::shape(double u, double& value, double& valueSlope) const
+{
+    // logistic rise, computed without overflow on either side
+    double z = (u-riseOffset)/riseTime;
+    double rise;
+    if(z>=0)
+    {
+        rise = 1/(1+exp(-z));
+    }
+
+    else
+    {
+        double ez = exp(z);
+        rise = ez/(1+ez);
+    }
+
+    value = exp(-u/decayTime)*rise;
+    valueSlope = value*((1-rise)/riseTime - 1/decayTime);
+}
+
+double PulseFitter::evaluate(double t, const double* p, double* gradient) const
+{
+    const double* amplitudes = p;
+    const double* starts = p+numberOfPeaks;
+    double background = p[2*numberOfPeaks];
+
+    double value = background;
+    if(useSlope)
+    {
+        value += slope*(t-starts[0]);
+    }
+
+    for(int k=0; k<numberOfPeaks; k++)
+    {
+        double s, ds;
+        shape(t-starts[k], s, ds);
+
+        value += amplitudes[k]*s;
+
+        if(gradient)
+        {
+            gradient[k] = s;
+            gradient[numberOfPeaks+k] = -amplitudes[k]*ds;
+        }
+    }
+
+    if(gradient)
+    {
+        if(useSlope)
+        {
+            gradient[numberOfPeaks] -= slope;
+        }
+
+        gradient[2*numberOfPeaks] = 1;
+    }
+
+    return value;
+}
+
+double PulseFitter::evaluate(double t) const
+{
+    return evaluate(t, parameters, 0);
+}
+
+double PulseFitter::derivative(double t) const
+{
+    double value = useSlope ? slope : 0;
+
+    for(int k=0; k<numberOfPeaks; k++)
+    {
+        double s, ds;
+        shape(t-parameters[numberOfPeaks+k], s, ds);
+
+        value += parameters[k]*ds;
+    }
+
+    return value;
+}
+
+double PulseFitter::calculateChiSquare(const vector<int>& waveform, const double* p) const
+{
+    double chiSquare = 0;
+
+    for(int i=1; (size_t)i<waveform.size(); i++)
+    {
+        double y = waveform[i];
+        if(y<=0)
+        {
+            continue;
+        }
+
+        double residual = y-evaluate((i-0.5)*samplePeriod, p, 0);
+        chiSquare += residual*residual/y;
+    }
+
+    return chiSquare;
+}
+
+int PulseFitter::solveStep(double lambda)
+{
+    const int n = getNumberOfFreeParameters();
+
+    // Cholesky decomposition of the damped normal matrix (symmetric,
+    // positive-definite unless singular)
+    double L[MAX_FREE_PARAMETERS][MAX_FREE_PARAMETERS];
+
+    for(int i=0; i<n; i++)
+    {
+        for(int j=0; j<=i; j++)
+        {
+            double sum = alpha[i][j];
+            if(i==j)
+            {
+                sum *= 1+lambda;
+            }
+
+            for(int k=0; k<j; k++)
+            {
+                sum -= L[i][k]*L[j][k];
+            }
+
+            if(i==j)
+            {
+                if(sum<=0)
+                {
+                    return 1;
+                }
+
+                L[i][i] = sqrt(sum);
+            }
+
+            else
+            {
+                L[i][j] = sum/L[j][j];
+            }
+        }
+    }
+
+    // forward, then back substitution
+    for(int i=0; i<n; i++)
+    {
+        double sum = beta[i];
+        for(int k=0; k<i; k++)
+        {
+            sum -= L[i][k]*step[k];
+        }
+
+        step[i] = sum/L[i][i];
+    }
+
+    for(int i=n-1; i>=0; i--)
+    {
+        double sum = step[i];
+        for(int k=i+1; k<n; k++)
+        {
+            sum -= L[k][i]*step[k];
+        }
+
+        step[i] = sum/L[i][i];
+    }
+
+    return 0;
+}
+
+double PulseFitter::fit(const vector<int>& waveform)
+{
+    const int n = getNumberOfFreeParameters();
+
+    for(int j=0; j<n; j++)
+    {
+        parameters[j] = min(max(parameters[j], parameterMin[j]), parameterMax[j]);
+    }
+
+    double chiSquare = calculateChiSquare(waveform, parameters);
+    double lambda = 0.001;
+
+    double gradient[MAX_FREE_PARAMETERS];
+    double trial[MAX_FREE_PARAMETERS];
+
+    for(int iteration=0; iteration<MAX_ITERATIONS; iteration++)
+    {
+        // normal equations at the current parameters
+        for(int j=0; j<n; j++)
+        {
+            beta[j] = 0;
+            fill(alpha[j], alpha[j]+n, 0);
+        }
+
+        for(int i=1; (size_t)i<waveform.size(); i++)
+        {
+            double y = waveform[i];
+            if(y<=0)
+            {
+                continue;
+            }
+
+            double weight = 1/y;
+            double residual = y-evaluate((i-0.5)*samplePeriod, parameters, gradient);
+
+            for(int j=0; j<n; j++)
+            {
+                double weightedGradient = weight*gradient[j];
+                beta[j] += weightedGradient*residual;
+
+                for(int k=0; k<=j; k++)
+                {
+                    alpha[j][k] += weightedGradient*gradient[k];
+                }
+            }
+        }
+
+        for(int j=0; j<n; j++)
+        {
+            for(int k=0; k<j; k++)
+            {
+                alpha[k][j] = alpha[j][k];
+            }
+
+            // keep parameters the data don't constrain (e.g., a start time
+            // far outside the waveform) from making the matrix singular
+            if(alpha[j][j]<=0)
+            {
+                alpha[j][j] = 1e-12;
+            }
+        }
+
+        // increase the damping until a step improves the fit
+        bool improved = false;
+        double trialChiSquare = chiSquare;
+
+        while(lambda<1e10)
+        {
+            if(!solveStep(lambda))
+            {
+                for(int j=0; j<n; j++)
+                {
+                    trial[j] = min(max(parameters[j]+step[j], parameterMin[j]), parameterMax[j]);
+                }
+
+                trialChiSquare = calculateChiSquare(waveform, trial);
+
+                if(trialChiSquare<chiSquare)
+                {
+                    improved = true;
+                    lambda = max(lambda/10, 1e-12);
+                    break;
+                }
+            }
+
+            lambda *= 10;
+        }
+
+        if(!improved)
+        {
+            break;
+        }
+
+        copy(trial, trial+n, parameters);
+
+        bool converged = (chiSquare-trialChiSquare <= 1e-9*chiSquare);
+        chiSquare = trialChiSquare;
+
+        if(converged)
+        {
+            break;
+        }
+    }
+
+    return chiSquare;
+}
+
+double PulseFitter::fitOnePeak(const vector<int>& waveform, double* par, const float* parMin, const float* parMax)
+{
+    // onePeakForm: A, t1, n, d, C, m (m unused)
+    const int freeIndices[3] = {0, 1, 4};
+
+    numberOfPeaks = 1;
+    decayTime = par[2];
+    riseTime = par[3];
+    slope = par[5];
+    useSlope = false;
+
+    for(int j=0; j<3; j++)
+    {
+        parameters[j] = par[freeIndices[j]];
+        parameterMin[j] = parMin[freeIndices[j]];
+        parameterMax[j] = parMax[freeIndices[j]];
+    }
+
+    double chiSquare = fit(waveform);
+
+    for(int j=0; j<3; j++)
+    {
+        par[freeIndices[j]] = parameters[j];
+    }
+
+    return chiSquare;
+}
+
+double PulseFitter::fitTwoPeaks(const vector<int>& waveform, double* par, const float* parMin, const float* parMax)
+{
+    // twoPeakForm: A, B, t1, t2, n, d, C, m
+    const int freeIndices[5] = {0, 1, 2, 3, 6};
+
+    numberOfPeaks = 2;
+    decayTime = par[4];
+    riseTime = par[5];
+    slope = par[7];
+    useSlope = true;
+
+    for(int j=0; j<5; j++)
+    {
+        parameters[j] = par[freeIndices[j]];
+        parameterMin[j] = parMin[freeIndices[j]];
+        parameterMax[j] = parMax[freeIndices[j]];
+    }
+
+    double chiSquare = fit(waveform);
+
+    for(int j=0; j<5; j++)
+    {
+        par[freeIndices[j]] = parameters[j];
+    }
+
+    return chiSquare;
+}
+
+int PulseFitter::getTiming(int peak, double window, PulseTiming& timing) const
+{
+    if(peak<0 || peak>=numberOfPeaks)
+    {
+        return 1;
+    }
+
+    double start = parameters[numberOfPeaks+peak];
+    double background = parameters[2*numberOfPeaks];
+
+    // the shape's extreme: where (1-rise)/riseTime = 1/decayTime, i.e.
+    // exp(-(u-riseOffset)/riseTime) = riseTime/(decayTime-riseTime). If the
+    // decay is faster than the rise, the shape only falls.
+    double peakOffset = 0;
+    if(decayTime>riseTime)
+    {
+        peakOffset = riseOffset-riseTime*log(riseTime/(decayTime-riseTime));
+    }
+
+    peakOffset = min(max(peakOffset, 0.0), window);
+
+    timing.peakValue = evaluate(start+peakOffset);
+
+    // the leading edge is monotonic; bracket the half-height crossing on it
+    double level = (background+timing.peakValue)/2;
+
+    double low = start;
+    double high = start+peakOffset;
+    double lowValue = evaluate(low)-level;
+    double highValue = evaluate(high)-level;
+
+    if(lowValue*highValue>0 || high<=low)
+    {
+        return 1;
+    }
+
+    double t = (low+high)/2;
+
+    for(int iteration=0; iteration<50; iteration++)
+    {
+        double value = evaluate(t)-level;
+
+        if((value<0)==(lowValue<0))
+        {
+            low = t;
+            lowValue = value;
+        }
+
+        else
+        {
+            high = t;
+        }
+
+        double slopeAtT = derivative(t);
+        double next = (slopeAtT!=0) ? t-value/slopeAtT : low-1;
+
+        // fall back to bisection if Newton leaves the bracket
+        if(next<=low || next>=high)
+        {
+            next = (low+high)/2;
+        }
+
+        if(fabs(next-t)<1e-9)
+        {
+            t = next;
+            break;
+        }
+
+        t = next;
+    }
+
+    timing.triggerTime = t;
+    timing.triggerValue = evaluate(t);
+    timing.derivative = derivative(t);
+
+    return 0;
+}
@@ -75,8 +75,6 @@ const unsigned int FINETIME_MASK = 0x03ff;
 const unsigned int BUFFER_SIZE = 2; // in bytes
 unsigned short buffer[BUFFER_SIZE/(sizeof(unsigned short))]; // for holding words read from the input file
 
-extern Config config;
-
 // read a word from the input file and store in a variable
 bool readWord(ifstream& file, unsigned int& variable)
 {
@@ -258,7 +256,7 @@ bool readEvent(ifstream& file, RawEvent& rawEvent)
     return false;
 }
 
-int readRawData(string inFileName, string outFileName, ofstream& logFile)
+int readRawData(string inFileName, string outFileName, ofstream& logFile, const Config& config)
 {
     // check to see if output file already exists; if so, exit
     ifstream f(outFileName);
@@ -365,66 +363,55 @@ int readRawData(string inFileName, string outFileName, ofstream& logFile)
                 continue;
             }
 
+            if(rawEvent.chNo>=config.channels.NEEDS_FINE_TIME.size())
+            {
+                cerr << "Error: encountered unimplemented channel number " << rawEvent.chNo << " during complete time assignment. Ending raw data read-in..." << endl;
+                return 1;
+            }
+
+            // only detector and veto channels need precise timing (see the
+            // channel roles in the run's channel map)
+            bool needsFineTime = config.channels.NEEDS_FINE_TIME[rawEvent.chNo];
+
             if(rawEvent.extraSelect==0)
             {
-                // use software CFD to improve timing precision
-                switch(rawEvent.chNo)
+                if(!needsFineTime)
                 {
-                    case 0:
-                    case 1:
-                    case 2:
-                    case 3:
-                    case 7:
-                        rawEvent.fineTime = 0;
-                        break;
-
-                    case 4:
-                    case 5:
-                    case 6:
-                        rawEvent.fineTime = calculateCFDTime(
-                                rawEvent.waveform,
-                                rawEvent.baseline,
-                                config.softwareCFD.CFD_FRACTION,
-                                config.softwareCFD.CFD_DELAY); // CFD time in samples
-
-                        if(rawEvent.fineTime>=0)
-                        {
-                            // recovered a good fine time for this event
-                            rawEvent.completeTime += (rawEvent.fineTime-config.softwareCFD.CFD_TIME_OFFSET)*config.digitizer.SAMPLE_PERIOD;
-                        }
-
-                        else
-                        {
-                            badCFDs++;
-                        }
-
-                        break;
-
-                    default:
-                        cerr << "Error: encountered unimplemented channel number " << rawEvent.chNo << " during complete time assignment. Ending raw data read-in..." << endl;
-                        return 1;
+                    rawEvent.fineTime = 0;
+                }
+
+                else
+                {
+                    // use software CFD to improve timing precision
+                    rawEvent.fineTime = calculateCFDTime(
+                            rawEvent.waveform,
+                            rawEvent.baseline,
+                            config.softwareCFD.CFD_FRACTION,
+                            config.softwareCFD.CFD_DELAY,
+                            config.softwareCFD.CFD_ZC_TRIGGER_THRESHOLD); // CFD time in samples
+
+                    if(rawEvent.fineTime>=0)
+                    {
+                        // recovered a good fine time for this event
+                        rawEvent.completeTime += (rawEvent.fineTime-config.softwareCFD.CFD_TIME_OFFSET)*config.digitizer.SAMPLE_PERIOD;
+                    }
+
+                    else
+                    {
+                        badCFDs++;
+                    }
                 }
             }
 
             else if(rawEvent.extraSelect==5)
             {
                 // calculate fine time based on on-board PZC and NZC
-                switch(rawEvent.chNo)
+                if(needsFineTime)
                 {
-                    case 0:
-                    case 1:
-                    case 2:
-                    case 3:
-                    case 7:
-                        break;
-
-                    case 4:
-                    case 5:
-                    case 6:
-                        rawEvent.fineTime = ((double)(8192-rawEvent.NZC)/
-                                (rawEvent.PZC-rawEvent.NZC));
-
-                        rawEvent.completeTime += rawEvent.fineTime*config.digitizer.SAMPLE_PERIOD;
+                    rawEvent.fineTime = ((double)(8192-rawEvent.NZC)/
+                            (rawEvent.PZC-rawEvent.NZC));
+
+                    rawEvent.completeTime += rawEvent.fineTime*config.digitizer.SAMPLE_PERIOD;
                 }
             }
 
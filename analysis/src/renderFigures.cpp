@@ -0,0 +1,67 @@
+/* How to use:
+ *
+ * ./renderFigures [-f formats] [output directory] [figure macro file names...]
+ *
+ * Renders the figures drawn by ROOT macros (e.g., those in prettyPrint) without
+ * a display, several at once, saving each canvas as a file of each format
+ * (a comma-separated list; pdf and png by default). Figures whose macros and
+ * inputs haven't changed since they were last rendered are skipped. E.g.,
+ *
+ *   bin/renderFigures -f eps,pdf plots/figures prettyPrint/SixPanel.cpp prettyPrint/FourPanelSn.cpp
+ */
+
+#include "../include/figureRenderer.h"
+#include "../include/fastHisto.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    vector<string> formats = {"pdf", "png"};
+
+    int firstArgument = 1;
+    if(argc>2 && strcmp(argv[1], "-f")==0)
+    {
+        formats.clear();
+
+        istringstream formatList(argv[2]);
+        string format;
+        while(getline(formatList, format, ','))
+        {
+            if(!format.empty())
+            {
+                formats.push_back(format);
+            }
+        }
+
+        firstArgument = 3;
+    }
+
+    if(argc<firstArgument+2 || formats.empty())
+    {
+        cerr << "Error: expected an output directory and at least one figure macro." << endl;
+        return 1;
+    }
+
+    string outputDirectory = argv[firstArgument];
+
+    vector<Figure> figures;
+    for(int i=firstArgument+1; i<argc; i++)
+    {
+        Figure figure;
+        if(findFigureInputs(argv[i], figure))
+        {
+            return 1;
+        }
+
+        figures.push_back(figure);
+    }
+
+    return renderFigures(figures, outputDirectory, formats, getNumberOfThreads());
+}
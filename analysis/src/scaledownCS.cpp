@@ -19,8 +19,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     scaledownCS(argv[1], argv[2], stoi(argv[3]), argv[4], argv[5]);
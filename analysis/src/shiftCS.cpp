@@ -19,8 +19,6 @@
 
 using namespace std;
 
-Config config;
-
 int main(int, char* argv[])
 {
     shiftCS(argv[1], argv[2], stod(argv[3]), argv[4], argv[5]);
@@ -2,11 +2,11 @@
 #include <vector>
 
 #include "../include/softwareCFD.h"
-#include "../include/config.h"
+#include "../include/waveformDSP.h"
 
 using namespace std;
 
-double calculateCFDTime(const vector<int>& waveform, const double& baseline, const double& fraction, const int& delay)
+double calculateCFDTime(const vector<int>& waveform, const double& baseline, const double& fraction, const int& delay, const double& armThreshold)
 {
     if(delay<=0 || delay>=waveform.size())
     {
@@ -20,34 +20,22 @@ double calculateCFDTime(const vector<int>& waveform, const double& baseline, con
         return 0;
     }
 
-    bool listenForZC = false;
-    double CFDSample;
-    double prevCFDSample = 0;
-
-    for(int i=1; i<waveform.size()-(delay+1); i++)
-    {
-        // produce CFD sum: opposite-sign waveform*fraction + normal-sign waveform, centered at
-        // baseline
-        double CFDSample = waveform[i]-(fraction*waveform[i+delay]+baseline*(1-fraction));
-
-        if(!listenForZC && CFDSample>(config.softwareCFD.CFD_ZC_TRIGGER_THRESHOLD))
-        {
-            // approaching ZC - start looking for a ZC
-            listenForZC = true;
-        }
+    WaveformDSPSettings settings;
+    settings.defaultBaseline = baseline;
+    settings.triggerStart = waveform.size(); // no trigger search
+    settings.CFDFraction = fraction;
+    settings.CFDDelay = delay;
+    settings.CFDArmThreshold = armThreshold;
 
-        if(listenForZC && CFDSample<0)
-        {
-            // found ZC: return time of crossing, i.e., (baseline-NZC)/(PZC-NZC)
-            return (i-1)+(0-prevCFDSample)/(CFDSample-prevCFDSample);
-        }
+    WaveformFeatures features;
+    analyzeWaveform(waveform.data(), waveform.size(), settings, features);
 
-        prevCFDSample = CFDSample;
-    }
-    
-    //cerr << "Error: could not calculate fine time of waveform." << endl;
+    //if(features.CFDTime<0)
+    //{
+    //    cerr << "Error: could not calculate fine time of waveform." << endl;
+    //}
 
-    return -1;
+    return features.CFDTime;
 }
 
 double calculateMacropulseFineTime(vector<int>* waveform, double threshold)
@@ -0,0 +1,448 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <mutex>
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "../include/subRunCatalog.h"
+
+using namespace std;
+
+// guards all catalogs, so that subruns can be read and added from several
+// threads at once
+static mutex catalogMutex;
+
+const char CATALOG_MAGIC[8] = {'S','R','C','A','T','0','0','1'};
+const char TOTALS_MAGIC[8] = {'S','R','T','O','T','0','0','1'};
+
+// sanity limits used to detect a damaged record
+const int MAX_TARGET_NAME_LENGTH = 256;
+const int MAX_TOF_BINS = 100000000;
+
+void writeSubRunSummary(ostream& file, const SubRunSummary& summary)
+{
+    int nameLength = summary.targetName.size();
+
+    file.write((char*)&summary.runNumber, sizeof(summary.runNumber));
+    file.write((char*)&summary.subRun, sizeof(summary.subRun));
+    file.write((char*)&nameLength, sizeof(nameLength));
+    file.write(summary.targetName.c_str(), nameLength);
+
+    file.write((char*)&summary.sourceTime, sizeof(summary.sourceTime));
+    file.write((char*)&summary.monitorCounts, sizeof(double));
+    file.write((char*)&summary.goodMacroNumber, sizeof(double));
+    file.write((char*)&summary.totalMacroNumber, sizeof(double));
+    file.write((char*)&summary.totalEventNumber, sizeof(double));
+
+    file.write((char*)&summary.TOFBins, sizeof(summary.TOFBins));
+    file.write((char*)&summary.TOFLowerBound, sizeof(double));
+    file.write((char*)&summary.TOFUpperBound, sizeof(double));
+
+    file.write((char*)&summary.TOF[0], summary.TOF.size()*sizeof(double));
+    file.write((char*)&summary.uncorrectedTOF[0], summary.uncorrectedTOF.size()*sizeof(double));
+}
+
+void readSubRunSummaryHeader(istream& file, SubRunSummary& summary)
+{
+    int nameLength;
+
+    file.read((char*)&summary.runNumber, sizeof(summary.runNumber));
+    file.read((char*)&summary.subRun, sizeof(summary.subRun));
+    file.read((char*)&nameLength, sizeof(nameLength));
+
+    if(!file.good() || nameLength<0 || nameLength>MAX_TARGET_NAME_LENGTH)
+    {
+        file.setstate(ios::failbit);
+        return;
+    }
+
+    summary.targetName.assign(nameLength, ' ');
+    file.read(&summary.targetName[0], nameLength);
+
+    file.read((char*)&summary.sourceTime, sizeof(summary.sourceTime));
+    file.read((char*)&summary.monitorCounts, sizeof(double));
+    file.read((char*)&summary.goodMacroNumber, sizeof(double));
+    file.read((char*)&summary.totalMacroNumber, sizeof(double));
+    file.read((char*)&summary.totalEventNumber, sizeof(double));
+
+    file.read((char*)&summary.TOFBins, sizeof(summary.TOFBins));
+    file.read((char*)&summary.TOFLowerBound, sizeof(double));
+    file.read((char*)&summary.TOFUpperBound, sizeof(double));
+
+    if(!file.good() || summary.TOFBins<0 || summary.TOFBins>MAX_TOF_BINS)
+    {
+        file.setstate(ios::failbit);
+    }
+}
+
+void readSubRunSummary(istream& file, SubRunSummary& summary)
+{
+    readSubRunSummaryHeader(file, summary);
+
+    if(!file.good())
+    {
+        return;
+    }
+
+    summary.TOF.resize(summary.TOFBins+2);
+    summary.uncorrectedTOF.resize(summary.TOFBins+2);
+
+    file.read((char*)&summary.TOF[0], summary.TOF.size()*sizeof(double));
+    file.read((char*)&summary.uncorrectedTOF[0], summary.uncorrectedTOF.size()*sizeof(double));
+}
+
+SubRunCatalog::SubRunCatalog(string name) : fileName(name)
+{
+    ifstream file(fileName, ios::binary);
+    if(!file.good())
+    {
+        // no catalog yet; it's created on the first add()
+        return;
+    }
+
+    file.seekg(0, ios::end);
+    long fileLength = file.tellg();
+    file.seekg(0, ios::beg);
+
+    char magic[8];
+    file.read(magic, sizeof(magic));
+
+    if(!file.good() || memcmp(magic, CATALOG_MAGIC, sizeof(magic)))
+    {
+        cerr << "Error: " << fileName << " is not a subrun catalog; ignoring it." << endl;
+        fileName = "";
+        return;
+    }
+
+    long validLength = sizeof(CATALOG_MAGIC);
+
+    while(validLength<fileLength)
+    {
+        long offset = validLength;
+        file.seekg(offset);
+
+        SubRunSummary header;
+        readSubRunSummaryHeader(file, header);
+
+        if(!file.good())
+        {
+            break;
+        }
+
+        long recordEnd = (long)file.tellg()
+            + 2*(header.TOFBins+2)*sizeof(double); // TOF and uncorrected TOF contents
+
+        if(recordEnd>fileLength)
+        {
+            break;
+        }
+
+        index[Key(header.runNumber, header.subRun, header.targetName)] = offset;
+        validLength = recordEnd;
+    }
+
+    file.close();
+
+    // drop an incomplete record left by an interrupted write
+    if(validLength<fileLength)
+    {
+        cerr << "Warning: discarding damaged tail of subrun catalog " << fileName << "." << endl;
+
+        if(truncate(fileName.c_str(), validLength))
+        {
+            cerr << "Error: failed to truncate " << fileName << "." << endl;
+        }
+    }
+}
+
+bool SubRunCatalog::contains(int runNumber, int subRun, string targetName) const
+{
+    lock_guard<mutex> lock(catalogMutex);
+
+    return index.count(Key(runNumber, subRun, targetName))>0;
+}
+
+int SubRunCatalog::read(int runNumber, int subRun, string targetName, SubRunSummary& summary) const
+{
+    lock_guard<mutex> lock(catalogMutex);
+
+    auto it = index.find(Key(runNumber, subRun, targetName));
+    if(it==index.end())
+    {
+        return 1;
+    }
+
+    ifstream file(fileName, ios::binary);
+    file.seekg(it->second);
+
+    readSubRunSummary(file, summary);
+
+    if(!file.good())
+    {
+        cerr << "Error: failed to read subrun " << runNumber << "-" << subRun
+            << " (" << targetName << ") from " << fileName << "." << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int SubRunCatalog::add(const SubRunSummary& summary)
+{
+    lock_guard<mutex> lock(catalogMutex);
+
+    if(fileName=="")
+    {
+        return 1;
+    }
+
+    if((int)summary.TOF.size()!=summary.TOFBins+2
+            || (int)summary.uncorrectedTOF.size()!=summary.TOFBins+2)
+    {
+        cerr << "Error: subrun summary TOF contents don't match its binning; not adding to "
+            << fileName << "." << endl;
+        return 1;
+    }
+
+    ofstream file(fileName, ios::binary | ios::app);
+    if(!file.good())
+    {
+        cerr << "Error: failed to open subrun catalog " << fileName << " for writing." << endl;
+        return 1;
+    }
+
+    long offset = file.tellp();
+    if(offset==0)
+    {
+        file.write(CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+        offset = sizeof(CATALOG_MAGIC);
+    }
+
+    writeSubRunSummary(file, summary);
+
+    file.close();
+
+    if(!file.good())
+    {
+        cerr << "Error: failed to write subrun " << summary.runNumber << "-" << summary.subRun
+            << " to " << fileName << "." << endl;
+        return 1;
+    }
+
+    index[Key(summary.runNumber, summary.subRun, summary.targetName)] = offset;
+
+    return 0;
+}
+
+vector<int> SubRunCatalog::getSubRuns(int runNumber) const
+{
+    lock_guard<mutex> lock(catalogMutex);
+
+    vector<int> subRuns;
+
+    for(auto& entry : index)
+    {
+        if(get<0>(entry.first)==runNumber
+                && (subRuns.empty() || subRuns.back()!=get<1>(entry.first)))
+        {
+            subRuns.push_back(get<1>(entry.first));
+        }
+    }
+
+    return subRuns;
+}
+
+vector<string> SubRunCatalog::getTargetNames(int runNumber, int subRun) const
+{
+    lock_guard<mutex> lock(catalogMutex);
+
+    vector<string> targetNames;
+
+    for(auto it = index.lower_bound(Key(runNumber, subRun, ""));
+            it!=index.end() && get<0>(it->first)==runNumber && get<1>(it->first)==subRun; it++)
+    {
+        targetNames.push_back(get<2>(it->first));
+    }
+
+    return targetNames;
+}
+
+long SubRunCatalog::size() const
+{
+    lock_guard<mutex> lock(catalogMutex);
+
+    return index.size();
+}
+
+SubRunCatalog& getSubRunCatalog(string dataLocation, string detectorName)
+{
+    static map<string, SubRunCatalog> catalogs;
+
+    lock_guard<mutex> lock(catalogMutex);
+
+    string catalogName = dataLocation + "/subRunCatalog_" + detectorName + ".bin";
+
+    auto it = catalogs.find(catalogName);
+    if(it==catalogs.end())
+    {
+        it = catalogs.insert(make_pair(catalogName, SubRunCatalog(catalogName))).first;
+    }
+
+    return it->second;
+}
+
+vector<int> findSubRuns(string dataLocation, int runNumber)
+{
+    vector<int> subRuns;
+
+    string runLocation = dataLocation + "/" + to_string(runNumber);
+
+    DIR* runDirectory = opendir(runLocation.c_str());
+    if(!runDirectory)
+    {
+        return subRuns;
+    }
+
+    struct dirent* entry;
+    while((entry = readdir(runDirectory)))
+    {
+        string name = entry->d_name;
+
+        if(name.empty() || name.find_first_not_of("0123456789")!=string::npos)
+        {
+            continue;
+        }
+
+        subRuns.push_back(stoi(name));
+    }
+
+    closedir(runDirectory);
+
+    sort(subRuns.begin(), subRuns.end());
+
+    return subRuns;
+}
+
+long getLatestModificationTime(const vector<string>& fileNames)
+{
+    long latest = 0;
+
+    for(auto& fileName : fileNames)
+    {
+        struct stat fileStatus;
+        if(stat(fileName.c_str(), &fileStatus))
+        {
+            return -1;
+        }
+
+        latest = max(latest, (long)fileStatus.st_mtime);
+    }
+
+    return latest;
+}
+
+int readSubRunTotals(string fileName, SubRunTotals& totals)
+{
+    ifstream file(fileName, ios::binary);
+    if(!file.good())
+    {
+        return 1;
+    }
+
+    char magic[8];
+    file.read(magic, sizeof(magic));
+
+    if(!file.good() || memcmp(magic, TOTALS_MAGIC, sizeof(magic)))
+    {
+        cerr << "Error: " << fileName << " is not a subrun totals file; ignoring it." << endl;
+        return 1;
+    }
+
+    SubRunTotals fileTotals;
+
+    long numberOfSubRuns;
+    file.read((char*)&numberOfSubRuns, sizeof(numberOfSubRuns));
+
+    for(long i=0; i<numberOfSubRuns && file.good(); i++)
+    {
+        int runNumber;
+        int subRun;
+        long sourceTime;
+
+        file.read((char*)&runNumber, sizeof(runNumber));
+        file.read((char*)&subRun, sizeof(subRun));
+        file.read((char*)&sourceTime, sizeof(sourceTime));
+
+        fileTotals.subRuns[make_pair(runNumber, subRun)] = sourceTime;
+    }
+
+    int numberOfTargets;
+    file.read((char*)&numberOfTargets, sizeof(numberOfTargets));
+
+    for(int i=0; i<numberOfTargets && file.good(); i++)
+    {
+        SubRunSummary summary;
+        readSubRunSummary(file, summary);
+        fileTotals.targets.push_back(summary);
+    }
+
+    if(!file.good())
+    {
+        cerr << "Error: failed to read subrun totals from " << fileName << "; ignoring them." << endl;
+        return 1;
+    }
+
+    totals = fileTotals;
+
+    return 0;
+}
+
+int writeSubRunTotals(string fileName, const SubRunTotals& totals)
+{
+    // write to a temporary file first, so that an interrupted write leaves
+    // the previous totals intact
+    string temporaryFileName = fileName + ".tmp";
+
+    ofstream file(temporaryFileName, ios::binary | ios::trunc);
+    if(!file.good())
+    {
+        cerr << "Error: failed to open " << temporaryFileName << " for writing." << endl;
+        return 1;
+    }
+
+    file.write(TOTALS_MAGIC, sizeof(TOTALS_MAGIC));
+
+    long numberOfSubRuns = totals.subRuns.size();
+    file.write((char*)&numberOfSubRuns, sizeof(numberOfSubRuns));
+
+    for(auto& entry : totals.subRuns)
+    {
+        file.write((char*)&entry.first.first, sizeof(int));
+        file.write((char*)&entry.first.second, sizeof(int));
+        file.write((char*)&entry.second, sizeof(long));
+    }
+
+    int numberOfTargets = totals.targets.size();
+    file.write((char*)&numberOfTargets, sizeof(numberOfTargets));
+
+    for(auto& summary : totals.targets)
+    {
+        writeSubRunSummary(file, summary);
+    }
+
+    file.close();
+
+    if(!file.good() || rename(temporaryFileName.c_str(), fileName.c_str()))
+    {
+        cerr << "Error: failed to write subrun totals to " << fileName << "." << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -3,30 +3,153 @@
 #include <sstream>
 #include <iomanip>
 #include <string>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
 
 #include "TFile.h"
 #include "TTree.h"
 #include "TGraphAsymmErrors.h"
 #include "TMath.h"
 #include "TLatex.h"
+#include "TROOT.h"
 
 #include "../include/target.h"
 #include "../include/dataSet.h"
 #include "../include/dataPoint.h"
 #include "../include/CSPrereqs.h"
+#include "../include/subRunCatalog.h"
 #include "../include/crossSection.h"
 #include "../include/experiment.h"
+#include "../include/configRegistry.h"
 #include "../include/plots.h"
 #include "../include/CSUtilities.h"
 #include "../include/correctForBackground.h"
+#include "../include/fastHisto.h"
 
 using namespace std;
 
-Config config;
-
 const int MAX_SUBRUN_NUMBER = 100;
 
-int main(int, char* argv[])
+// Load the totals saved by a previous invocation into allCSPrereqs, then
+// subtract the subruns in them that should no longer be included (their run is
+// no longer in the run list, or they've been blacklisted or deleted). If any
+// included subrun has been reprocessed since, or a removed subrun's data isn't
+// available for subtraction, the totals are discarded and everything is
+// re-summed. Returns 1 if the totals weren't used.
+int readPreviousTotals(string totalsFileName, string expName, string detectorName,
+        string dataLocation, const vector<int>& runNumbers,
+        vector<CSPrereqs>& allCSPrereqs, map<pair<int,int>, long>& includedSubRuns)
+{
+    SubRunTotals totals;
+    if(readSubRunTotals(totalsFileName, totals))
+    {
+        return 1;
+    }
+
+    SubRunCatalog& catalog = getSubRunCatalog(dataLocation, detectorName);
+    set<int> listedRuns(runNumbers.begin(), runNumbers.end());
+
+    map<pair<int,int>, long> keptSubRuns;
+    vector<SubRunSummary> removedSummaries;
+
+    for(auto& entry : totals.subRuns)
+    {
+        int runNumber = entry.first.first;
+        int subRun = entry.first.second;
+
+        long sourceTime = getSubRunSourceTime(dataLocation, runNumber, subRun);
+
+        bool removed = !listedRuns.count(runNumber)
+            || subRun>MAX_SUBRUN_NUMBER
+            || sourceTime<0
+            || checkBlacklist(expName, runNumber, subRun);
+
+        if(!removed)
+        {
+            if(sourceTime!=entry.second)
+            {
+                cout << "Sub-run " << runNumber << "-" << subRun
+                    << " was reprocessed since the previous sum; re-summing all sub-runs." << endl;
+                return 1;
+            }
+
+            keptSubRuns.insert(entry);
+            continue;
+        }
+
+        // subtract the same summaries that were added
+        vector<string> targetNames = catalog.getTargetNames(runNumber, subRun);
+
+        for(string targetName : targetNames)
+        {
+            SubRunSummary summary;
+            if(catalog.read(runNumber, subRun, targetName, summary)
+                    || summary.sourceTime!=entry.second)
+            {
+                targetNames.clear();
+                break;
+            }
+
+            removedSummaries.push_back(summary);
+        }
+
+        if(targetNames.empty())
+        {
+            cout << "Couldn't find the summed data of removed sub-run " << runNumber << "-" << subRun
+                << "; re-summing all sub-runs." << endl;
+            return 1;
+        }
+    }
+
+    for(auto& summary : totals.targets)
+    {
+        // (no config is loaded yet, so skip the constructor's empty histograms)
+        CSPrereqs targetData;
+        targetData.target = Target("../" + expName + "/targetData/" + summary.targetName + ".txt");
+        targetData.readSummary(summary);
+        allCSPrereqs.push_back(targetData);
+    }
+
+    for(auto& summary : removedSummaries)
+    {
+        CSPrereqs removedData;
+        removedData.target = Target("../" + expName + "/targetData/" + summary.targetName + ".txt");
+        removedData.readSummary(summary);
+
+        bool foundTarget = false;
+
+        for(CSPrereqs& csp : allCSPrereqs)
+        {
+            if(csp.target.getName() == summary.targetName)
+            {
+                csp -= removedData;
+                foundTarget = true;
+                break;
+            }
+        }
+
+        if(!foundTarget)
+        {
+            cout << "Target " << summary.targetName << " of removed sub-run " << summary.runNumber
+                << "-" << summary.subRun << " isn't in the previous sum; re-summing all sub-runs." << endl;
+            allCSPrereqs.clear();
+            return 1;
+        }
+
+        cout << "Removed " << summary.runNumber << "-" << summary.subRun
+            << " (" << summary.targetName << ") from the previous sum" << endl;
+    }
+
+    includedSubRuns = keptSubRuns;
+
+    cout << "Starting from the previous sum of " << includedSubRuns.size() << " sub-runs" << endl;
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
 {
     string dataLocation = argv[1];
 
@@ -35,6 +158,14 @@ int main(int, char* argv[])
 
     string detectorName = argv[3]; // detector name to be used for calculating cross sections
 
+    // optionally, rebuild TOF histograms from each subrun's event columns
+    // (using the current TOF binning and gates) instead of reading them
+    bool useEventColumns = false;
+    if(argc>4 && string(argv[4])=="events")
+    {
+        useEventColumns = true;
+    }
+
     // Open run list
     string runListName = "../" + expName + "/runsToSort.txt";
     ifstream runList(runListName);
@@ -45,71 +176,136 @@ int main(int, char* argv[])
     }
     cout << endl;
 
+    vector<int> runNumbers;
+
+    string line;
+    while (runList >> line)
+    {
+        runNumbers.push_back(stoi(line));
+    }
+
     // store run data in a "cross section prerequisites" structure
     vector<CSPrereqs> allCSPrereqs;
-    vector<vector<double>> runningFluxAvg;
 
-    bool printRunCount;
+    // subruns included in allCSPrereqs, with the source time of their data
+    map<pair<int,int>, long> includedSubRuns;
 
-    // Ingest data from every run in the run list
-    int runNumber;
+    // start from the totals saved by the previous invocation, unless
+    // re-histogramming events (whose binning and gates may have changed since).
+    // Delete the totals file to force a full re-sum.
+    string totalsFileName = dataLocation + "/sumAllTotals_" + detectorName + ".bin";
 
-    string line;
-    while (runList >> line)
+    if(!useEventColumns)
     {
-        runNumber = stoi(line);
+        readPreviousTotals(totalsFileName, expName, detectorName, dataLocation,
+                runNumbers, allCSPrereqs, includedSubRuns);
+    }
 
-        // read in run config file
-        config = Config(expName, runNumber);
+    // subruns are read on several threads at once
+    ROOT::EnableThreadSafety();
+    unsigned int numberOfThreads = getNumberOfThreads();
 
-        readTargetData(allCSPrereqs, expName);
+    ConfigRegistry& configRegistry = getConfigRegistry(expName);
 
-        // Loop through all subruns of this run
-        for(int subRun=0; subRun<=MAX_SUBRUN_NUMBER; subRun++)
-        {
-            printRunCount = false;
+    // Ingest data from every run in the run list
+    for(int runNumber : runNumbers)
+    {
+        // this run's config (shared by its subrun threads)
+        shared_ptr<const Config> runConfig = configRegistry.getConfig(runNumber);
 
-            // Loop through all target positions in this subrun
-            for(int j=0; (size_t)j<config.target.TARGET_ORDER.size(); j++)
+        readTargetData(allCSPrereqs, expName, *runConfig);
+
+        // only subruns not already in the totals
+        vector<int> subRuns;
+        for(int subRun : findSubRuns(dataLocation, runNumber))
+        {
+            if(subRun<=MAX_SUBRUN_NUMBER
+                    && !includedSubRuns.count(make_pair(runNumber, subRun)))
             {
-                // pull data needed for CS calculation from subrun 
-                string targetDataLocation = "../" + expName + "/targetData/" + config.target.TARGET_ORDER[j] + ".txt";
-                CSPrereqs subRunData(targetDataLocation);
+                subRuns.push_back(subRun);
+            }
+        }
+
+        // read all subruns of this run in parallel; subRunData[i] holds the
+        // targets successfully read from subRuns[i]
+        vector<vector<CSPrereqs>> subRunData(subRuns.size());
 
-                if(readSubRun(subRunData, expName, runNumber, subRun, detectorName, dataLocation))
+        runInParallel(subRuns.size(), numberOfThreads, [&](long i)
                 {
-                    break;
-                }
+                    // Loop through all target positions in this subrun
+                    for(int j=0; (size_t)j<runConfig->target.TARGET_ORDER.size(); j++)
+                    {
+                        // pull data needed for CS calculation from subrun 
+                        string targetDataLocation = "../" + expName + "/targetData/" + runConfig->target.TARGET_ORDER[j] + ".txt";
+                        CSPrereqs targetData(targetDataLocation, *runConfig);
+
+                        if(readSubRun(targetData, expName, runNumber, subRuns[i], detectorName, dataLocation, *runConfig, useEventColumns))
+                        {
+                            break;
+                        }
 
-                printRunCount = true;
+                        subRunData[i].push_back(targetData);
+                    }
+                });
 
-                // find the correct CSPrereqs to add this target's data to
+        for(int i=0; (size_t)i<subRuns.size(); i++)
+        {
+            if(subRunData[i].size())
+            {
+                cout << "Read " << runNumber << "-" << subRuns[i] << endl;
 
-                for(CSPrereqs& csp : allCSPrereqs)
+                includedSubRuns[make_pair(runNumber, subRuns[i])]
+                    = getSubRunSourceTime(dataLocation, runNumber, subRuns[i]);
+            }
+        }
+
+        // sum this run's subruns for each target (in subrun order, so that the
+        // totals don't depend on the number of threads), then add the run
+        // totals to the totals over all runs
+        for(CSPrereqs& csp : allCSPrereqs)
+        {
+            vector<CSPrereqs> targetData;
+
+            for(auto& data : subRunData)
+            {
+                for(auto& p : data)
                 {
-                    if(csp.target.getName() == subRunData.target.getName())
+                    if(p.target.getName() == csp.target.getName())
                     {
-                        // add subrun data to total
-                        csp = csp + subRunData;
+                        targetData.push_back(move(p));
                     }
                 }
+            }
 
-                vector<double> currentFluxAvg;
+            if(targetData.empty())
+            {
+                continue;
+            }
 
-                for(auto& p : allCSPrereqs)
-                {
-                    currentFluxAvg.push_back(p.monitorCounts);
-                }
+            CSPrereqs runTotal = sumPairwise(targetData);
+            csp += runTotal;
+        }
+    }
 
-                runningFluxAvg.push_back(currentFluxAvg);
+    // the background correction and cross sections use the last run's config
+    shared_ptr<const Config> config = make_shared<const Config>();
+    if(runNumbers.size())
+    {
+        config = configRegistry.getConfig(runNumbers.back());
+    }
 
-            }
+    // save totals (before background correction) for the next invocation
+    if(!useEventColumns)
+    {
+        SubRunTotals totals;
+        totals.subRuns = includedSubRuns;
 
-            if(printRunCount)
-            {
-                cout << "Read " << runNumber << "-" << subRun << endl;
-            }
+        for(auto& p : allCSPrereqs)
+        {
+            totals.targets.push_back(p.getSummary(0, 0, 0));
         }
+
+        writeSubRunTotals(totalsFileName, totals);
     }
 
     string outFileName = dataLocation + "/total.root";
@@ -118,12 +314,9 @@ int main(int, char* argv[])
     CSPrereqs blank;
     for(auto& p : allCSPrereqs)
     {
-        correctForBackground(p);
+        correctForBackground(p, *config);
 
-        string energyHistoName = p.target.getName();
-        energyHistoName = energyHistoName + "Energy";
-
-        p.energyHisto = convertTOFtoEnergy(p.TOFHisto, energyHistoName.c_str());
+        p.energy = convertTOFtoEnergy(p.TOF, *config);
 
         if(p.target.getName()=="blank" || p.target.getName()=="blankW")
         {
@@ -133,11 +326,11 @@ int main(int, char* argv[])
         cout << "all CS Prereqs name = " << p.target.getName() << endl;
 
         double totalCounts = 0;
-        int numberOfBins = p.TOFHisto->GetNbinsX();
+        int numberOfBins = p.TOF.getNBins();
 
         for(int i=1; i<=numberOfBins; i++)
         {
-            double tempCounts = p.TOFHisto->GetBinContent(i);
+            double tempCounts = p.TOF.getBinContent(i);
             if(tempCounts < 0)
             {
                 continue;
@@ -154,22 +347,25 @@ int main(int, char* argv[])
             << p.totalMacroNumber << ", total event number = "
             << p.totalEventNumber << endl;
 
+        outFile->cd();
+
         string name = p.target.getName() + "TOF";
-        p.TOFHisto->SetNameTitle(name.c_str(),name.c_str());
-        p.TOFHisto->SetDirectory(outFile);
-        p.TOFHisto->Write();
+        p.TOF.toTH1D(name, name)->Write();
 
         name = p.target.getName() + "TOFUncorrected";
-        p.uncorrectedTOFHisto->SetNameTitle(name.c_str(),name.c_str());
-        p.uncorrectedTOFHisto->SetDirectory(outFile);
-        p.uncorrectedTOFHisto->Write();
+        p.uncorrectedTOF.toTH1D(name, name)->Write();
     }
 
     vector<CrossSection> crossSections;
     for(auto& p : allCSPrereqs)
     {
         CrossSection cs;
-        cs.calculateCS(p,blank);
+        cs.calculateCS(p,blank,*config);
+
+        // counts behind each point, for propagating correlated errors to
+        // ratios of cross sections (see toyMC.h)
+        outFile->cd();
+        cs.createCountsTree(cs.name + "Counts");
 
         correctForBlank(cs, p, expName);
         crossSections.push_back(cs);;
@@ -193,7 +389,7 @@ int main(int, char* argv[])
     // read literature data and bin to appropriate energy range
     string litDirectory = "../" + expName + "/literatureData";
     string litOutputName = dataLocation + "/literatureData.root";
-    if(readLitData(litDirectory, litOutputName, config))
+    if(readLitData(litDirectory, litOutputName, *config))
     {
         cerr << "Error: failed to produce properly binned literature cross sections. Exiting..." << endl;
         return 1;
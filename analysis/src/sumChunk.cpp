@@ -3,6 +3,7 @@
 #include <sstream>
 #include <iomanip>
 #include <string>
+#include <algorithm>
 
 #include "TFile.h"
 #include "TTree.h"
@@ -14,6 +15,7 @@
 #include "../include/dataSet.h"
 #include "../include/dataPoint.h"
 #include "../include/CSPrereqs.h"
+#include "../include/prefixSums.h"
 #include "../include/CSUtilities.h"
 #include "../include/crossSection.h"
 #include "../include/experiment.h"
@@ -22,9 +24,7 @@
 
 using namespace std;
 
-Config config;
-
-int main(int, char* argv[])
+int main(int argc, char* argv[])
 {
     string dataLocation = argv[1];
 
@@ -38,39 +38,100 @@ int main(int, char* argv[])
 
     string detectorName = argv[6]; // detector name to be used for calculating cross sections
 
+    // optionally, the chunk runs from lowSubrun of runNumber through
+    // highSubrun of a later run
+    int lastRunNumber = runNumber;
+    if(argc>7)
+    {
+        lastRunNumber = atoi(argv[7]);
+    }
+
+    // Chunks are differences of cumulative sums over subruns, which only need
+    // updating when subruns are added, reprocessed, or blacklisted. Chunks
+    // spanning runs also use cumulative sums of whole runs, over all runs in
+    // the run list.
+    vector<int> runNumbers;
+
+    if(lastRunNumber==runNumber)
+    {
+        runNumbers.push_back(runNumber);
+    }
+
+    else
+    {
+        string runListName = "../" + expName + "/runsToSort.txt";
+        ifstream runList(runListName);
+        if(!runList.is_open())
+        {
+            cerr << "Error: couldn't find runlist at " << runListName << endl;
+            return 1;
+        }
+
+        string line;
+        while(runList >> line)
+        {
+            runNumbers.push_back(stoi(line));
+        }
+
+        if(find(runNumbers.begin(), runNumbers.end(), runNumber)==runNumbers.end()
+                || find(runNumbers.begin(), runNumbers.end(), lastRunNumber)==runNumbers.end())
+        {
+            cerr << "Error: runs " << runNumber << " and " << lastRunNumber
+                << " must both be in " << runListName << endl;
+            return 1;
+        }
+    }
+
+    if(updatePrefixSums(expName, runNumbers, detectorName, dataLocation))
+    {
+        cerr << "Error: failed to update prefix sums. Exiting..." << endl;
+        return 1;
+    }
+
+    vector<SubRunSummary> sums;
+    if(sumSubRunRange(dataLocation, detectorName, runNumber, lowSubrun,
+                lastRunNumber, highSubrun, sums))
+    {
+        cerr << "Error: failed to sum sub-runs " << runNumber << "-" << lowSubrun
+            << " through " << lastRunNumber << "-" << highSubrun << ". Exiting..." << endl;
+        return 1;
+    }
+
     vector<CSPrereqs> allCSPrereqs;
     
     // read in run config file
-    config = Config(expName, runNumber);
+    const Config config(expName, runNumber);
 
-    readTargetData(allCSPrereqs, expName);
+    readTargetData(allCSPrereqs, expName, config);
 
-    // Loop through all subruns of this run
-    for(int subRun=lowSubrun; subRun<=highSubrun; subRun++)
+    for(auto& sum : sums)
     {
-        // Loop through all target positions in this subrun
-        for(int j=0; (size_t)j<config.target.TARGET_ORDER.size(); j++)
+        // no data for this target in the chunk
+        if(sum.TOFBins==0)
         {
-            // pull data needed for CS calculation from subrun 
-            string targetDataLocation = "../" + expName + "/targetData/" + config.target.TARGET_ORDER[j] + ".txt";
-            CSPrereqs subRunData(targetDataLocation);
-
-            if(readSubRun(subRunData, expName, runNumber, subRun, detectorName, dataLocation))
-            {
-                break;
-            }
+            continue;
+        }
 
-            // find the correct CSPrereqs to add this target's data to
+        // find the correct CSPrereqs to fill with this target's data
+        bool foundTarget = false;
 
-            for(CSPrereqs& csp: allCSPrereqs)
+        for(CSPrereqs& csp: allCSPrereqs)
+        {
+            if(csp.target.getName() == sum.targetName)
             {
-                if(csp.target.getName() == subRunData.target.getName())
-                {
-                    // add subrun data to total
-                    csp = csp + subRunData;
-                }
+                csp.readSummary(sum);
+                foundTarget = true;
             }
         }
+
+        // targets used only in later runs of the chunk
+        if(!foundTarget)
+        {
+            string targetDataLocation = "../" + expName + "/targetData/" + sum.targetName + ".txt";
+            CSPrereqs targetData(targetDataLocation, config);
+            targetData.readSummary(sum);
+            allCSPrereqs.push_back(targetData);
+        }
     }
 
     string outFileName = dataLocation + "/total.root";
@@ -79,12 +140,12 @@ int main(int, char* argv[])
     CSPrereqs blank;
     for(auto& p : allCSPrereqs)
     {
-        //correctForBackground(p);
+        //correctForBackground(p, config);
 
         string energyHistoName = p.target.getName();
         energyHistoName = energyHistoName + "Energy";
 
-        p.energyHisto = convertTOFtoEnergy(p.TOFHisto, energyHistoName.c_str());
+        p.energy = convertTOFtoEnergy(p.TOF, config);
 
         if(p.target.getName()=="blank" || p.target.getName()=="blankW")
         {
@@ -92,11 +153,11 @@ int main(int, char* argv[])
         }
 
         double totalCounts = 0;
-        int numberOfBins = p.energyHisto->GetNbinsX();
+        int numberOfBins = p.energy.getNBins();
 
         for(int i=1; i<=numberOfBins; i++)
         {
-            double tempCounts = p.energyHisto->GetBinContent(i);
+            double tempCounts = p.energy.getBinContent(i);
             if(tempCounts < 0)
             {
                 continue;
@@ -113,21 +174,25 @@ int main(int, char* argv[])
             << p.totalMacroNumber << ", total event number = "
             << p.totalEventNumber << endl;
 
-        p.energyHisto->SetDirectory(outFile);
-        p.energyHisto->Write();
+        outFile->cd();
 
-        string name = p.target.getName() + "TOF";
-        p.TOFHisto->SetNameTitle(name.c_str(),name.c_str());
-        p.TOFHisto->SetDirectory(outFile);
+        p.energy.toTH1D(energyHistoName, energyHistoName)->Write();
 
-        p.TOFHisto->Write();
+        string name = p.target.getName() + "TOF";
+        p.TOF.toTH1D(name, name)->Write();
     }
 
     vector<CrossSection> crossSections;
     for(auto& p : allCSPrereqs)
     {
         CrossSection cs = CrossSection();
-        cs.calculateCS(p,blank);
+        cs.calculateCS(p,blank,config);
+
+        // counts behind each point, for propagating correlated errors to
+        // ratios of cross sections (see toyMC.h)
+        outFile->cd();
+        cs.createCountsTree(cs.name + "Counts");
+
         correctForBlank(cs, p, expName);
 
         crossSections.push_back(cs);
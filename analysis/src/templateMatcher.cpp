@@ -0,0 +1,337 @@
+#include "../include/templateMatcher.h"
+#include "../include/fastHisto.h"
+
+#include <vector>
+#include <complex>
+#include <cmath>
+
+using namespace std;
+
+// number of waveform pairs each thread correlates at a time
+const long PAIRS_PER_TASK = 256;
+
+FFTPlan::FFTPlan(unsigned int size) : size(size)
+{
+    unsigned int numberOfBits = 0;
+    while((1u<<numberOfBits) < size)
+    {
+        numberOfBits++;
+    }
+
+    bitReversal.resize(size);
+    for(unsigned int i=0; i<size; i++)
+    {
+        unsigned int reversed = 0;
+        for(unsigned int bit=0; bit<numberOfBits; bit++)
+        {
+            if(i & (1u<<bit))
+            {
+                reversed |= 1u<<(numberOfBits-1-bit);
+            }
+        }
+
+        bitReversal[i] = reversed;
+    }
+
+    for(unsigned int k=0; k<size/2; k++)
+    {
+        twiddles.push_back(polar(1.0, -2*M_PI*k/size));
+    }
+}
+
+unsigned int FFTPlan::getSize() const
+{
+    return size;
+}
+
+void FFTPlan::transform(vector<complex<double>>& data, bool inverse) const
+{
+    for(unsigned int i=0; i<size; i++)
+    {
+        if(i<bitReversal[i])
+        {
+            swap(data[i], data[bitReversal[i]]);
+        }
+    }
+
+    for(unsigned int length=2; length<=size; length*=2)
+    {
+        unsigned int half = length/2;
+        unsigned int stride = size/length;
+
+        for(unsigned int start=0; start<size; start+=length)
+        {
+            for(unsigned int k=0; k<half; k++)
+            {
+                complex<double> twiddle = inverse ? conj(twiddles[k*stride]) : twiddles[k*stride];
+                complex<double> odd = twiddle*data[start+k+half];
+
+                data[start+k+half] = data[start+k]-odd;
+                data[start+k] += odd;
+            }
+        }
+    }
+
+    if(inverse)
+    {
+        for(unsigned int i=0; i<size; i++)
+        {
+            data[i] /= size;
+        }
+    }
+}
+
+PulseTemplate::PulseTemplate(int preSamples, int length)
+    : preSamples(preSamples), length(length), numberOfPulses(0), sum(length, 0)
+{
+}
+
+int PulseTemplate::addPulse(const vector<int>& waveform, double referenceTime)
+{
+    double start = referenceTime-preSamples;
+
+    // need at least one baseline sample before the template's start, and a
+    // sample after its end to interpolate to
+    if(start<1 || floor(start)+length >= waveform.size())
+    {
+        return 1;
+    }
+
+    int firstSample = floor(start);
+    double fraction = start-firstSample;
+
+    double baseline = 0;
+    for(int i=0; i<firstSample; i++)
+    {
+        baseline += waveform[i];
+    }
+
+    baseline /= firstSample;
+
+    vector<double> pulse(length);
+    double peak = 0;
+
+    for(int j=0; j<length; j++)
+    {
+        int i = firstSample+j;
+        pulse[j] = (1-fraction)*waveform[i]+fraction*waveform[i+1]-baseline;
+
+        if(fabs(pulse[j])>fabs(peak))
+        {
+            peak = pulse[j];
+        }
+    }
+
+    if(peak==0)
+    {
+        return 1;
+    }
+
+    for(int j=0; j<length; j++)
+    {
+        sum[j] += pulse[j]/fabs(peak);
+    }
+
+    numberOfPulses++;
+
+    return 0;
+}
+
+int PulseTemplate::getNumberOfPulses() const
+{
+    return numberOfPulses;
+}
+
+int PulseTemplate::getPreSamples() const
+{
+    return preSamples;
+}
+
+int PulseTemplate::getLength() const
+{
+    return length;
+}
+
+vector<double> PulseTemplate::getShape() const
+{
+    vector<double> shape(sum);
+
+    if(numberOfPulses>0)
+    {
+        for(double& value : shape)
+        {
+            value /= numberOfPulses;
+        }
+    }
+
+    return shape;
+}
+
+// smallest power of two that holds a waveform of the given length
+unsigned int getFFTSize(unsigned int length)
+{
+    unsigned int size = 1;
+    while(size<length)
+    {
+        size *= 2;
+    }
+
+    return size;
+}
+
+TemplateMatcher::TemplateMatcher(const PulseTemplate& pulseTemplate, unsigned int maxWaveformLength)
+    : preSamples(pulseTemplate.getPreSamples()),
+      templateLength(pulseTemplate.getLength()),
+      maxWaveformLength(maxWaveformLength),
+      plan(getFFTSize(max(maxWaveformLength, (unsigned int)templateLength)))
+{
+    vector<double> shape = pulseTemplate.getShape();
+
+    // remove the template's mean, so a waveform's baseline doesn't add to its
+    // correlation
+    double mean = 0;
+    for(double value : shape)
+    {
+        mean += value;
+    }
+
+    mean /= shape.size();
+
+    templateSpectrum.assign(plan.getSize(), 0);
+    for(int j=0; j<templateLength; j++)
+    {
+        templateSpectrum[j] = shape[j]-mean;
+    }
+
+    plan.transform(templateSpectrum, false);
+
+    for(complex<double>& value : templateSpectrum)
+    {
+        value = conj(value);
+    }
+}
+
+double TemplateMatcher::findPeak(const vector<double>& correlation, unsigned int waveformLength) const
+{
+    // only search lags where the whole template overlaps the waveform
+    int lastLag = waveformLength-templateLength;
+
+    int bestLag = 0;
+    for(int lag=1; lag<=lastLag; lag++)
+    {
+        if(correlation[lag]>correlation[bestLag])
+        {
+            bestLag = lag;
+        }
+    }
+
+    if(bestLag==0 || bestLag==lastLag)
+    {
+        return -1;
+    }
+
+    double before = correlation[bestLag-1];
+    double peak = correlation[bestLag];
+    double after = correlation[bestLag+1];
+
+    double curvature = before-2*peak+after;
+    if(curvature>=0)
+    {
+        return -1;
+    }
+
+    return bestLag+0.5*(before-after)/curvature+preSamples;
+}
+
+void TemplateMatcher::calculateTimes(const vector<vector<int>>& waveforms,
+        vector<double>& times, unsigned int numberOfThreads) const
+{
+    times.assign(waveforms.size(), -1);
+
+    long numberOfPairs = (waveforms.size()+1)/2;
+    long numberOfTasks = (numberOfPairs+PAIRS_PER_TASK-1)/PAIRS_PER_TASK;
+
+    const unsigned int size = plan.getSize();
+
+    runInParallel(numberOfTasks, numberOfThreads, [&](long task)
+    {
+        vector<complex<double>> data(size);
+        vector<double> realCorrelation(size);
+        vector<double> imaginaryCorrelation(size);
+
+        long lastPair = min((task+1)*PAIRS_PER_TASK, numberOfPairs);
+
+        for(long pair=task*PAIRS_PER_TASK; pair<lastPair; pair++)
+        {
+            size_t first = 2*pair;
+            size_t second = first+1;
+
+            // waveforms that can be timed go in the real (first) and
+            // imaginary (second) parts
+            bool useFirst = waveforms[first].size()>=(size_t)templateLength+2
+                && waveforms[first].size()<=maxWaveformLength;
+
+            bool useSecond = second<waveforms.size()
+                && waveforms[second].size()>=(size_t)templateLength+2
+                && waveforms[second].size()<=maxWaveformLength;
+
+            if(!useFirst && !useSecond)
+            {
+                continue;
+            }
+
+            fill(data.begin(), data.end(), 0);
+
+            // subtract each waveform's first sample, so the transforms don't
+            // carry its (large) baseline
+            if(useFirst)
+            {
+                const vector<int>& waveform = waveforms[first];
+                for(size_t i=0; i<waveform.size(); i++)
+                {
+                    data[i].real(waveform[i]-waveform[0]);
+                }
+            }
+
+            if(useSecond)
+            {
+                const vector<int>& waveform = waveforms[second];
+                for(size_t i=0; i<waveform.size(); i++)
+                {
+                    data[i].imag(waveform[i]-waveform[0]);
+                }
+            }
+
+            // correlate both with the template at once: the template is real,
+            // so each waveform's correlation stays in its own part
+            plan.transform(data, false);
+
+            for(unsigned int k=0; k<size; k++)
+            {
+                data[k] *= templateSpectrum[k];
+            }
+
+            plan.transform(data, true);
+
+            if(useFirst)
+            {
+                for(unsigned int k=0; k<size; k++)
+                {
+                    realCorrelation[k] = data[k].real();
+                }
+
+                times[first] = findPeak(realCorrelation, waveforms[first].size());
+            }
+
+            if(useSecond)
+            {
+                for(unsigned int k=0; k<size; k++)
+                {
+                    imaginaryCorrelation[k] = data[k].imag();
+                }
+
+                times[second] = findPeak(imaginaryCorrelation, waveforms[second].size());
+            }
+        }
+    });
+}
@@ -0,0 +1,308 @@
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+#include "TF1.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+
+#include "../include/config.h"
+#include "../include/templateTiming.h"
+#include "../include/templateMatcher.h"
+#include "../include/fastHisto.h"
+
+using namespace std;
+
+// template span, in samples, and where the CFD time falls in it
+const int TEMPLATE_PRE_SAMPLES = 4;
+const int TEMPLATE_LENGTH = 24;
+
+// number of gamma pulses averaged into a template
+const int MIN_TEMPLATE_PULSES = 100;
+const int MAX_TEMPLATE_PULSES = 20000;
+
+// number of waveforms read from the tree and timed at once
+const long TEMPLATE_TIMING_BATCH_SIZE = 100000;
+
+// center of the gamma peak in a channel's TOF spectrum: the center of the 2-ns
+// neighborhood holding the most events
+double findGammaPeak(const vector<double>& microTimes, const Config& config)
+{
+    FastHisto1D TOF("TOF", "TOF",
+            config.plot.TOF_BINS,
+            config.plot.TOF_LOWER_BOUND,
+            config.plot.TOF_UPPER_BOUND);
+
+    for(double microTime : microTimes)
+    {
+        TOF.fill(microTime);
+    }
+
+    int binNeighborhood = config.plot.TOF_BINS_PER_NS;
+
+    long maxSum = 0;
+    int maxBin = 1;
+
+    for(int i=1; i<=config.plot.TOF_BINS; i++)
+    {
+        long sum = 0;
+        for(int j=max(i-binNeighborhood,1); j<min(i+binNeighborhood,config.plot.TOF_BINS+1); j++)
+        {
+            sum += TOF.getBinContent(j);
+        }
+
+        if(sum>maxSum)
+        {
+            maxSum = sum;
+            maxBin = i;
+        }
+    }
+
+    const FastAxis& axis = TOF.getAxis();
+    return axis.low+(maxBin-0.5)*axis.width/axis.nBins;
+}
+
+// Gaussian sigma of a gamma peak histogram (0 if it's empty)
+double fitGammaSigma(TH1D* gammaHisto, double& sigmaError)
+{
+    sigmaError = 0;
+
+    if(gammaHisto->GetEntries()==0)
+    {
+        return 0;
+    }
+
+    TF1* gammaPeakFit = new TF1("gammaPeakFit","gaus",
+            gammaHisto->GetXaxis()->GetXmin(), gammaHisto->GetXaxis()->GetXmax());
+    gammaHisto->Fit(gammaPeakFit,"Q0");
+
+    sigmaError = gammaPeakFit->GetParError(2);
+    double sigma = fabs(gammaPeakFit->GetParameter(2));
+
+    delete gammaPeakFit;
+    return sigma;
+}
+
+int calculateTemplateTiming(string inputFileName, ofstream& logFile, string outputFileName, const Config& config)
+{
+    // test if output file already exists
+    ifstream f(outputFileName);
+    if(f.good())
+    {
+        cout << outputFileName << " already exists; skipping template timing." << endl;
+        logFile << outputFileName << " already exists; skipping template timing." << endl;
+        return 2;
+    }
+
+    cout << endl << "Start template timing of detector events..." << endl;
+    logFile << endl << "*** Template Timing ***" << endl;
+
+    TFile* inputFile = new TFile(inputFileName.c_str(),"READ");
+    if(!inputFile->IsOpen())
+    {
+        cerr << "Error: failed to open " << inputFileName << " for template timing." << endl;
+        return 1;
+    }
+
+    // check that every detector channel's tree is present before creating the
+    // output, so a failed run doesn't leave a partial file behind
+    for(auto& channel : config.digitizer.CHANNEL_MAP)
+    {
+        if(config.channels.ROLES[channel.first] != ChannelRole::DETECTOR)
+        {
+            continue;
+        }
+
+        if(!inputFile->Get(channel.second.c_str()))
+        {
+            cerr << "Error: tried to time events by template matching, but failed to find " << channel.second << " in " << inputFileName << endl;
+            inputFile->Close();
+            return 1;
+        }
+    }
+
+    TFile* outputFile = new TFile(outputFileName.c_str(),"RECREATE");
+
+    const double GAMMA_WINDOW_WIDTH = config.time.GAMMA_WINDOW_SIZE/2;
+    const double SAMPLE_PERIOD = config.digitizer.SAMPLE_PERIOD;
+
+    unsigned int numberOfThreads = getNumberOfThreads();
+
+    for(auto& channel : config.digitizer.CHANNEL_MAP)
+    {
+        if(config.channels.ROLES[channel.first] != ChannelRole::DETECTOR)
+        {
+            continue;
+        }
+
+        TTree* tree = (TTree*)inputFile->Get(channel.second.c_str());
+
+        double macroTime;
+        double completeTime;
+        double fineTime;
+        vector<int>* waveformPointer = 0;
+
+        tree->SetBranchAddress("macroTime",&macroTime);
+        tree->SetBranchAddress("completeTime",&completeTime);
+        tree->SetBranchAddress("fineTime",&fineTime);
+        tree->SetBranchAddress("waveform",&waveformPointer);
+
+        long totalEntries = tree->GetEntries();
+
+        // read the event times once (without waveforms); later passes use
+        // these copies
+        vector<double> microTimes(totalEntries);
+        vector<double> completeTimes(totalEntries);
+        vector<double> fineTimes(totalEntries);
+
+        tree->SetBranchStatus("waveform",0);
+
+        for(long i=0; i<totalEntries; i++)
+        {
+            tree->GetEntry(i);
+
+            microTimes[i] = fmod(completeTime-macroTime,config.facility.MICRO_LENGTH);
+            completeTimes[i] = completeTime;
+            fineTimes[i] = fineTime;
+        }
+
+        tree->SetBranchStatus("waveform",1);
+
+        double gammaCenter = findGammaPeak(microTimes, config);
+
+        // average the gamma pulses, aligned at their CFD times, into a template
+        PulseTemplate pulseTemplate(TEMPLATE_PRE_SAMPLES, TEMPLATE_LENGTH);
+        size_t maxWaveformLength = 0;
+
+        for(long i=0; i<totalEntries && pulseTemplate.getNumberOfPulses()<MAX_TEMPLATE_PULSES; i++)
+        {
+            if(fabs(microTimes[i]-gammaCenter)>=GAMMA_WINDOW_WIDTH || fineTimes[i]<0)
+            {
+                continue;
+            }
+
+            tree->GetEntry(i);
+            pulseTemplate.addPulse(*waveformPointer, fineTimes[i]);
+
+            maxWaveformLength = max(maxWaveformLength, waveformPointer->size());
+        }
+
+        if(pulseTemplate.getNumberOfPulses()<MIN_TEMPLATE_PULSES)
+        {
+            cout << "Only " << pulseTemplate.getNumberOfPulses() << " gamma pulses with CFD times on channel \""
+                << channel.second << "\"; skipping template timing." << endl;
+            logFile << "Only " << pulseTemplate.getNumberOfPulses() << " gamma pulses with CFD times on channel \""
+                << channel.second << "\"; skipping template timing." << endl;
+            continue;
+        }
+
+        TemplateMatcher matcher(pulseTemplate, maxWaveformLength);
+
+        TDirectory* directory = outputFile->mkdir(channel.second.c_str(),channel.second.c_str());
+        directory->cd();
+
+        TH1D* templateShape = new TH1D("templateShape","pulse template, relative to CFD time (samples)",
+                TEMPLATE_LENGTH, -TEMPLATE_PRE_SAMPLES-0.5, TEMPLATE_LENGTH-TEMPLATE_PRE_SAMPLES-0.5);
+
+        vector<double> shape = pulseTemplate.getShape();
+        for(int j=0; j<TEMPLATE_LENGTH; j++)
+        {
+            templateShape->SetBinContent(j+1, shape[j]);
+        }
+
+        TH1D* CFDGammaH = new TH1D("CFDGammaH","gamma peak, CFD times",
+                500, gammaCenter-GAMMA_WINDOW_WIDTH, gammaCenter+GAMMA_WINDOW_WIDTH);
+        TH1D* templateGammaH = new TH1D("templateGammaH","gamma peak, template times",
+                500, gammaCenter-GAMMA_WINDOW_WIDTH, gammaCenter+GAMMA_WINDOW_WIDTH);
+        TH1D* templateMinusCFDH = new TH1D("templateMinusCFDH","template time - CFD time, gammas (ns)",
+                400, -2*SAMPLE_PERIOD, 2*SAMPLE_PERIOD);
+
+        double templateTime;
+        TTree* templateTree = new TTree(channel.second.c_str(),"");
+        templateTree->Branch("templateTime",&templateTime,"templateTime/d");
+
+        long unmatched = 0;
+
+        vector<vector<int>> waveforms;
+        vector<double> times;
+
+        // time events in batches: read serially, correlate in parallel
+        for(long first=0; first<totalEntries; first+=TEMPLATE_TIMING_BATCH_SIZE)
+        {
+            long batchSize = min(TEMPLATE_TIMING_BATCH_SIZE, totalEntries-first);
+            waveforms.resize(batchSize);
+
+            for(long i=0; i<batchSize; i++)
+            {
+                tree->GetEntry(first+i);
+                waveforms[i] = *waveformPointer;
+            }
+
+            matcher.calculateTimes(waveforms, times, numberOfThreads);
+
+            for(long i=0; i<batchSize; i++)
+            {
+                long entry = first+i;
+
+                if(times[i]<0)
+                {
+                    templateTime = completeTimes[entry];
+                    templateTree->Fill();
+
+                    unmatched++;
+                    continue;
+                }
+
+                // replace the CFD time (if there was one) with the template time,
+                // as the raw data read-in applied it
+                double timeShift = (times[i]-config.softwareCFD.CFD_TIME_OFFSET)*SAMPLE_PERIOD;
+                if(fineTimes[entry]>=0)
+                {
+                    timeShift -= (fineTimes[entry]-config.softwareCFD.CFD_TIME_OFFSET)*SAMPLE_PERIOD;
+                }
+
+                templateTime = completeTimes[entry]+timeShift;
+                templateTree->Fill();
+
+                if(fabs(microTimes[entry]-gammaCenter)<GAMMA_WINDOW_WIDTH && fineTimes[entry]>=0)
+                {
+                    CFDGammaH->Fill(microTimes[entry]);
+                    templateGammaH->Fill(microTimes[entry]+timeShift);
+                    templateMinusCFDH->Fill(timeShift);
+                }
+            }
+
+            cout << "Timed " << first+batchSize << " \"" << channel.second << "\" events by template matching...\r";
+            fflush(stdout);
+        }
+
+        cout << endl;
+
+        double CFDSigmaError;
+        double templateSigmaError;
+        double CFDSigma = fitGammaSigma(CFDGammaH, CFDSigmaError);
+        double templateSigma = fitGammaSigma(templateGammaH, templateSigmaError);
+
+        cout << "Channel \"" << channel.second << "\" timing resolution (gamma peak sigma, "
+            << CFDGammaH->GetEntries() << " gammas): CFD = " << CFDSigma << " +/- " << CFDSigmaError
+            << " ns, template = " << templateSigma << " +/- " << templateSigmaError << " ns." << endl;
+        logFile << "Channel \"" << channel.second << "\" timing resolution (gamma peak sigma, "
+            << CFDGammaH->GetEntries() << " gammas): CFD = " << CFDSigma << " +/- " << CFDSigmaError
+            << " ns, template = " << templateSigma << " +/- " << templateSigmaError << " ns." << endl;
+        logFile << "Template averaged from " << pulseTemplate.getNumberOfPulses() << " gamma pulses; "
+            << unmatched << " of " << totalEntries << " events had no template match." << endl;
+
+        templateShape->Write();
+        CFDGammaH->Write();
+        templateGammaH->Write();
+        templateMinusCFDH->Write();
+        templateTree->Write();
+    }
+
+    outputFile->Close();
+    inputFile->Close();
+
+    return 0;
+}
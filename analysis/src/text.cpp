@@ -11,7 +11,6 @@
 #include "../include/config.h"
 
 extern RawEvent rawEvent;
-Config config;
 
 // keep track of event statistics
 long numberOfEvents = 0;
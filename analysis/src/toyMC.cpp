@@ -0,0 +1,364 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TGraphAsymmErrors.h"
+#include "TDirectory.h"
+
+#include "../include/toyMC.h"
+#include "../include/dataSet.h"
+#include "../include/fastHisto.h"
+
+using namespace std;
+
+// replicas are drawn and evaluated in batches of this size, so the arithmetic
+// runs over plain arrays
+const int TOY_MC_BATCH_SIZE = 4096;
+
+const long TOY_MC_REPLICAS = 100000;
+const unsigned long TOY_MC_SEED = 1;
+
+int readPointCounts(TFile* file, string treeName, vector<PointCounts>& counts)
+{
+    TTree* tree = (TTree*)file->Get(treeName.c_str());
+    if(!tree)
+    {
+        return 1;
+    }
+
+    PointCounts point;
+    tree->SetBranchAddress("energy", &point.energy);
+    tree->SetBranchAddress("targetDetCounts", &point.targetDetCounts);
+    tree->SetBranchAddress("blankDetCounts", &point.blankDetCounts);
+    tree->SetBranchAddress("targetMonitorCounts", &point.targetMonitorCounts);
+    tree->SetBranchAddress("blankMonitorCounts", &point.blankMonitorCounts);
+    tree->SetBranchAddress("arealDensity", &point.arealDensity);
+
+    counts.clear();
+    for(long i=0; i<tree->GetEntries(); i++)
+    {
+        tree->GetEntry(i);
+        counts.push_back(point);
+    }
+
+    return 0;
+}
+
+// Quantile by linear interpolation between order statistics. Partially
+// reorders values (a full sort per point would dominate the run time).
+static double getQuantile(vector<double>& values, double q)
+{
+    int n = values.size();
+    double position = q*(n-1);
+    int below = (int)position;
+
+    nth_element(values.begin(), values.begin()+below, values.end());
+    double lowValue = values[below];
+
+    if(below>=n-1)
+    {
+        return lowValue;
+    }
+
+    // the next order statistic is the smallest value above position below
+    double highValue = *min_element(values.begin()+below+1, values.end());
+
+    return lowValue + (position-below)*(highValue-lowValue);
+}
+
+// Fill z with n standard normal deviates (n even), by the Box-Muller
+// transform over arrays of uniform deviates
+static void fillGaussian(mt19937_64& generator, vector<double>& uniforms, double* z, int n)
+{
+    // uniform deviates in (0, 1]
+    for(int k=0; k<n; k++)
+    {
+        uniforms[k] = ((generator()>>11)+1)*(1.0/9007199254740992.0);
+    }
+
+    const double twoPi = 2*M_PI;
+
+    for(int k=0; k<n; k+=2)
+    {
+        double radius = sqrt(-2*log(uniforms[k]));
+        double angle = twoPi*uniforms[k+1];
+
+        z[k] = radius*cos(angle);
+        z[k+1] = radius*sin(angle);
+    }
+}
+
+static double evaluate(ToyMCQuantity quantity, double a, double b)
+{
+    if(quantity==ToyMCQuantity::RATIO)
+    {
+        return a/b;
+    }
+
+    return (a-b)/(a+b);
+}
+
+// One point's inputs: nominal cross sections and counts of both targets
+struct ToyMCPoint
+{
+    double energy;
+    double aValue;
+    double bValue;
+    PointCounts aCounts;
+    PointCounts bCounts;
+};
+
+int propagateToyMC(const DataSet& a, const vector<PointCounts>& aCounts,
+        const DataSet& b, const vector<PointCounts>& bCounts,
+        ToyMCQuantity quantity, long numberOfReplicas, unsigned long seed,
+        unsigned int numberOfThreads, ToyMCBands& bands)
+{
+    map<double, double> aValues;
+    for(int i=0; i<a.getNumberOfPoints(); i++)
+    {
+        aValues[a.getPoint(i).getXValue()] = a.getPoint(i).getYValue();
+    }
+
+    map<double, double> bValues;
+    for(int i=0; i<b.getNumberOfPoints(); i++)
+    {
+        bValues[b.getPoint(i).getXValue()] = b.getPoint(i).getYValue();
+    }
+
+    map<double, const PointCounts*> bCountsByEnergy;
+    for(const PointCounts& c : bCounts)
+    {
+        bCountsByEnergy[c.energy] = &c;
+    }
+
+    vector<ToyMCPoint> points;
+    for(const PointCounts& c : aCounts)
+    {
+        auto bCount = bCountsByEnergy.find(c.energy);
+        auto aValue = aValues.find(c.energy);
+        auto bValue = bValues.find(c.energy);
+
+        if(bCount==bCountsByEnergy.end() || aValue==aValues.end() || bValue==bValues.end())
+        {
+            continue;
+        }
+
+        const PointCounts& d = *bCount->second;
+
+        if(c.targetDetCounts<=0 || c.blankDetCounts<=0 || c.targetMonitorCounts<=0
+                || c.blankMonitorCounts<=0 || c.arealDensity<=0
+                || d.targetDetCounts<=0 || d.blankDetCounts<=0 || d.targetMonitorCounts<=0
+                || d.blankMonitorCounts<=0 || d.arealDensity<=0)
+        {
+            continue;
+        }
+
+        points.push_back(ToyMCPoint{c.energy, aValue->second, bValue->second, c, d});
+    }
+
+    if(points.empty() || numberOfReplicas<2)
+    {
+        cerr << "Error: no points with counts in common to propagate errors with." << endl;
+        return 1;
+    }
+
+    int numberOfPoints = points.size();
+
+    bands.energy.assign(numberOfPoints, 0);
+    bands.value.assign(numberOfPoints, 0);
+    bands.median.assign(numberOfPoints, 0);
+    bands.lower68.assign(numberOfPoints, 0);
+    bands.upper68.assign(numberOfPoints, 0);
+    bands.lower95.assign(numberOfPoints, 0);
+    bands.upper95.assign(numberOfPoints, 0);
+
+    runInParallel(numberOfPoints, numberOfThreads, [&](long i)
+            {
+                const ToyMCPoint& p = points[i];
+
+                // blank counts are common to both cross sections when both
+                // come from the same runs
+                bool sharedBlank =
+                    p.aCounts.blankDetCounts==p.bCounts.blankDetCounts
+                    && p.aCounts.blankMonitorCounts==p.bCounts.blankMonitorCounts;
+
+                // relative standard deviation of each count
+                double aT = 1/sqrt(p.aCounts.targetDetCounts);
+                double aB = 1/sqrt(p.aCounts.blankDetCounts);
+                double aTM = 1/sqrt(p.aCounts.targetMonitorCounts);
+                double aBM = 1/sqrt(p.aCounts.blankMonitorCounts);
+                double bT = 1/sqrt(p.bCounts.targetDetCounts);
+                double bB = 1/sqrt(p.bCounts.blankDetCounts);
+                double bTM = 1/sqrt(p.bCounts.targetMonitorCounts);
+                double bBM = 1/sqrt(p.bCounts.blankMonitorCounts);
+
+                // cross section change per unit change of the log count ratio, in barns
+                double aScale = pow(10,24)/p.aCounts.arealDensity;
+                double bScale = pow(10,24)/p.bCounts.arealDensity;
+
+                seed_seq seeds{(unsigned long)seed, (unsigned long)i};
+                mt19937_64 generator(seeds);
+
+                // shared blank counts are drawn once
+                int numberOfCounts = sharedBlank ? 6 : 8;
+
+                vector<double> z(8*TOY_MC_BATCH_SIZE);
+                vector<double> uniforms(8*TOY_MC_BATCH_SIZE);
+                vector<double> values;
+                values.reserve(numberOfReplicas);
+
+                for(long first=0; first<numberOfReplicas; first+=TOY_MC_BATCH_SIZE)
+                {
+                    // (rounded up to even, for fillGaussian)
+                    int n = min((long)TOY_MC_BATCH_SIZE, numberOfReplicas-first);
+                    n += n%2;
+
+                    fillGaussian(generator, uniforms, &z[0], numberOfCounts*n);
+
+                    const double* zAT = &z[0];
+                    const double* zAB = &z[n];
+                    const double* zATM = &z[2*n];
+                    const double* zABM = &z[3*n];
+                    const double* zBT = &z[4*n];
+                    const double* zBB = sharedBlank ? zAB : &z[6*n];
+                    const double* zBTM = &z[5*n];
+                    const double* zBBM = sharedBlank ? zABM : &z[7*n];
+
+                    for(int k=0; k<n && first+k<numberOfReplicas; k++)
+                    {
+                        // each count, relative to its nominal value
+                        double uAT = 1+aT*zAT[k];
+                        double uAB = 1+aB*zAB[k];
+                        double uATM = 1+aTM*zATM[k];
+                        double uABM = 1+aBM*zABM[k];
+                        double uBT = 1+bT*zBT[k];
+                        double uBB = 1+bB*zBB[k];
+                        double uBTM = 1+bTM*zBTM[k];
+                        double uBBM = 1+bBM*zBBM[k];
+
+                        // a replica with a non-positive count has no cross section
+                        if(uAT<=0 || uAB<=0 || uATM<=0 || uABM<=0
+                                || uBT<=0 || uBB<=0 || uBTM<=0 || uBBM<=0)
+                        {
+                            continue;
+                        }
+
+                        double aReplica = p.aValue + aScale*log((uAB*uATM)/(uAT*uABM));
+                        double bReplica = p.bValue + bScale*log((uBB*uBTM)/(uBT*uBBM));
+
+                        double value = evaluate(quantity, aReplica, bReplica);
+                        if(isfinite(value))
+                        {
+                            values.push_back(value);
+                        }
+                    }
+                }
+
+                bands.energy[i] = p.energy;
+                bands.value[i] = evaluate(quantity, p.aValue, p.bValue);
+
+                if(values.size()<2)
+                {
+                    bands.median[i] = bands.value[i];
+                    bands.lower68[i] = bands.upper68[i] = bands.value[i];
+                    bands.lower95[i] = bands.upper95[i] = bands.value[i];
+                    return;
+                }
+
+                bands.median[i] = getQuantile(values, 0.5);
+                bands.lower68[i] = getQuantile(values, 0.15866);
+                bands.upper68[i] = getQuantile(values, 0.84134);
+                bands.lower95[i] = getQuantile(values, 0.02275);
+                bands.upper95[i] = getQuantile(values, 0.97725);
+            });
+
+    return 0;
+}
+
+void writeToyMCBands(const ToyMCBands& bands, string name)
+{
+    int n = bands.energy.size();
+    if(n==0)
+    {
+        return;
+    }
+
+    vector<double> zeros(n, 0);
+    vector<double> errorL68;
+    vector<double> errorR68;
+    vector<double> errorL95;
+    vector<double> errorR95;
+
+    for(int i=0; i<n; i++)
+    {
+        errorL68.push_back(max(0., bands.value[i]-bands.lower68[i]));
+        errorR68.push_back(max(0., bands.upper68[i]-bands.value[i]));
+        errorL95.push_back(max(0., bands.value[i]-bands.lower95[i]));
+        errorR95.push_back(max(0., bands.upper95[i]-bands.value[i]));
+    }
+
+    string graphName = name + "ToyMC";
+    TGraphAsymmErrors* t = new TGraphAsymmErrors(n,
+            &bands.energy[0], &bands.value[0],
+            &zeros[0], &zeros[0],
+            &errorL68[0], &errorR68[0]);
+    t->SetNameTitle(graphName.c_str(), graphName.c_str());
+    gDirectory->WriteTObject(t);
+
+    graphName = name + "ToyMC95";
+    t = new TGraphAsymmErrors(n,
+            &bands.energy[0], &bands.value[0],
+            &zeros[0], &zeros[0],
+            &errorL95[0], &errorR95[0]);
+    t->SetNameTitle(graphName.c_str(), graphName.c_str());
+    gDirectory->WriteTObject(t);
+}
+
+int addToyMCBands(TFile* aFile, string aGraphName, const DataSet& a,
+        TFile* bFile, string bGraphName, const DataSet& b,
+        ToyMCQuantity quantity, string name)
+{
+    // reading changes the current directory
+    TDirectory* outputDirectory = gDirectory;
+
+    vector<PointCounts> aCounts;
+    vector<PointCounts> bCounts;
+
+    if(readPointCounts(aFile, aGraphName + "Counts", aCounts)
+            || readPointCounts(bFile, bGraphName + "Counts", bCounts))
+    {
+        cout << "No counts trees for " << aGraphName << " and " << bGraphName
+            << "; skipping toy MC error propagation." << endl;
+        outputDirectory->cd();
+        return 1;
+    }
+
+    outputDirectory->cd();
+
+    return addToyMCBands(a, aCounts, b, bCounts, quantity, name);
+}
+
+int addToyMCBands(const DataSet& a, const vector<PointCounts>& aCounts,
+        const DataSet& b, const vector<PointCounts>& bCounts,
+        ToyMCQuantity quantity, string name)
+{
+    ToyMCBands bands;
+    if(propagateToyMC(a, aCounts, b, bCounts, quantity, TOY_MC_REPLICAS, TOY_MC_SEED,
+                getNumberOfThreads(), bands))
+    {
+        return 1;
+    }
+
+    writeToyMCBands(bands, name);
+
+    cout << "Wrote toy MC error bands (" << TOY_MC_REPLICAS << " replicas at each of "
+        << bands.energy.size() << " energies) for " << name << endl;
+
+    return 0;
+}
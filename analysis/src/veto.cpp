@@ -1,5 +1,7 @@
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <algorithm>
 
 #include "TTree.h"
 #include "TFile.h"
@@ -8,212 +10,197 @@
 
 #include "../include/dataStructures.h"
 #include "../include/branches.h"
+#include "../include/fastHisto.h"
 
 using namespace std;
 
-extern Config config;
-
 const double VETO_WINDOW = 5; // in ns
 
-int vetoEvents(string detectorFileName, string outputFileName, ofstream& logFile, string vetoTreeName)
+// event times needed for vetoing, read from a sorted tree
+struct VetoInput
 {
-    // check to see if output file already exists; if so, exit
-    ifstream f(outputFileName);
+    vector<int> cycleNumber;
+    vector<double> completeTime;
+};
 
-    if(f.good())
-    {
-        cout << outputFileName << " already exists; skipping vetoing of events." << endl;
-        logFile << outputFileName << " already exists; skipping vetoing of events." << endl;
-        return 0;
-    }
+void readVetoInput(TTree* tree, VetoInput& input)
+{
+    int cycleNumber;
+    double completeTime;
 
-    f.close();
+    // skip all other branches (waveforms in particular)
+    tree->SetBranchStatus("*",0);
+    tree->SetBranchStatus("cycleNumber",1);
+    tree->SetBranchStatus("completeTime",1);
 
-    // create output file
-    TFile* outputFile = new TFile(outputFileName.c_str(),"CREATE");
+    tree->SetBranchAddress("cycleNumber",&cycleNumber);
+    tree->SetBranchAddress("completeTime",&completeTime);
 
-    TFile* detectorFile = new TFile(detectorFileName.c_str(),"READ");
-    TTree* vetoTree = (TTree*)detectorFile->Get(vetoTreeName.c_str());
+    long numberOfEntries = tree->GetEntries();
 
-    DetectorEvent veto;
-    vetoTree->SetBranchAddress("cycleNumber",&veto.cycleNumber);
-    vetoTree->SetBranchAddress("completeTime",&veto.completeTime);
+    input.cycleNumber.resize(numberOfEntries);
+    input.completeTime.resize(numberOfEntries);
 
-    for(string detTreeName : config.cs.DETECTOR_NAMES)
+    for(long i=0; i<numberOfEntries; i++)
     {
-        // read input trees to prepare for vetoing
-        TTree* detTree = (TTree*)detectorFile->Get(detTreeName.c_str());
-        if(!detTree)
-        {
-            cerr << "Error: failed to find detector tree " << detTreeName << endl;
-            return 1;
-        }
+        tree->GetEntry(i);
 
-        DetectorEvent event;
-        vector<int>* waveformPointer = 0;
+        input.cycleNumber[i] = cycleNumber;
+        input.completeTime[i] = completeTime;
+    }
+}
 
-        detTree->SetBranchAddress("cycleNumber",&event.cycleNumber);
-        detTree->SetBranchAddress("macroNo",&event.macroNo);
-        detTree->SetBranchAddress("macroTime",&event.macroTime);
-        detTree->SetBranchAddress("fineTime",&event.fineTime);
-        detTree->SetBranchAddress("eventNo",&event.eventNo);
-        detTree->SetBranchAddress("completeTime",&event.completeTime);
-        detTree->SetBranchAddress("targetPos",&event.targetPos);
-        detTree->SetBranchAddress("sgQ",&event.sgQ);
-        detTree->SetBranchAddress("lgQ",&event.lgQ);
-        detTree->SetBranchAddress("waveform",&waveformPointer);
+// Linear merge-join of detector events against veto paddle events (both in
+// cycle and time order): an event is vetoed if the first veto event not
+// already passed lies within VETO_WINDOW of it. Detector events after the
+// last veto event are never vetoed.
+void findVetoedEvents(const VetoInput& detector, const VetoInput& veto,
+        vector<char>& vetoed, vector<double>& vetoedTimeDiffs)
+{
+    long detectorEntries = detector.completeTime.size();
+    long vetoEntries = veto.completeTime.size();
 
-        outputFile->cd();
+    vetoed.assign(detectorEntries, false);
 
-        // output tree holds events that have survived the veto
-        TTree* tree = new TTree(detTreeName.c_str(),detTreeName.c_str());
-        tree->Branch("cycleNumber",&event.cycleNumber, "cycleNumber/I");
-        tree->Branch("macroNo",&event.macroNo, "macroNo/I");
-        tree->Branch("macroTime",&event.macroTime, "macroTime/d");
-        tree->Branch("fineTime",&event.fineTime, "fineTime/d");
-        tree->Branch("eventNo",&event.eventNo, "eventNo/I");
-        tree->Branch("completeTime",&event.completeTime, "completeTime/d");
-        tree->Branch("targetPos",&event.targetPos, "targetPos/I");
-        tree->Branch("sgQ",&event.sgQ, "sgQ/I");
-        tree->Branch("lgQ",&event.lgQ, "lgQ/I");
-        tree->Branch("vetoed",&event.vetoed,"vetoed/O");
-
-        tree->Branch("waveform",&waveformPointer);
+    long j=0;
 
-        TH1D* vetoedEventHisto = new TH1D("vetoed event time diff",
-            "vetoed event time diff", 100*VETO_WINDOW, -10*VETO_WINDOW, 10*VETO_WINDOW);
+    for(long i=0; i<detectorEntries && j<vetoEntries; i++)
+    {
+        int cycleNumber = detector.cycleNumber[i];
+        double completeTime = detector.completeTime[i];
 
-        int detTreeEntries = detTree->GetEntries();
-        int vetoTreeEntries = vetoTree->GetEntries();
-        int numberVetoedEvents = 0;
+        // shift veto event up to cycle of current event
+        while(j<vetoEntries && veto.cycleNumber[j] < cycleNumber)
+        {
+            j++;
+        }
 
-        bool endVeto = false;
+        while(j<vetoEntries && veto.cycleNumber[j] == cycleNumber
+                && veto.completeTime[j]+VETO_WINDOW < completeTime)
+        {
+            j++;
+        }
 
-        // load the first veto event; j is the veto event counter
-        int j=0;
-        vetoTree->GetEntry(j);
+        if(j==vetoEntries)
+        {
+            break;
+        }
 
-        for(int i=0; i<detTreeEntries; i++)
+        // test for coincidence, within VETO_WINDOW
+        double timeDiff = completeTime-veto.completeTime[j];
+        if(abs(timeDiff)<VETO_WINDOW)
         {
-            detTree->GetEntry(i);
+            vetoed[i] = true;
+            vetoedTimeDiffs.push_back(timeDiff);
+        }
+    }
+}
 
-            // shift vetoEvent up to macropulse of current event
-            while(veto.cycleNumber < event.cycleNumber)
-            {
-                j++;
+int vetoEvents(string detectorFileName, string outputFileName, ofstream& logFile, string vetoTreeName, const Config& config)
+{
+    // check to see if output file already exists; if so, exit
+    ifstream f(outputFileName);
 
-                if(j<vetoTreeEntries)
-                {
-                    vetoTree->GetEntry(j);
-                }
+    if(f.good())
+    {
+        cout << outputFileName << " already exists; skipping vetoing of events." << endl;
+        logFile << outputFileName << " already exists; skipping vetoing of events." << endl;
+        return 0;
+    }
 
-                else
-                {
-                    cout << "Reached end of veto tree - allowing all remaining events." << endl;
+    f.close();
 
-                    while(i<detTreeEntries)
-                    {
-                        detTree->GetEntry(i);
-                        tree->Fill();
-                        i++;
+    TFile* detectorFile = new TFile(detectorFileName.c_str(),"READ");
+    TTree* vetoTree = (TTree*)detectorFile->Get(vetoTreeName.c_str());
+    if(!vetoTree)
+    {
+        cerr << "Error: failed to find veto tree " << vetoTreeName << endl;
+        detectorFile->Close();
+        return 1;
+    }
 
-                        if(i%10000==0)
-                        {
-                            cout << "Processed " << i << " events on " << detTreeName << " through veto \r";
-                            fflush(stdout);
-                        }
-                    }
+    VetoInput veto;
+    readVetoInput(vetoTree, veto);
 
-                    vetoedEventHisto->Write();
+    // read event times for each detector (ROOT I/O is serial)
+    const vector<string>& detectorNames = config.cs.DETECTOR_NAMES;
+    vector<VetoInput> detectors(detectorNames.size());
 
-                    tree->Write();
+    for(int d=0; (size_t)d<detectorNames.size(); d++)
+    {
+        TTree* detTree = (TTree*)detectorFile->Get(detectorNames[d].c_str());
+        if(!detTree)
+        {
+            cerr << "Error: failed to find detector tree " << detectorNames[d] << endl;
+            detectorFile->Close();
+            return 1;
+        }
 
-                    logFile << "Fraction of events surviving veto: " << (detTreeEntries-numberVetoedEvents)/detTreeEntries << endl;
+        readVetoInput(detTree, detectors[d]);
+    }
 
-                    endVeto = true;
-                    break;
-                }
-            }
+    detectorFile->Close();
 
-            if(endVeto)
-            {
-                break;
-            }
+    // veto each detector on its own thread
+    vector<vector<char>> vetoed(detectorNames.size());
+    vector<vector<double>> vetoedTimeDiffs(detectorNames.size());
 
-            while(veto.cycleNumber == event.cycleNumber &&
-                    (veto.completeTime+VETO_WINDOW < event.completeTime))
-            {
-                j++;
+    unsigned int numberOfThreads = min((unsigned int)detectorNames.size(), getNumberOfThreads());
 
-                if(j<vetoTreeEntries)
+    fillInParallel(detectorNames.size(), numberOfThreads,
+            [&](unsigned int, long begin, long end)
+            {
+                for(long d=begin; d<end; d++)
                 {
-                    vetoTree->GetEntry(j);
+                    findVetoedEvents(detectors[d], veto, vetoed[d], vetoedTimeDiffs[d]);
                 }
+            });
 
-                else
-                {
-                    cout << "Reached end of veto tree - allowing all remaining events." << endl;
-
-                    while(i<detTreeEntries)
-                    {
-                        detTree->GetEntry(i);
-                        tree->Fill();
-                        i++;
-
-                        if(i%10000==0)
-                        {
-                            cout << "Processed " << i << " events on " << detTreeName << " through veto \r";
-                            fflush(stdout);
-                        }
-                    }
-
-                    vetoedEventHisto->Write();
-
-                    tree->Write();
-
-                    logFile << "Fraction of events surviving veto: " << (detTreeEntries-numberVetoedEvents)/detTreeEntries << endl;
-
-                    endVeto = true;
-                    break;
-                }
-            }
+    // create output file
+    TFile* outputFile = new TFile(outputFileName.c_str(),"CREATE");
 
-            if(endVeto)
-            {
-                break;
-            }
+    for(int d=0; (size_t)d<detectorNames.size(); d++)
+    {
+        outputFile->cd();
 
-            // test for coincidence, within VETO_WINDOW
-            if(abs(event.completeTime-veto.completeTime)<VETO_WINDOW)
-            {
-                // coincidence found - mark event as "vetoed"
-                vetoedEventHisto->Fill(event.completeTime-veto.completeTime);
-                event.vetoed = true;
-                numberVetoedEvents++;
-            }
+        // output tree holds only the veto bit, one entry per event of the
+        // sorted detector tree, for use as a friend of that tree
+        TTree* tree = new TTree(detectorNames[d].c_str(),detectorNames[d].c_str());
 
-            else
-            {
-                event.vetoed = false;
-            }
+        Bool_t eventVetoed;
+        tree->Branch("vetoed",&eventVetoed,"vetoed/O");
 
+        long detTreeEntries = vetoed[d].size();
+        for(long i=0; i<detTreeEntries; i++)
+        {
+            eventVetoed = vetoed[d][i];
             tree->Fill();
+        }
 
-            if(i%10000==0)
-            {
-                cout << "Processed " << i << " events on " << detTreeName << " through veto \r";
-                fflush(stdout);
-            }
+        TH1D* vetoedEventHisto = new TH1D("vetoed event time diff",
+            "vetoed event time diff", 100*VETO_WINDOW, -10*VETO_WINDOW, 10*VETO_WINDOW);
+
+        for(double timeDiff : vetoedTimeDiffs[d])
+        {
+            vetoedEventHisto->Fill(timeDiff);
         }
 
         vetoedEventHisto->Write();
 
         tree->Write();
 
-        logFile << "Fraction of events surviving veto: " << (detTreeEntries-numberVetoedEvents)/detTreeEntries << endl;
+        long numberVetoedEvents = vetoedTimeDiffs[d].size();
+
+        cout << "Vetoed " << numberVetoedEvents << " of " << detTreeEntries
+            << " events on " << detectorNames[d] << endl;
+
+        if(detTreeEntries>0)
+        {
+            logFile << "Fraction of events surviving veto: "
+                << (detTreeEntries-numberVetoedEvents)/(double)detTreeEntries << endl;
+        }
     }
 
-    detectorFile->Close();
     outputFile->Close();
 
     return 0;
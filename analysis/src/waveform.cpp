@@ -3,9 +3,9 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <algorithm>
 #include "TFile.h"
 #include "TTree.h"
-#include "TF1.h"
 #include "TH1.h"
 #include "TH2.h"
 #include "TCanvas.h"
@@ -20,16 +20,17 @@
 #include "../include/dataStructures.h"
 #include "../include/target.h"
 #include "../include/waveformFitting.h"
+#include "../include/pulseFitter.h"
+#include "../include/waveformDSP.h"
 #include "../include/waveform.h"
 #include "../include/plots.h"
 #include "../include/branches.h"
 #include "../include/experiment.h"
+#include "../include/fastHisto.h"
 
 using namespace std;
 
 TH2I *triggerWalk;
-TH1I *peakHisto;
-TF1 *fittingFunc;
 
 unsigned int DPP_WAVEFORM_SAMPLES = 60;
 unsigned int DPP_PEAKFIT_START = 2;
@@ -44,10 +45,9 @@ double microTime, velocity, rKE;
 double prevTriggerTime = 0;
 double eventTimeDiff = 0;
 
-/*****************************************************************************/
-
-// Keep track of sample number where triggers are found
-vector<double> triggerValues;
+// Waveforms are read from the tree in batches (ROOT I/O isn't thread-safe),
+// analyzed in parallel, then their results are filled into histograms in order
+const int DPP_WAVEFORM_BATCH_SIZE = 4096;
 
 /*****************************************************************************/
 
@@ -64,125 +64,27 @@ TH1 *triggerH;
 
 
 /*****************************************************************************/
-// Check a set of waveform samples to see if they are suitable for calculating
-// the baseline. If so, return the average of the samples and treat as the
-// baseline.
-
-// Pass in a set of BASELINE_SAMPLES consecutive samples
-float baselineWithinThreshold(vector<int> bw)
+// Settings for finding a waveform's baseline and triggers (see waveformDSP.h):
+// the baseline is the average of the first BASELINE_SAMPLES-long window, within
+// BASELINE_LIMIT samples, whose samples are all within BASELINE_THRESHOLD of
+// each other, and a trigger is the first sample (from triggerStart on) at least
+// THRESHOLD below the baseline whose previous sample isn't.
+WaveformDSPSettings getTriggerSettings(int triggerStart)
 {
-    // find the average of these consecutive samples
-    float baselineAvg=0;
-
-    for(int i=0; (size_t)i<bw.size(); i++)
-    {
-        baselineAvg += bw.at(i);
-    }
-
-    baselineAvg /= BASELINE_SAMPLES;
-
-    // test each sample to see if it deviates too far from the baseline
-    // average (i.e., more than +/- BASELINE_THRESHOLD).
-    for(int i=0; (size_t)i<bw.size(); i++)
-    {
-        if(bw.at(i) > baselineAvg+BASELINE_THRESHOLD || bw.at(i) < baselineAvg-BASELINE_THRESHOLD)
-        {
-            // if one of the samples deviates too far from the baseline average,
-            // then the set of samples being used to calculate the baseline is
-            // NOT representative of the baseline. Thus, return false, and a new
-            // set of baseline samples will be used.
-            return 0;
-        }
-    }
-    // All the samples in the baseline window are within BASELINE_THRESHOLD of
-    // each other, so they should be appropriate for calculating the baseline
-    // for this waveform.
-    return baselineAvg;
-}
-/*****************************************************************************/
+    WaveformDSPSettings settings;
 
-/*****************************************************************************/
-// Starting at the beginning of a waveform, try to find a window of samples
-// BASELINE_LIMIT long that are all within +/- BASELINE_THRESHOLD ADC units)
-// of each other. Average these points to find the baseline.
-float calculateBaseline(const vector<int>& waveform)
-{
-    if(BASELINE_SAMPLES > waveform.size() ||
-       BASELINE_LIMIT > waveform.size())
-    {
-        return BASELINE;
-    }
-
-    vector<int> baselineWindow;
-
-    // Load the first BASELINE_SAMPLES waveform samples into the baseline window
-    for(int i=0; i<BASELINE_SAMPLES; i++)
-    {
-        baselineWindow.push_back(waveform[i]);
-    }
-
-    // Loop through the waveform to try to find a BASELINE_SAMPLES-long stretch
-    // that can be used to calculate the baseline. Truncate the search at
-    // BASELINE_LIMIT samples.
-
-    for(int i=BASELINE_SAMPLES; i<BASELINE_LIMIT; i++)
-    {
-        //BASELINE = baselineWithinThreshold(baselineWindow);
-
-        // test to see if the baseline returned by baselineWithinThreshold is
-        // non-zero.
-
-        if(BASELINE==0)
-        {
-            // Baseline calculation failed, so move the baseline window forward
-            // one step and try to calculate the baseline again.
-            baselineWindow.erase(baselineWindow.begin());
-            baselineWindow.push_back(waveform[i]);
-        }
-
-        else
-        {
-            // Successful baseline calculation. End looping to find a baseline
-            // window.
-            break;
-        }
-    }
+    settings.baselineSamples = BASELINE_SAMPLES;
+    settings.baselineLimit = BASELINE_LIMIT;
+    settings.baselineThreshold = BASELINE_THRESHOLD;
+    settings.defaultBaseline = BASELINE;
 
-    /*if(BASELINE < paramMin[6] || BASELINE > paramMax[6])
-    {
-        cout << "Baseline outside of bounds: " << BASELINE << endl;
-    }*/
+    settings.triggerStart = triggerStart;
+    settings.triggerThreshold = THRESHOLD;
 
-    return BASELINE;
+    return settings;
 }
 /*****************************************************************************/
 
-/*****************************************************************************/
-// Using the waveform value at time i, check for a peak, and return true if
-// there is
-bool isTrigger(int i, const vector<int>& waveform)
-{
-    // Check for triggers using:
-    //      - a raw threshold above the baseline
-    //      - a derivative threshold above the value DERIVATIVE_THRESHOLD
-    //      - by rejecting triggers if the PREVIOUS point was already above
-    //      these thresholds
-
-    if((waveform[i] <= BASELINE-THRESHOLD
-       /*&& (waveform[i]-waveform[i-1])/(double)SAMPLE_PERIOD <= DERIVATIVE_THRESHOLD*/)
-
-       && (waveform[i-1] > BASELINE-THRESHOLD
-       /*|| (waveform[i-1]-waveform[i-2])/(double)SAMPLE_PERIOD > DERIVATIVE_THRESHOLD*/))
-    {
-        return true;
-    }
-
-    else
-    {
-        return false;
-    }
-}
-
 struct fitData
 {
     double trigger1Time = 0;
@@ -209,13 +111,42 @@ struct fitData
         chiSquare = 10000;
         goodFit = false;
     }
-} data;
+};
 
-bool testForEcho(vector<int>* waveform, int triggerSample)
+// One waveform to analyze, and the results of its analysis. Everything the
+// analysis of a waveform reads or writes is here, so waveforms can be
+// analyzed on separate threads.
+struct WaveformTask
+{
+    // copied from the tree
+    int waveformNo = 0;
+    int targetPos = 0;
+    double timeDiff = 0; // waveform time, relative to its macropulse
+    unsigned int lgQ = 0;
+    vector<int> waveform;
+
+    // analysis results
+    double baseline = BASELINE;
+    vector<fitData> fits; // one for each trigger fit, good or bad
+    vector<double> triggerList; // times of good fits
+    vector<double> triggerValues; // fitted form at each trigger time
+    double gammaOffset = 0;
+
+    void clearResults()
+    {
+        baseline = BASELINE;
+        fits.clear();
+        triggerList.clear();
+        triggerValues.clear();
+        gammaOffset = 0;
+    }
+};
+
+bool testForEcho(vector<int>* waveform, int triggerSample, double baseline)
 {
     for(int i=triggerSample; i<triggerSample+PEAKFIT_WINDOW; i++)
     {
-        if(waveform->at(i)>BASELINE)
+        if(waveform->at(i)>baseline)
         {
             return true;
         }
@@ -226,14 +157,17 @@ bool testForEcho(vector<int>* waveform, int triggerSample)
 
 fitData fitTrigger(int waveformNo, double triggerSample, const vector<int>& waveform)
 {
-    // A trigger has been detected on the current waveform; fitTrigger attempts
-    // to fit the region around this trigger using a series of progressively
-    // more complicated fitting functions.
-    // If any of these functions fits the waveform to within an error boundary,
-    // fitTrigger accepts it as a good fit and exits.
+    // A trigger has been detected on the current waveform; fitTrigger fits
+    // the waveform with one peak, with the peak shape and background slope
+    // fixed (manually chosen to match the real peak shape).
+    // If the fit is within ERROR_LIMIT, fitTrigger accepts it as a good fit
+    // and takes the trigger time where the peak's leading edge crosses
+    // halfway between the background and the peak.
 
-    // reset fit data
-    data.clear();
+    // one fitter (and its workspace) for each thread's fits
+    static thread_local PulseFitter pulseFitter(SAMPLE_PERIOD, FERMI_OFFSET);
+
+    fitData data;
 
     // check to make sure we don't run off the end of the waveform
     if(triggerSample+PEAKFIT_WINDOW+PEAKFIT_OFFSET >= waveform.size() || triggerSample+PEAKFIT_OFFSET<0)
@@ -241,178 +175,21 @@ fitData fitTrigger(int waveformNo, double triggerSample, const vector<int>& wave
         return data;
     }
 
-    // extract the waveform chunk we'd like to fit
-    stringstream temp;
-    temp << "waveform" << waveformNo << "_peak" << triggerSample;
-
-    //peakHisto = new TH1I(temp.str().c_str(),temp.str().c_str(),PEAKFIT_WINDOW,SAMPLE_PERIOD*PEAKFIT_OFFSET,SAMPLE_PERIOD*(PEAKFIT_OFFSET+PEAKFIT_WINDOW));
-    peakHisto = new TH1I(temp.str().c_str(),temp.str().c_str(),waveform.size(),0,waveform.size()*SAMPLE_PERIOD);
-
-    for (int i=0; i<waveform.size(); i++)
-    {
-        peakHisto->SetBinContent(i,waveform[i]);
-    }
-
-    /*************************************************************************/
-    // first, try fitting with one peak
-    fittingFunc = new TF1("fittingFunc",onePeakForm,0,waveform.size()*SAMPLE_PERIOD,nParamsOnePeak);
-    fittingFunc->SetParameters(A_init,trig1_init,n_init,d_init,C_init,m_init);
-
-    // Lock in the shape of the peak (manually chosen to match real peak shape)
-    fittingFunc->FixParameter(2,n_init);
-    fittingFunc->FixParameter(3,d_init);
-
-    // Lock in a constant background
-    fittingFunc->FixParameter(5,m_init);
-
-    // Set parameter boundaries
-    for (int i=0; i<fittingFunc->GetNpar(); i++)
-    {
-        fittingFunc->SetParLimits(i,onePeakParamMin[i],onePeakParamMax[i]);
-    }
-
-    // fit peak 
-    peakHisto->Fit("fittingFunc","RQ");
+    double par[nParamsOnePeak] = {A_init,trig1_init,n_init,d_init,C_init,m_init};
+    double chiSquare = pulseFitter.fitOnePeak(waveform, par, onePeakParamMin, onePeakParamMax);
 
-    /*if(waveformNo<5000)
-    {
-        peakHisto->Write(); // uncomment to produce a fitted histo for each peak
-    }*/
-
-    if(fittingFunc->GetChisquare() < ERROR_LIMIT)
+    PulseTiming timing;
+    if(chiSquare < ERROR_LIMIT && !pulseFitter.getTiming(0, 20, timing))
     {
         // Success - we've achieved a good fit with just one peak
-        // Output fit data
-
-        data.peak1Amplitude = fittingFunc->GetMinimum(fittingFunc->GetParameter(1),fittingFunc->GetParameter(1)+20);
-        
-        /*TF1* CFD = new TF1("CFD",CFDForm,SAMPLE_PERIOD*PEAKFIT_OFFSET,SAMPLE_PERIOD*(PEAKFIT_OFFSET+PEAKFIT_WINDOW),nParamsOnePeak);
-
-        for(int i=0; i<fittingFunc->GetNpar(); i++)
-        {
-            CFD->SetParameter(i,fittingFunc->GetParameter(i));
-        }*/
-
-        //CFD->Write();
-
-        //double relativeTriggerTime = CFD->GetX(fittingFunc->GetParameter(4),fittingFunc->GetParameter(1),fittingFunc->GetParameter(1)+10);
-
-        //double relativeTriggerTime = fittingFunc->GetX(data.peak1Amplitude,fittingFunc->GetParameter(1),fittingFunc->GetParameter(1)+30);
-        double relativeTriggerTime = fittingFunc->GetX((fittingFunc->GetParameter(4)+data.peak1Amplitude)/2,fittingFunc->GetParameter(1),fittingFunc->GetParameter(1)+20);
-        //double relativeTriggerTime = fittingFunc->GetParameter(1);
-        //double relativeTriggerTime = triggerSample*(double)SAMPLE_PERIOD;
-
-        data.peak1TriggerAmplitude = fittingFunc->Eval(relativeTriggerTime);
-
-        data.trigger1Time = relativeTriggerTime;
-
-        data.peak1Derivative = fittingFunc->Derivative(relativeTriggerTime);
-        data.chiSquare = fittingFunc->GetChisquare();
+        data.peak1Amplitude = timing.peakValue;
+        data.peak1TriggerAmplitude = timing.triggerValue;
+        data.trigger1Time = timing.triggerTime;
+        data.peak1Derivative = timing.derivative;
+        data.chiSquare = chiSquare;
         data.goodFit = true;
-
-        numberOnePeakFits++;
-    }
-
-    /*if(data.trigger1Time+DPP_PEAKFIT_OFFSET>4)
-    {
-        peakHisto->Write();
-    }*/
-
-    /*************************************************************************/
-
-    /*else
-    {
-        fittingFunc = new TF1("fittingFunc",onePeakExpBackForm,SAMPLE_PERIOD*PEAKFIT_OFFSET,SAMPLE_PERIOD*(PEAKFIT_OFFSET+PEAKFIT_WINDOW),nParamsOnePeakExpBack);
-        fittingFunc->SetParameters(A_init,trig1_init,n_init,d_init,C_init,m_init,E_init,tE_init);
-
-        // Lock in the shape of the peak (manually chosen to match real peak shape)
-        fittingFunc->FixParameter(2,n_init);
-        fittingFunc->FixParameter(3,d_init);
-
-        // Lock in a constant background
-        fittingFunc->FixParameter(5,m_init);
-
-        // Set parameter boundaries
-        for (int i=0; i<fittingFunc->GetNpar(); i++)
-        {
-            fittingFunc->SetParLimits(i,onePeakExpBackParamMin[i],onePeakExpBackParamMax[i]);
-        }
-
-        // fit peak 
-        peakHisto->Fit("fittingFunc","RQ");
-
-        // see if peak fitting was successful
-        if(fittingFunc->GetChisquare() < ERROR_LIMIT_2)
-        {
-            data.peak1Amplitude = fittingFunc->GetMinimum(fittingFunc->GetParameter(2),fittingFunc->GetParameter(2)+10);
-
-            double relativeTriggerSample = fittingFunc->GetX((fittingFunc->GetParameter(6)+data.peak1Amplitude)/2,fittingFunc->GetParameter(2)-10,fittingFunc->GetParameter(2)+10);
-            data.trigger1Time = SAMPLE_PERIOD*(triggerSample+relativeTriggerSample);
-            data.peak1Derivative = fittingFunc->Derivative(relativeTriggerSample);
-            relativeTriggerSampleHisto->Fill(relativeTriggerSample);
-
-            data.chiSquare = fittingFunc->GetChisquare();
-            data.goodFit = true;
-
-            numberOnePeakExpBackFits++;
-        }
-
-        else
-        {
-            // failed to fit w/ one peak; try allowing two peaks
-            fittingFunc = new TF1("fittingFunc",twoPeakForm,SAMPLE_PERIOD*PEAKFIT_OFFSET,SAMPLE_PERIOD*(PEAKFIT_OFFSET+PEAKFIT_WINDOW),nParamsTwoPeaks);
-            fittingFunc->SetParameters(A_init,B_init,trig1_init,trig2_init,n_init,d_init,C_init,m_init);
-
-            // Lock in the shape of the peak (manually chosen to match real peak shape)
-            fittingFunc->FixParameter(4,n_init);
-            fittingFunc->FixParameter(5,d_init);
-
-            // Lock in a constant background
-            fittingFunc->FixParameter(7,m_init);
-
-            // Set parameter boundaries
-            for (int i=0; i<fittingFunc->GetNpar(); i++)
-            {
-                fittingFunc->SetParLimits(i,twoPeakParamMin[i],twoPeakParamMax[i]);
-            }
-
-            // fit peak 
-            peakHisto->Fit("fittingFunc","RQ");
-
-            // see if peak fitting was successful
-            if(fittingFunc->GetChisquare() < ERROR_LIMIT_2)
-            {
-                data.peak1Amplitude = fittingFunc->GetMinimum(fittingFunc->GetParameter(2),fittingFunc->GetParameter(2)+10);
-                data.peak2Amplitude = fittingFunc->GetMinimum(fittingFunc->GetParameter(3),fittingFunc->GetParameter(3)+10);
-
-                double relativeTriggerSample = fittingFunc->GetX((fittingFunc->GetParameter(6)+data.peak1Amplitude)/2,fittingFunc->GetParameter(2)-10,fittingFunc->GetParameter(2)+10);
-                data.trigger1Time = SAMPLE_PERIOD*(triggerSample+relativeTriggerSample);
-                data.peak1Derivative = fittingFunc->Derivative(relativeTriggerSample);
-                relativeTriggerSampleHisto->Fill(relativeTriggerSample);
-
-                relativeTriggerSample = fittingFunc->GetX((fittingFunc->GetParameter(6)+data.peak2Amplitude)/2,fittingFunc->GetParameter(3)-5,fittingFunc->GetParameter(2)+5);
-                data.trigger2Time = SAMPLE_PERIOD*(triggerSample+relativeTriggerSample);
-                data.peak2Derivative = fittingFunc->Derivative(relativeTriggerSample);
-                relativeTriggerSampleHisto->Fill(relativeTriggerSample);
-
-                data.chiSquare = fittingFunc->GetChisquare();
-                data.goodFit = true;
-
-                numberTwoPeakFits++;
-            }
-        }
     }
-*/
-
-    delete peakHisto;
-    delete fittingFunc;
-
-    /*if(data.chiSquare<5)
-      {
-      delete peakHisto;
-      }*/
 
-    // failed to fit
     return data;
 }
 
@@ -445,7 +222,7 @@ double calculateGammaOffset(const vector<double>& triggerList)
 //, int waveformNo
 //triggerWalk->Fill(microTime,waveformNo);
 
-void fillTriggerHistos(double triggerTime, vector<Plots>& plots)
+void fillTriggerHistos(double triggerTime, int targetPos, vector<Plots>& plots)
 {
     // Calculate time of flight from trigger time
     microTime = fmod((triggerTime),MICRO_LENGTH);
@@ -458,10 +235,10 @@ void fillTriggerHistos(double triggerTime, vector<Plots>& plots)
     // convert velocity to relativistic kinetic energy
     rKE = (pow((1.-pow((velocity/C),2.)),-0.5)-1.)*NEUTRON_MASS; // in MeV
 
-    if (procEvent.targetPos>0 && procEvent.targetPos<=tarGates.size()-1)
+    if (targetPos>0 && targetPos<=tarGates.size()-1)
     {
-        TH1D* tof = plots[procEvent.targetPos-1].getTOFHisto();
-        TH1D* en = plots[procEvent.targetPos-1].getEnergyHisto();
+        TH1D* tof = plots[targetPos-1].getTOFHisto();
+        TH1D* en = plots[targetPos-1].getEnergyHisto();
 
         tof->Fill(microTime);
         en->Fill(rKE);
@@ -473,41 +250,119 @@ void fillTriggerHistos(double triggerTime, vector<Plots>& plots)
 }
 
 /*****************************************************************************/
-void processTrigger(int waveformNo, int triggerSample, vector<double>& triggerList, const vector<int>& waveform)
+const fitData& processTrigger(int triggerSample, WaveformTask& task)
 {
     // Uncomment to use raw trigger sample as trigger time
     //double triggerTime = triggerSample*2;
-    //triggerList.push_back(triggerTime);
+    //task.triggerList.push_back(triggerTime);
 
-    double timeOffset = 0;
+    task.fits.push_back(fitTrigger(task.waveformNo, triggerSample, task.waveform));
+    const fitData& data = task.fits.back();
 
     // Uncomment to use fitted peak threshold-intercept as trigger time
-    if(fitTrigger(waveformNo, triggerSample, waveform).goodFit)
+    if(data.goodFit)
     {
-        triggerList.push_back(data.trigger1Time);
-        triggerValues.push_back(data.peak1TriggerAmplitude);
+        task.triggerList.push_back(data.trigger1Time);
+        task.triggerValues.push_back(data.peak1TriggerAmplitude);
 
         /*if(data.peak2Amplitude && data.peak1Amplitude > 13000)
         {
-            triggerList.push_back(data.trigger2Time);
+            task.triggerList.push_back(data.trigger2Time);
         }*/
+    }
+
+    //else
+    //{
+    //    task.triggerList.push_back(triggerSample*SAMPLE_PERIOD-timeOffset);
+    //}
+
+    //cout << data.chiSquare << endl;
+
+    return data;
+}
 
-        numberGoodFits++;
+// Analyze a DPP-mode waveform (one wavelet per event): fit the first trigger,
+// if the wavelet falls in the gamma gate
+void analyzeDPPWaveform(WaveformTask& task)
+{
+    const int gammaGate[2] = {80,90};
+
+    task.clearResults();
+
+    // find the baseline and first trigger in one pass
+    WaveformFeatures features;
+    analyzeWaveform(task.waveform.data(), task.waveform.size(),
+            getTriggerSettings(DPP_PEAKFIT_START), features);
+
+    task.baseline = features.baseline;
+
+    if(features.triggerSample>=0)
+    {
+        // trigger found - plot/fit/extract time
+        double microTime = fmod(task.timeDiff,MICRO_LENGTH);
+
+        if(microTime > gammaGate[0] && microTime < gammaGate[1])
+        {
+            processTrigger(features.triggerSample, task);
+        }
     }
+}
 
-    else
+// Analyze a waveform-mode waveform (a whole macropulse): fit every trigger,
+// then use the gamma peaks to find the time offset of the waveform
+void analyzeFullWaveform(WaveformTask& task)
+{
+    task.clearResults();
+
+    WaveformDSPSettings settings = getTriggerSettings(PEAKFIT_WINDOW);
+
+    WaveformFeatures features;
+    analyzeWaveform(task.waveform.data(), task.waveform.size(), settings, features);
+
+    task.baseline = features.baseline;
+
+    // keep the baseline found above while searching for later triggers
+    settings.baselineSamples = 0;
+    settings.defaultBaseline = task.baseline;
+
+    while(features.triggerSample>=0)
     {
-        //triggerList.push_back(triggerSample*SAMPLE_PERIOD-timeOffset);
-        numberBadFits++;
+        // trigger found - plot/fit/extract time
+        processTrigger(features.triggerSample, task);
+
+        // resume the search past the end of this fitting window so that we
+        // don't refit the same data
+        settings.triggerStart = features.triggerSample+PEAKFIT_WINDOW+1;
+        analyzeWaveform(task.waveform.data(), task.waveform.size(), settings, features);
     }
 
-    //cout << data.chiSquare << endl;
+    task.gammaOffset = calculateGammaOffset(task.triggerList);
 }
 
-void produceTriggerOverlay(int j, vector<double>& triggerList, vector<int>& waveform)
+// Add a task's fits to the fit tallies
+void countFits(const WaveformTask& task)
 {
+    for(const fitData& data : task.fits)
+    {
+        if(data.goodFit)
+        {
+            numberGoodFits++;
+            numberOnePeakFits++;
+        }
+
+        else
+        {
+            numberBadFits++;
+        }
+    }
+}
+
+void produceTriggerOverlay(const WaveformTask& task)
+{
+    const vector<int>& waveform = task.waveform;
+
     stringstream temp;
-    temp << "waveform " << j;
+    temp << "waveform " << task.waveformNo;
     waveformH = new TH1I(temp.str().c_str(),temp.str().c_str(),waveform.size(),0,SAMPLE_PERIOD*waveform.size());
 
     for(int k=0; (size_t)k<waveform.size(); k++)
@@ -520,9 +375,9 @@ void produceTriggerOverlay(int j, vector<double>& triggerList, vector<int>& wave
     temp << "triggers";
     triggerH = new TH1I(temp.str().c_str(),temp.str().c_str(),waveform.size(),0,SAMPLE_PERIOD*(waveform.size()));
 
-    for(int k=0; (size_t)k<triggerList.size(); k++)
+    for(int k=0; (size_t)k<task.triggerList.size(); k++)
     {
-        triggerH->SetBinContent((triggerList[k]/*+DPP_PEAKFIT_OFFSET*/)/(double)SAMPLE_PERIOD,triggerValues[k]);
+        triggerH->SetBinContent((task.triggerList[k]/*+DPP_PEAKFIT_OFFSET*/)/(double)SAMPLE_PERIOD,task.triggerValues[k]);
     }
 
     TCanvas *c1 = new TCanvas;
@@ -563,121 +418,126 @@ void processWaveforms(TTree* treeToSort, vector<Plots>& targetPlots, TFile* outF
         int totalEntries = treeToSort->GetEntries();
         cout << "Total waveforms = " << totalEntries << endl;
 
-        vector<double> triggerList;
+        unsigned int numberOfThreads = getNumberOfThreads();
 
         waveformWrap = new TMultiGraph("DPP waveforms", "DPP waveforms");
         vector<TGraph*> waveletGraphs;
         vector<TGraph*> triggerGraphs;
 
-        int gammaGate[2] = {80,90};
-
         double prevGammaTime = 0;
 
-        for(int j=1; j<totalEntries; j++)
+        vector<WaveformTask> batch(DPP_WAVEFORM_BATCH_SIZE);
+
+        for(int firstEntry=1; firstEntry<totalEntries; firstEntry+=DPP_WAVEFORM_BATCH_SIZE)
         {
-            if(j%1000==0)
-            {
-                cout << "Processing triggers on waveform " << j << "\r";
-                fflush(stdout);
-            }
+            int batchSize = min(DPP_WAVEFORM_BATCH_SIZE, totalEntries-firstEntry);
 
-            /*if(j>500)
+            // pull a batch of individual waveform events
+            for(int i=0; i<batchSize; i++)
             {
-                break;
-            }*/
+                int j = firstEntry+i;
 
-            triggerList.clear();
-            triggerValues.clear();
+                if(j%1000==0)
+                {
+                    cout << "Processing triggers on waveform " << j << "\r";
+                    fflush(stdout);
+                }
 
-            // pull individual waveform event
-            treeToSort->GetEntry(j);
+                treeToSort->GetEntry(j);
 
-            // calculate the baseline for this waveform
-            BASELINE = calculateBaseline(*procEvent.waveform);
+                WaveformTask& task = batch[i];
+                task.waveformNo = j;
+                task.targetPos = procEvent.targetPos;
+                task.timeDiff = procEvent.completeTime-procEvent.macroTime;
+                task.lgQ = procEvent.lgQ;
+                task.waveform = *procEvent.waveform;
+            }
 
-            // Loop through all points in the waveform and fit peaks
-            for(int k=DPP_PEAKFIT_START; (size_t)k<procEvent.waveform->size(); k++)
+            // find and fit each waveform's trigger
+            runInParallel(batchSize, numberOfThreads, [&](long i)
             {
-                // Check to see if this point creates a new trigger
-                if(isTrigger(k, *procEvent.waveform))
-                {
-                    // trigger found - plot/fit/extract time
+                analyzeDPPWaveform(batch[i]);
+            });
 
-                    double timeDiff = procEvent.completeTime-procEvent.macroTime;
-                    double microTime = fmod(timeDiff,MICRO_LENGTH);
+            // fill histograms with the results, in waveform order
+            for(int i=0; i<batchSize; i++)
+            {
+                const WaveformTask& task = batch[i];
 
-                    if(microTime > gammaGate[0] && microTime < gammaGate[1])
-                    {
-                        processTrigger(j, k, triggerList, *procEvent.waveform);
+                countFits(task);
 
-                        double fullTime = procEvent.completeTime-procEvent.macroTime+data.trigger1Time+DPP_PEAKFIT_OFFSET;
-                        gammaToGammaTimeH->Fill(fmod(fullTime,MICRO_LENGTH)-prevGammaTime);
-                        prevGammaTime=fmod(fullTime,MICRO_LENGTH);
+                //produceTriggerOverlay(task);
 
-                        fillTriggerHistos(fullTime, targetPlots);
-                        fittedTimeHisto->Fill(data.trigger1Time);
-                    }
+                if(task.fits.empty())
+                {
+                    // no trigger in the gamma gate
+                    continue;
+                }
 
-                    //processTrigger(j, k, triggerList, *procEvent.waveform);
+                const fitData& data = task.fits.front();
 
-                    break;
-                }
-            }
+                double fullTime = task.timeDiff+data.trigger1Time+DPP_PEAKFIT_OFFSET;
+                gammaToGammaTimeH->Fill(fmod(fullTime,MICRO_LENGTH)-prevGammaTime);
+                prevGammaTime=fmod(fullTime,MICRO_LENGTH);
 
-            //produceTriggerOverlay(j, triggerList, *procEvent.waveform);
+                fillTriggerHistos(fullTime, task.targetPos, targetPlots);
+                fittedTimeHisto->Fill(data.trigger1Time);
 
-            TH2D* deltaTVsPulseIntegralHisto;
+                TH2D* deltaTVsPulseIntegralHisto = 0;
 
-            switch(procEvent.targetPos-1)
-            {
-                case 0:
-                    deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral0;
-                    break;
+                switch(task.targetPos-1)
+                {
+                    case 0:
+                        deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral0;
+                        break;
 
-                case 1:
-                    deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral1;
-                    break;
+                    case 1:
+                        deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral1;
+                        break;
 
-                case 2:
-                    deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral2;
-                    break;
+                    case 2:
+                        deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral2;
+                        break;
 
-                case 3:
-                    deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral3;
-                    break;
+                    case 3:
+                        deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral3;
+                        break;
 
-                case 4:
-                    deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral4;
-                    break;
+                    case 4:
+                        deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral4;
+                        break;
 
-                case 5:
-                    deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral5;
-                    break;
-            }
+                    case 5:
+                        deltaTVsPulseIntegralHisto = deltaTVsPulseIntegral5;
+                        break;
+                }
 
-            triggerAmplitudeHisto->Fill(data.peak1Amplitude);
-            relativeTriggerTimeHisto->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET);
-            relativeTriggerTimeVsAmplitude->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET,data.peak1Amplitude);
+                triggerAmplitudeHisto->Fill(data.peak1Amplitude);
+                relativeTriggerTimeHisto->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET);
+                relativeTriggerTimeVsAmplitude->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET,data.peak1Amplitude);
 
-            deltaTVsPulseIntegralHisto->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET, procEvent.lgQ);
-            deltaTVsPulseHeight->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET, data.peak1Amplitude);
+                if(deltaTVsPulseIntegralHisto)
+                {
+                    deltaTVsPulseIntegralHisto->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET, task.lgQ);
+                }
 
-            // Create a new graph for each wavelet
-            //waveletGraphs.push_back(new TGraph());
+                deltaTVsPulseHeight->Fill(data.trigger1Time+DPP_PEAKFIT_OFFSET, data.peak1Amplitude);
 
-            // Fill each micropulse graph with waveform samples
-            /*for (int l=0; l<procEvent.waveform->size(); l++)
-              {
-              waveletGraphs.back()->SetPoint(l,l*SAMPLE_PERIOD,procEvent.waveform->at(l));
-              }*/
+                // Create a new graph for each wavelet
+                //waveletGraphs.push_back(new TGraph());
 
-            // Create a new graph for each wavelet
-            //triggerGraphs.push_back(new TGraph());
+                // Fill each micropulse graph with waveform samples
+                /*for (int l=0; l<task.waveform.size(); l++)
+                  {
+                  waveletGraphs.back()->SetPoint(l,l*SAMPLE_PERIOD,task.waveform.at(l));
+                  }*/
 
-            // Fill each micropulse graph with waveform samples
-            //triggerGraphs.back()->SetPoint(0,triggerList[0],triggerValues[0]);
+                // Create a new graph for each wavelet
+                //triggerGraphs.push_back(new TGraph());
 
-            fill(procEvent.waveform->begin(),procEvent.waveform->end(),BASELINE);
+                // Fill each micropulse graph with waveform samples
+                //triggerGraphs.back()->SetPoint(0,task.triggerList[0],task.triggerValues[0]);
+            }
         }
 
         TGraph* exponentialFit = new TGraph();
@@ -750,7 +610,6 @@ void processWaveforms(TTree* treeToSort, vector<Plots>& targetPlots, TFile* outF
 
         long triggersWithGamma = 0;
         vector<int> fullWaveform(MACRO_LENGTH/2, BASELINE);
-        vector<double> triggerList;
 
         int prevTargetPos = 0;
         double firstTimetagInSeries = 0;
@@ -758,6 +617,48 @@ void processWaveforms(TTree* treeToSort, vector<Plots>& targetPlots, TFile* outF
         int totalEntries = treeToSort->GetEntries();
         cout << "Total waveforms = " << totalEntries << endl;
 
+        unsigned int numberOfThreads = getNumberOfThreads();
+
+        // macropulse waveforms waiting to be analyzed (each is a whole
+        // macropulse long, so only queue one per thread)
+        vector<WaveformTask> batch;
+
+        auto processBatch = [&]()
+        {
+            // find and fit each waveform's triggers
+            runInParallel(batch.size(), numberOfThreads, [&](long i)
+            {
+                analyzeFullWaveform(batch[i]);
+            });
+
+            // fill histograms with the results, in waveform order
+            for(const WaveformTask& task : batch)
+            {
+                countFits(task);
+
+                // Use the gamma peaks to find the time offset for this
+                // waveform, and adjust the microTime with this offset
+                if(task.gammaOffset!=0)
+                {
+                    for(int m=0; (size_t)m<task.triggerList.size(); m++)
+                    {
+                        //fillTriggerHistos(task.triggerList[m]-task.gammaOffset+WAVEFORM_OFFSET, task.targetPos, targetPlots);
+                    }
+
+                    triggersWithGamma++;
+                }
+
+                /*if(task.waveformNo<30)
+                  {
+                  produceTriggerOverlay(task);
+                  }*/
+
+                monitorHisto->Fill(task.targetPos);
+            }
+
+            batch.clear();
+        };
+
         /*TCanvas *mycan = (TCanvas*)gROOT->FindObject("mycan");
 
           if(!mycan)
@@ -776,9 +677,6 @@ void processWaveforms(TTree* treeToSort, vector<Plots>& targetPlots, TFile* outF
                 break;
             }
 
-            triggerList.clear();
-            triggerValues.clear();
-
             prevTargetPos = procEvent.targetPos;
 
             // pull individual waveform event
@@ -786,111 +684,21 @@ void processWaveforms(TTree* treeToSort, vector<Plots>& targetPlots, TFile* outF
 
             if(procEvent.evtNo==1)
             {
-                // new macropulse; process the previous macropulse's waveform
-
-                // calculate the baseline for this waveform
-                BASELINE = calculateBaseline(fullWaveform);
-
-                // Loop through all points in the waveform and fit peaks
-                for(int k=PEAKFIT_WINDOW; (size_t)k<fullWaveform.size(); k++)
-                {
-                    // Check to see if this point creates a new trigger
-                    if(isTrigger(k, fullWaveform))
-                    {
-                        // trigger found - plot/fit/extract time
-                        processTrigger(j, k, triggerList, fullWaveform);
-
-                        // shift waveform index past the end of this fitting window
-                        // so that we don't refit the same data
-                        k += PEAKFIT_WINDOW;
-                    }
-                    /*if(triggerList.size()>10)
-                      {
-                      for(int m=0; m<triggerList.size(); m++)
-                      {
-                      cout << "triggerList[" << m << "] = " << triggerList[m] << endl;
-                      }
-                      break;
-                      }*/
-                }
-
-                // Use the gamma peaks to find the time offset for this waveform, and
-                // adjust the microTime with this offset
-
-                double gammaOffset = calculateGammaOffset(triggerList);
-
-                /*for(int m=0; (size_t)m<triggerList.size(); m++)
-                  {
-                  fillTriggerHistos(triggerList[m]-gammaOffset, targetPlots);
-                  }*/
-
-                if(gammaOffset!=0)
-                {
-                    for(int m=0; (size_t)m<triggerList.size(); m++)
-                    {
-                        //fillTriggerHistos(triggerList[m]-gammaOffset+WAVEFORM_OFFSET, targetPlots);
-                    }
-
-                    triggersWithGamma++;
-                }
+                // new macropulse; queue the previous macropulse's waveform
+                batch.push_back(WaveformTask());
 
-                /*if(j<30)
-                  {
-                  produceTriggerOverlay(j, triggerList, fullWaveform);
-                  }*/
-
-                /*temp.str("");
-                  temp << "waveformWrap" << j;
-
-                  waveformWrap = new TMultiGraph(temp.str().c_str(), temp.str().c_str());
+                WaveformTask& task = batch.back();
+                task.waveformNo = j;
+                task.targetPos = prevTargetPos;
+                task.waveform.swap(fullWaveform);
 
-                  vector<TGraph*> microGraphs;
+                fullWaveform.assign(MACRO_LENGTH/2, BASELINE);
 
-                // Create a new graph for each micropulse period to be plotted
-                for (int m = 0; m<floor(2*procEvent.waveform->size()/MICRO_LENGTH); m++)
-                {
-                microGraphs.push_back(new TGraph());
-                }
-
-                // Fill each micropulse graph with waveform samples
-                for (int l = 0; l<procEvent.waveform->size(); l++)
+                if(batch.size()>=numberOfThreads)
                 {
-                microGraphs[(int)floor(l/(double)MICRO_LENGTH)]->SetPoint(microGraphs[(int)floor(l/(double)MICRO_LENGTH)]->GetN(),fmod(2*l+WAVEFORM_OFFSET,MICRO_LENGTH),procEvent.waveform->at(l));
-                //cout << "Adding value " << procEvent.waveform->at(l) << " to position " << fmod(l,MICRO_LENGTH) << " in microGraph " << floor(l/(double)MICRO_LENGTH) << endl;
+                    processBatch();
                 }
 
-                // Add each graph to the MultiGraph
-                for (int m = 0; m<microGraphs.size(); m++)
-                {
-                //cout << "adding graph " << m << " to multigraph" << endl;
-                microGraphs[m]->Draw();
-                waveformWrap->Add(microGraphs[m],"l");
-                }
-
-                waveformWrap->Write();
-                */
-
-                //gPad->Modified();
-                //mycan->Update();
-
-                // Fill trigger histogram
-                /*for (int l = 0; l<triggerList.size(); l++)
-                  {
-                  cout << "trigger " << l << " = " << triggerList[l] << ", " << triggerValues[l] << endl;
-                  }*/
-
-                //triggerH->Write();
-                //cout << "Finished processing waveform " << j << endl << endl;
-
-                /*if(j==10)
-                  {
-                  break;
-                  }*/
-
-                monitorHisto->Fill(prevTargetPos);
-
-                fill(fullWaveform.begin(),fullWaveform.end(),BASELINE);
-
                 firstTimetagInSeries = procEvent.completeTime;
             }
 
@@ -910,6 +718,9 @@ void processWaveforms(TTree* treeToSort, vector<Plots>& targetPlots, TFile* outF
             }
         }
 
+        // analyze the macropulses still queued
+        processBatch();
+
         cout << "Triggers with gamma in wavelet: " << triggersWithGamma << endl;
 
         monitorHisto->Write();
@@ -0,0 +1,216 @@
+#include "../include/waveformDSP.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// true if every sample of the window is within threshold of average
+inline bool isFlat(const int* window, int length, double average, double threshold)
+{
+    int minimum = window[0];
+    int maximum = window[0];
+
+    for(int i=1; i<length; i++)
+    {
+        minimum = min(minimum, window[i]);
+        maximum = max(maximum, window[i]);
+    }
+
+    return maximum<=average+threshold && minimum>=average-threshold;
+}
+
+// Trigger search: the first sample at or below level whose previous sample
+// is above it
+struct TriggerSearch
+{
+    TriggerSearch(const int* samples, double level) : samples(samples), level(level) {}
+
+    // check sample i; returns true if it's the trigger
+    inline bool step(int i)
+    {
+        if(samples[i]<=level && samples[i-1]>level)
+        {
+            triggerSample = i;
+            return true;
+        }
+
+        return false;
+    }
+
+    const int* samples;
+    double level;
+
+    int triggerSample = -1;
+};
+
+// CFD search, as in calculateCFDTime
+struct CFDSearch
+{
+    CFDSearch(const int* samples, double baseline, const WaveformDSPSettings& settings)
+        : samples(samples),
+          fraction(settings.CFDFraction),
+          delay(settings.CFDDelay),
+          armThreshold(settings.CFDArmThreshold),
+          offset(baseline*(1-settings.CFDFraction)) {}
+
+    // add sample i to the CFD sum; returns true at the zero crossing
+    inline bool step(int i)
+    {
+        double CFDSample = samples[i]-(fraction*samples[i+delay]+offset);
+
+        if(!listenForZC && CFDSample>armThreshold)
+        {
+            // approaching ZC - start looking for a ZC
+            listenForZC = true;
+        }
+
+        if(listenForZC && CFDSample<0)
+        {
+            // found ZC: time of crossing, by linear interpolation
+            CFDTime = (i-1)+(0-prevCFDSample)/(CFDSample-prevCFDSample);
+            return true;
+        }
+
+        prevCFDSample = CFDSample;
+        return false;
+    }
+
+    const int* samples;
+    double fraction;
+    int delay;
+    double armThreshold;
+    double offset;
+
+    bool listenForZC = false;
+    double prevCFDSample = 0;
+
+    double CFDTime = -1;
+};
+
+void analyzeWaveform(const int* samples, int numberOfSamples,
+        const WaveformDSPSettings& settings, WaveformFeatures& features)
+{
+    features = WaveformFeatures();
+
+    /*************************************************************************/
+    // baseline: slide a window along the start of the waveform, keeping a
+    // running sum of its samples
+    features.baseline = settings.defaultBaseline;
+
+    const int window = settings.baselineSamples;
+    const int searchEnd = min(settings.baselineLimit, numberOfSamples);
+
+    if(window>0 && window<=searchEnd)
+    {
+        long windowSum = 0;
+        for(int i=0; i<window; i++)
+        {
+            windowSum += samples[i];
+        }
+
+        for(int start=0; ; start++)
+        {
+            double average = windowSum/(double)window;
+
+            if(isFlat(samples+start, window, average, settings.baselineThreshold))
+            {
+                features.baseline = average;
+                break;
+            }
+
+            if(start+window>=searchEnd)
+            {
+                break;
+            }
+
+            windowSum += samples[start+window]-samples[start];
+        }
+    }
+
+    const double baseline = features.baseline;
+
+    /*************************************************************************/
+    // trigger and CFD: search together until one is found, then finish the
+    // other alone
+    TriggerSearch trigger(samples, baseline-settings.triggerThreshold);
+    CFDSearch CFD(samples, baseline, settings);
+
+    const int triggerStart = max(settings.triggerStart, 1);
+    const int triggerEnd = numberOfSamples;
+
+    // the CFD sum needs the sample CFDDelay samples ahead
+    const int CFDEnd = (settings.CFDDelay>0) ? numberOfSamples-(settings.CFDDelay+1) : 0;
+
+    int i = 1;
+    bool triggerDone = false;
+    bool CFDDone = false;
+
+    // before the trigger search starts
+    for(; i<min(triggerStart,CFDEnd) && !CFDDone; i++)
+    {
+        CFDDone = CFD.step(i);
+    }
+
+    for(; i<min(triggerEnd,CFDEnd) && !triggerDone && !CFDDone; i++)
+    {
+        triggerDone = trigger.step(i);
+        CFDDone = CFD.step(i);
+    }
+
+    for(int j=max(i,triggerStart); j<triggerEnd && !triggerDone; j++)
+    {
+        triggerDone = trigger.step(j);
+    }
+
+    for(; i<CFDEnd && !CFDDone; i++)
+    {
+        CFDDone = CFD.step(i);
+    }
+
+    features.triggerSample = trigger.triggerSample;
+    features.CFDTime = CFD.CFDTime;
+
+    /*************************************************************************/
+    // gates: sum the samples, and find the lowest, over the short gate and
+    // then the rest of the long gate
+    if(features.triggerSample<0 || settings.longGateSamples<=0)
+    {
+        return;
+    }
+
+    const int gateStart = max(features.triggerSample-settings.gatePreSamples, 0);
+    const int longGateEnd = min(gateStart+settings.longGateSamples, numberOfSamples);
+    const int shortGateEnd = min(gateStart+settings.shortGateSamples, longGateEnd);
+
+    long shortSum = 0;
+    int shortMinimum = samples[gateStart];
+    for(int i=gateStart; i<shortGateEnd; i++)
+    {
+        shortSum += samples[i];
+        shortMinimum = min(shortMinimum, samples[i]);
+    }
+
+    long restSum = 0;
+    int restMinimum = samples[gateStart];
+    for(int i=shortGateEnd; i<longGateEnd; i++)
+    {
+        restSum += samples[i];
+        restMinimum = min(restMinimum, samples[i]);
+    }
+
+    features.shortIntegral = (shortGateEnd-gateStart)*baseline-shortSum;
+    features.longIntegral = (longGateEnd-gateStart)*baseline-(shortSum+restSum);
+
+    // the (first) lowest sample is the peak
+    int minimum = min(shortMinimum, restMinimum);
+    for(int i=gateStart; i<longGateEnd; i++)
+    {
+        if(samples[i]==minimum)
+        {
+            features.peakSample = i;
+            break;
+        }
+    }
+
+    features.peakAmplitude = baseline-minimum;
+}
@@ -4,7 +4,7 @@
 using namespace std;
 
 // For functions that use a Fermi function, define the x-axis offset
-const double FERMI_OFFSET = 11.5; // in ns
+extern const double FERMI_OFFSET = 11.5; // in ns
 
 /*****************************************************************************/
 /* Define the peak-fitting functional form here: